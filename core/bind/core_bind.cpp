@@ -131,6 +131,31 @@ bool _ResourceLoader::exists(const String &p_path, const String &p_type_hint) {
 	return ResourceLoader::exists(p_path, p_type_hint);
 }
 
+void _ResourceLoader::set_cache_budget(int64_t p_bytes) {
+
+	ERR_FAIL_COND(p_bytes < 0);
+	ResourceCache::set_retain_budget(p_bytes);
+}
+
+int64_t _ResourceLoader::get_cache_budget() const {
+
+	return ResourceCache::get_retain_budget();
+}
+
+Dictionary _ResourceLoader::get_cache_stats() const {
+
+	ResourceCache::RetainStats stats = ResourceCache::get_retain_stats();
+
+	Dictionary d;
+	d["budget"] = stats.budget;
+	d["retained_bytes"] = stats.retained_bytes;
+	d["retained_count"] = stats.retained_count;
+	d["hits"] = stats.hits;
+	d["misses"] = stats.misses;
+	d["evictions"] = stats.evictions;
+	return d;
+}
+
 void _ResourceLoader::_bind_methods() {
 
 	ClassDB::bind_method(D_METHOD("load_threaded_request", "path", "type_hint", "use_sub_threads"), &_ResourceLoader::load_threaded_request, DEFVAL(""), DEFVAL(false));
@@ -144,6 +169,10 @@ void _ResourceLoader::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("has_cached", "path"), &_ResourceLoader::has_cached);
 	ClassDB::bind_method(D_METHOD("exists", "path", "type_hint"), &_ResourceLoader::exists, DEFVAL(""));
 
+	ClassDB::bind_method(D_METHOD("set_cache_budget", "bytes"), &_ResourceLoader::set_cache_budget);
+	ClassDB::bind_method(D_METHOD("get_cache_budget"), &_ResourceLoader::get_cache_budget);
+	ClassDB::bind_method(D_METHOD("get_cache_stats"), &_ResourceLoader::get_cache_stats);
+
 	BIND_ENUM_CONSTANT(THREAD_LOAD_INVALID_RESOURCE);
 	BIND_ENUM_CONSTANT(THREAD_LOAD_IN_PROGRESS);
 	BIND_ENUM_CONSTANT(THREAD_LOAD_FAILED);
@@ -69,6 +69,10 @@ public:
 	bool has_cached(const String &p_path);
 	bool exists(const String &p_path, const String &p_type_hint = "");
 
+	void set_cache_budget(int64_t p_bytes);
+	int64_t get_cache_budget() const;
+	Dictionary get_cache_stats() const;
+
 	_ResourceLoader();
 };
 
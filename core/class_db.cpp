@@ -1195,6 +1195,33 @@ StringName ClassDB::get_property_getter(StringName p_class, const StringName &p_
 	return StringName();
 }
 
+// Returns the binds get_property()/set_property() would end up calling for p_property.
+// Fails if the name resolves to a constant, method or signal first, so callers can safely cache the binds per class.
+bool ClassDB::get_property_binds(const StringName &p_class, const StringName &p_property, MethodBind *&r_setter, MethodBind *&r_getter, int &r_index) {
+
+	OBJTYPE_RLOCK;
+
+	ClassInfo *check = classes.getptr(p_class);
+	while (check) {
+		const PropertySetGet *psg = check->property_setget.getptr(p_property);
+		if (psg) {
+
+			r_setter = psg->_setptr;
+			r_getter = psg->_getptr;
+			r_index = psg->index;
+			return true;
+		}
+
+		if (check->constant_map.has(p_property) || check->method_map.has(p_property) || check->signal_map.has(p_property)) {
+			return false;
+		}
+
+		check = check->inherits_ptr;
+	}
+
+	return false;
+}
+
 bool ClassDB::has_property(const StringName &p_class, const StringName &p_property, bool p_no_inheritance) {
 
 	ClassInfo *type = classes.getptr(p_class);
@@ -35,7 +35,9 @@
 #include "core/io/resource_loader.h"
 #include "core/math/math_funcs.h"
 #include "core/os/copymem.h"
+#include "core/os/os.h"
 #include "core/print_string.h"
+#include "core/thread_work_pool.h"
 
 #include "thirdparty/misc/hq2x.h"
 
@@ -523,6 +525,92 @@ Image::Format Image::get_format() const {
 	return format;
 }
 
+// Large images are resampled in bands of destination rows spread over all cores.
+#define IMAGE_BAND_MIN_PIXELS 65536
+
+static ThreadWorkPool image_work_pool;
+static std::atomic<bool> image_work_pool_busy(false);
+static bool image_work_pool_started = false;
+
+void Image::finish_work_pool() {
+
+	image_work_pool.finish();
+	image_work_pool_started = false;
+}
+
+// The pool is shared by all images, when another thread is using it the work runs on the calling thread.
+template <class C, class M>
+static void _image_do_work(uint32_t p_elements, C *p_instance, M p_method) {
+
+	bool busy = false;
+	if (p_elements > 1 && image_work_pool_busy.compare_exchange_strong(busy, true)) {
+		if (!image_work_pool_started) {
+			image_work_pool.init();
+			image_work_pool_started = true;
+		}
+		image_work_pool.do_work(p_elements, p_instance, p_method, (void *)NULL);
+		image_work_pool_busy.store(false);
+	} else {
+		for (uint32_t i = 0; i < p_elements; i++) {
+			(p_instance->*p_method)(i, NULL);
+		}
+	}
+}
+
+typedef void (*ImageRowsFunc)(const uint8_t *__restrict p_src, uint8_t *__restrict p_dst, uint32_t p_src_width, uint32_t p_src_height, uint32_t p_dst_width, uint32_t p_dst_height, uint32_t p_from_row, uint32_t p_to_row);
+
+static uint32_t _get_band_count(uint32_t p_width, uint32_t p_height) {
+
+#ifdef NO_THREADS
+	return 1;
+#else
+	int cores = OS::get_singleton()->get_processor_count();
+	if (cores <= 1 || uint64_t(p_width) * p_height < IMAGE_BAND_MIN_PIXELS) {
+		return 1;
+	}
+	return MIN(uint32_t(cores * 4), p_height);
+#endif
+}
+
+struct ImageRowsJob {
+
+	ImageRowsFunc func;
+	const uint8_t *src;
+	uint8_t *dst;
+	uint32_t src_width;
+	uint32_t src_height;
+	uint32_t dst_width;
+	uint32_t dst_height;
+	uint32_t band_height;
+
+	void process_band(uint32_t p_band, void *) {
+
+		uint32_t from = p_band * band_height;
+		func(src, dst, src_width, src_height, dst_width, dst_height, from, MIN(from + band_height, dst_height));
+	}
+};
+
+static void _process_rows(ImageRowsFunc p_func, const uint8_t *p_src, uint8_t *p_dst, uint32_t p_src_width, uint32_t p_src_height, uint32_t p_dst_width, uint32_t p_dst_height) {
+
+	uint32_t bands = _get_band_count(p_dst_width, p_dst_height);
+	if (bands <= 1) {
+		p_func(p_src, p_dst, p_src_width, p_src_height, p_dst_width, p_dst_height, 0, p_dst_height);
+		return;
+	}
+
+	ImageRowsJob job;
+	job.func = p_func;
+	job.src = p_src;
+	job.dst = p_dst;
+	job.src_width = p_src_width;
+	job.src_height = p_src_height;
+	job.dst_width = p_dst_width;
+	job.dst_height = p_dst_height;
+	job.band_height = (p_dst_height + bands - 1) / bands;
+
+	_image_do_work((p_dst_height + job.band_height - 1) / job.band_height, &job, &ImageRowsJob::process_band);
+}
+
 static double _bicubic_interp_kernel(double x) {
 
 	x = ABS(x);
@@ -538,71 +626,66 @@ static double _bicubic_interp_kernel(double x) {
 }
 
 template <int CC, class T>
-static void _scale_cubic(const uint8_t *__restrict p_src, uint8_t *__restrict p_dst, uint32_t p_src_width, uint32_t p_src_height, uint32_t p_dst_width, uint32_t p_dst_height) {
+static void _scale_cubic_rows(const uint8_t *__restrict p_src, uint8_t *__restrict p_dst, uint32_t p_src_width, uint32_t p_src_height, uint32_t p_dst_width, uint32_t p_dst_height, uint32_t p_from_row, uint32_t p_to_row) {
 
 	// get source image size
 	int width = p_src_width;
 	int height = p_src_height;
 	double xfac = (double)width / p_dst_width;
 	double yfac = (double)height / p_dst_height;
-	// coordinates of source points and coefficients
-	double ox, oy, dx, dy, k1, k2;
-	int ox1, oy1, ox2, oy2;
-	// destination pixel values
 	// width and height decreased by 1
 	int ymax = height - 1;
 	int xmax = width - 1;
-	// temporary pointer
 
-	for (uint32_t y = 0; y < p_dst_height; y++) {
+	// The X coefficients and clamped source offsets are the same for every row.
+	double *x_coefs = memnew_arr(double, p_dst_width * 4);
+	uint32_t *x_ofs = memnew_arr(uint32_t, p_dst_width * 4);
+
+	for (uint32_t x = 0; x < p_dst_width; x++) {
+		double ox = (double)x * xfac - 0.5f;
+		int ox1 = (int)ox;
+		double dx = ox - (double)ox1;
+
+		for (int m = -1; m < 3; m++) {
+			x_coefs[x * 4 + m + 1] = _bicubic_interp_kernel((double)m - dx);
+			x_ofs[x * 4 + m + 1] = CLAMP(ox1 + m, 0, xmax) * CC;
+		}
+	}
+
+	for (uint32_t y = p_from_row; y < p_to_row; y++) {
 		// Y coordinates
-		oy = (double)y * yfac - 0.5f;
-		oy1 = (int)oy;
-		dy = oy - (double)oy1;
+		double oy = (double)y * yfac - 0.5f;
+		int oy1 = (int)oy;
+		double dy = oy - (double)oy1;
 
-		for (uint32_t x = 0; x < p_dst_width; x++) {
-			// X coordinates
-			ox = (double)x * xfac - 0.5f;
-			ox1 = (int)ox;
-			dx = ox - (double)ox1;
+		double y_coefs[4];
+		const T *rows[4];
+		for (int n = -1; n < 3; n++) {
+			y_coefs[n + 1] = _bicubic_interp_kernel(dy - (double)n);
+			rows[n + 1] = ((const T *)p_src) + CLAMP(oy1 + n, 0, ymax) * p_src_width * CC;
+		}
 
-			// initial pixel value
+		T *__restrict dst = ((T *)p_dst) + y * p_dst_width * CC;
 
-			T *__restrict dst = ((T *)p_dst) + (y * p_dst_width + x) * CC;
+		for (uint32_t x = 0; x < p_dst_width; x++) {
 
 			double color[CC];
 			for (int i = 0; i < CC; i++) {
 				color[i] = 0;
 			}
 
-			for (int n = -1; n < 3; n++) {
-				// get Y coefficient
-				k1 = _bicubic_interp_kernel(dy - (double)n);
+			for (int n = 0; n < 4; n++) {
 
-				oy2 = oy1 + n;
-				if (oy2 < 0)
-					oy2 = 0;
-				if (oy2 > ymax)
-					oy2 = ymax;
+				for (int m = 0; m < 4; m++) {
 
-				for (int m = -1; m < 3; m++) {
-					// get X coefficient
-					k2 = k1 * _bicubic_interp_kernel((double)m - dx);
-
-					ox2 = ox1 + m;
-					if (ox2 < 0)
-						ox2 = 0;
-					if (ox2 > xmax)
-						ox2 = xmax;
-
-					// get pixel of original image
-					const T *__restrict p = ((T *)p_src) + (oy2 * p_src_width + ox2) * CC;
+					double k = y_coefs[n] * x_coefs[x * 4 + m];
+					const T *__restrict p = rows[n] + x_ofs[x * 4 + m];
 
 					for (int i = 0; i < CC; i++) {
 						if (sizeof(T) == 2) { //half float
-							color[i] = Math::half_to_float(p[i]);
+							color[i] += Math::half_to_float(p[i]) * k;
 						} else {
-							color[i] += p[i] * k2;
+							color[i] += p[i] * k;
 						}
 					}
 				}
@@ -617,12 +700,23 @@ static void _scale_cubic(const uint8_t *__restrict p_src, uint8_t *__restrict p_
 					dst[i] = color[i];
 				}
 			}
+
+			dst += CC;
 		}
 	}
+
+	memdelete_arr(x_coefs);
+	memdelete_arr(x_ofs);
 }
 
 template <int CC, class T>
-static void _scale_bilinear(const uint8_t *__restrict p_src, uint8_t *__restrict p_dst, uint32_t p_src_width, uint32_t p_src_height, uint32_t p_dst_width, uint32_t p_dst_height) {
+static void _scale_cubic(const uint8_t *__restrict p_src, uint8_t *__restrict p_dst, uint32_t p_src_width, uint32_t p_src_height, uint32_t p_dst_width, uint32_t p_dst_height) {
+
+	_process_rows(_scale_cubic_rows<CC, T>, p_src, p_dst, p_src_width, p_src_height, p_dst_width, p_dst_height);
+}
+
+template <int CC, class T>
+static void _scale_bilinear_rows(const uint8_t *__restrict p_src, uint8_t *__restrict p_dst, uint32_t p_src_width, uint32_t p_src_height, uint32_t p_dst_width, uint32_t p_dst_height, uint32_t p_from_row, uint32_t p_to_row) {
 
 	enum {
 		FRAC_BITS = 8,
@@ -631,7 +725,22 @@ static void _scale_bilinear(const uint8_t *__restrict p_src, uint8_t *__restrict
 
 	};
 
-	for (uint32_t i = 0; i < p_dst_height; i++) {
+	// The X offsets and fractions are the same for every row.
+	uint32_t *x_cols = memnew_arr(uint32_t, p_dst_width * 3);
+
+	for (uint32_t j = 0; j < p_dst_width; j++) {
+
+		uint32_t src_xofs_left_fp = (j * p_src_width * FRAC_LEN / p_dst_width);
+		uint32_t src_xofs_right = (j + 1) * p_src_width / p_dst_width;
+		if (src_xofs_right >= p_src_width)
+			src_xofs_right = p_src_width - 1;
+
+		x_cols[j * 3 + 0] = (src_xofs_left_fp >> FRAC_BITS) * CC;
+		x_cols[j * 3 + 1] = src_xofs_right * CC;
+		x_cols[j * 3 + 2] = src_xofs_left_fp & FRAC_MASK;
+	}
+
+	for (uint32_t i = p_from_row; i < p_to_row; i++) {
 
 		uint32_t src_yofs_up_fp = (i * p_src_height * FRAC_LEN / p_dst_height);
 		uint32_t src_yofs_frac = src_yofs_up_fp & FRAC_MASK;
@@ -641,81 +750,77 @@ static void _scale_bilinear(const uint8_t *__restrict p_src, uint8_t *__restrict
 		if (src_yofs_down >= p_src_height)
 			src_yofs_down = p_src_height - 1;
 
-		//src_yofs_up*=CC;
-		//src_yofs_down*=CC;
+		const T *src_up = ((const T *)p_src) + src_yofs_up * p_src_width * CC;
+		const T *src_down = ((const T *)p_src) + src_yofs_down * p_src_width * CC;
+		T *dst = ((T *)p_dst) + i * p_dst_width * CC;
 
-		uint32_t y_ofs_up = src_yofs_up * p_src_width * CC;
-		uint32_t y_ofs_down = src_yofs_down * p_src_width * CC;
+		float yofs_frac = float(src_yofs_frac) / (1 << FRAC_BITS);
 
 		for (uint32_t j = 0; j < p_dst_width; j++) {
 
-			uint32_t src_xofs_left_fp = (j * p_src_width * FRAC_LEN / p_dst_width);
-			uint32_t src_xofs_frac = src_xofs_left_fp & FRAC_MASK;
-			uint32_t src_xofs_left = src_xofs_left_fp >> FRAC_BITS;
-			uint32_t src_xofs_right = (j + 1) * p_src_width / p_dst_width;
-			if (src_xofs_right >= p_src_width)
-				src_xofs_right = p_src_width - 1;
-
-			src_xofs_left *= CC;
-			src_xofs_right *= CC;
+			uint32_t src_xofs_left = x_cols[j * 3 + 0];
+			uint32_t src_xofs_right = x_cols[j * 3 + 1];
+			uint32_t src_xofs_frac = x_cols[j * 3 + 2];
 
 			for (uint32_t l = 0; l < CC; l++) {
 
 				if (sizeof(T) == 1) { //uint8
-					uint32_t p00 = p_src[y_ofs_up + src_xofs_left + l] << FRAC_BITS;
-					uint32_t p10 = p_src[y_ofs_up + src_xofs_right + l] << FRAC_BITS;
-					uint32_t p01 = p_src[y_ofs_down + src_xofs_left + l] << FRAC_BITS;
-					uint32_t p11 = p_src[y_ofs_down + src_xofs_right + l] << FRAC_BITS;
+					uint32_t p00 = uint32_t(((const uint8_t *)src_up)[src_xofs_left + l]) << FRAC_BITS;
+					uint32_t p10 = uint32_t(((const uint8_t *)src_up)[src_xofs_right + l]) << FRAC_BITS;
+					uint32_t p01 = uint32_t(((const uint8_t *)src_down)[src_xofs_left + l]) << FRAC_BITS;
+					uint32_t p11 = uint32_t(((const uint8_t *)src_down)[src_xofs_right + l]) << FRAC_BITS;
 
 					uint32_t interp_up = p00 + (((p10 - p00) * src_xofs_frac) >> FRAC_BITS);
 					uint32_t interp_down = p01 + (((p11 - p01) * src_xofs_frac) >> FRAC_BITS);
 					uint32_t interp = interp_up + (((interp_down - interp_up) * src_yofs_frac) >> FRAC_BITS);
 					interp >>= FRAC_BITS;
-					p_dst[i * p_dst_width * CC + j * CC + l] = interp;
+					((uint8_t *)dst)[j * CC + l] = interp;
 				} else if (sizeof(T) == 2) { //half float
 
 					float xofs_frac = float(src_xofs_frac) / (1 << FRAC_BITS);
-					float yofs_frac = float(src_yofs_frac) / (1 << FRAC_BITS);
-					const T *src = ((const T *)p_src);
-					T *dst = ((T *)p_dst);
 
-					float p00 = Math::half_to_float(src[y_ofs_up + src_xofs_left + l]);
-					float p10 = Math::half_to_float(src[y_ofs_up + src_xofs_right + l]);
-					float p01 = Math::half_to_float(src[y_ofs_down + src_xofs_left + l]);
-					float p11 = Math::half_to_float(src[y_ofs_down + src_xofs_right + l]);
+					float p00 = Math::half_to_float(src_up[src_xofs_left + l]);
+					float p10 = Math::half_to_float(src_up[src_xofs_right + l]);
+					float p01 = Math::half_to_float(src_down[src_xofs_left + l]);
+					float p11 = Math::half_to_float(src_down[src_xofs_right + l]);
 
 					float interp_up = p00 + (p10 - p00) * xofs_frac;
 					float interp_down = p01 + (p11 - p01) * xofs_frac;
 					float interp = interp_up + ((interp_down - interp_up) * yofs_frac);
 
-					dst[i * p_dst_width * CC + j * CC + l] = Math::make_half_float(interp);
+					dst[j * CC + l] = Math::make_half_float(interp);
 				} else if (sizeof(T) == 4) { //float
 
 					float xofs_frac = float(src_xofs_frac) / (1 << FRAC_BITS);
-					float yofs_frac = float(src_yofs_frac) / (1 << FRAC_BITS);
-					const T *src = ((const T *)p_src);
-					T *dst = ((T *)p_dst);
 
-					float p00 = src[y_ofs_up + src_xofs_left + l];
-					float p10 = src[y_ofs_up + src_xofs_right + l];
-					float p01 = src[y_ofs_down + src_xofs_left + l];
-					float p11 = src[y_ofs_down + src_xofs_right + l];
+					float p00 = src_up[src_xofs_left + l];
+					float p10 = src_up[src_xofs_right + l];
+					float p01 = src_down[src_xofs_left + l];
+					float p11 = src_down[src_xofs_right + l];
 
 					float interp_up = p00 + (p10 - p00) * xofs_frac;
 					float interp_down = p01 + (p11 - p01) * xofs_frac;
 					float interp = interp_up + ((interp_down - interp_up) * yofs_frac);
 
-					dst[i * p_dst_width * CC + j * CC + l] = interp;
+					dst[j * CC + l] = interp;
 				}
 			}
 		}
 	}
+
+	memdelete_arr(x_cols);
 }
 
 template <int CC, class T>
-static void _scale_nearest(const uint8_t *__restrict p_src, uint8_t *__restrict p_dst, uint32_t p_src_width, uint32_t p_src_height, uint32_t p_dst_width, uint32_t p_dst_height) {
+static void _scale_bilinear(const uint8_t *__restrict p_src, uint8_t *__restrict p_dst, uint32_t p_src_width, uint32_t p_src_height, uint32_t p_dst_width, uint32_t p_dst_height) {
 
-	for (uint32_t i = 0; i < p_dst_height; i++) {
+	_process_rows(_scale_bilinear_rows<CC, T>, p_src, p_dst, p_src_width, p_src_height, p_dst_width, p_dst_height);
+}
+
+template <int CC, class T>
+static void _scale_nearest_rows(const uint8_t *__restrict p_src, uint8_t *__restrict p_dst, uint32_t p_src_width, uint32_t p_src_height, uint32_t p_dst_width, uint32_t p_dst_height, uint32_t p_from_row, uint32_t p_to_row) {
+
+	for (uint32_t i = p_from_row; i < p_to_row; i++) {
 
 		uint32_t src_yofs = i * p_src_height / p_dst_height;
 		uint32_t y_ofs = src_yofs * p_src_width * CC;
@@ -737,6 +842,12 @@ static void _scale_nearest(const uint8_t *__restrict p_src, uint8_t *__restrict
 	}
 }
 
+template <int CC, class T>
+static void _scale_nearest(const uint8_t *__restrict p_src, uint8_t *__restrict p_dst, uint32_t p_src_width, uint32_t p_src_height, uint32_t p_dst_width, uint32_t p_dst_height) {
+
+	_process_rows(_scale_nearest_rows<CC, T>, p_src, p_dst, p_src_width, p_src_height, p_dst_width, p_dst_height);
+}
+
 #define LANCZOS_TYPE 3
 
 static float _lanczos(float p_x) {
@@ -744,47 +855,47 @@ static float _lanczos(float p_x) {
 }
 
 template <int CC, class T>
-static void _scale_lanczos(const uint8_t *__restrict p_src, uint8_t *__restrict p_dst, uint32_t p_src_width, uint32_t p_src_height, uint32_t p_dst_width, uint32_t p_dst_height) {
-
-	int32_t src_width = p_src_width;
-	int32_t src_height = p_src_height;
-	int32_t dst_height = p_dst_height;
-	int32_t dst_width = p_dst_width;
+struct ImageLanczosJob {
 
-	uint32_t buffer_size = src_height * dst_width * CC;
-	float *buffer = memnew_arr(float, buffer_size); // Store the first pass in a buffer
+	const uint8_t *src;
+	uint8_t *dst;
+	float *buffer; // First pass result, src_height rows of dst_width pixels.
+	int32_t src_width;
+	int32_t src_height;
+	int32_t dst_width;
+	int32_t dst_height;
 
-	{ // FIRST PASS (horizontal)
+	// Horizontal kernels of all the columns, each one starting at column * kernel_size.
+	float *x_kernels;
+	float *x_weights;
+	int32_t *x_starts;
+	int32_t *x_ends;
+	int32_t x_kernel_size;
 
-		float x_scale = float(src_width) / float(dst_width);
+	uint32_t band_height;
 
-		float scale_factor = MAX(x_scale, 1); // A larger kernel is required only when downscaling
-		int32_t half_kernel = LANCZOS_TYPE * scale_factor;
+	void horizontal_band(uint32_t p_band, void *) {
 
-		float *kernel = memnew_arr(float, half_kernel * 2);
+		int32_t from = p_band * band_height;
+		int32_t to = MIN(from + int32_t(band_height), src_height);
 
-		for (int32_t buffer_x = 0; buffer_x < dst_width; buffer_x++) {
+		for (int32_t buffer_y = from; buffer_y < to; buffer_y++) {
 
-			// The corresponding point on the source image
-			float src_x = (buffer_x + 0.5f) * x_scale; // Offset by 0.5 so it uses the pixel's center
-			int32_t start_x = MAX(0, int32_t(src_x) - half_kernel + 1);
-			int32_t end_x = MIN(src_width - 1, int32_t(src_x) + half_kernel);
+			const T *__restrict src_row = ((const T *)src) + buffer_y * src_width * CC;
+			float *__restrict dst_data = buffer + buffer_y * dst_width * CC;
 
-			// Create the kernel used by all the pixels of the column
-			for (int32_t target_x = start_x; target_x <= end_x; target_x++)
-				kernel[target_x - start_x] = _lanczos((target_x + 0.5f - src_x) / scale_factor);
+			for (int32_t buffer_x = 0; buffer_x < dst_width; buffer_x++) {
 
-			for (int32_t buffer_y = 0; buffer_y < src_height; buffer_y++) {
+				const float *kernel = x_kernels + buffer_x * x_kernel_size;
+				int32_t start_x = x_starts[buffer_x];
+				int32_t end_x = x_ends[buffer_x];
 
 				float pixel[CC] = { 0 };
-				float weight = 0;
 
 				for (int32_t target_x = start_x; target_x <= end_x; target_x++) {
 
 					float lanczos_val = kernel[target_x - start_x];
-					weight += lanczos_val;
-
-					const T *__restrict src_data = ((const T *)p_src) + (buffer_y * src_width + target_x) * CC;
+					const T *__restrict src_data = src_row + target_x * CC;
 
 					for (uint32_t i = 0; i < CC; i++) {
 						if (sizeof(T) == 2) //half float
@@ -794,17 +905,18 @@ static void _scale_lanczos(const uint8_t *__restrict p_src, uint8_t *__restrict
 					}
 				}
 
-				float *dst_data = ((float *)buffer) + (buffer_y * dst_width + buffer_x) * CC;
-
 				for (uint32_t i = 0; i < CC; i++)
-					dst_data[i] = pixel[i] / weight; // Normalize the sum of all the samples
+					dst_data[i] = pixel[i] / x_weights[buffer_x]; // Normalize the sum of all the samples
+
+				dst_data += CC;
 			}
 		}
+	}
 
-		memdelete_arr(kernel);
-	} // End of first pass
+	void vertical_band(uint32_t p_band, void *) {
 
-	{ // SECOND PASS (vertical + result)
+		int32_t from = p_band * band_height;
+		int32_t to = MIN(from + int32_t(band_height), dst_height);
 
 		float y_scale = float(src_height) / float(dst_height);
 
@@ -813,32 +925,33 @@ static void _scale_lanczos(const uint8_t *__restrict p_src, uint8_t *__restrict
 
 		float *kernel = memnew_arr(float, half_kernel * 2);
 
-		for (int32_t dst_y = 0; dst_y < dst_height; dst_y++) {
+		for (int32_t dst_y = from; dst_y < to; dst_y++) {
 
 			float buffer_y = (dst_y + 0.5f) * y_scale;
 			int32_t start_y = MAX(0, int32_t(buffer_y) - half_kernel + 1);
 			int32_t end_y = MIN(src_height - 1, int32_t(buffer_y) + half_kernel);
 
-			for (int32_t target_y = start_y; target_y <= end_y; target_y++)
+			float weight = 0;
+			for (int32_t target_y = start_y; target_y <= end_y; target_y++) {
 				kernel[target_y - start_y] = _lanczos((target_y + 0.5f - buffer_y) / scale_factor);
+				weight += kernel[target_y - start_y];
+			}
 
 			for (int32_t dst_x = 0; dst_x < dst_width; dst_x++) {
 
 				float pixel[CC] = { 0 };
-				float weight = 0;
 
 				for (int32_t target_y = start_y; target_y <= end_y; target_y++) {
 
 					float lanczos_val = kernel[target_y - start_y];
-					weight += lanczos_val;
 
-					float *buffer_data = ((float *)buffer) + (target_y * dst_width + dst_x) * CC;
+					float *buffer_data = buffer + (target_y * dst_width + dst_x) * CC;
 
 					for (uint32_t i = 0; i < CC; i++)
 						pixel[i] += buffer_data[i] * lanczos_val;
 				}
 
-				T *dst_data = ((T *)p_dst) + (dst_y * dst_width + dst_x) * CC;
+				T *dst_data = ((T *)dst) + (dst_y * dst_width + dst_x) * CC;
 
 				for (uint32_t i = 0; i < CC; i++) {
 					pixel[i] /= weight;
@@ -854,9 +967,73 @@ static void _scale_lanczos(const uint8_t *__restrict p_src, uint8_t *__restrict
 		}
 
 		memdelete_arr(kernel);
+	}
+};
+
+template <int CC, class T>
+static void _scale_lanczos(const uint8_t *__restrict p_src, uint8_t *__restrict p_dst, uint32_t p_src_width, uint32_t p_src_height, uint32_t p_dst_width, uint32_t p_dst_height) {
+
+	ImageLanczosJob<CC, T> job;
+	job.src = p_src;
+	job.dst = p_dst;
+	job.src_width = p_src_width;
+	job.src_height = p_src_height;
+	job.dst_width = p_dst_width;
+	job.dst_height = p_dst_height;
+
+	job.buffer = memnew_arr(float, p_src_height * p_dst_width * CC); // Store the first pass in a buffer
+
+	{ // FIRST PASS (horizontal)
+
+		float x_scale = float(job.src_width) / float(job.dst_width);
+
+		float scale_factor = MAX(x_scale, 1); // A larger kernel is required only when downscaling
+		int32_t half_kernel = LANCZOS_TYPE * scale_factor;
+
+		// Create the kernels used by all the pixels of each column
+		job.x_kernel_size = half_kernel * 2;
+		job.x_kernels = memnew_arr(float, job.dst_width * job.x_kernel_size);
+		job.x_weights = memnew_arr(float, job.dst_width);
+		job.x_starts = memnew_arr(int32_t, job.dst_width);
+		job.x_ends = memnew_arr(int32_t, job.dst_width);
+
+		for (int32_t buffer_x = 0; buffer_x < job.dst_width; buffer_x++) {
+
+			// The corresponding point on the source image
+			float src_x = (buffer_x + 0.5f) * x_scale; // Offset by 0.5 so it uses the pixel's center
+			int32_t start_x = MAX(0, int32_t(src_x) - half_kernel + 1);
+			int32_t end_x = MIN(job.src_width - 1, int32_t(src_x) + half_kernel);
+
+			float *kernel = job.x_kernels + buffer_x * job.x_kernel_size;
+			float weight = 0;
+			for (int32_t target_x = start_x; target_x <= end_x; target_x++) {
+				kernel[target_x - start_x] = _lanczos((target_x + 0.5f - src_x) / scale_factor);
+				weight += kernel[target_x - start_x];
+			}
+
+			job.x_weights[buffer_x] = weight;
+			job.x_starts[buffer_x] = start_x;
+			job.x_ends[buffer_x] = end_x;
+		}
+
+		uint32_t bands = _get_band_count(p_dst_width, p_src_height);
+		job.band_height = (p_src_height + bands - 1) / bands;
+		_image_do_work((p_src_height + job.band_height - 1) / job.band_height, &job, &ImageLanczosJob<CC, T>::horizontal_band);
+
+		memdelete_arr(job.x_kernels);
+		memdelete_arr(job.x_weights);
+		memdelete_arr(job.x_starts);
+		memdelete_arr(job.x_ends);
+	} // End of first pass
+
+	{ // SECOND PASS (vertical + result)
+
+		uint32_t bands = _get_band_count(p_dst_width, p_dst_height);
+		job.band_height = (p_dst_height + bands - 1) / bands;
+		_image_do_work((p_dst_height + job.band_height - 1) / job.band_height, &job, &ImageLanczosJob<CC, T>::vertical_band);
 	} // End of second pass
 
-	memdelete_arr(buffer);
+	memdelete_arr(job.buffer);
 }
 
 static void _overlay(const uint8_t *__restrict p_src, uint8_t *__restrict p_dst, float p_alpha, uint32_t p_width, uint32_t p_height, uint32_t p_pixel_size) {
@@ -1284,21 +1461,21 @@ bool Image::_can_modify(Format p_format) const {
 template <class Component, int CC, bool renormalize,
 		void (*average_func)(Component &, const Component &, const Component &, const Component &, const Component &),
 		void (*renormalize_func)(Component *)>
-static void _generate_po2_mipmap(const Component *p_src, Component *p_dst, uint32_t p_width, uint32_t p_height) {
+static void _generate_po2_mipmap_rows(const uint8_t *__restrict p_src, uint8_t *__restrict p_dst, uint32_t p_width, uint32_t p_height, uint32_t p_dst_width, uint32_t p_dst_height, uint32_t p_from_row, uint32_t p_to_row) {
 
 	//fast power of 2 mipmap generation
-	uint32_t dst_w = MAX(p_width >> 1, 1);
-	uint32_t dst_h = MAX(p_height >> 1, 1);
+	const Component *src = reinterpret_cast<const Component *>(p_src);
+	Component *dst = reinterpret_cast<Component *>(p_dst);
 
 	int right_step = (p_width == 1) ? 0 : CC;
 	int down_step = (p_height == 1) ? 0 : (p_width * CC);
 
-	for (uint32_t i = 0; i < dst_h; i++) {
+	for (uint32_t i = p_from_row; i < p_to_row; i++) {
 
-		const Component *rup_ptr = &p_src[i * 2 * down_step];
+		const Component *rup_ptr = &src[i * 2 * down_step];
 		const Component *rdown_ptr = rup_ptr + down_step;
-		Component *dst_ptr = &p_dst[i * dst_w * CC];
-		uint32_t count = dst_w;
+		Component *dst_ptr = &dst[i * p_dst_width * CC];
+		uint32_t count = p_dst_width;
 
 		while (count) {
 			count--;
@@ -1317,6 +1494,93 @@ static void _generate_po2_mipmap(const Component *p_src, Component *p_dst, uint3
 	}
 }
 
+template <class Component, int CC, bool renormalize,
+		void (*average_func)(Component &, const Component &, const Component &, const Component &, const Component &),
+		void (*renormalize_func)(Component *)>
+static void _generate_po2_mipmap(const Component *p_src, Component *p_dst, uint32_t p_width, uint32_t p_height) {
+
+	_process_rows(_generate_po2_mipmap_rows<Component, CC, renormalize, average_func, renormalize_func>, reinterpret_cast<const uint8_t *>(p_src), reinterpret_cast<uint8_t *>(p_dst), p_width, p_height, MAX(p_width >> 1, 1), MAX(p_height >> 1, 1));
+}
+
+// 8-bit sRGB values and their linear intensity, to average colors in linear space.
+struct ImageSRGBTables {
+
+	float to_linear[256];
+	float thresholds[255]; // Halfway between the linear intensities of consecutive values.
+
+	_FORCE_INLINE_ uint8_t to_srgb(float p_linear) const {
+
+		// Nearest value, found by binary search.
+		int from = 0;
+		int to = 255;
+		while (from < to) {
+			int middle = (from + to) >> 1;
+			if (p_linear > thresholds[middle]) {
+				from = middle + 1;
+			} else {
+				to = middle;
+			}
+		}
+		return from;
+	}
+
+	ImageSRGBTables() {
+
+		for (int i = 0; i < 256; i++) {
+			float c = i / 255.0f;
+			to_linear[i] = c < 0.04045f ? c * (1.0f / 12.92f) : Math::pow((c + 0.055f) * (1.0f / 1.055f), 2.4f);
+		}
+		for (int i = 0; i < 255; i++) {
+			thresholds[i] = (to_linear[i] + to_linear[i + 1]) * 0.5f;
+		}
+	}
+};
+
+static const ImageSRGBTables &_get_srgb_tables() {
+
+	static ImageSRGBTables tables;
+	return tables;
+}
+
+template <int CC>
+static void _generate_po2_mipmap_srgb_rows(const uint8_t *__restrict p_src, uint8_t *__restrict p_dst, uint32_t p_width, uint32_t p_height, uint32_t p_dst_width, uint32_t p_dst_height, uint32_t p_from_row, uint32_t p_to_row) {
+
+	// Alpha, the last channel of two and four channel formats, is not gamma encoded.
+	const int color_channels = (CC == 2 || CC == 4) ? CC - 1 : CC;
+	const ImageSRGBTables &tables = _get_srgb_tables();
+
+	int right_step = (p_width == 1) ? 0 : CC;
+	int down_step = (p_height == 1) ? 0 : (p_width * CC);
+
+	for (uint32_t i = p_from_row; i < p_to_row; i++) {
+
+		const uint8_t *rup_ptr = &p_src[i * 2 * down_step];
+		const uint8_t *rdown_ptr = rup_ptr + down_step;
+		uint8_t *dst_ptr = &p_dst[i * p_dst_width * CC];
+
+		for (uint32_t count = p_dst_width; count; count--) {
+
+			for (int j = 0; j < color_channels; j++) {
+				float linear = tables.to_linear[rup_ptr[j]] + tables.to_linear[rup_ptr[j + right_step]] + tables.to_linear[rdown_ptr[j]] + tables.to_linear[rdown_ptr[j + right_step]];
+				dst_ptr[j] = tables.to_srgb(linear * 0.25f);
+			}
+			for (int j = color_channels; j < CC; j++) {
+				dst_ptr[j] = (rup_ptr[j] + rup_ptr[j + right_step] + rdown_ptr[j] + rdown_ptr[j + right_step] + 2) >> 2;
+			}
+
+			dst_ptr += CC;
+			rup_ptr += right_step * 2;
+			rdown_ptr += right_step * 2;
+		}
+	}
+}
+
+template <int CC>
+static void _generate_po2_mipmap_srgb(const uint8_t *p_src, uint8_t *p_dst, uint32_t p_width, uint32_t p_height) {
+
+	_process_rows(_generate_po2_mipmap_srgb_rows<CC>, p_src, p_dst, p_width, p_height, MAX(p_width >> 1, 1), MAX(p_height >> 1, 1));
+}
+
 void Image::expand_x2_hq2x() {
 
 	ERR_FAIL_COND(!_can_modify(format));
@@ -1454,7 +1718,7 @@ void Image::normalize() {
 	}
 }
 
-Error Image::generate_mipmaps(bool p_renormalize) {
+Error Image::generate_mipmaps(bool p_renormalize, bool p_srgb) {
 
 	ERR_FAIL_COND_V_MSG(!_can_modify(format), ERR_UNAVAILABLE, "Cannot generate mipmaps in compressed or custom image formats.");
 
@@ -1482,12 +1746,24 @@ Error Image::generate_mipmaps(bool p_renormalize) {
 		switch (format) {
 
 			case FORMAT_L8:
+				if (p_srgb)
+					_generate_po2_mipmap_srgb<1>(&wp[prev_ofs], &wp[ofs], prev_w, prev_h);
+				else
+					_generate_po2_mipmap<uint8_t, 1, false, Image::average_4_uint8, Image::renormalize_uint8>(&wp[prev_ofs], &wp[ofs], prev_w, prev_h);
+				break;
 			case FORMAT_R8: _generate_po2_mipmap<uint8_t, 1, false, Image::average_4_uint8, Image::renormalize_uint8>(&wp[prev_ofs], &wp[ofs], prev_w, prev_h); break;
 			case FORMAT_LA8:
+				if (p_srgb)
+					_generate_po2_mipmap_srgb<2>(&wp[prev_ofs], &wp[ofs], prev_w, prev_h);
+				else
+					_generate_po2_mipmap<uint8_t, 2, false, Image::average_4_uint8, Image::renormalize_uint8>(&wp[prev_ofs], &wp[ofs], prev_w, prev_h);
+				break;
 			case FORMAT_RG8: _generate_po2_mipmap<uint8_t, 2, false, Image::average_4_uint8, Image::renormalize_uint8>(&wp[prev_ofs], &wp[ofs], prev_w, prev_h); break;
 			case FORMAT_RGB8:
 				if (p_renormalize)
 					_generate_po2_mipmap<uint8_t, 3, true, Image::average_4_uint8, Image::renormalize_uint8>(&wp[prev_ofs], &wp[ofs], prev_w, prev_h);
+				else if (p_srgb)
+					_generate_po2_mipmap_srgb<3>(&wp[prev_ofs], &wp[ofs], prev_w, prev_h);
 				else
 					_generate_po2_mipmap<uint8_t, 3, false, Image::average_4_uint8, Image::renormalize_uint8>(&wp[prev_ofs], &wp[ofs], prev_w, prev_h);
 
@@ -1495,6 +1771,8 @@ Error Image::generate_mipmaps(bool p_renormalize) {
 			case FORMAT_RGBA8:
 				if (p_renormalize)
 					_generate_po2_mipmap<uint8_t, 4, true, Image::average_4_uint8, Image::renormalize_uint8>(&wp[prev_ofs], &wp[ofs], prev_w, prev_h);
+				else if (p_srgb)
+					_generate_po2_mipmap_srgb<4>(&wp[prev_ofs], &wp[ofs], prev_w, prev_h);
 				else
 					_generate_po2_mipmap<uint8_t, 4, false, Image::average_4_uint8, Image::renormalize_uint8>(&wp[prev_ofs], &wp[ofs], prev_w, prev_h);
 				break;
@@ -1780,6 +2058,11 @@ Vector<uint8_t> Image::get_data() const {
 	return data;
 }
 
+uint64_t Image::get_memory_size_estimate() const {
+
+	return sizeof(Image) + data.size();
+}
+
 void Image::create(int p_width, int p_height, bool p_use_mipmaps, Format p_format) {
 
 	ERR_FAIL_INDEX(p_width - 1, MAX_WIDTH);
@@ -2225,6 +2508,83 @@ Error Image::compress_from_channels(CompressMode p_mode, UsedChannels p_channels
 	return OK;
 }
 
+struct ImageCompressBlocksJob {
+
+	struct Row {
+		const uint8_t *src; // Mipmap level.
+		uint8_t *dst;
+		int width;
+		int height;
+		int y;
+	};
+
+	const Row *rows;
+	Image::CompressBlocksFunc func;
+	void *userdata;
+
+	void compress_row(uint32_t p_index, void *) {
+
+		const Row &row = rows[p_index];
+		func(row.src, row.width, row.height, row.y, MIN(row.y + 4, row.height), row.dst, userdata);
+	}
+};
+
+void Image::compress_blocks(Format p_target_format, CompressBlocksFunc p_func, void *p_userdata) {
+
+	ERR_FAIL_COND_MSG(!_can_modify(format), "Cannot compress from compressed or custom image formats.");
+	ERR_FAIL_COND(get_format_block_size(p_target_format) != 4);
+
+	int w = width;
+	int h = height;
+	int shift = get_format_pixel_rshift(p_target_format);
+	int mm_count = mipmaps ? get_image_required_mipmaps(width, height, p_target_format) : 0;
+
+	Vector<uint8_t> dst_data;
+	dst_data.resize(get_image_data_size(width, height, p_target_format, mipmaps));
+
+	const uint8_t *rb = data.ptr();
+	uint8_t *wb = dst_data.ptrw();
+	int dst_ofs = 0;
+
+	Vector<ImageCompressBlocksJob::Row> rows;
+
+	for (int i = 0; i <= mm_count; i++) {
+
+		int bw = w % 4 != 0 ? w + (4 - w % 4) : w;
+		int bh = h % 4 != 0 ? h + (4 - h % 4) : h;
+
+		ImageCompressBlocksJob::Row row;
+		row.src = &rb[get_mipmap_offset(i)];
+		row.width = w;
+		row.height = h;
+
+		for (int y = 0; y < h; y += 4) {
+			row.y = y;
+			row.dst = &wb[dst_ofs + ((y * bw) >> shift)];
+			rows.push_back(row);
+		}
+
+		dst_ofs += (MAX(4, bw) * MAX(4, bh)) >> shift;
+		w = MAX(w / 2, 1);
+		h = MAX(h / 2, 1);
+	}
+
+	ImageCompressBlocksJob job;
+	job.rows = rows.ptr();
+	job.func = p_func;
+	job.userdata = p_userdata;
+
+	if (OS::get_singleton()->can_use_threads() && OS::get_singleton()->get_processor_count() > 1) {
+		_image_do_work(rows.size(), &job, &ImageCompressBlocksJob::compress_row);
+	} else {
+		for (int i = 0; i < rows.size(); i++) {
+			job.compress_row(i, NULL);
+		}
+	}
+
+	create(width, height, mipmaps, p_target_format, dst_data);
+}
+
 Image::Image(const char **p_xpm) {
 
 	width = 0;
@@ -2928,7 +3288,7 @@ void Image::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("crop", "width", "height"), &Image::crop);
 	ClassDB::bind_method(D_METHOD("flip_x"), &Image::flip_x);
 	ClassDB::bind_method(D_METHOD("flip_y"), &Image::flip_y);
-	ClassDB::bind_method(D_METHOD("generate_mipmaps", "renormalize"), &Image::generate_mipmaps, DEFVAL(false));
+	ClassDB::bind_method(D_METHOD("generate_mipmaps", "renormalize", "srgb"), &Image::generate_mipmaps, DEFVAL(false), DEFVAL(false));
 	ClassDB::bind_method(D_METHOD("clear_mipmaps"), &Image::clear_mipmaps);
 
 	ClassDB::bind_method(D_METHOD("create", "width", "height", "use_mipmaps", "format"), &Image::_create_empty);
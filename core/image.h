@@ -249,7 +249,7 @@ public:
 	/**
 	 * Generate a mipmap to an image (creates an image 1/4 the size, with averaging of 4->1)
 	 */
-	Error generate_mipmaps(bool p_renormalize = false);
+	Error generate_mipmaps(bool p_renormalize = false, bool p_srgb = false);
 
 	enum RoughnessChannel {
 		ROUGHNESS_CHANNEL_R,
@@ -277,6 +277,7 @@ public:
 	bool empty() const;
 
 	Vector<uint8_t> get_data() const;
+	virtual uint64_t get_memory_size_estimate() const;
 
 	Error load(const String &p_path);
 	Error save_png(const String &p_path) const;
@@ -333,6 +334,14 @@ public:
 	Error compress(CompressMode p_mode, CompressSource p_source = COMPRESS_SOURCE_GENERIC, float p_lossy_quality = 0.7);
 	Error compress_from_channels(CompressMode p_mode, UsedChannels p_channels, float p_lossy_quality = 0.7);
 	Error decompress();
+
+	// Compresses pixel rows p_from_y to p_to_y (at most one row of 4x4 blocks) of a mipmap
+	// level starting at p_src, writing the blocks of that row to p_dst.
+	typedef void (*CompressBlocksFunc)(const uint8_t *p_src, int p_width, int p_height, int p_from_y, int p_to_y, uint8_t *p_dst, void *p_userdata);
+	// For compressors of formats whose blocks are encoded independently: converts every
+	// mipmap to p_target_format calling p_func on each row of blocks, spread over all cores.
+	void compress_blocks(Format p_target_format, CompressBlocksFunc p_func, void *p_userdata);
+	static void finish_work_pool();
 	bool is_compressed() const;
 
 	void fix_alpha_edges();
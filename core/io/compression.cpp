@@ -39,7 +39,7 @@
 #include <zlib.h>
 #include <zstd.h>
 
-int Compression::compress(uint8_t *p_dst, const uint8_t *p_src, int p_src_size, Mode p_mode) {
+int Compression::compress(uint8_t *p_dst, const uint8_t *p_src, int p_src_size, Mode p_mode, const Vector<uint8_t> &p_zstd_dictionary) {
 
 	switch (p_mode) {
 		case MODE_FASTLZ: {
@@ -87,7 +87,12 @@ int Compression::compress(uint8_t *p_dst, const uint8_t *p_src, int p_src_size,
 				ZSTD_CCtx_setParameter(cctx, ZSTD_c_windowLog, zstd_window_log_size);
 			}
 			int max_dst_size = get_max_compressed_buffer_size(p_src_size, MODE_ZSTD);
-			int ret = ZSTD_compressCCtx(cctx, p_dst, max_dst_size, p_src, p_src_size, zstd_level);
+			int ret;
+			if (p_zstd_dictionary.size()) {
+				ret = ZSTD_compress_usingDict(cctx, p_dst, max_dst_size, p_src, p_src_size, p_zstd_dictionary.ptr(), p_zstd_dictionary.size(), zstd_level);
+			} else {
+				ret = ZSTD_compressCCtx(cctx, p_dst, max_dst_size, p_src, p_src_size, zstd_level);
+			}
 			ZSTD_freeCCtx(cctx);
 			return ret;
 		} break;
@@ -132,7 +137,7 @@ int Compression::get_max_compressed_buffer_size(int p_src_size, Mode p_mode) {
 	ERR_FAIL_V(-1);
 }
 
-int Compression::decompress(uint8_t *p_dst, int p_dst_max_size, const uint8_t *p_src, int p_src_size, Mode p_mode) {
+int Compression::decompress(uint8_t *p_dst, int p_dst_max_size, const uint8_t *p_src, int p_src_size, Mode p_mode, const Vector<uint8_t> &p_zstd_dictionary) {
 
 	switch (p_mode) {
 		case MODE_FASTLZ: {
@@ -178,7 +183,12 @@ int Compression::decompress(uint8_t *p_dst, int p_dst_max_size, const uint8_t *p
 			if (zstd_long_distance_matching) {
 				ZSTD_DCtx_setParameter(dctx, ZSTD_d_windowLogMax, zstd_window_log_size);
 			}
-			int ret = ZSTD_decompressDCtx(dctx, p_dst, p_dst_max_size, p_src, p_src_size);
+			int ret;
+			if (p_zstd_dictionary.size()) {
+				ret = ZSTD_decompress_usingDict(dctx, p_dst, p_dst_max_size, p_src, p_src_size, p_zstd_dictionary.ptr(), p_zstd_dictionary.size());
+			} else {
+				ret = ZSTD_decompressDCtx(dctx, p_dst, p_dst_max_size, p_src, p_src_size);
+			}
 			ZSTD_freeDCtx(dctx);
 			return ret;
 		} break;
@@ -30,9 +30,29 @@
 
 #include "file_access_compressed.h"
 
+#include "core/hashfuncs.h"
+#include "core/os/os.h"
 #include "core/print_string.h"
 
-void FileAccessCompressed::configure(const String &p_magic, Compression::Mode p_mode, int p_block_size) {
+// Set in the compression mode of files written with a Zstandard dictionary, followed by the hash of the dictionary.
+#define COMPRESSED_ZSTD_DICTIONARY (1 << 16)
+// Batches of blocks smaller than this are decompressed on the calling thread.
+#define PARALLEL_DECOMPRESS_MIN_SIZE (256 * 1024)
+
+int FileAccessCompressed::default_block_size = 4096;
+int FileAccessCompressed::read_ahead_blocks = 64;
+
+ThreadWorkPool FileAccessCompressed::decompress_pool;
+std::atomic<bool> FileAccessCompressed::decompress_pool_busy(false);
+bool FileAccessCompressed::decompress_pool_started = false;
+
+void FileAccessCompressed::finish_decompress_pool() {
+
+	decompress_pool.finish();
+	decompress_pool_started = false;
+}
+
+void FileAccessCompressed::configure(const String &p_magic, Compression::Mode p_mode, int p_block_size, const Vector<uint8_t> &p_zstd_dictionary) {
 
 	magic = p_magic.ascii().get_data();
 	if (magic.length() > 4)
@@ -43,7 +63,8 @@ void FileAccessCompressed::configure(const String &p_magic, Compression::Mode p_
 	}
 
 	cmode = p_mode;
-	block_size = p_block_size;
+	block_size = p_block_size > 0 ? p_block_size : default_block_size;
+	zstd_dictionary = p_zstd_dictionary;
 }
 
 #define WRITE_FIT(m_bytes)                                  \
@@ -58,41 +79,144 @@ void FileAccessCompressed::configure(const String &p_magic, Compression::Mode p_
 		}                                                   \
 	}
 
+void FileAccessCompressed::DecompressJob::decompress_block(uint32_t p_index, void *p_userdata) {
+
+	int block = first_block + p_index;
+	const ReadBlock &rb = file->read_blocks[block];
+	uint8_t *block_dst = dst + p_index * file->block_size;
+	const uint8_t *block_src = src + rb.offset - file->read_blocks[first_block].offset;
+
+	int ret;
+	if (file->read_dictionary) {
+		ret = Compression::decompress(block_dst, file->_get_block_size(block), block_src, rb.csize, file->cmode, file->zstd_dictionary);
+	} else {
+		ret = Compression::decompress(block_dst, file->_get_block_size(block), block_src, rb.csize, file->cmode);
+	}
+	if (ret < 0) {
+		error.store(true);
+	}
+}
+
+int FileAccessCompressed::_get_block_size(int p_block) const {
+
+	return p_block == read_block_count - 1 ? read_total % block_size : block_size;
+}
+
+bool FileAccessCompressed::_load_block(int p_block) const {
+
+	if (p_block < batch_first_block || p_block >= batch_first_block + batch_block_count) {
+
+		// Read ahead only while the file is read in order, doubling the batch each time. Seeking elsewhere decompresses the block alone.
+		if (batch_block_count > 0 && p_block == batch_first_block + batch_block_count) {
+			read_ahead = MIN(read_ahead * 2, MAX(read_ahead_blocks, 1));
+		} else {
+			read_ahead = 1;
+		}
+
+		// Read the compressed data of the batch at once, then decompress it.
+		int count = MIN(read_ahead, read_block_count - p_block);
+		const ReadBlock &last = read_blocks[p_block + count - 1];
+		int comp_size = last.offset + last.csize - read_blocks[p_block].offset;
+
+		if (comp_buffer.size() < comp_size) {
+			comp_buffer.resize(comp_size);
+		}
+		if (buffer.size() < count * (int)block_size) {
+			buffer.resize(count * block_size);
+		}
+
+		batch_block_count = 0;
+		f->seek(read_blocks[p_block].offset);
+		ERR_FAIL_COND_V_MSG(f->get_buffer(comp_buffer.ptrw(), comp_size) != comp_size, false, "Compressed file '" + f->get_path() + "' is truncated.");
+
+		DecompressJob job;
+		job.file = this;
+		job.first_block = p_block;
+		job.src = comp_buffer.ptr();
+		job.dst = buffer.ptrw();
+		job.error.store(false);
+
+		// The pool is shared by all files, when another thread is using it this one decompresses on its own.
+		bool busy = false;
+		if (count > 1 && count * block_size >= PARALLEL_DECOMPRESS_MIN_SIZE && OS::get_singleton()->get_processor_count() > 1 && decompress_pool_busy.compare_exchange_strong(busy, true)) {
+			if (!decompress_pool_started) {
+				decompress_pool.init();
+				decompress_pool_started = true;
+			}
+			decompress_pool.do_work(count, &job, &DecompressJob::decompress_block, (void *)NULL);
+			decompress_pool_busy.store(false);
+		} else {
+			for (int i = 0; i < count; i++) {
+				job.decompress_block(i, NULL);
+			}
+		}
+		ERR_FAIL_COND_V_MSG(job.error.load(), false, "Compressed file '" + f->get_path() + "' is corrupt.");
+
+		batch_first_block = p_block;
+		batch_block_count = count;
+	}
+
+	read_ptr = buffer.ptrw() + (p_block - batch_first_block) * block_size;
+	read_block_size = _get_block_size(p_block);
+	return true;
+}
+
+bool FileAccessCompressed::_next_block() const {
+
+	if (read_block + 1 < read_block_count && _get_block_size(read_block + 1) > 0 && _load_block(read_block + 1)) {
+		read_block++;
+		read_pos = 0;
+		return true;
+	}
+
+	at_end = true;
+	return false;
+}
+
 Error FileAccessCompressed::open_after_magic(FileAccess *p_base) {
 
 	f = p_base;
-	cmode = (Compression::Mode)f->get_32();
+	uint32_t mode = f->get_32();
+	cmode = (Compression::Mode)(mode & ~COMPRESSED_ZSTD_DICTIONARY);
 	block_size = f->get_32();
 	if (block_size == 0) {
 		f = NULL; // Let the caller to handle the FileAccess object if failed to open as compressed file.
 		ERR_FAIL_V_MSG(ERR_FILE_CORRUPT, "Can't open compressed file '" + p_base->get_path() + "' with block size 0, it is corrupted.");
 	}
 	read_total = f->get_32();
+	read_dictionary = mode & COMPRESSED_ZSTD_DICTIONARY;
+	if (read_dictionary) {
+		uint32_t hash = f->get_32();
+		if (zstd_dictionary.empty() || hash != hash_djb2_buffer(zstd_dictionary.ptr(), zstd_dictionary.size())) {
+			f = NULL;
+			ERR_FAIL_V_MSG(ERR_FILE_CORRUPT, "Can't open compressed file '" + p_base->get_path() + "', it needs a Zstandard dictionary that wasn't configured.");
+		}
+	}
 	int bc = (read_total / block_size) + 1;
 	int acc_ofs = f->get_position() + bc * 4;
-	int max_bs = 0;
 	for (int i = 0; i < bc; i++) {
 
 		ReadBlock rb;
 		rb.offset = acc_ofs;
 		rb.csize = f->get_32();
 		acc_ofs += rb.csize;
-		max_bs = MAX(max_bs, rb.csize);
 		read_blocks.push_back(rb);
 	}
 
-	comp_buffer.resize(max_bs);
-	buffer.resize(block_size);
-	read_ptr = buffer.ptrw();
-	f->get_buffer(comp_buffer.ptrw(), read_blocks[0].csize);
 	at_end = false;
 	read_eof = false;
 	read_block_count = bc;
-	read_block_size = read_blocks.size() == 1 ? read_total : block_size;
-
-	Compression::decompress(buffer.ptrw(), read_block_size, comp_buffer.ptr(), read_blocks[0].csize, cmode);
 	read_block = 0;
 	read_pos = 0;
+	batch_first_block = 0;
+	batch_block_count = 0;
+
+	if (!_load_block(0)) {
+		read_blocks.clear();
+		f = NULL;
+		return ERR_FILE_CORRUPT;
+	}
+	at_end = read_block_size == 0;
 
 	return OK;
 }
@@ -129,8 +253,9 @@ Error FileAccessCompressed::_open(const String &p_path, int p_mode_flags) {
 		char rmagic[5];
 		f->get_buffer((uint8_t *)rmagic, 4);
 		rmagic[4] = 0;
-		if (magic != rmagic || open_after_magic(f) != OK) {
-			memdelete(f);
+		FileAccess *base = f;
+		if (magic != rmagic || open_after_magic(base) != OK) {
+			memdelete(base); // open_after_magic() clears f when failing.
 			f = NULL;
 			return ERR_FILE_UNRECOGNIZED;
 		}
@@ -148,9 +273,13 @@ void FileAccessCompressed::close() {
 
 		CharString mgc = magic.utf8();
 		f->store_buffer((const uint8_t *)mgc.get_data(), mgc.length()); //write header 4
-		f->store_32(cmode); //write compression mode 4
+		f->store_32(cmode | (zstd_dictionary.size() ? COMPRESSED_ZSTD_DICTIONARY : 0)); //write compression mode 4
 		f->store_32(block_size); //write block size 4
 		f->store_32(write_max); //max amount of data written 4
+		if (zstd_dictionary.size()) {
+			f->store_32(hash_djb2_buffer(zstd_dictionary.ptr(), zstd_dictionary.size())); //checked when reading 4
+		}
+		size_t block_table = f->get_position();
 		int bc = (write_max / block_size) + 1;
 
 		for (int i = 0; i < bc; i++) {
@@ -165,13 +294,13 @@ void FileAccessCompressed::close() {
 
 			Vector<uint8_t> cblock;
 			cblock.resize(Compression::get_max_compressed_buffer_size(bl, cmode));
-			int s = Compression::compress(cblock.ptrw(), bp, bl, cmode);
+			int s = Compression::compress(cblock.ptrw(), bp, bl, cmode, zstd_dictionary);
 
 			f->store_buffer(cblock.ptr(), s);
 			block_sizes.push_back(s);
 		}
 
-		f->seek(16); //ok write block sizes
+		f->seek(block_table); //ok write block sizes
 		for (int i = 0; i < bc; i++)
 			f->store_32(block_sizes[i]);
 		f->seek_end();
@@ -184,6 +313,7 @@ void FileAccessCompressed::close() {
 		comp_buffer.clear();
 		buffer.clear();
 		read_blocks.clear();
+		batch_block_count = 0;
 	}
 
 	memdelete(f);
@@ -207,21 +337,16 @@ void FileAccessCompressed::seek(size_t p_position) {
 	} else {
 
 		ERR_FAIL_COND(p_position > read_total);
+		read_eof = false;
 		if (p_position == read_total) {
 			at_end = true;
+			read_block = read_block_count - 1;
+			read_pos = _get_block_size(read_block);
 		} else {
-			at_end = false;
-			read_eof = false;
 			int block_idx = p_position / block_size;
-			if (block_idx != read_block) {
-
-				read_block = block_idx;
-				f->seek(read_blocks[read_block].offset);
-				f->get_buffer(comp_buffer.ptrw(), read_blocks[read_block].csize);
-				Compression::decompress(buffer.ptrw(), read_blocks.size() == 1 ? read_total : block_size, comp_buffer.ptr(), read_blocks[read_block].csize, cmode);
-				read_block_size = read_block == read_block_count - 1 ? read_total % block_size : block_size;
-			}
-
+			ERR_FAIL_COND(!_load_block(block_idx));
+			at_end = false;
+			read_block = block_idx;
 			read_pos = p_position % block_size;
 		}
 	}
@@ -284,19 +409,7 @@ uint8_t FileAccessCompressed::get_8() const {
 
 	read_pos++;
 	if (read_pos >= read_block_size) {
-		read_block++;
-
-		if (read_block < read_block_count) {
-			//read another block of compressed data
-			f->get_buffer(comp_buffer.ptrw(), read_blocks[read_block].csize);
-			Compression::decompress(buffer.ptrw(), read_blocks.size() == 1 ? read_total : block_size, comp_buffer.ptr(), read_blocks[read_block].csize, cmode);
-			read_block_size = read_block == read_block_count - 1 ? read_total % block_size : block_size;
-			read_pos = 0;
-
-		} else {
-			read_block--;
-			at_end = true;
-		}
+		_next_block();
 	}
 
 	return ret;
@@ -311,27 +424,18 @@ int FileAccessCompressed::get_buffer(uint8_t *p_dst, int p_length) const {
 		return 0;
 	}
 
-	for (int i = 0; i < p_length; i++) {
-
-		p_dst[i] = read_ptr[read_pos];
-		read_pos++;
-		if (read_pos >= read_block_size) {
-			read_block++;
-
-			if (read_block < read_block_count) {
-				//read another block of compressed data
-				f->get_buffer(comp_buffer.ptrw(), read_blocks[read_block].csize);
-				Compression::decompress(buffer.ptrw(), read_blocks.size() == 1 ? read_total : block_size, comp_buffer.ptr(), read_blocks[read_block].csize, cmode);
-				read_block_size = read_block == read_block_count - 1 ? read_total % block_size : block_size;
-				read_pos = 0;
-
-			} else {
-				read_block--;
-				at_end = true;
-				if (i < p_length - 1)
-					read_eof = true;
-				return i;
-			}
+	int read = 0;
+	while (read < p_length) {
+
+		int to_copy = MIN(p_length - read, read_block_size - read_pos);
+		copymem(&p_dst[read], &read_ptr[read_pos], to_copy);
+		read += to_copy;
+		read_pos += to_copy;
+
+		if (read_pos >= read_block_size && !_next_block()) {
+			if (read < p_length)
+				read_eof = true;
+			return read;
 		}
 	}
 
@@ -403,8 +507,12 @@ FileAccessCompressed::FileAccessCompressed() :
 		read_block_count(0),
 		read_block_size(0),
 		read_pos(0),
+		batch_first_block(0),
+		batch_block_count(0),
+		read_ahead(1),
 		read_total(0),
 		magic("GCMP"),
+		read_dictionary(false),
 		f(NULL) {
 }
 
@@ -33,6 +33,7 @@
 
 #include "core/io/compression.h"
 #include "core/os/file_access.h"
+#include "core/thread_work_pool.h"
 
 class FileAccessCompressed : public FileAccess {
 
@@ -51,21 +52,51 @@ class FileAccessCompressed : public FileAccess {
 		int offset;
 	};
 
+	// Blocks are decompressed in batches, which grow while the file is read in order and are decompressed in parallel when large enough.
+	struct DecompressJob {
+		const FileAccessCompressed *file;
+		int first_block;
+		const uint8_t *src;
+		uint8_t *dst;
+		std::atomic<bool> error;
+
+		void decompress_block(uint32_t p_index, void *p_userdata);
+	};
+
 	mutable Vector<uint8_t> comp_buffer;
-	uint8_t *read_ptr;
+	mutable uint8_t *read_ptr;
 	mutable int read_block;
 	int read_block_count;
 	mutable int read_block_size;
 	mutable int read_pos;
+	mutable int batch_first_block;
+	mutable int batch_block_count;
+	mutable int read_ahead;
 	Vector<ReadBlock> read_blocks;
 	uint32_t read_total;
 
 	String magic;
+	Vector<uint8_t> zstd_dictionary;
+	bool read_dictionary;
 	mutable Vector<uint8_t> buffer;
 	FileAccess *f;
 
+	int _get_block_size(int p_block) const;
+	bool _load_block(int p_block) const;
+	bool _next_block() const;
+
+	static ThreadWorkPool decompress_pool;
+	static std::atomic<bool> decompress_pool_busy;
+	static bool decompress_pool_started;
+
 public:
-	void configure(const String &p_magic, Compression::Mode p_mode = Compression::MODE_ZSTD, int p_block_size = 4096);
+	static int default_block_size;
+	static int read_ahead_blocks;
+
+	static void finish_decompress_pool();
+
+	// A block size of 0 uses the project default. Files written with a Zstandard dictionary need the same one to be read.
+	void configure(const String &p_magic, Compression::Mode p_mode = Compression::MODE_ZSTD, int p_block_size = 0, const Vector<uint8_t> &p_zstd_dictionary = Vector<uint8_t>());
 
 	Error open_after_magic(FileAccess *p_base);
 
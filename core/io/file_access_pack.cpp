@@ -30,12 +30,17 @@
 
 #include "file_access_pack.h"
 
+#include "core/io/compression.h"
+#include "core/io/marshalls.h"
 #include "core/version.h"
 
 #include <stdio.h>
+#include <string.h>
 
 Error PackedData::add_pack(const String &p_path, bool p_replace_files) {
 
+	layer_count++;
+
 	for (int i = 0; i < sources.size(); i++) {
 
 		if (sources[i]->try_open_pack(p_path, p_replace_files)) {
@@ -47,7 +52,7 @@ Error PackedData::add_pack(const String &p_path, bool p_replace_files) {
 	return ERR_FILE_UNRECOGNIZED;
 };
 
-void PackedData::add_path(const String &pkg_path, const String &path, uint64_t ofs, uint64_t size, const uint8_t *p_md5, PackSource *p_src, bool p_replace_files) {
+void PackedData::add_path(const String &pkg_path, const String &path, uint64_t ofs, uint64_t size, const uint8_t *p_md5, PackSource *p_src, bool p_replace_files, const uint8_t *p_data, uint64_t p_compressed_size) {
 
 	PathMD5 pmd5(path.md5_buffer());
 	//printf("adding path %ls, %lli, %lli\n", path.c_str(), pmd5.a, pmd5.b);
@@ -61,39 +66,164 @@ void PackedData::add_path(const String &pkg_path, const String &path, uint64_t o
 	for (int i = 0; i < 16; i++)
 		pf.md5[i] = p_md5[i];
 	pf.src = p_src;
+	pf.data = p_data;
+	pf.compressed_size = p_compressed_size;
+	pf.layer = layer_count;
+	pf.replace_files = p_replace_files;
 
 	if (!exists || p_replace_files)
 		files[pmd5] = pf;
 
 	if (!exists) {
-		//search for dir
-		String p = path.replace_first("res://", "");
-		PackedDir *cd = root;
+		MutexLock lock(dirs_mutex);
+		_add_path_to_dirs(path);
+	}
+}
+
+void PackedData::_add_path_to_dirs(const String &p_path) {
 
-		if (p.find("/") != -1) { //in a subdir
+	//search for dir
+	String p = p_path.replace_first("res://", "");
+	PackedDir *cd = root;
 
-			Vector<String> ds = p.get_base_dir().split("/");
+	if (p.find("/") != -1) { //in a subdir
 
-			for (int j = 0; j < ds.size(); j++) {
+		Vector<String> ds = p.get_base_dir().split("/");
 
-				if (!cd->subdirs.has(ds[j])) {
+		for (int j = 0; j < ds.size(); j++) {
 
-					PackedDir *pd = memnew(PackedDir);
-					pd->name = ds[j];
-					pd->parent = cd;
-					cd->subdirs[pd->name] = pd;
-					cd = pd;
-				} else {
-					cd = cd->subdirs[ds[j]];
-				}
+			if (!cd->subdirs.has(ds[j])) {
+
+				PackedDir *pd = memnew(PackedDir);
+				pd->name = ds[j];
+				pd->parent = cd;
+				cd->subdirs[pd->name] = pd;
+				cd = pd;
+			} else {
+				cd = cd->subdirs[ds[j]];
 			}
 		}
-		String filename = path.get_file();
-		// Don't add as a file if the path points to a directory
-		if (!filename.empty()) {
-			cd->files.insert(filename);
+	}
+	String filename = p_path.get_file();
+	// Don't add as a file if the path points to a directory
+	if (!filename.empty()) {
+		cd->files.insert(filename);
+	}
+}
+
+PackedData::PackedDir *PackedData::_get_root() {
+
+	MutexLock lock(dirs_mutex);
+
+	for (; indices_in_dirs < indices.size(); indices_in_dirs++) {
+
+		const PackIndex &index = indices[indices_in_dirs];
+		for (uint32_t i = 0; i < index.count; i++) {
+
+			const uint8_t *entry = index.entries + i * PACK_INDEX_ENTRY_SIZE;
+			String path;
+			path.parse_utf8((const char *)index.strings + decode_uint32(entry + 56), decode_uint32(entry + 60));
+			_add_path_to_dirs(path);
 		}
 	}
+
+	return root;
+}
+
+void PackedData::add_index(const String &p_pack, PackSource *p_src, const uint8_t *p_index, Vector<uint8_t> p_buffer, const uint8_t *p_data, bool p_replace_files) {
+
+	PackIndex index;
+	index.pack = p_pack;
+	index.src = p_src;
+	index.count = decode_uint32(p_index);
+	index.entries = p_index + 8;
+	index.strings = index.entries + index.count * PACK_INDEX_ENTRY_SIZE;
+	index.data = p_data;
+	index.buffer = p_buffer; // Shares the data p_index points to, if any.
+	index.layer = layer_count;
+	index.replace_files = p_replace_files;
+
+	MutexLock lock(dirs_mutex);
+	indices.push_back(index);
+}
+
+void PackedData::get_path_key(const String &p_path, uint64_t r_key[2]) {
+
+	Vector<uint8_t> md5 = p_path.md5_buffer();
+	r_key[0] = decode_uint64(&md5[0]);
+	r_key[1] = decode_uint64(&md5[8]);
+}
+
+bool PackedData::_find_in_index(const PackIndex &p_index, const uint64_t p_key[2], PackedFile &r_file) const {
+
+	uint32_t low = 0;
+	uint32_t high = p_index.count;
+
+	while (low < high) {
+
+		uint32_t middle = low + (high - low) / 2;
+		const uint8_t *entry = p_index.entries + middle * PACK_INDEX_ENTRY_SIZE;
+		uint64_t a = decode_uint64(entry);
+		uint64_t b = decode_uint64(entry + 8);
+
+		if (a < p_key[0] || (a == p_key[0] && b < p_key[1])) {
+			low = middle + 1;
+		} else if (a == p_key[0] && b == p_key[1]) {
+
+			r_file.pack = p_index.pack;
+			r_file.offset = decode_uint64(entry + 16);
+			r_file.size = decode_uint64(entry + 24);
+			r_file.compressed_size = decode_uint64(entry + 32);
+			memcpy(r_file.md5, entry + 40, 16);
+			r_file.src = p_index.src;
+			r_file.data = p_index.data ? p_index.data + r_file.offset : NULL;
+			r_file.layer = p_index.layer;
+			r_file.replace_files = p_index.replace_files;
+			return true;
+		} else {
+			high = middle;
+		}
+	}
+
+	return false;
+}
+
+bool PackedData::_find_file(const String &p_path, PackedFile &r_file) const {
+
+	PathMD5 pmd5(p_path.md5_buffer());
+	const Map<PathMD5, PackedFile>::Element *E = files.find(pmd5);
+
+	if (indices.empty()) {
+		if (!E)
+			return false;
+		r_file = E->get();
+		return true;
+	}
+
+	// Go through the packs in the order they were added, as add_path() does with the map.
+	uint64_t key[2] = { pmd5.a, pmd5.b };
+#ifdef BIG_ENDIAN_ENABLED
+	key[0] = BSWAP64(key[0]);
+	key[1] = BSWAP64(key[1]);
+#endif
+
+	bool found = false;
+	for (int i = 0; i <= indices.size(); i++) {
+
+		if (E && (i == indices.size() || E->get().layer < indices[i].layer)) {
+			if (!found || E->get().replace_files) {
+				r_file = E->get();
+				found = true;
+			}
+			E = NULL;
+		}
+
+		if (i < indices.size() && (!found || indices[i].replace_files)) {
+			found = _find_in_index(indices[i], key, r_file) || found;
+		}
+	}
+
+	return found;
 }
 
 void PackedData::add_pack_source(PackSource *p_source) {
@@ -110,6 +240,8 @@ PackedData::PackedData() {
 	singleton = this;
 	root = memnew(PackedDir);
 	root->parent = NULL;
+	indices_in_dirs = 0;
+	layer_count = 0;
 	disabled = false;
 
 	add_pack_source(memnew(PackedSourcePCK));
@@ -134,7 +266,7 @@ PackedData::~PackedData() {
 
 bool PackedSourcePCK::try_open_pack(const String &p_path, bool p_replace_files) {
 
-	FileAccess *f = FileAccess::open(p_path, FileAccess::READ);
+	FileAccess *f = FileAccess::open_mapped(p_path);
 	if (!f)
 		return false;
 
@@ -170,7 +302,7 @@ bool PackedSourcePCK::try_open_pack(const String &p_path, bool p_replace_files)
 	uint32_t ver_minor = f->get_32();
 	f->get_32(); // patch number, not used for validation.
 
-	if (version != PACK_FORMAT_VERSION) {
+	if (version != PACK_FORMAT_VERSION && version != PACK_FORMAT_VERSION_FLAT) {
 		f->close();
 		memdelete(f);
 		ERR_FAIL_V_MSG(false, "Pack version unsupported: " + itos(version) + ".");
@@ -186,6 +318,75 @@ bool PackedSourcePCK::try_open_pack(const String &p_path, bool p_replace_files)
 		f->get_32();
 	}
 
+	// When the pack is mapped, its files are served as slices of it instead of opening the pack again for each.
+	const uint8_t *base = NULL;
+	{
+		size_t directory_pos = f->get_position();
+		f->seek(0);
+		base = f->get_buffer_ptr(0);
+		f->seek(directory_pos);
+	}
+
+	if (version == PACK_FORMAT_VERSION) {
+		if (!_read_index(p_path, f, base, p_replace_files)) {
+			f->close();
+			memdelete(f);
+			ERR_FAIL_V_MSG(false, "Pack index is corrupt: " + p_path + ".");
+		}
+	} else {
+		_read_flat_table(p_path, f, base, p_replace_files);
+	}
+
+	if (base) {
+		mapped_packs.push_back(f);
+	} else {
+		f->close();
+		memdelete(f);
+	}
+	return true;
+};
+
+bool PackedSourcePCK::_read_index(const String &p_path, FileAccess *p_file, const uint8_t *p_base, bool p_replace_files) {
+
+	size_t index_pos = p_file->get_position();
+	uint32_t file_count = p_file->get_32();
+	uint32_t strings_size = p_file->get_32();
+	uint64_t index_size = 8 + uint64_t(file_count) * PACK_INDEX_ENTRY_SIZE + strings_size;
+	ERR_FAIL_COND_V(index_pos + index_size > p_file->get_len(), false);
+
+	// A mapped index is searched where it is, otherwise it's read in one go.
+	Vector<uint8_t> buffer;
+	const uint8_t *index = NULL;
+	if (p_base) {
+		index = p_base + index_pos;
+	} else {
+		ERR_FAIL_COND_V(index_size > 0x7FFFFFFF, false);
+		buffer.resize(index_size);
+		p_file->seek(index_pos);
+		ERR_FAIL_COND_V(p_file->get_buffer(buffer.ptrw(), index_size) != (int)index_size, false);
+		index = buffer.ptr();
+	}
+
+	const uint8_t *entries = index + 8;
+	for (uint32_t i = 0; i < file_count; i++) {
+
+		const uint8_t *entry = entries + i * PACK_INDEX_ENTRY_SIZE;
+		uint64_t ofs = decode_uint64(entry + 16);
+		uint64_t stored_size = decode_uint64(entry + 32) ? decode_uint64(entry + 32) : decode_uint64(entry + 24);
+		ERR_FAIL_COND_V(uint64_t(decode_uint32(entry + 56)) + decode_uint32(entry + 60) > strings_size, false);
+		ERR_FAIL_COND_V(ofs + stored_size > p_file->get_len(), false);
+		if (i > 0) { // Must be sorted to be searched.
+			const uint8_t *prev = entry - PACK_INDEX_ENTRY_SIZE;
+			ERR_FAIL_COND_V(decode_uint64(prev) > decode_uint64(entry) || (decode_uint64(prev) == decode_uint64(entry) && decode_uint64(prev + 8) >= decode_uint64(entry + 8)), false);
+		}
+	}
+
+	PackedData::get_singleton()->add_index(p_path, this, index, buffer, p_base, p_replace_files);
+	return true;
+}
+
+void PackedSourcePCK::_read_flat_table(const String &p_path, FileAccess *f, const uint8_t *base, bool p_replace_files) {
+
 	int file_count = f->get_32();
 
 	for (int i = 0; i < file_count; i++) {
@@ -203,19 +404,32 @@ bool PackedSourcePCK::try_open_pack(const String &p_path, bool p_replace_files)
 		uint64_t size = f->get_64();
 		uint8_t md5[16];
 		f->get_buffer(md5, 16);
-		PackedData::get_singleton()->add_path(p_path, path, ofs, size, md5, this, p_replace_files);
-	};
 
-	f->close();
-	memdelete(f);
-	return true;
-};
+		const uint8_t *data = NULL;
+		if (base && ofs + size <= f->get_len()) {
+			data = base + ofs;
+		}
+		PackedData::get_singleton()->add_path(p_path, path, ofs, size, md5, this, p_replace_files, data);
+	};
+}
 
 FileAccess *PackedSourcePCK::get_file(const String &p_path, PackedData::PackedFile *p_file) {
 
-	return memnew(FileAccessPack(p_path, *p_file));
+	FileAccessPack *fa = memnew(FileAccessPack(p_path, *p_file));
+	if (!fa->is_open()) {
+		memdelete(fa);
+		return NULL;
+	}
+	return fa;
 };
 
+PackedSourcePCK::~PackedSourcePCK() {
+
+	for (int i = 0; i < mapped_packs.size(); i++) {
+		memdelete(mapped_packs[i]);
+	}
+}
+
 //////////////////////////////////////////////////////////////////
 
 Error FileAccessPack::_open(const String &p_path, int p_mode_flags) {
@@ -226,12 +440,15 @@ Error FileAccessPack::_open(const String &p_path, int p_mode_flags) {
 
 void FileAccessPack::close() {
 
-	f->close();
+	if (f) {
+		f->close();
+	}
+	opened = false;
 }
 
 bool FileAccessPack::is_open() const {
 
-	return f->is_open();
+	return opened && (!f || f->is_open());
 }
 
 void FileAccessPack::seek(size_t p_position) {
@@ -242,7 +459,9 @@ void FileAccessPack::seek(size_t p_position) {
 		eof = false;
 	}
 
-	f->seek(pf.offset + p_position);
+	if (f) {
+		f->seek(pf.offset + p_position);
+	}
 	pos = p_position;
 }
 void FileAccessPack::seek_end(int64_t p_position) {
@@ -270,6 +489,10 @@ uint8_t FileAccessPack::get_8() const {
 		return 0;
 	}
 
+	if (data) {
+		return data[pos++];
+	}
+
 	pos++;
 	return f->get_8();
 }
@@ -285,18 +508,37 @@ int FileAccessPack::get_buffer(uint8_t *p_dst, int p_length) const {
 		to_read = int64_t(pf.size) - int64_t(pos);
 	}
 
-	pos += p_length;
-
-	if (to_read <= 0)
+	if (to_read <= 0) {
+		pos += p_length;
 		return 0;
-	f->get_buffer(p_dst, to_read);
+	}
+
+	if (data) {
+		memcpy(p_dst, &data[pos], to_read);
+	} else {
+		f->get_buffer(p_dst, to_read);
+	}
+	pos += p_length;
 
 	return to_read;
 }
 
+const uint8_t *FileAccessPack::get_buffer_ptr(int p_length) const {
+
+	if (!data || eof || p_length < 0 || pos + p_length > pf.size) {
+		return NULL;
+	}
+
+	const uint8_t *ptr = &data[pos];
+	pos += p_length;
+	return ptr;
+}
+
 void FileAccessPack::set_endian_swap(bool p_swap) {
 	FileAccess::set_endian_swap(p_swap);
-	f->set_endian_swap(p_swap);
+	if (f) {
+		f->set_endian_swap(p_swap);
+	}
 }
 
 Error FileAccessPack::get_error() const {
@@ -328,13 +570,40 @@ bool FileAccessPack::file_exists(const String &p_name) {
 
 FileAccessPack::FileAccessPack(const String &p_path, const PackedData::PackedFile &p_file) :
 		pf(p_file),
-		f(FileAccess::open(pf.pack, FileAccess::READ)) {
+		pos(0),
+		eof(false),
+		data(p_file.data),
+		opened(true),
+		f(NULL) {
+
+	if (!data) {
+		f = FileAccess::open(pf.pack, FileAccess::READ);
+		opened = f != NULL;
+		ERR_FAIL_COND_MSG(!f, "Can't open pack-referenced file '" + String(pf.pack) + "'.");
+
+		f->seek(pf.offset);
+	}
 
-	ERR_FAIL_COND_MSG(!f, "Can't open pack-referenced file '" + String(pf.pack) + "'.");
+	if (pf.compressed_size) {
+		// Compressed files are decompressed whole when opened, then read from memory.
+		Vector<uint8_t> compressed;
+		const uint8_t *src = data;
+		if (!src) {
+			compressed.resize(pf.compressed_size);
+			f->get_buffer(compressed.ptrw(), pf.compressed_size);
+			src = compressed.ptr();
+			memdelete(f);
+			f = NULL;
+		}
 
-	f->seek(pf.offset);
-	pos = 0;
-	eof = false;
+		decompressed.resize(pf.size);
+		int ret = Compression::decompress(decompressed.ptrw(), pf.size, src, pf.compressed_size, Compression::MODE_ZSTD);
+		data = decompressed.ptr();
+		if (ret != (int)pf.size) {
+			opened = false;
+			ERR_FAIL_MSG("Can't decompress pack-referenced file '" + String(pf.pack) + "'.");
+		}
+	}
 }
 
 FileAccessPack::~FileAccessPack() {
@@ -426,7 +695,7 @@ Error DirAccessPack::change_dir(String p_dir) {
 	PackedData::PackedDir *pd;
 
 	if (absolute)
-		pd = PackedData::get_singleton()->root;
+		pd = PackedData::get_singleton()->_get_root();
 	else
 		pd = current;
 
@@ -506,7 +775,7 @@ String DirAccessPack::get_filesystem_type() const {
 
 DirAccessPack::DirAccessPack() {
 
-	current = PackedData::get_singleton()->root;
+	current = PackedData::get_singleton()->_get_root();
 	cdir = false;
 }
 
@@ -35,12 +35,21 @@
 #include "core/map.h"
 #include "core/os/dir_access.h"
 #include "core/os/file_access.h"
+#include "core/os/mutex.h"
 #include "core/print_string.h"
 
 // Godot's packed file magic header ("GDPC" in ASCII).
 #define PACK_HEADER_MAGIC 0x43504447
 // The current packed file format version number.
-#define PACK_FORMAT_VERSION 1
+#define PACK_FORMAT_VERSION 2
+// Version 1 packs list their files in a flat table, which is read into a map on load.
+#define PACK_FORMAT_VERSION_FLAT 1
+
+// Version 2 packs store their files in an index sorted by path key, searched in place on load.
+// The index is the file count (32 bits), the size of the path strings (32 bits), the entries, then the path strings.
+// Each entry is the path key (2x64 bits), offset, size and compressed size (64 bits each, compressed size is 0 if
+// the file is stored), the MD5 of the contents (16 bytes), then the offset and length of its path in the strings (32 bits each).
+#define PACK_INDEX_ENTRY_SIZE 64
 
 class PackSource;
 
@@ -57,6 +66,10 @@ public:
 		uint64_t size;
 		uint8_t md5[16];
 		PackSource *src;
+		const uint8_t *data; // Contents in the mapped pack, NULL if the pack is read through a file.
+		uint64_t compressed_size; // Size in the pack when compressed with Zstandard, 0 if stored.
+		uint32_t layer; // Pack this file comes from, in the order packs were added.
+		bool replace_files;
 	};
 
 private:
@@ -93,21 +106,46 @@ private:
 		};
 	};
 
+	// Sorted file index of a version 2 pack, searched without building a map.
+	struct PackIndex {
+		String pack;
+		PackSource *src;
+		const uint8_t *entries;
+		const uint8_t *strings;
+		uint32_t count;
+		const uint8_t *data; // Start of the mapped pack, NULL if it is read through a file.
+		Vector<uint8_t> buffer; // Holds the index when the pack isn't mapped.
+		uint32_t layer;
+		bool replace_files;
+	};
+
 	Map<PathMD5, PackedFile> files;
+	Vector<PackIndex> indices;
+	uint32_t layer_count;
 
 	Vector<PackSource *> sources;
 
 	PackedDir *root;
+	int indices_in_dirs; // Indices whose paths were added to the directory tree, which is built when first listed.
+	Mutex dirs_mutex;
 	//Map<String,PackedDir*> dirs;
 
 	static PackedData *singleton;
 	bool disabled;
 
 	void _free_packed_dirs(PackedDir *p_dir);
+	void _add_path_to_dirs(const String &p_path);
+	PackedDir *_get_root();
+
+	bool _find_in_index(const PackIndex &p_index, const uint64_t p_key[2], PackedFile &r_file) const;
+	bool _find_file(const String &p_path, PackedFile &r_file) const;
 
 public:
 	void add_pack_source(PackSource *p_source);
-	void add_path(const String &pkg_path, const String &path, uint64_t ofs, uint64_t size, const uint8_t *p_md5, PackSource *p_src, bool p_replace_files); // for PackSource
+	void add_path(const String &pkg_path, const String &path, uint64_t ofs, uint64_t size, const uint8_t *p_md5, PackSource *p_src, bool p_replace_files, const uint8_t *p_data = NULL, uint64_t p_compressed_size = 0); // for PackSource
+	void add_index(const String &p_pack, PackSource *p_src, const uint8_t *p_index, Vector<uint8_t> p_buffer, const uint8_t *p_data, bool p_replace_files); // for PackSource
+
+	static void get_path_key(const String &p_path, uint64_t r_key[2]); // Key of a path in the index of version 2 packs.
 
 	void set_disabled(bool p_disabled) { disabled = p_disabled; }
 	_FORCE_INLINE_ bool is_disabled() const { return disabled; }
@@ -132,9 +170,16 @@ public:
 
 class PackedSourcePCK : public PackSource {
 
+	Vector<FileAccess *> mapped_packs; // Kept open while their files are in use.
+
+	bool _read_index(const String &p_path, FileAccess *p_file, const uint8_t *p_base, bool p_replace_files);
+	void _read_flat_table(const String &p_path, FileAccess *f, const uint8_t *base, bool p_replace_files);
+
 public:
 	virtual bool try_open_pack(const String &p_path, bool p_replace_files);
 	virtual FileAccess *get_file(const String &p_path, PackedData::PackedFile *p_file);
+
+	~PackedSourcePCK();
 };
 
 class FileAccessPack : public FileAccess {
@@ -144,6 +189,9 @@ class FileAccessPack : public FileAccess {
 	mutable size_t pos;
 	mutable bool eof;
 
+	const uint8_t *data; // Read from memory when the pack is mapped or the file is compressed, else through f.
+	Vector<uint8_t> decompressed;
+	bool opened;
 	FileAccess *f;
 	virtual Error _open(const String &p_path, int p_mode_flags);
 	virtual uint64_t _get_modified_time(const String &p_file) { return 0; }
@@ -164,6 +212,7 @@ public:
 	virtual uint8_t get_8() const;
 
 	virtual int get_buffer(uint8_t *p_dst, int p_length) const;
+	virtual const uint8_t *get_buffer_ptr(int p_length) const;
 
 	virtual void set_endian_swap(bool p_swap);
 
@@ -182,19 +231,19 @@ public:
 
 FileAccess *PackedData::try_open_path(const String &p_path) {
 
-	PathMD5 pmd5(p_path.md5_buffer());
-	Map<PathMD5, PackedFile>::Element *E = files.find(pmd5);
-	if (!E)
+	PackedFile pf;
+	if (!_find_file(p_path, pf))
 		return NULL; //not found
-	if (E->get().offset == 0)
+	if (pf.offset == 0)
 		return NULL; //was erased
 
-	return E->get().src->get_file(p_path, &E->get());
+	return pf.src->get_file(p_path, &pf);
 }
 
 bool PackedData::has_path(const String &p_path) {
 
-	return files.has(PathMD5(p_path.md5_buffer()));
+	PackedFile pf;
+	return _find_file(p_path, pf);
 }
 
 class DirAccessPack : public DirAccess {
@@ -51,7 +51,7 @@ Error ImageLoader::load_image(String p_file, Ref<Image> p_image, FileAccess *p_c
 	FileAccess *f = p_custom;
 	if (!f) {
 		Error err;
-		f = FileAccess::open(p_file, FileAccess::READ, &err);
+		f = FileAccess::open_mapped(p_file, &err);
 		if (!f) {
 			ERR_PRINT("Error opening file '" + p_file + "'.");
 			return err;
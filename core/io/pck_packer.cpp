@@ -30,10 +30,16 @@
 
 #include "pck_packer.h"
 
+#include "core/crypto/crypto_core.h"
+#include "core/io/compression.h"
 #include "core/io/file_access_pack.h" // PACK_HEADER_MAGIC, PACK_FORMAT_VERSION
+#include "core/io/marshalls.h"
 #include "core/os/file_access.h"
 #include "core/version.h"
 
+// Files up to this size are read whole, so they can be compressed.
+#define PACK_COMPRESS_MAX_SIZE (64 * 1024 * 1024)
+
 static uint64_t _align(uint64_t p_n, int p_alignment) {
 
 	if (p_alignment == 0)
@@ -54,14 +60,103 @@ static void _pad(FileAccess *p_file, int p_bytes) {
 	};
 };
 
+PCKPacker::IndexEntry::IndexEntry() :
+		offset(0),
+		size(0),
+		compressed_size(0) {
+
+	key[0] = key[1] = 0;
+	memset(md5, 0, 16);
+}
+
+PCKPacker::IndexEntry::IndexEntry(const String &p_path) :
+		path_utf8(p_path.utf8()),
+		offset(0),
+		size(0),
+		compressed_size(0) {
+
+	PackedData::get_path_key(p_path, key);
+	memset(md5, 0, 16);
+}
+
+void PCKPacker::store_header(FileAccess *p_file) {
+
+	p_file->store_32(PACK_HEADER_MAGIC);
+	p_file->store_32(PACK_FORMAT_VERSION);
+	p_file->store_32(VERSION_MAJOR);
+	p_file->store_32(VERSION_MINOR);
+	p_file->store_32(VERSION_PATCH);
+
+	for (int i = 0; i < 16; i++) {
+
+		p_file->store_32(0); // reserved
+	};
+}
+
+uint64_t PCKPacker::get_index_size(const Vector<IndexEntry> &p_entries) {
+
+	uint64_t size = 8 + uint64_t(p_entries.size()) * PACK_INDEX_ENTRY_SIZE;
+	for (int i = 0; i < p_entries.size(); i++) {
+		size += p_entries[i].path_utf8.length();
+	}
+	return size;
+}
+
+void PCKPacker::store_index(FileAccess *p_file, const Vector<IndexEntry> &p_entries) {
+
+	uint32_t strings_size = get_index_size(p_entries) - 8 - uint64_t(p_entries.size()) * PACK_INDEX_ENTRY_SIZE;
+
+	p_file->store_32(p_entries.size());
+	p_file->store_32(strings_size);
+
+	uint32_t path_ofs = 0;
+	for (int i = 0; i < p_entries.size(); i++) {
+
+		const IndexEntry &e = p_entries[i];
+		p_file->store_64(e.key[0]);
+		p_file->store_64(e.key[1]);
+		p_file->store_64(e.offset);
+		p_file->store_64(e.size);
+		p_file->store_64(e.compressed_size);
+		p_file->store_buffer(e.md5, 16);
+		p_file->store_32(path_ofs);
+		p_file->store_32(e.path_utf8.length());
+		path_ofs += e.path_utf8.length();
+	}
+
+	for (int i = 0; i < p_entries.size(); i++) {
+		p_file->store_buffer((const uint8_t *)p_entries[i].path_utf8.get_data(), p_entries[i].path_utf8.length());
+	}
+}
+
+bool PCKPacker::compress_file(const Vector<uint8_t> &p_data, Vector<uint8_t> &r_compressed) {
+
+	// Small files aren't worth a decompression on load.
+	if (p_data.size() < 256 || p_data.size() > PACK_COMPRESS_MAX_SIZE) {
+		return false;
+	}
+
+	r_compressed.resize(Compression::get_max_compressed_buffer_size(p_data.size(), Compression::MODE_ZSTD));
+	int size = Compression::compress(r_compressed.ptrw(), p_data.ptr(), p_data.size(), Compression::MODE_ZSTD);
+
+	// Keep it compressed only when it saves at least an eighth, already compressed formats usually don't.
+	if (size <= 0 || size > p_data.size() - p_data.size() / 8) {
+		r_compressed.clear();
+		return false;
+	}
+
+	r_compressed.resize(size);
+	return true;
+}
+
 void PCKPacker::_bind_methods() {
 
-	ClassDB::bind_method(D_METHOD("pck_start", "pck_name", "alignment"), &PCKPacker::pck_start, DEFVAL(0));
+	ClassDB::bind_method(D_METHOD("pck_start", "pck_name", "alignment", "compress"), &PCKPacker::pck_start, DEFVAL(0), DEFVAL(true));
 	ClassDB::bind_method(D_METHOD("add_file", "pck_path", "source_path"), &PCKPacker::add_file);
 	ClassDB::bind_method(D_METHOD("flush", "verbose"), &PCKPacker::flush, DEFVAL(false));
 };
 
-Error PCKPacker::pck_start(const String &p_file, int p_alignment) {
+Error PCKPacker::pck_start(const String &p_file, int p_alignment, bool p_compress) {
 
 	if (file != NULL) {
 		memdelete(file);
@@ -72,19 +167,12 @@ Error PCKPacker::pck_start(const String &p_file, int p_alignment) {
 	ERR_FAIL_COND_V_MSG(!file, ERR_CANT_CREATE, "Can't open file to write: " + String(p_file) + ".");
 
 	alignment = p_alignment;
+	compress = p_compress;
 
-	file->store_32(PACK_HEADER_MAGIC);
-	file->store_32(PACK_FORMAT_VERSION);
-	file->store_32(VERSION_MAJOR);
-	file->store_32(VERSION_MINOR);
-	file->store_32(VERSION_PATCH);
-
-	for (int i = 0; i < 16; i++) {
-
-		file->store_32(0); // reserved
-	};
+	store_header(file);
 
 	files.clear();
+	file_indices.clear();
 
 	return OK;
 };
@@ -97,12 +185,17 @@ Error PCKPacker::add_file(const String &p_file, const String &p_src) {
 	};
 
 	File pf;
-	pf.path = p_file;
+	pf.entry = IndexEntry(p_file);
+	pf.entry.size = f->get_len();
 	pf.src_path = p_src;
-	pf.size = f->get_len();
-	pf.offset_offset = 0;
 
-	files.push_back(pf);
+	Map<String, int>::Element *E = file_indices.find(p_file);
+	if (E) {
+		files.write[E->get()] = pf;
+	} else {
+		file_indices[p_file] = files.size();
+		files.push_back(pf);
+	}
 
 	f->close();
 	memdelete(f);
@@ -114,23 +207,21 @@ Error PCKPacker::flush(bool p_verbose) {
 
 	ERR_FAIL_COND_V_MSG(!file, ERR_INVALID_PARAMETER, "File must be opened before use.");
 
-	// write the index
-
-	file->store_32(files.size());
+	// write the index, sorted so it can be searched in place when loaded
 
+	files.sort();
 	for (int i = 0; i < files.size(); i++) {
+		file_indices[String::utf8(files[i].entry.path_utf8.get_data())] = i;
+	}
 
-		file->store_pascal_string(files[i].path);
-		files.write[i].offset_offset = file->get_position();
-		file->store_64(0); // offset
-		file->store_64(files[i].size); // size
+	Vector<IndexEntry> index;
+	index.resize(files.size());
+	for (int i = 0; i < files.size(); i++) {
+		index.write[i] = files[i].entry;
+	}
 
-		// # empty md5
-		file->store_32(0);
-		file->store_32(0);
-		file->store_32(0);
-		file->store_32(0);
-	};
+	uint64_t index_pos = file->get_position();
+	store_index(file, index); // Stored again below, once offsets and sizes are known.
 
 	uint64_t ofs = file->get_position();
 	ofs = _align(ofs, alignment);
@@ -143,21 +234,41 @@ Error PCKPacker::flush(bool p_verbose) {
 	int count = 0;
 	for (int i = 0; i < files.size(); i++) {
 
+		IndexEntry &e = index.write[i];
 		FileAccess *src = FileAccess::open(files[i].src_path, FileAccess::READ);
-		uint64_t to_write = files[i].size;
-		while (to_write > 0) {
-
-			int read = src->get_buffer(buf, MIN(to_write, buf_max));
-			file->store_buffer(buf, read);
-			to_write -= read;
-		};
+		e.offset = ofs;
+
+		if (compress && e.size <= PACK_COMPRESS_MAX_SIZE) {
+
+			Vector<uint8_t> data;
+			data.resize(e.size);
+			src->get_buffer(data.ptrw(), e.size);
+			CryptoCore::md5(data.ptr(), data.size(), e.md5);
+
+			Vector<uint8_t> compressed;
+			if (compress_file(data, compressed)) {
+				e.compressed_size = compressed.size();
+				file->store_buffer(compressed.ptr(), compressed.size());
+			} else {
+				file->store_buffer(data.ptr(), data.size());
+			}
+		} else {
+
+			CryptoCore::MD5Context md5;
+			md5.start();
+			uint64_t to_write = e.size;
+			while (to_write > 0) {
+
+				int read = src->get_buffer(buf, MIN(to_write, buf_max));
+				md5.update(buf, read);
+				file->store_buffer(buf, read);
+				to_write -= read;
+			};
+			md5.finish(e.md5);
+		}
 
 		uint64_t pos = file->get_position();
-		file->seek(files[i].offset_offset); // go back to store the file's offset
-		file->store_64(ofs);
-		file->seek(pos);
-
-		ofs = _align(ofs + files[i].size, alignment);
+		ofs = _align(pos, alignment);
 		_pad(file, ofs - pos);
 
 		src->close();
@@ -174,6 +285,9 @@ Error PCKPacker::flush(bool p_verbose) {
 	if (p_verbose)
 		printf("\n");
 
+	file->seek(index_pos);
+	store_index(file, index);
+
 	file->close();
 	memdelete_arr(buf);
 
@@ -183,6 +297,8 @@ Error PCKPacker::flush(bool p_verbose) {
 PCKPacker::PCKPacker() {
 
 	file = NULL;
+	alignment = 0;
+	compress = true;
 };
 
 PCKPacker::~PCKPacker() {
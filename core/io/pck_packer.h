@@ -31,6 +31,7 @@
 #ifndef PCK_PACKER_H
 #define PCK_PACKER_H
 
+#include "core/map.h"
 #include "core/reference.h"
 
 class FileAccess;
@@ -39,22 +40,49 @@ class PCKPacker : public Reference {
 
 	GDCLASS(PCKPacker, Reference);
 
+public:
+	// Entry of the sorted file index of packs, see PACK_INDEX_ENTRY_SIZE.
+	struct IndexEntry {
+
+		CharString path_utf8;
+		uint64_t key[2];
+		uint64_t offset;
+		uint64_t size;
+		uint64_t compressed_size;
+		uint8_t md5[16];
+
+		bool operator<(const IndexEntry &p_entry) const {
+			return key[0] == p_entry.key[0] ? key[1] < p_entry.key[1] : key[0] < p_entry.key[0];
+		}
+
+		IndexEntry();
+		IndexEntry(const String &p_path);
+	};
+
+private:
 	FileAccess *file;
 	int alignment;
+	bool compress;
 
 	static void _bind_methods();
 
 	struct File {
 
-		String path;
+		IndexEntry entry;
 		String src_path;
-		int size;
-		uint64_t offset_offset;
+
+		bool operator<(const File &p_file) const { return entry < p_file.entry; }
 	};
 	Vector<File> files;
+	Map<String, int> file_indices; // Adding a path again replaces its file, paths must be unique in the index.
 
 public:
-	Error pck_start(const String &p_file, int p_alignment = 0);
+	static void store_header(FileAccess *p_file);
+	static uint64_t get_index_size(const Vector<IndexEntry> &p_entries);
+	static void store_index(FileAccess *p_file, const Vector<IndexEntry> &p_entries);
+	static bool compress_file(const Vector<uint8_t> &p_data, Vector<uint8_t> &r_compressed);
+
+	Error pck_start(const String &p_file, int p_alignment = 0, bool p_compress = true);
 	Error add_file(const String &p_file, const String &p_src);
 	Error flush(bool p_verbose = false);
 
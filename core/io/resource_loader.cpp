@@ -218,12 +218,61 @@ RES ResourceLoader::_load(const String &p_path, const String &p_original_path, c
 	ERR_FAIL_V_MSG(RES(), "No loader found for resource: " + p_path + ".");
 }
 
+void ResourceLoader::ThreadLoadBatch::load_task(uint32_t p_index, void *p_userdata) {
+
+	ThreadLoadTask *load_task = tasks[p_index];
+
+	thread_load_mutex->lock();
+	if (!load_task->queued) { //already taken by a thread waiting for it
+		thread_load_mutex->unlock();
+		return;
+	}
+	load_task->queued = false;
+	thread_load_mutex->unlock();
+
+	_thread_load_function(load_task);
+}
+
+void ResourceLoader::_load_queued(ThreadLoadTask &p_load_task) {
+
+	//called with thread_load_mutex locked, which is held again on return
+
+	bool busy = false;
+	if (thread_load_pool_busy.compare_exchange_strong(busy, true)) {
+
+		// Load everything queued so far on the pool, the task waited for included.
+		ThreadLoadBatch batch;
+		batch.tasks = thread_load_queue;
+		thread_load_queue.clear();
+		thread_load_mutex->unlock();
+
+		if (!thread_load_pool_started) {
+			thread_load_pool.init();
+			thread_load_pool_started = true;
+		}
+		thread_load_pool.do_work(batch.tasks.size(), &batch, &ThreadLoadBatch::load_task, (void *)NULL);
+
+		thread_load_pool_busy.store(false);
+		thread_load_mutex->lock();
+	} else {
+
+		// The pool is loading another batch, possibly the one this thread is part of, so load the task right here.
+		p_load_task.queued = false;
+		thread_load_queue.erase(&p_load_task);
+		thread_load_mutex->unlock();
+
+		_thread_load_function(&p_load_task);
+
+		thread_load_mutex->lock();
+	}
+}
+
 void ResourceLoader::_thread_load_function(void *p_userdata) {
 
 	ThreadLoadTask &load_task = *(ThreadLoadTask *)p_userdata;
 	load_task.loader_id = Thread::get_caller_id();
 
-	if (load_task.semaphore) {
+	if (load_task.semaphore && !load_task.pooled) {
 		//this is an actual thread, so wait for Ok fom semaphore
 		thread_load_semaphore->wait(); //wait until its ok to start loading
 	}
@@ -239,20 +288,24 @@ void ResourceLoader::_thread_load_function(void *p_userdata) {
 	}
 	if (load_task.semaphore) {
 
-		if (load_task.start_next && thread_waiting_count > 0) {
-			thread_waiting_count--;
-			//thread loading count remains constant, this ends but another one begins
-			thread_load_semaphore->post();
-		} else {
-			thread_loading_count--; //no threads waiting, just reduce loading count
-		}
+		if (!load_task.pooled) {
+			if (load_task.start_next && thread_waiting_count > 0) {
+				thread_waiting_count--;
+				//thread loading count remains constant, this ends but another one begins
+				thread_load_semaphore->post();
+			} else {
+				thread_loading_count--; //no threads waiting, just reduce loading count
+			}
 
-		print_lt("END: load count: " + itos(thread_loading_count) + " / wait count: " + itos(thread_waiting_count) + " / suspended count: " + itos(thread_suspended_count) + " / active: " + itos(thread_loading_count - thread_suspended_count));
+			print_lt("END: load count: " + itos(thread_loading_count) + " / wait count: " + itos(thread_waiting_count) + " / suspended count: " + itos(thread_suspended_count) + " / active: " + itos(thread_loading_count - thread_suspended_count));
+		}
 
 		for (int i = 0; i < load_task.poll_requests; i++) {
 			load_task.semaphore->post();
 		}
-		memdelete(load_task.semaphore);
+		if (load_task.poll_requests == 0) {
+			memdelete(load_task.semaphore);
+		} //otherwise threads may still be inside wait(), the last one to leave deletes it
 		load_task.semaphore = nullptr;
 	}
 
@@ -277,7 +330,13 @@ void ResourceLoader::_thread_load_function(void *p_userdata) {
 		}
 	}
 
+	RES resource = load_task.resource;
+
 	thread_load_mutex->unlock();
+
+	if (resource.is_valid()) {
+		ResourceCache::retain(resource, false);
+	}
 }
 Error ResourceLoader::load_threaded_request(const String &p_path, const String &p_type_hint, bool p_use_sub_threads, const String &p_source_resource) {
 
@@ -313,7 +372,10 @@ Error ResourceLoader::load_threaded_request(const String &p_path, const String &
 		if (p_source_resource != String()) {
 			thread_load_tasks[p_source_resource].sub_tasks.insert(local_path);
 		}
+		// Served by the task that is loading or has loaded it, counted as a hit (the resource is null while loading).
+		RES resource = thread_load_tasks[local_path].resource;
 		thread_load_mutex->unlock();
+		ResourceCache::retain(resource, true);
 		return OK;
 	}
 
@@ -355,6 +417,10 @@ Error ResourceLoader::load_threaded_request(const String &p_path, const String &
 			if (ResourceCache::lock) {
 				ResourceCache::lock->read_unlock();
 			}
+
+			if (load_task.resource.is_valid()) {
+				ResourceCache::retain(load_task.resource, true);
+			}
 		}
 
 		if (p_source_resource != String()) {
@@ -366,7 +432,16 @@ Error ResourceLoader::load_threaded_request(const String &p_path, const String &
 
 	ThreadLoadTask &load_task = thread_load_tasks[local_path];
 
-	if (load_task.resource.is_null()) { //needs  to be loaded in thread
+	if (load_task.resource.is_null() && p_source_resource != String()) {
+
+		// Dependencies requested by a format loader wait until it needs one of them, then everything queued
+		// is loaded at once on the pool. No thread is created for each, and the graph is loaded in parallel.
+		load_task.semaphore = memnew(Semaphore);
+		load_task.pooled = true;
+		load_task.queued = true;
+		thread_load_queue.push_back(&load_task);
+
+	} else if (load_task.resource.is_null()) { //needs  to be loaded in thread
 
 		load_task.semaphore = memnew(Semaphore);
 		if (thread_loading_count < thread_load_max) {
@@ -453,6 +528,10 @@ RES ResourceLoader::load_threaded_get(const String &p_path, Error *r_error) {
 
 	ThreadLoadTask &load_task = thread_load_tasks[local_path];
 
+	if (load_task.queued) {
+		_load_queued(load_task);
+	}
+
 	//semaphore still exists, meaning its still loading, request poll
 	Semaphore *semaphore = load_task.semaphore;
 	if (semaphore) {
@@ -468,7 +547,7 @@ RES ResourceLoader::load_threaded_get(const String &p_path, Error *r_error) {
 			// This ensures loading is never blocked and that is also within
 			// the maximum number of active threads.
 
-			if (thread_waiting_count > 0) {
+			if (!load_task.pooled && thread_waiting_count > 0) {
 				thread_waiting_count--;
 				thread_loading_count++;
 				thread_load_semaphore->post();
@@ -494,6 +573,11 @@ RES ResourceLoader::load_threaded_get(const String &p_path, Error *r_error) {
 			}
 			return RES();
 		}
+
+		load_task.poll_requests--;
+		if (load_task.poll_requests == 0) {
+			memdelete(semaphore);
+		}
 	}
 
 	RES resource = load_task.resource;
@@ -562,6 +646,8 @@ RES ResourceLoader::load(const String &p_path, const String &p_type_hint, bool p
 				}
 				thread_load_mutex->unlock();
 
+				ResourceCache::retain(res, true);
+
 				if (r_error) {
 					*r_error = OK;
 				}
@@ -1135,6 +1221,8 @@ void ResourceLoader::initialize() {
 
 void ResourceLoader::finalize() {
 
+	thread_load_pool.finish();
+	thread_load_pool_started = false;
 	memdelete(thread_load_mutex);
 	memdelete(thread_load_semaphore);
 }
@@ -1156,6 +1244,10 @@ int ResourceLoader::thread_loading_count = 0;
 int ResourceLoader::thread_waiting_count = 0;
 int ResourceLoader::thread_suspended_count = 0;
 int ResourceLoader::thread_load_max = 0;
+Vector<ResourceLoader::ThreadLoadTask *> ResourceLoader::thread_load_queue;
+ThreadWorkPool ResourceLoader::thread_load_pool;
+std::atomic<bool> ResourceLoader::thread_load_pool_busy(false);
+bool ResourceLoader::thread_load_pool_started = false;
 
 SelfList<Resource>::List ResourceLoader::remapped_list;
 HashMap<String, Vector<String> > ResourceLoader::translation_remaps;
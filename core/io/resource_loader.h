@@ -34,6 +34,7 @@
 #include "core/os/semaphore.h"
 #include "core/os/thread.h"
 #include "core/resource.h"
+#include "core/thread_work_pool.h"
 
 class ResourceFormatLoader : public Reference {
 
@@ -116,7 +117,7 @@ private:
 		String type_hint;
 		float progress = 0.0;
 		ThreadLoadStatus status = THREAD_LOAD_IN_PROGRESS;
-		Error error;
+		Error error = OK;
 		RES resource;
 		bool xl_remapped = false;
 		bool use_sub_threads = false;
@@ -124,9 +125,17 @@ private:
 		int requests = 0;
 		int poll_requests = 0;
 		Set<String> sub_tasks;
+		bool pooled = false; // Dependency loaded on thread_load_pool, or by the thread waiting for it, instead of its own thread.
+		bool queued = false; // Pooled and not started yet, see thread_load_queue.
+	};
+
+	struct ThreadLoadBatch {
+		Vector<ThreadLoadTask *> tasks;
+		void load_task(uint32_t p_index, void *p_userdata);
 	};
 
 	static void _thread_load_function(void *p_userdata);
+	static void _load_queued(ThreadLoadTask &p_load_task);
 	static Mutex *thread_load_mutex;
 	static HashMap<String, ThreadLoadTask> thread_load_tasks;
 	static Semaphore *thread_load_semaphore;
@@ -134,6 +143,10 @@ private:
 	static int thread_loading_count;
 	static int thread_suspended_count;
 	static int thread_load_max;
+	static Vector<ThreadLoadTask *> thread_load_queue;
+	static ThreadWorkPool thread_load_pool;
+	static std::atomic<bool> thread_load_pool_busy;
+	static bool thread_load_pool_started;
 
 	static float _dependency_get_progress(const String &p_path);
 
@@ -569,8 +569,10 @@ public:
 		for (Set<Object *>::Element *E = change_receptors.front(); E; E = E->next())
 			((Object *)(E->get()))->_changed_callback(this, p_property);
 	}
+	_FORCE_INLINE_ void _mark_edited() { _edited = true; }
 #else
 	_FORCE_INLINE_ void _change_notify(const char *p_what = "") {}
+	_FORCE_INLINE_ void _mark_edited() {}
 #endif
 	static void *get_class_ptr_static() {
 		static int ptr;
@@ -752,6 +754,25 @@ public:
 bool predelete_handler(Object *p_object);
 void postinitialize_handler(Object *p_object);
 
+#ifdef DEBUG_ENABLED
+
+// Keeps an object from being freed while one of its methods is running.
+// Exposed so script VMs that call resolved methods directly get the same protection as Object::call().
+struct _ObjectDebugLock {
+
+	Object *obj;
+
+	_ObjectDebugLock(Object *p_obj) {
+		obj = p_obj;
+		obj->_lock_index.ref();
+	}
+	~_ObjectDebugLock() {
+		obj->_lock_index.unref();
+	}
+};
+
+#endif
+
 class ObjectDB {
 
 //this needs to add up to 63, 1 bit is for reference
@@ -37,6 +37,7 @@
 #include "core/project_settings.h"
 
 FileAccess::CreateFunc FileAccess::create_func[ACCESS_MAX] = { 0, 0 };
+FileAccess::CreateFunc FileAccess::create_mapped_func[ACCESS_MAX] = { 0, 0 };
 
 FileAccess::FileCloseFailNotify FileAccess::close_fail_notify = NULL;
 
@@ -119,6 +120,33 @@ FileAccess *FileAccess::open(const String &p_path, int p_mode_flags, Error *r_er
 	return ret;
 }
 
+FileAccess *FileAccess::open_mapped(const String &p_path, Error *r_error) {
+
+	AccessType access = ACCESS_FILESYSTEM;
+	if (p_path.begins_with("res://")) {
+		access = ACCESS_RESOURCES;
+	} else if (p_path.begins_with("user://")) {
+		access = ACCESS_USERDATA;
+	}
+
+	// Packed files are slices of the mapped pack already.
+	bool packed = PackedData::get_singleton() && !PackedData::get_singleton()->is_disabled() && PackedData::get_singleton()->has_path(p_path);
+
+	if (create_mapped_func[access] && !packed) {
+
+		FileAccess *ret = create_mapped_func[access]();
+		ret->_set_access_type(access);
+		if (ret->_open(p_path, READ) == OK) {
+			if (r_error)
+				*r_error = OK;
+			return ret;
+		}
+		memdelete(ret);
+	}
+
+	return open(p_path, READ, r_error);
+}
+
 FileAccess::CreateFunc FileAccess::get_create_func(AccessType p_access) {
 
 	return create_func[p_access];
@@ -71,6 +71,7 @@ private:
 
 	AccessType _access_type;
 	static CreateFunc create_func[ACCESS_MAX]; /** default file access creation function for a platform */
+	static CreateFunc create_mapped_func[ACCESS_MAX]; /** read-only file access mapping files in memory, if the platform has one */
 	template <class T>
 	static FileAccess *_create_builtin() {
 
@@ -113,6 +114,7 @@ public:
 	virtual real_t get_real() const;
 
 	virtual int get_buffer(uint8_t *p_dst, int p_length) const; ///< get an array of bytes
+	virtual const uint8_t *get_buffer_ptr(int p_length) const { return NULL; } ///< get the next bytes without copying them, NULL (and nothing read) unless the file is in memory
 	virtual String get_line() const;
 	virtual String get_token() const;
 	virtual Vector<String> get_csv_line(const String &p_delim = ",") const;
@@ -154,6 +156,7 @@ public:
 	static FileAccess *create(AccessType p_access); /// Create a file access (for the current platform) this is the only portable way of accessing files.
 	static FileAccess *create_for_path(const String &p_path);
 	static FileAccess *open(const String &p_path, int p_mode_flags, Error *r_error = NULL); /// Create a file access (for the current platform) this is the only portable way of accessing files.
+	static FileAccess *open_mapped(const String &p_path, Error *r_error = NULL); /// Open a file for reading, mapped in memory when the platform supports it.
 	static CreateFunc get_create_func(AccessType p_access);
 	static bool exists(const String &p_name); ///< return true if a file exists
 	static uint64_t get_modified_time(const String &p_file);
@@ -174,6 +177,13 @@ public:
 	static void make_default(AccessType p_access) {
 
 		create_func[p_access] = _create_builtin<T>;
+		create_mapped_func[p_access] = NULL; // Set again through make_default_mapped() if T can be mapped.
+	}
+
+	template <class T>
+	static void make_default_mapped(AccessType p_access) {
+
+		create_mapped_func[p_access] = _create_builtin<T>;
 	}
 
 	FileAccess();
@@ -32,6 +32,7 @@
 
 #include "core/bind/core_bind.h"
 #include "core/core_string_names.h"
+#include "core/io/file_access_compressed.h"
 #include "core/io/file_access_network.h"
 #include "core/io/file_access_pack.h"
 #include "core/io/marshalls.h"
@@ -1209,6 +1210,11 @@ ProjectSettings::ProjectSettings() {
 	Compression::zstd_window_log_size = GLOBAL_DEF("compression/formats/zstd/window_log_size", 27);
 	custom_prop_info["compression/formats/zstd/window_log_size"] = PropertyInfo(Variant::INT, "compression/formats/zstd/window_log_size", PROPERTY_HINT_RANGE, "10,30,1");
 
+	FileAccessCompressed::default_block_size = GLOBAL_DEF("compression/formats/compressed_files/block_size", 4096);
+	custom_prop_info["compression/formats/compressed_files/block_size"] = PropertyInfo(Variant::INT, "compression/formats/compressed_files/block_size", PROPERTY_HINT_RANGE, "4096,4194304,4096");
+	FileAccessCompressed::read_ahead_blocks = GLOBAL_DEF("compression/formats/compressed_files/read_ahead_blocks", 64);
+	custom_prop_info["compression/formats/compressed_files/read_ahead_blocks"] = PropertyInfo(Variant::INT, "compression/formats/compressed_files/read_ahead_blocks", PROPERTY_HINT_RANGE, "1,256,1");
+
 	Compression::zlib_level = GLOBAL_DEF("compression/formats/zlib/compression_level", Z_DEFAULT_COMPRESSION);
 	custom_prop_info["compression/formats/zlib/compression_level"] = PropertyInfo(Variant::INT, "compression/formats/zlib/compression_level", PROPERTY_HINT_RANGE, "-1,9,1");
 
@@ -41,6 +41,7 @@
 #include "core/input_map.h"
 #include "core/io/config_file.h"
 #include "core/io/dtls_server.h"
+#include "core/io/file_access_compressed.h"
 #include "core/io/http_client.h"
 #include "core/io/image_loader.h"
 #include "core/io/marshalls.h"
@@ -304,6 +305,8 @@ void unregister_core_types() {
 		memdelete(ip);
 
 	ResourceLoader::finalize();
+	FileAccessCompressed::finish_decompress_pool();
+	Image::finish_work_pool();
 
 	ClassDB::cleanup_defaults();
 	ObjectDB::cleanup();
@@ -428,8 +428,14 @@ void Resource::_bind_methods() {
 	BIND_VMETHOD(MethodInfo("_setup_local_to_scene"));
 }
 
+uint64_t Resource::get_memory_size_estimate() const {
+
+	return 1024;
+}
+
 Resource::Resource() :
-		remapped_list(this) {
+		remapped_list(this),
+		retained_list(this) {
 
 #ifdef TOOLS_ENABLED
 	last_modified_time = 0;
@@ -439,6 +445,7 @@ Resource::Resource() :
 	subindex = 0;
 	local_to_scene = false;
 	local_scene = NULL;
+	retained_size = 0;
 }
 
 Resource::~Resource() {
@@ -463,6 +470,15 @@ RWLock *ResourceCache::lock = NULL;
 RWLock *ResourceCache::path_cache_lock = NULL;
 #endif
 
+Mutex ResourceCache::retain_mutex;
+SelfList<Resource>::List ResourceCache::retained;
+uint64_t ResourceCache::retain_budget = 0;
+uint64_t ResourceCache::retained_bytes = 0;
+int ResourceCache::retained_count = 0;
+uint64_t ResourceCache::retain_hits = 0;
+uint64_t ResourceCache::retain_misses = 0;
+uint64_t ResourceCache::retain_evictions = 0;
+
 void ResourceCache::setup() {
 
 	lock = RWLock::create();
@@ -472,6 +488,8 @@ void ResourceCache::setup() {
 }
 
 void ResourceCache::clear() {
+	clear_retained();
+
 	if (resources.size())
 		ERR_PRINT("Resources Still in use at Exit!");
 
@@ -479,6 +497,98 @@ void ResourceCache::clear() {
 	memdelete(lock);
 }
 
+void ResourceCache::_evict_retained(uint64_t p_budget, Vector<RES> *r_released) {
+
+	// Oldest first. The references are handed back to the caller, so resources
+	// that were only kept alive here are freed once retain_mutex is released.
+	while (retained_bytes > p_budget && retained.last()) {
+		Resource *r = retained.last()->self();
+		retained.remove(&r->retained_list);
+		retained_bytes -= r->retained_size;
+		retained_count--;
+		retain_evictions++;
+
+		r_released->push_back(RES(r));
+		r->unreference();
+	}
+}
+
+void ResourceCache::set_retain_budget(uint64_t p_bytes) {
+
+	Vector<RES> released;
+
+	retain_mutex.lock();
+	retain_budget = p_bytes;
+	_evict_retained(retain_budget, &released);
+	retain_mutex.unlock();
+}
+
+uint64_t ResourceCache::get_retain_budget() {
+
+	return retain_budget;
+}
+
+void ResourceCache::retain(const RES &p_resource, bool p_hit) {
+
+	if (p_hit) {
+		atomic_increment(&retain_hits);
+	} else {
+		atomic_increment(&retain_misses);
+	}
+
+	if (retain_budget == 0 || p_resource.is_null()) {
+		return;
+	}
+
+	Resource *r = const_cast<Resource *>(p_resource.ptr());
+	Vector<RES> released;
+
+	retain_mutex.lock();
+
+	if (r->retained_list.in_list()) {
+		retained.remove(&r->retained_list);
+		retained.add(&r->retained_list);
+	} else {
+		uint64_t size = r->get_memory_size_estimate();
+		if (size <= retain_budget) {
+			// Keep a reference, so the resource stays in the cache once everything else releases it.
+			r->reference();
+			r->retained_size = size;
+			retained.add(&r->retained_list);
+			retained_bytes += size;
+			retained_count++;
+			_evict_retained(retain_budget, &released);
+		}
+	}
+
+	retain_mutex.unlock();
+}
+
+void ResourceCache::clear_retained() {
+
+	Vector<RES> released;
+
+	retain_mutex.lock();
+	_evict_retained(0, &released);
+	retain_mutex.unlock();
+}
+
+ResourceCache::RetainStats ResourceCache::get_retain_stats() {
+
+	RetainStats stats;
+
+	retain_mutex.lock();
+	stats.budget = retain_budget;
+	stats.retained_bytes = retained_bytes;
+	stats.retained_count = retained_count;
+	stats.hits = retain_hits;
+	stats.misses = retain_misses;
+	stats.evictions = retain_evictions;
+	retain_mutex.unlock();
+
+	return stats;
+}
+
 void ResourceCache::reload_externals() {
 
 	/*
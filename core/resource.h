@@ -33,6 +33,7 @@
 
 #include "core/class_db.h"
 #include "core/object.h"
+#include "core/os/mutex.h"
 #include "core/reference.h"
 #include "core/safe_refcount.h"
 #include "core/self_list.h"
@@ -73,6 +74,9 @@ class Resource : public Reference {
 
 	SelfList<Resource> remapped_list;
 
+	SelfList<Resource> retained_list;
+	uint64_t retained_size;
+
 protected:
 	void emit_changed();
 
@@ -131,6 +135,7 @@ public:
 	bool is_translation_remapped() const;
 
 	virtual RID get_rid() const; // some resources may offer conversion to RID
+	virtual uint64_t get_memory_size_estimate() const; // bytes kept alive by this resource, used to budget ResourceCache retention
 
 #ifdef TOOLS_ENABLED
 	//helps keep IDs same number when loading/saving scenes. -1 clears ID and it Returns -1 when no id stored
@@ -158,7 +163,33 @@ class ResourceCache {
 	friend void register_core_types();
 	static void setup();
 
+	static Mutex retain_mutex;
+	static SelfList<Resource>::List retained; // Most recently used first.
+	static uint64_t retain_budget;
+	static uint64_t retained_bytes;
+	static int retained_count;
+	static uint64_t retain_hits;
+	static uint64_t retain_misses;
+	static uint64_t retain_evictions;
+
+	static void _evict_retained(uint64_t p_budget, Vector<RES> *r_released);
+
 public:
+	struct RetainStats {
+		uint64_t budget = 0;
+		uint64_t retained_bytes = 0;
+		int retained_count = 0;
+		uint64_t hits = 0;
+		uint64_t misses = 0;
+		uint64_t evictions = 0;
+	};
+
+	static void set_retain_budget(uint64_t p_bytes);
+	static uint64_t get_retain_budget();
+	static void retain(const RES &p_resource, bool p_hit);
+	static void clear_retained();
+	static RetainStats get_retain_stats();
+
 	static void reload_externals();
 	static bool has(const String &p_path);
 	static Resource *get(const String &p_path);
@@ -193,6 +193,7 @@ public:
 
 	virtual Object *get_owner() { return NULL; }
 	virtual void get_property_state(List<Pair<StringName, Variant> > &state);
+	virtual bool reset_state() { return false; } // Back to the state of a new instance, so the object can be reused. False if it can't be.
 
 	virtual void get_method_list(List<MethodInfo> *p_list) const = 0;
 	virtual bool has_method(const StringName &p_method) const = 0;
@@ -0,0 +1,194 @@
+/*************************************************************************/
+/*  variant_internal.h                                                   */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2020 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2020 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef VARIANT_INTERNAL_H
+#define VARIANT_INTERNAL_H
+
+#include "core/variant.h"
+
+// Direct access to the storage of a Variant whose type is already known.
+// Meant for interpreters that check types once and then operate on the raw
+// values, callers are responsible for checking get_type() before any access.
+class VariantInternal {
+public:
+	_FORCE_INLINE_ static bool *get_bool(Variant *v) { return &v->_data._bool; }
+	_FORCE_INLINE_ static const bool *get_bool(const Variant *v) { return &v->_data._bool; }
+	_FORCE_INLINE_ static int64_t *get_int(Variant *v) { return &v->_data._int; }
+	_FORCE_INLINE_ static const int64_t *get_int(const Variant *v) { return &v->_data._int; }
+	_FORCE_INLINE_ static double *get_float(Variant *v) { return &v->_data._float; }
+	_FORCE_INLINE_ static const double *get_float(const Variant *v) { return &v->_data._float; }
+	_FORCE_INLINE_ static String *get_string(Variant *v) { return reinterpret_cast<String *>(v->_data._mem); }
+	_FORCE_INLINE_ static const String *get_string(const Variant *v) { return reinterpret_cast<const String *>(v->_data._mem); }
+	_FORCE_INLINE_ static Vector2 *get_vector2(Variant *v) { return reinterpret_cast<Vector2 *>(v->_data._mem); }
+	_FORCE_INLINE_ static const Vector2 *get_vector2(const Variant *v) { return reinterpret_cast<const Vector2 *>(v->_data._mem); }
+	_FORCE_INLINE_ static Vector3 *get_vector3(Variant *v) { return reinterpret_cast<Vector3 *>(v->_data._mem); }
+	_FORCE_INLINE_ static const Vector3 *get_vector3(const Variant *v) { return reinterpret_cast<const Vector3 *>(v->_data._mem); }
+	_FORCE_INLINE_ static Array *get_array(Variant *v) { return reinterpret_cast<Array *>(v->_data._mem); }
+	_FORCE_INLINE_ static const Array *get_array(const Variant *v) { return reinterpret_cast<const Array *>(v->_data._mem); }
+
+	// Only valid for the PACKED_*_ARRAY type storing T.
+	template <class T>
+	_FORCE_INLINE_ static Vector<T> *get_packed_array(const Variant *v) { return Variant::PackedArrayRef<T>::get_array_ptr(v->_data.packed_array); }
+
+	// Numeric value of an INT or FLOAT variant.
+	_FORCE_INLINE_ static double get_number(const Variant *v) { return v->type == Variant::INT ? double(v->_data._int) : v->_data._float; }
+
+	_FORCE_INLINE_ static void set_bool(Variant *v, bool p_value) {
+		if (v->type != Variant::BOOL) {
+			_reset(v, Variant::BOOL);
+		}
+		v->_data._bool = p_value;
+	}
+	_FORCE_INLINE_ static void set_int(Variant *v, int64_t p_value) {
+		if (v->type != Variant::INT) {
+			_reset(v, Variant::INT);
+		}
+		v->_data._int = p_value;
+	}
+	_FORCE_INLINE_ static void set_float(Variant *v, double p_value) {
+		if (v->type != Variant::FLOAT) {
+			_reset(v, Variant::FLOAT);
+		}
+		v->_data._float = p_value;
+	}
+	_FORCE_INLINE_ static void set_vector2(Variant *v, const Vector2 &p_value) {
+		if (v->type != Variant::VECTOR2) {
+			_reset(v, Variant::VECTOR2);
+		}
+		*get_vector2(v) = p_value;
+	}
+	_FORCE_INLINE_ static void set_vector3(Variant *v, const Vector3 &p_value) {
+		if (v->type != Variant::VECTOR3) {
+			_reset(v, Variant::VECTOR3);
+		}
+		*get_vector3(v) = p_value;
+	}
+
+	// Types whose PtrToArg encoding is the storage of a Variant holding them, so method
+	// binds can be ptrcalled with get_inline_pointer() for arguments of that type.
+	_FORCE_INLINE_ static bool is_ptrcall_type(Variant::Type p_type) {
+		switch (p_type) {
+			case Variant::NIL: // Variant arguments.
+			case Variant::BOOL:
+			case Variant::INT:
+			case Variant::FLOAT:
+			case Variant::STRING:
+			case Variant::VECTOR2:
+			case Variant::RECT2:
+			case Variant::VECTOR3:
+			case Variant::PLANE:
+			case Variant::QUAT:
+			case Variant::COLOR:
+			case Variant::STRING_NAME:
+			case Variant::NODE_PATH:
+			case Variant::DICTIONARY:
+			case Variant::ARRAY:
+				return true;
+			default:
+				return false;
+		}
+	}
+
+	// Makes v a default constructed value of p_type and returns a pointer to its storage,
+	// laid out the way PtrToArg expects. Returns NULL for types that aren't stored inline.
+	static void *initialize_inline(Variant *v, Variant::Type p_type) {
+		if (v->type != p_type) {
+			switch (p_type) {
+				case Variant::NIL:
+				case Variant::BOOL:
+				case Variant::INT:
+				case Variant::FLOAT:
+				case Variant::STRING:
+				case Variant::VECTOR2:
+				case Variant::VECTOR2I:
+				case Variant::RECT2:
+				case Variant::RECT2I:
+				case Variant::VECTOR3:
+				case Variant::VECTOR3I:
+				case Variant::PLANE:
+				case Variant::QUAT:
+				case Variant::COLOR:
+				case Variant::STRING_NAME:
+				case Variant::NODE_PATH:
+				case Variant::DICTIONARY:
+				case Variant::ARRAY:
+					break;
+				default:
+					return NULL;
+			}
+			Callable::CallError ce;
+			*v = Variant::construct(p_type, NULL, 0, ce);
+		}
+		return get_inline_pointer(v);
+	}
+
+	// Pointer to the storage of types kept inside the Variant itself, NULL otherwise.
+	// NIL stands for "any type" in method signatures, so the Variant itself is returned.
+	_FORCE_INLINE_ static void *get_inline_pointer(Variant *v) {
+		switch (v->type) {
+			case Variant::NIL:
+				return v;
+			case Variant::BOOL:
+				return &v->_data._bool;
+			case Variant::INT:
+				return &v->_data._int;
+			case Variant::FLOAT:
+				return &v->_data._float;
+			case Variant::STRING:
+			case Variant::VECTOR2:
+			case Variant::VECTOR2I:
+			case Variant::RECT2:
+			case Variant::RECT2I:
+			case Variant::VECTOR3:
+			case Variant::VECTOR3I:
+			case Variant::PLANE:
+			case Variant::QUAT:
+			case Variant::COLOR:
+			case Variant::STRING_NAME:
+			case Variant::NODE_PATH:
+			case Variant::DICTIONARY:
+			case Variant::ARRAY:
+				return v->_data._mem;
+			default:
+				return NULL;
+		}
+	}
+
+private:
+	_FORCE_INLINE_ static void _reset(Variant *v, Variant::Type p_type) {
+		if (v->type != Variant::NIL) {
+			v->clear();
+		}
+		v->type = p_type;
+		v->_data._int = 0;
+	}
+};
+
+#endif // VARIANT_INTERNAL_H
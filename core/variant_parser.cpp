@@ -35,38 +35,56 @@
 #include "core/os/keyboard.h"
 #include "core/string_buffer.h"
 
-CharType VariantParser::StreamFile::get_char() {
+CharType VariantParser::Stream::_read_ahead() {
 
-	return f->get_8();
+	readahead_filled = _read_buffer(readahead_buffer, readahead_enabled ? READAHEAD_SIZE : 1);
+	if (readahead_filled == 0) {
+		// You need to try to read again when you have reached the end for EOF to be reported.
+		eof = true;
+		return 0;
+	}
+
+	readahead_pointer = 1;
+	return readahead_buffer[0];
+}
+
+uint32_t VariantParser::StreamFile::_read_buffer(CharType *p_buffer, uint32_t p_num_chars) {
+
+	// Bytes are handed out one per character, tokens decode UTF-8 once they are complete.
+	uint8_t bytes[READAHEAD_SIZE];
+	int read = f->get_buffer(bytes, MIN(p_num_chars, (uint32_t)READAHEAD_SIZE));
+	for (int i = 0; i < read; i++) {
+		p_buffer[i] = bytes[i];
+	}
+	return MAX(read, 0);
 }
 
 bool VariantParser::StreamFile::is_utf8() const {
 
 	return true;
 }
-bool VariantParser::StreamFile::is_eof() const {
+bool VariantParser::StreamFile::_is_eof() const {
 
 	return f->eof_reached();
 }
 
-CharType VariantParser::StreamString::get_char() {
+uint32_t VariantParser::StreamString::_read_buffer(CharType *p_buffer, uint32_t p_num_chars) {
 
-	if (pos > s.length()) {
+	int read = MIN((int)p_num_chars, s.length() - pos);
+	if (read <= 0) {
+		pos = s.length() + 1;
 		return 0;
-	} else if (pos == s.length()) {
-		// You need to try to read again when you have reached the end for EOF to be reported,
-		// so this works the same as files (like StreamFile does)
-		pos++;
-		return 0;
-	} else {
-		return s[pos++];
 	}
+
+	memcpy(p_buffer, s.ptr() + pos, read * sizeof(CharType));
+	pos += read;
+	return read;
 }
 
 bool VariantParser::StreamString::is_utf8() const {
 	return false;
 }
-bool VariantParser::StreamString::is_eof() const {
+bool VariantParser::StreamString::_is_eof() const {
 	return pos > s.length();
 }
 
@@ -92,6 +110,30 @@ const char *VariantParser::tk_name[TK_MAX] = {
 	"ERROR"
 };
 
+// Every power of ten up to 1e22 is exactly representable as a double.
+static const double _pow10_exact[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Computes p_mantissa * 10^p_exponent with a single rounding, which is only possible when
+// both operands are exact doubles. Returns false for everything else (long mantissas, large
+// exponents), which then needs a full conversion from the text.
+static _FORCE_INLINE_ bool _make_double_exact(uint64_t p_mantissa, int p_exponent, double &r_value) {
+
+	if (p_mantissa > (uint64_t(1) << 53) || p_exponent < -22 || p_exponent > 22) {
+		return false;
+	}
+
+	double value = double(p_mantissa);
+	if (p_exponent < 0) {
+		r_value = value / _pow10_exact[-p_exponent];
+	} else {
+		r_value = value * _pow10_exact[p_exponent];
+	}
+	return true;
+}
+
 Error VariantParser::get_token(Stream *p_stream, Token &r_token, int &line, String &r_err_str) {
 
 	bool string_name = false;
@@ -220,7 +262,8 @@ Error VariantParser::get_token(Stream *p_stream, Token &r_token, int &line, Stri
 			}
 			case '"': {
 
-				String str;
+				StringBuffer<> str;
+				bool ascii = true;
 				while (true) {
 
 					CharType ch = p_stream->get_char();
@@ -288,24 +331,27 @@ Error VariantParser::get_token(Stream *p_stream, Token &r_token, int &line, Stri
 						}
 
 						str += res;
+						ascii = ascii && res < 128;
 
 					} else {
 						if (ch == '\n')
 							line++;
 						str += ch;
+						ascii = ascii && ch < 128;
 					}
 				}
 
-				if (p_stream->is_utf8()) {
-					str.parse_utf8(str.ascii(true).get_data());
+				String s = str.as_string();
+				if (p_stream->is_utf8() && !ascii) {
+					s.parse_utf8(s.ascii(true).get_data());
 				}
 				if (string_name) {
 					r_token.type = TK_STRING_NAME;
-					r_token.value = StringName(str);
+					r_token.value = StringName(s);
 					string_name = false; //reset
 				} else {
 					r_token.type = TK_STRING;
-					r_token.value = str;
+					r_token.value = s;
 				}
 				return OK;
 
@@ -327,8 +373,10 @@ Error VariantParser::get_token(Stream *p_stream, Token &r_token, int &line, Stri
 #define READING_DONE 4
 					int reading = READING_INT;
 
+					bool negative = false;
 					if (cchar == '-') {
 						num += '-';
+						negative = true;
 						cchar = p_stream->get_char();
 					}
 
@@ -337,13 +385,23 @@ Error VariantParser::get_token(Stream *p_stream, Token &r_token, int &line, Stri
 					bool exp_beg = false;
 					bool is_float = false;
 
+					// The value is accumulated while reading, so most numbers need no second pass over the text.
+					uint64_t mantissa = 0;
+					int mantissa_digits = 0;
+					int exponent = 0;
+					int exp_value = 0;
+					bool exp_negative = false;
+
 					while (true) {
 
 						switch (reading) {
 							case READING_INT: {
 
 								if (c >= '0' && c <= '9') {
-									//pass
+									if (mantissa != 0 || c != '0') {
+										mantissa_digits++;
+									}
+									mantissa = mantissa * 10 + (c - '0');
 								} else if (c == '.') {
 									reading = READING_DEC;
 									is_float = true;
@@ -358,7 +416,11 @@ Error VariantParser::get_token(Stream *p_stream, Token &r_token, int &line, Stri
 							case READING_DEC: {
 
 								if (c >= '0' && c <= '9') {
-
+									if (mantissa != 0 || c != '0') {
+										mantissa_digits++;
+									}
+									mantissa = mantissa * 10 + (c - '0');
+									exponent--;
 								} else if (c == 'e') {
 									reading = READING_EXP;
 								} else {
@@ -370,9 +432,13 @@ Error VariantParser::get_token(Stream *p_stream, Token &r_token, int &line, Stri
 
 								if (c >= '0' && c <= '9') {
 									exp_beg = true;
+									if (exp_value < 10000) {
+										exp_value = exp_value * 10 + (c - '0');
+									}
 
 								} else if ((c == '-' || c == '+') && !exp_sign && !exp_beg) {
 									exp_sign = true;
+									exp_negative = c == '-';
 
 								} else {
 									reading = READING_DONE;
@@ -390,10 +456,19 @@ Error VariantParser::get_token(Stream *p_stream, Token &r_token, int &line, Stri
 
 					r_token.type = TK_NUMBER;
 
-					if (is_float)
-						r_token.value = num.as_double();
-					else
+					if (is_float) {
+						double value;
+						bool exp_valid = exp_beg || !exp_sign;
+						if (exp_valid && mantissa_digits <= 19 && _make_double_exact(mantissa, exponent + (exp_negative ? -exp_value : exp_value), value)) {
+							r_token.value = negative ? -value : value;
+						} else {
+							r_token.value = num.as_double();
+						}
+					} else if (mantissa_digits <= 18) {
+						r_token.value = negative ? -int64_t(mantissa) : int64_t(mantissa);
+					} else {
 						r_token.value = num.as_int();
+					}
 					return OK;
 
 				} else if ((cchar >= 'A' && cchar <= 'Z') || (cchar >= 'a' && cchar <= 'z') || cchar == '_') {
@@ -458,6 +533,21 @@ Error VariantParser::_parse_enginecfg(Stream *p_stream, Vector<String> &strings,
 	}
 }
 
+// Reals without a number literal, as written by VariantWriter.
+static bool _parse_special_real(const String &p_id, double &r_value) {
+
+	if (p_id == "inf") {
+		r_value = Math_INF;
+	} else if (p_id == "inf_neg") {
+		r_value = -Math_INF;
+	} else if (p_id == "nan") {
+		r_value = Math_NAN;
+	} else {
+		return false;
+	}
+	return true;
+}
+
 template <class T>
 Error VariantParser::_parse_construct(Stream *p_stream, Vector<T> &r_construct, int &line, String &r_err_str) {
 
@@ -484,8 +574,11 @@ Error VariantParser::_parse_construct(Stream *p_stream, Vector<T> &r_construct,
 		}
 		get_token(p_stream, token, line, r_err_str);
 
+		double special;
 		if (first && token.type == TK_PARENTHESIS_CLOSE) {
 			break;
+		} else if (token.type == TK_IDENTIFIER && _parse_special_real(token.value, special)) {
+			token.value = special;
 		} else if (token.type != TK_NUMBER) {
 			r_err_str = "Expected float in constructor";
 			return ERR_PARSE_ERROR;
@@ -526,12 +619,15 @@ Error VariantParser::parse_value(Token &token, Variant &value, Stream *p_stream,
 	} else if (token.type == TK_IDENTIFIER) {
 
 		String id = token.value;
+		double special;
 		if (id == "true")
 			value = true;
 		else if (id == "false")
 			value = false;
 		else if (id == "null" || id == "nil")
 			value = Variant();
+		else if (_parse_special_real(id, special))
+			value = special;
 		else if (id == "Vector2") {
 
 			Vector<float> args;
@@ -948,17 +1044,7 @@ Error VariantParser::parse_value(Token &token, Variant &value, Stream *p_stream,
 			if (err)
 				return err;
 
-			Vector<int32_t> arr;
-			{
-				int32_t len = args.size();
-				arr.resize(len);
-				int32_t *w = arr.ptrw();
-				for (int32_t i = 0; i < len; i++) {
-					w[i] = int32_t(args[i]);
-				}
-			}
-
-			value = arr;
+			value = args;
 
 			return OK;
 
@@ -969,17 +1055,7 @@ Error VariantParser::parse_value(Token &token, Variant &value, Stream *p_stream,
 			if (err)
 				return err;
 
-			Vector<int64_t> arr;
-			{
-				int64_t len = args.size();
-				arr.resize(len);
-				int64_t *w = arr.ptrw();
-				for (int64_t i = 0; i < len; i++) {
-					w[i] = int64_t(args[i]);
-				}
-			}
-
-			value = arr;
+			value = args;
 
 			return OK;
 
@@ -990,17 +1066,7 @@ Error VariantParser::parse_value(Token &token, Variant &value, Stream *p_stream,
 			if (err)
 				return err;
 
-			Vector<float> arr;
-			{
-				int len = args.size();
-				arr.resize(len);
-				float *w = arr.ptrw();
-				for (int i = 0; i < len; i++) {
-					w[i] = args[i];
-				}
-			}
-
-			value = arr;
+			value = args;
 
 			return OK;
 		} else if (id == "PackedFloat64Array") {
@@ -1010,17 +1076,7 @@ Error VariantParser::parse_value(Token &token, Variant &value, Stream *p_stream,
 			if (err)
 				return err;
 
-			Vector<double> arr;
-			{
-				int len = args.size();
-				arr.resize(len);
-				double *w = arr.ptrw();
-				for (int i = 0; i < len; i++) {
-					w[i] = args[i];
-				}
-			}
-
-			value = arr;
+			value = args;
 
 			return OK;
 		} else if (id == "PackedStringArray" || id == "PoolStringArray" || id == "StringArray") {
@@ -1288,9 +1344,9 @@ Error VariantParser::_parse_tag(Token &token, Stream *p_stream, int &line, Strin
 
 	if (p_simple_tag) {
 
-		r_tag.name = "";
 		r_tag.fields.clear();
 
+		StringBuffer<> name;
 		while (true) {
 
 			CharType c = p_stream->get_char();
@@ -1300,10 +1356,10 @@ Error VariantParser::_parse_tag(Token &token, Stream *p_stream, int &line, Strin
 			}
 			if (c == ']')
 				break;
-			r_tag.name += String::chr(c);
+			name += c;
 		}
 
-		r_tag.name = r_tag.name.strip_edges();
+		r_tag.name = name.as_string().strip_edges();
 
 		return OK;
 	}
@@ -1389,7 +1445,7 @@ Error VariantParser::parse_tag_assign_eof(Stream *p_stream, int &line, String &r
 
 	//assign..
 	r_assign = "";
-	String what;
+	StringBuffer<> what;
 
 	while (true) {
 
@@ -1438,12 +1494,13 @@ Error VariantParser::parse_tag_assign_eof(Stream *p_stream, int &line, String &r
 					return ERR_INVALID_DATA;
 				}
 
-				what = tk.value;
+				what = StringBuffer<>();
+				what += String(tk.value);
 
 			} else if (c != '=') {
-				what += String::chr(c);
+				what += c;
 			} else {
-				r_assign = what;
+				r_assign = what.as_string();
 				Token token;
 				get_token(p_stream, token, line, r_err_str);
 				Error err = parse_value(token, r_value, p_stream, line, r_err_str, p_res_parser);
@@ -1477,6 +1534,10 @@ static String rtosfix(double p_value) {
 
 	if (p_value == 0.0)
 		return "0"; //avoid negative zero (-0) being written, which may annoy git, svn, etc. for changes when they don't exist.
+	else if (Math::is_nan(p_value))
+		return "nan";
+	else if (Math::is_inf(p_value))
+		return p_value > 0 ? "inf" : "inf_neg";
 	else
 		return rtoss(p_value);
 }
@@ -1499,7 +1560,7 @@ Error VariantWriter::write(const Variant &p_variant, StoreStringFunc p_store_str
 		case Variant::FLOAT: {
 
 			String s = rtosfix(p_variant.operator real_t());
-			if (s.find(".") == -1 && s.find("e") == -1)
+			if (s != "inf" && s != "inf_neg" && s != "nan" && s.find(".") == -1 && s.find("e") == -1)
 				s += ".0";
 			p_store_string_func(p_store_string_ud, s);
 		} break;
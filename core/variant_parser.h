@@ -39,36 +39,82 @@ class VariantParser {
 public:
 	struct Stream {
 
-		virtual CharType get_char() = 0;
-		virtual bool is_utf8() const = 0;
-		virtual bool is_eof() const = 0;
+	protected:
+		enum {
+			READAHEAD_SIZE = 2048
+		};
+
+	private:
+		CharType readahead_buffer[READAHEAD_SIZE];
+		uint32_t readahead_pointer;
+		uint32_t readahead_filled;
+		bool eof;
+
+		CharType _read_ahead();
+
+	protected:
+		bool readahead_enabled;
 
+		// Reads up to p_num_chars (at least one) into p_buffer, returns how many were read, zero at the end.
+		virtual uint32_t _read_buffer(CharType *p_buffer, uint32_t p_num_chars) = 0;
+		virtual bool _is_eof() const = 0;
+
+	public:
 		CharType saved;
 
+		_FORCE_INLINE_ CharType get_char() {
+
+			if (readahead_pointer < readahead_filled) {
+				return readahead_buffer[readahead_pointer++];
+			}
+			return _read_ahead();
+		}
+
+		_FORCE_INLINE_ bool is_eof() const {
+
+			return readahead_enabled ? eof : _is_eof();
+		}
+
+		virtual bool is_utf8() const = 0;
+
 		Stream() :
+				readahead_pointer(0),
+				readahead_filled(0),
+				eof(false),
+				readahead_enabled(true),
 				saved(0) {}
 		virtual ~Stream() {}
 	};
 
 	struct StreamFile : public Stream {
 
+	protected:
+		virtual uint32_t _read_buffer(CharType *p_buffer, uint32_t p_num_chars);
+		virtual bool _is_eof() const;
+
+	public:
 		FileAccess *f;
 
-		virtual CharType get_char();
 		virtual bool is_utf8() const;
-		virtual bool is_eof() const;
 
-		StreamFile() { f = NULL; }
+		// Without readahead, the file position stays right after the last character read.
+		StreamFile(bool p_readahead_enabled = true) {
+			f = NULL;
+			readahead_enabled = p_readahead_enabled;
+		}
 	};
 
 	struct StreamString : public Stream {
 
+	protected:
+		virtual uint32_t _read_buffer(CharType *p_buffer, uint32_t p_num_chars);
+		virtual bool _is_eof() const;
+
+	public:
 		String s;
 		int pos;
 
-		virtual CharType get_char();
 		virtual bool is_utf8() const;
-		virtual bool is_eof() const;
 
 		StreamString() { pos = 0; }
 	};
@@ -764,6 +764,8 @@ public:
 	void canvas_render_items(Item *p_item_list, int p_z, const Color &p_modulate, Light *p_light, const Transform2D &p_transform){};
 	void canvas_debug_viewport_shadows(Light *p_lights_with_shadow){};
 
+	int get_render_info(VS::RenderInfo p_info) { return 0; }
+
 	void canvas_light_shadow_buffer_update(RID p_buffer, const Transform2D &p_light_xform, int p_light_mask, float p_near, float p_far, LightOccluderInstance *p_occluders, CameraMatrix *p_xform_cache) {}
 
 	void reset_canvas() {}
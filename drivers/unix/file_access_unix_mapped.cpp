@@ -0,0 +1,237 @@
+/*************************************************************************/
+/*  file_access_unix_mapped.cpp                                          */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2020 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2020 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "file_access_unix_mapped.h"
+
+#if defined(UNIX_ENABLED)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+Error FileAccessUnixMapped::_open(const String &p_path, int p_mode_flags) {
+
+	close();
+
+	ERR_FAIL_COND_V_MSG(p_mode_flags != READ, ERR_UNAVAILABLE, "Mapped files can only be opened for reading.");
+
+	path_src = p_path;
+	path = fix_path(p_path);
+
+	int fd = ::open(path.utf8().get_data(), O_RDONLY | O_CLOEXEC);
+	if (fd == -1) {
+		return errno == ENOENT ? ERR_FILE_NOT_FOUND : ERR_FILE_CANT_OPEN;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+		::close(fd);
+		return ERR_FILE_CANT_OPEN;
+	}
+
+	length = st.st_size;
+	if (length) {
+		void *mapped = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapped == MAP_FAILED) {
+			::close(fd);
+			length = 0;
+			return ERR_FILE_CANT_OPEN;
+		}
+		data = (uint8_t *)mapped;
+	}
+
+	// The mapping stays valid once the descriptor is closed.
+	::close(fd);
+
+	pos = 0;
+	eof = false;
+	opened = true;
+	return OK;
+}
+
+void FileAccessUnixMapped::close() {
+
+	if (data) {
+		munmap(data, length);
+		data = NULL;
+	}
+	length = 0;
+	opened = false;
+}
+
+bool FileAccessUnixMapped::is_open() const {
+
+	return opened;
+}
+
+String FileAccessUnixMapped::get_path() const {
+
+	return path_src;
+}
+
+String FileAccessUnixMapped::get_path_absolute() const {
+
+	return path;
+}
+
+void FileAccessUnixMapped::seek(size_t p_position) {
+
+	pos = p_position;
+	eof = p_position > length;
+}
+
+void FileAccessUnixMapped::seek_end(int64_t p_position) {
+
+	seek(length + p_position);
+}
+
+size_t FileAccessUnixMapped::get_position() const {
+
+	return pos;
+}
+
+size_t FileAccessUnixMapped::get_len() const {
+
+	return length;
+}
+
+bool FileAccessUnixMapped::eof_reached() const {
+
+	return eof;
+}
+
+uint8_t FileAccessUnixMapped::get_8() const {
+
+	if (pos >= length) {
+		eof = true;
+		return 0;
+	}
+
+	return data[pos++];
+}
+
+int FileAccessUnixMapped::get_buffer(uint8_t *p_dst, int p_length) const {
+
+	ERR_FAIL_COND_V(!p_dst && p_length > 0, -1);
+	ERR_FAIL_COND_V(p_length < 0, -1);
+
+	size_t left = pos < length ? length - pos : 0;
+	int read = p_length;
+	if ((size_t)read > left) {
+		eof = true;
+		read = left;
+	}
+
+	if (read > 0) {
+		memcpy(p_dst, &data[pos], read);
+		pos += read;
+	}
+
+	return read;
+}
+
+const uint8_t *FileAccessUnixMapped::get_buffer_ptr(int p_length) const {
+
+	if (p_length < 0 || pos + p_length > length) {
+		return NULL;
+	}
+
+	const uint8_t *ptr = &data[pos];
+	pos += p_length;
+	return ptr;
+}
+
+Error FileAccessUnixMapped::get_error() const {
+
+	return eof ? ERR_FILE_EOF : OK;
+}
+
+void FileAccessUnixMapped::flush() {
+
+	ERR_FAIL();
+}
+
+void FileAccessUnixMapped::store_8(uint8_t p_dest) {
+
+	ERR_FAIL();
+}
+
+void FileAccessUnixMapped::store_buffer(const uint8_t *p_src, int p_length) {
+
+	ERR_FAIL();
+}
+
+bool FileAccessUnixMapped::file_exists(const String &p_path) {
+
+	struct stat st;
+	if (stat(fix_path(p_path).utf8().get_data(), &st) != 0) {
+		return false;
+	}
+	return S_ISREG(st.st_mode);
+}
+
+uint64_t FileAccessUnixMapped::_get_modified_time(const String &p_file) {
+
+	struct stat st;
+	int err = stat(fix_path(p_file).utf8().get_data(), &st);
+	ERR_FAIL_COND_V_MSG(err, 0, "Failed to get modified time for: " + p_file + ".");
+	return st.st_mtime;
+}
+
+uint32_t FileAccessUnixMapped::_get_unix_permissions(const String &p_file) {
+
+	struct stat st;
+	int err = stat(fix_path(p_file).utf8().get_data(), &st);
+	ERR_FAIL_COND_V_MSG(err, 0, "Failed to get unix permissions for: " + p_file + ".");
+	return st.st_mode & 0x7FF; //only permissions
+}
+
+Error FileAccessUnixMapped::_set_unix_permissions(const String &p_file, uint32_t p_permissions) {
+
+	return chmod(fix_path(p_file).utf8().get_data(), p_permissions) == 0 ? OK : FAILED;
+}
+
+FileAccessUnixMapped::FileAccessUnixMapped() :
+		data(NULL),
+		length(0),
+		pos(0),
+		eof(false),
+		opened(false) {
+}
+
+FileAccessUnixMapped::~FileAccessUnixMapped() {
+
+	close();
+}
+
+#endif
@@ -33,6 +33,7 @@
 #include "core/crypto/crypto_core.h"
 #include "core/io/config_file.h"
 #include "core/io/file_access_pack.h" // PACK_HEADER_MAGIC, PACK_FORMAT_VERSION
+#include "core/io/pck_packer.h"
 #include "core/io/resource_loader.h"
 #include "core/io/resource_saver.h"
 #include "core/io/zip_io.h"
@@ -59,6 +60,8 @@ static int _get_pad(int p_alignment, int p_n) {
 }
 
 #define PCK_PADDING 16
+// Stored files of at least a page start on a page boundary, so they can be used from the mapped pack as is.
+#define PCK_PAGE_SIZE 4096
 
 bool EditorExportPreset::_set(const StringName &p_name, const Variant &p_value) {
 
@@ -321,15 +324,27 @@ Error EditorExportPlatform::_save_pack_file(void *p_userdata, const String &p_pa
 
 	SavedData sd;
 	sd.path_utf8 = p_path.utf8();
-	sd.ofs = pd->f->get_position();
 	sd.size = p_data.size();
+	sd.compressed_size = 0;
+
+	Vector<uint8_t> compressed;
+	if (PCKPacker::compress_file(p_data, compressed)) {
+		sd.compressed_size = compressed.size();
+	}
 
-	pd->f->store_buffer(p_data.ptr(), p_data.size());
-	int pad = _get_pad(PCK_PADDING, sd.size);
+	int alignment = (!sd.compressed_size && sd.size >= PCK_PAGE_SIZE) ? PCK_PAGE_SIZE : PCK_PADDING;
+	int pad = _get_pad(alignment, pd->f->get_position());
 	for (int i = 0; i < pad; i++) {
 		pd->f->store_8(0);
 	}
 
+	sd.ofs = pd->f->get_position();
+	if (sd.compressed_size) {
+		pd->f->store_buffer(compressed.ptr(), compressed.size());
+	} else {
+		pd->f->store_buffer(p_data.ptr(), p_data.size());
+	}
+
 	{
 		unsigned char hash[16];
 		CryptoCore::md5(p_data.ptr(), p_data.size(), hash);
@@ -936,7 +951,18 @@ Error EditorExportPlatform::save_pack(const Ref<EditorExportPreset> &p_preset, c
 		return err;
 	}
 
-	pd.file_ofs.sort(); //do sort, so we can do binary search later
+	// Sorted by path key, so it can be searched in place when loaded.
+	Vector<PCKPacker::IndexEntry> index;
+	index.resize(pd.file_ofs.size());
+	for (int i = 0; i < pd.file_ofs.size(); i++) {
+		PCKPacker::IndexEntry &e = index.write[i];
+		e = PCKPacker::IndexEntry(String::utf8(pd.file_ofs[i].path_utf8.get_data()));
+		e.offset = pd.file_ofs[i].ofs;
+		e.size = pd.file_ofs[i].size;
+		e.compressed_size = pd.file_ofs[i].compressed_size;
+		memcpy(e.md5, pd.file_ofs[i].md5.ptr(), 16);
+	}
+	index.sort();
 
 	FileAccess *f;
 	int64_t embed_pos = 0;
@@ -971,49 +997,18 @@ Error EditorExportPlatform::save_pack(const Ref<EditorExportPreset> &p_preset, c
 
 	int64_t pck_start_pos = f->get_position();
 
-	f->store_32(PACK_HEADER_MAGIC);
-	f->store_32(PACK_FORMAT_VERSION);
-	f->store_32(VERSION_MAJOR);
-	f->store_32(VERSION_MINOR);
-	f->store_32(VERSION_PATCH);
-
-	for (int i = 0; i < 16; i++) {
-		//reserved
-		f->store_32(0);
-	}
+	PCKPacker::store_header(f);
 
-	f->store_32(pd.file_ofs.size()); //amount of files
+	int64_t header_size = f->get_position() + PCKPacker::get_index_size(index);
 
-	int64_t header_size = f->get_position();
+	// The data saved so far is laid out from a page boundary, keep it there.
+	int header_padding = _get_pad(PCK_PAGE_SIZE, header_size);
 
-	//precalculate header size
-
-	for (int i = 0; i < pd.file_ofs.size(); i++) {
-		header_size += 4; // size of path string (32 bits is enough)
-		int string_len = pd.file_ofs[i].path_utf8.length();
-		header_size += string_len + _get_pad(4, string_len); ///size of path string
-		header_size += 8; // offset to file _with_ header size included
-		header_size += 8; // size of file
-		header_size += 16; // md5
+	for (int i = 0; i < index.size(); i++) {
+		index.write[i].offset += header_padding + header_size;
 	}
 
-	int header_padding = _get_pad(PCK_PADDING, header_size);
-
-	for (int i = 0; i < pd.file_ofs.size(); i++) {
-
-		int string_len = pd.file_ofs[i].path_utf8.length();
-		int pad = _get_pad(4, string_len);
-
-		f->store_32(string_len + pad);
-		f->store_buffer((const uint8_t *)pd.file_ofs[i].path_utf8.get_data(), string_len);
-		for (int j = 0; j < pad; j++) {
-			f->store_8(0);
-		}
-
-		f->store_64(pd.file_ofs[i].ofs + header_padding + header_size);
-		f->store_64(pd.file_ofs[i].size); // pay attention here, this is where file is
-		f->store_buffer(pd.file_ofs[i].md5.ptr(), 16); //also save md5 for file
-	}
+	PCKPacker::store_index(f, index);
 
 	for (int i = 0; i < header_padding; i++) {
 		f->store_8(0);
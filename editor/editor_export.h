@@ -164,6 +164,7 @@ private:
 
 		uint64_t ofs;
 		uint64_t size;
+		uint64_t compressed_size; // 0 if stored.
 		Vector<uint8_t> md5;
 		CharString path_utf8;
 
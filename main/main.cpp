@@ -884,6 +884,8 @@ Error Main::setup(const char *execpath, int argc, char *argv[], bool p_second_ph
 #endif
 	}
 
+	ResourceCache::set_retain_budget(uint64_t(int(GLOBAL_DEF("memory/limits/resource_cache/retain_budget_mb", 0))) * 1024 * 1024);
+	ProjectSettings::get_singleton()->set_custom_property_info("memory/limits/resource_cache/retain_budget_mb", PropertyInfo(Variant::INT, "memory/limits/resource_cache/retain_budget_mb", PROPERTY_HINT_RANGE, "0,4096,1,or_greater"));
 	GLOBAL_DEF("memory/limits/multithreaded_server/rid_pool_prealloc", 60);
 	ProjectSettings::get_singleton()->set_custom_property_info("memory/limits/multithreaded_server/rid_pool_prealloc", PropertyInfo(Variant::INT, "memory/limits/multithreaded_server/rid_pool_prealloc", PROPERTY_HINT_RANGE, "0,500,1")); // No negative and limit to 500 due to crashes
 	GLOBAL_DEF("network/limits/debugger_stdout/max_chars_per_second", 2048);
@@ -2194,6 +2196,8 @@ void Main::cleanup() {
 
 	OS::get_singleton()->delete_main_loop();
 
+	ResourceCache::clear_retained();
+
 	OS::get_singleton()->_cmdline.clear();
 	OS::get_singleton()->_execpath = "";
 	OS::get_singleton()->_local_clipboard = "";
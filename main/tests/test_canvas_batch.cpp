@@ -0,0 +1,166 @@
+/*************************************************************************/
+/*  test_canvas_batch.cpp                                                */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2020 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2020 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "test_canvas_batch.h"
+
+#include "core/os/os.h"
+#include "servers/visual/rasterizer_rd/canvas_batch_builder.h"
+
+namespace TestCanvasBatch {
+
+static CanvasBatchBuilder::Key make_key(uint64_t p_texture_binding, uint32_t p_flags = 0) {
+
+	CanvasBatchBuilder::Key key;
+	key.pipeline_variants = NULL;
+	key.texture_binding = p_texture_binding;
+	key.flags = p_flags;
+	key.specular_shininess = 0xFFFFFFFF;
+	key.color_texture_pixel_size[0] = 1.0;
+	key.color_texture_pixel_size[1] = 1.0;
+	return key;
+}
+
+static CanvasBatchBuilder::Instance make_instance(float p_x) {
+
+	CanvasBatchBuilder::Instance instance;
+	for (int i = 0; i < 6; i++) {
+		instance.world[i] = 0;
+	}
+	instance.world[0] = 1;
+	instance.world[3] = 1;
+	instance.world[4] = p_x;
+	instance.pad[0] = 0;
+	instance.pad[1] = 0;
+	for (int i = 0; i < 4; i++) {
+		instance.modulation[i] = 1;
+		instance.dst_rect[i] = i < 2 ? 0 : 16;
+		instance.src_rect[i] = i < 2 ? 0 : 1;
+	}
+	return instance;
+}
+
+bool test_merge_same_state() {
+
+	CanvasBatchBuilder builder;
+	builder.begin(1024);
+	for (int i = 0; i < 100; i++) {
+		builder.add_instance(make_key(1), make_instance(i));
+	}
+
+	return builder.get_batch_count() == 1 && builder.get_batch(0).count == 100 && builder.get_instance_count() == 100 && builder.get_instances()[42].world[4] == 42;
+}
+
+bool test_break_on_state_change() {
+
+	CanvasBatchBuilder builder;
+	builder.begin(1024);
+	// Tilemap-like pattern: two runs on one texture, one on another, then a flag change.
+	for (int i = 0; i < 10; i++) {
+		builder.add_instance(make_key(1), make_instance(i));
+	}
+	for (int i = 0; i < 5; i++) {
+		builder.add_instance(make_key(2), make_instance(i));
+	}
+	for (int i = 0; i < 3; i++) {
+		builder.add_instance(make_key(2, 1 << 10), make_instance(i));
+	}
+
+	bool ok = builder.get_batch_count() == 3;
+	ok = ok && builder.get_batch(0).from == 0 && builder.get_batch(0).count == 10;
+	ok = ok && builder.get_batch(1).from == 10 && builder.get_batch(1).count == 5;
+	ok = ok && builder.get_batch(2).from == 15 && builder.get_batch(2).count == 3;
+	ok = ok && builder.get_batch(2).key.flags == (1 << 10);
+	return ok;
+}
+
+bool test_limit() {
+
+	CanvasBatchBuilder builder;
+	builder.begin(8);
+	int added = 0;
+	for (int i = 0; i < 10; i++) {
+		if (builder.add_instance(make_key(1), make_instance(i))) {
+			added++;
+		}
+	}
+
+	bool ok = added == 8 && builder.get_instance_count() == 8;
+
+	// Starting over (as done after a flush) must reset both instances and batches.
+	builder.begin(4);
+	ok = ok && builder.get_instance_count() == 0 && builder.get_batch_count() == 0;
+	ok = ok && builder.add_instance(make_key(3), make_instance(0));
+	ok = ok && builder.get_batch_count() == 1 && builder.get_batch(0).key.texture_binding == 3;
+	return ok;
+}
+
+bool test_no_merge_across_runs() {
+
+	CanvasBatchBuilder builder;
+	builder.begin(1024);
+	// A-B-A must not be reordered into A-A-B, draw order has to be preserved.
+	builder.add_instance(make_key(1), make_instance(0));
+	builder.add_instance(make_key(2), make_instance(1));
+	builder.add_instance(make_key(1), make_instance(2));
+
+	return builder.get_batch_count() == 3 && builder.get_batch(2).from == 2;
+}
+
+typedef bool (*TestFunc)(void);
+
+TestFunc test_funcs[] = {
+	test_merge_same_state,
+	test_break_on_state_change,
+	test_limit,
+	test_no_merge_across_runs,
+	NULL
+};
+
+MainLoop *test() {
+
+	int count = 0;
+	int passed = 0;
+
+	while (true) {
+		if (!test_funcs[count])
+			break;
+		bool pass = test_funcs[count]();
+		if (pass)
+			passed++;
+		OS::get_singleton()->print("\t%s\n", pass ? "PASS" : "FAILED");
+
+		count++;
+	}
+	OS::get_singleton()->print("\n");
+	OS::get_singleton()->print("Passed %i of %i tests\n", passed, count);
+	return NULL;
+}
+
+} // namespace TestCanvasBatch
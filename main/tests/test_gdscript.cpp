@@ -30,15 +30,20 @@
 
 #include "test_gdscript.h"
 
+#include "core/io/resource_loader.h"
+#include "core/os/dir_access.h"
 #include "core/os/file_access.h"
 #include "core/os/main_loop.h"
 #include "core/os/os.h"
+#include "core/project_settings.h"
 
 #include "modules/modules_enabled.gen.h"
 #ifdef MODULE_GDSCRIPT_ENABLED
 
 #include "modules/gdscript/gdscript.h"
+#include "modules/gdscript/gdscript_compiled_buffer.h"
 #include "modules/gdscript/gdscript_compiler.h"
+#include "modules/gdscript/gdscript_optimizer.h"
 #include "modules/gdscript/gdscript_parser.h"
 #include "modules/gdscript/gdscript_tokenizer.h"
 
@@ -565,10 +570,22 @@ static void _disassemble_class(const Ref<GDScript> &p_class, const Vector<String
 
 			switch (code[ip]) {
 
-				case GDScriptFunction::OPCODE_OPERATOR: {
+				case GDScriptFunction::OPCODE_OPERATOR:
+				case GDScriptFunction::OPCODE_OPERATOR_INT:
+				case GDScriptFunction::OPCODE_OPERATOR_FLOAT:
+				case GDScriptFunction::OPCODE_OPERATOR_VECTOR2:
+				case GDScriptFunction::OPCODE_OPERATOR_VECTOR3:
+				case GDScriptFunction::OPCODE_COMPARE_JUMP_IF_NOT: {
 
 					int op = code[ip + 1];
-					txt += " op ";
+					switch (code[ip]) {
+						case GDScriptFunction::OPCODE_OPERATOR_INT: txt += " op_int "; break;
+						case GDScriptFunction::OPCODE_OPERATOR_FLOAT: txt += " op_float "; break;
+						case GDScriptFunction::OPCODE_OPERATOR_VECTOR2: txt += " op_vector2 "; break;
+						case GDScriptFunction::OPCODE_OPERATOR_VECTOR3: txt += " op_vector3 "; break;
+						case GDScriptFunction::OPCODE_COMPARE_JUMP_IF_NOT: txt += " op_jump_if_not "; break;
+						default: txt += " op ";
+					}
 
 					String opname = Variant::get_operator_name(Variant::Operator(op));
 
@@ -580,9 +597,10 @@ static void _disassemble_class(const Ref<GDScript> &p_class, const Vector<String
 					incr += 5;
 
 				} break;
-				case GDScriptFunction::OPCODE_SET: {
+				case GDScriptFunction::OPCODE_SET:
+				case GDScriptFunction::OPCODE_SET_INDEXED_ARRAY: {
 
-					txt += "set ";
+					txt += code[ip] == GDScriptFunction::OPCODE_SET ? "set " : "set_indexed_array ";
 					txt += DADDR(1);
 					txt += "[";
 					txt += DADDR(2);
@@ -591,9 +609,10 @@ static void _disassemble_class(const Ref<GDScript> &p_class, const Vector<String
 					incr += 4;
 
 				} break;
-				case GDScriptFunction::OPCODE_GET: {
+				case GDScriptFunction::OPCODE_GET:
+				case GDScriptFunction::OPCODE_GET_INDEXED_ARRAY: {
 
-					txt += " get ";
+					txt += code[ip] == GDScriptFunction::OPCODE_GET ? " get " : " get_indexed_array ";
 					txt += DADDR(3);
 					txt += "=";
 					txt += DADDR(1);
@@ -610,20 +629,20 @@ static void _disassemble_class(const Ref<GDScript> &p_class, const Vector<String
 					txt += "[\"";
 					txt += func.get_global_name(code[ip + 2]);
 					txt += "\"]=";
-					txt += DADDR(3);
-					incr += 4;
+					txt += DADDR(4);
+					incr += 5;
 
 				} break;
 				case GDScriptFunction::OPCODE_GET_NAMED: {
 
 					txt += " get_named ";
-					txt += DADDR(3);
+					txt += DADDR(4);
 					txt += "=";
 					txt += DADDR(1);
 					txt += "[\"";
 					txt += func.get_global_name(code[ip + 2]);
 					txt += "\"]";
-					incr += 4;
+					incr += 5;
 
 				} break;
 				case GDScriptFunction::OPCODE_SET_MEMBER: {
@@ -779,7 +798,7 @@ static void _disassemble_class(const Ref<GDScript> &p_class, const Vector<String
 
 					int argc = code[ip + 1];
 					if (ret) {
-						txt += DADDR(4 + argc) + "=";
+						txt += DADDR(5 + argc) + "=";
 					}
 
 					txt += DADDR(2) + ".";
@@ -789,11 +808,11 @@ static void _disassemble_class(const Ref<GDScript> &p_class, const Vector<String
 					for (int i = 0; i < argc; i++) {
 						if (i > 0)
 							txt += ", ";
-						txt += DADDR(4 + i);
+						txt += DADDR(5 + i);
 					}
 					txt += ")";
 
-					incr = 5 + argc;
+					incr = 6 + argc;
 
 				} break;
 				case GDScriptFunction::OPCODE_CALL_BUILT_IN: {
@@ -942,10 +961,811 @@ static void _disassemble_class(const Ref<GDScript> &p_class, const Vector<String
 	}
 }
 
+// Used by the benchmark test when no script is given.
+static const char *_benchmark_suite =
+		"extends Reference\n"
+		"\n"
+		"var counter = 0\n"
+		"var step = 3\n"
+		"\n"
+		"func bench_int_loop():\n"
+		"\tvar total := 0\n"
+		"\tfor i in 1000000:\n"
+		"\t\ttotal += i * 2 - 1\n"
+		"\treturn total\n"
+		"\n"
+		"func bench_float_loop():\n"
+		"\tvar x := 0.0\n"
+		"\tvar i := 0\n"
+		"\twhile i < 500000:\n"
+		"\t\tx = x * 0.5 + i / 3.0\n"
+		"\t\ti += 1\n"
+		"\treturn x\n"
+		"\n"
+		"func bench_constant_locals():\n"
+		"\tvar scale = 4\n"
+		"\tvar offset = scale * 2 + 1\n"
+		"\tvar total = 0\n"
+		"\tfor i in 300000:\n"
+		"\t\tif scale > 2:\n"
+		"\t\t\ttotal += offset * scale\n"
+		"\treturn total\n"
+		"\n"
+		"func bench_compare_and_branch():\n"
+		"\tvar hits = 0\n"
+		"\tvar i = 0\n"
+		"\twhile i < 500000:\n"
+		"\t\tif i % 3 == 0:\n"
+		"\t\t\thits += 1\n"
+		"\t\ti += 1\n"
+		"\treturn hits\n"
+		"\n"
+		"func bench_vector_math():\n"
+		"\tvar v := Vector2()\n"
+		"\tvar step := Vector2(0.5, 0.25)\n"
+		"\tfor i in 300000:\n"
+		"\t\tv = v + step * 2.0\n"
+		"\treturn v\n"
+		"\n"
+		"func bench_array_access():\n"
+		"\tvar arr := PackedInt32Array()\n"
+		"\tfor i in 1000:\n"
+		"\t\tarr.append(i)\n"
+		"\tvar total := 0\n"
+		"\tfor j in 200:\n"
+		"\t\tfor i in 1000:\n"
+		"\t\t\ttotal += arr[i]\n"
+		"\treturn total\n"
+		"\n"
+		"func bench_string_concat():\n"
+		"\tvar s := \"\"\n"
+		"\tfor i in 20000:\n"
+		"\t\ts += \"x\"\n"
+		"\treturn s.length()\n"
+		"\n"
+		"func bench_method_calls():\n"
+		"\tvar total = 0\n"
+		"\tfor i in 200000:\n"
+		"\t\ttotal += _add(i, 1)\n"
+		"\treturn total\n"
+		"\n"
+		"func _add(a, b):\n"
+		"\treturn a + b\n"
+		"\n"
+		"func bench_member_access():\n"
+		"\tcounter = 0\n"
+		"\tfor i in 300000:\n"
+		"\t\tcounter += step\n"
+		"\treturn counter\n"
+		"\n"
+		"func bench_math_functions():\n"
+		"\tvar total := 0.0\n"
+		"\tfor i in 200000:\n"
+		"\t\ttotal += sqrt(i) + sin(i * 0.01) * abs(total - i)\n"
+		"\treturn total\n"
+		"\n"
+		"func bench_nested_loops():\n"
+		"\tvar total := 0\n"
+		"\tfor i in 500:\n"
+		"\t\tfor j in 500:\n"
+		"\t\t\tif j > i:\n"
+		"\t\t\t\tbreak\n"
+		"\t\t\ttotal += j\n"
+		"\treturn total\n"
+		"\n"
+		"func bench_coroutines():\n"
+		"\tvar states = []\n"
+		"\tfor i in 10000:\n"
+		"\t\tstates.append(_coroutine(i))\n"
+		"\tfor step in 10:\n"
+		"\t\tfor i in states.size():\n"
+		"\t\t\tstates[i] = states[i].resume()\n"
+		"\tvar total = 0\n"
+		"\tfor result in states:\n"
+		"\t\ttotal += result\n"
+		"\treturn total\n"
+		"\n"
+		"func _coroutine(n):\n"
+		"\tvar total = 0\n"
+		"\tfor step in 10:\n"
+		"\t\ttotal += n + step\n"
+		"\t\tyield()\n"
+		"\treturn total\n";
+
+static Ref<GDScript> _compile_script(const String &p_code, bool p_optimize) {
+
+	const String setting = "debug/gdscript/optimizer/enable";
+	Variant optimize = ProjectSettings::get_singleton()->get(setting);
+	ProjectSettings::get_singleton()->set(setting, p_optimize);
+
+	Ref<GDScript> gds;
+	gds.instance();
+	gds->set_source_code(p_code);
+	Error err = gds->reload();
+
+	ProjectSettings::get_singleton()->set(setting, optimize);
+
+	if (err) {
+		print_line("Compile Error: " + itos(err));
+		return Ref<GDScript>();
+	}
+	return gds;
+}
+
+static void _get_method_names(const Ref<GDScript> &p_script, const String &p_prefix, Vector<StringName> &r_names) {
+
+	List<MethodInfo> methods;
+	p_script->get_script_method_list(&methods);
+	for (List<MethodInfo>::Element *E = methods.front(); E; E = E->next()) {
+		if (E->get().name.begins_with(p_prefix)) {
+			r_names.push_back(E->get().name);
+		}
+	}
+	r_names.sort_custom<StringName::AlphCompare>();
+}
+
+// Calls each method of the script the given number of times, keeping the best time and the result of the first call.
+static void _call_methods(const Ref<GDScript> &p_script, const Vector<StringName> &p_names, int p_runs, Vector<Variant> &r_results, Vector<uint64_t> &r_times) {
+
+	Object *obj = ClassDB::instance(p_script->get_instance_base_type());
+	ERR_FAIL_COND(!obj);
+	Ref<Reference> ref = Object::cast_to<Reference>(obj);
+	obj->set_script(p_script);
+
+	for (int i = 0; i < p_names.size(); i++) {
+
+		uint64_t best = 0;
+		for (int j = 0; j < p_runs; j++) {
+			Callable::CallError ce;
+			uint64_t begin = OS::get_singleton()->get_ticks_usec();
+			Variant result = obj->call(p_names[i], NULL, 0, ce);
+			uint64_t time = OS::get_singleton()->get_ticks_usec() - begin;
+			if (ce.error != Callable::CallError::CALL_OK) {
+				print_line("Error calling " + String(p_names[i]));
+			}
+			if (j == 0) {
+				r_results.push_back(result);
+			}
+			if (j == 0 || time < best) {
+				best = time;
+			}
+		}
+		r_times.push_back(best);
+	}
+
+	if (ref.is_null()) {
+		memdelete(obj);
+	}
+}
+
+// Calls every bench_* method of the script with the bytecode optimizer disabled and enabled, keeping the best of a few runs.
+// Both modes must return the same results.
+static void _run_benchmarks(const String &p_code) {
+
+	const int runs = 5;
+
+	Vector<StringName> names;
+	Vector<Variant> results[2];
+	Vector<uint64_t> times[2];
+
+	for (int pass = 0; pass < 2; pass++) {
+
+		Ref<GDScript> gds = _compile_script(p_code, pass == 1);
+		if (gds.is_null()) {
+			return;
+		}
+		if (pass == 0) {
+			_get_method_names(gds, "bench_", names);
+		}
+		_call_methods(gds, names, runs, results[pass], times[pass]);
+	}
+
+	bool ok = true;
+	for (int i = 0; i < names.size() && i < times[1].size(); i++) {
+		String ratio = times[1][i] ? String::num(double(times[0][i]) / times[1][i], 2) : "-";
+		print_line(String(names[i]) + ": " + itos(times[0][i]) + " usec unoptimized, " + itos(times[1][i]) + " usec optimized (" + ratio + "x)");
+		if (results[0][i] != results[1][i]) {
+			print_line("\tFAILED: returned " + String(results[0][i]) + " unoptimized, " + String(results[1][i]) + " optimized");
+			ok = false;
+		}
+	}
+	print_line(ok ? "Results match with and without the optimizer." : "Results differ with and without the optimizer.");
+}
+
+// Each test_* method has its result compared between both modes, and the optimized bytecode checked.
+static const char *_optimizer_suite =
+		"extends Reference\n"
+		"\n"
+		"var member = 2\n"
+		"\n"
+		"func test_constant_folding():\n"
+		"\tvar a = (2 + 3) * 4 - 10 / 4\n"
+		"\tvar b = 7.0 / 2 + 1\n"
+		"\tvar c = \"ab\" + \"cd\"\n"
+		"\tvar d = -(3 - 8) % 3\n"
+		"\tvar e = 1 < 2 and not 3 == 4\n"
+		"\treturn [a, b, c, d, e, Vector2(1, 2) * 2]\n"
+		"\n"
+		"func test_constant_propagation():\n"
+		"\tvar scale = 4\n"
+		"\tvar offset = scale * 2 + 1\n"
+		"\tvar total = 0\n"
+		"\tfor i in 10:\n"
+		"\t\tif scale > 2:\n"
+		"\t\t\ttotal += offset * scale + i\n"
+		"\t\telse:\n"
+		"\t\t\ttotal -= 1\n"
+		"\treturn total\n"
+		"\n"
+		"func test_dead_stores():\n"
+		"\tvar a = member * 3\n"
+		"\tvar b = a + 1\n"
+		"\tvar c = member + a * b\n"
+		"\ta = c - b\n"
+		"\tmember += a\n"
+		"\tvar result = [a, b, c, member]\n"
+		"\tmember = 2\n"
+		"\treturn result\n"
+		"\n"
+		"func test_jump_threading():\n"
+		"\tvar hits = []\n"
+		"\tvar i = 0\n"
+		"\twhile i < 20:\n"
+		"\t\ti += 1\n"
+		"\t\tif i % 2 == 0:\n"
+		"\t\t\tif i % 3 == 0:\n"
+		"\t\t\t\tcontinue\n"
+		"\t\t\telif i > 15:\n"
+		"\t\t\t\tbreak\n"
+		"\t\t\telse:\n"
+		"\t\t\t\thits.append(i)\n"
+		"\t\telif i % 5 == 0:\n"
+		"\t\t\thits.append(-i)\n"
+		"\treturn hits\n"
+		"\n"
+		"func test_stack_reuse():\n"
+		"\tvar total = 0\n"
+		"\tfor i in 5:\n"
+		"\t\ttotal += (i + 1) * (i + 2) + (i + 3) * (i + 4) + [i, i * 2][1]\n"
+		"\tfor j in [1, 2]:\n"
+		"\t\tfor k in [j, 3]:\n"
+		"\t\t\ttotal += (j * 3 + 1) * (total % 7 + 2) + {\"k\": k}[\"k\"]\n"
+		"\treturn total\n"
+		"\n"
+		"func test_coroutine_stack():\n"
+		"\tvar state = _coroutine(3)\n"
+		"\tvar values = []\n"
+		"\twhile state is GDScriptFunctionState:\n"
+		"\t\tstate = state.resume()\n"
+		"\t\tvalues.append(state if not state is GDScriptFunctionState else 0)\n"
+		"\treturn values\n"
+		"\n"
+		"func _coroutine(n):\n"
+		"\tvar total = 0\n"
+		"\tfor i in n:\n"
+		"\t\tvar a = (i + 1) * (n + 2)\n"
+		"\t\tyield()\n"
+		"\t\ttotal += a + (i * 2 + 1) * 3\n"
+		"\treturn total\n";
+
+static bool _has_opcode(const GDScriptFunction *p_function, int p_first, int p_last) {
+
+	const int *code = p_function->get_code();
+	int size = p_function->get_code_size();
+	int ip = 0;
+	while (ip < size) {
+		if (code[ip] >= p_first && code[ip] <= p_last) {
+			return true;
+		}
+		int length = GDScriptOptimizer::get_instruction_size(&code[ip], size - ip);
+		ERR_FAIL_COND_V(length == 0, true);
+		ip += length;
+	}
+	return false;
+}
+
+// Whether an unconditional jump leads to another jump, which jump threading removes.
+static bool _has_jump_to_jump(const GDScriptFunction *p_function) {
+
+	const int *code = p_function->get_code();
+	int size = p_function->get_code_size();
+	int ip = 0;
+	while (ip < size) {
+		if (code[ip] == GDScriptFunction::OPCODE_JUMP && code[ip + 1] < size && code[code[ip + 1]] == GDScriptFunction::OPCODE_JUMP) {
+			return true;
+		}
+		int length = GDScriptOptimizer::get_instruction_size(&code[ip], size - ip);
+		ERR_FAIL_COND_V(length == 0, true);
+		ip += length;
+	}
+	return false;
+}
+
+static bool _check_optimized(const StringName &p_name, const GDScriptFunction *p_unoptimized, const GDScriptFunction *p_optimized) {
+
+	String name = p_name;
+
+	if (name == "test_constant_folding") {
+		return !_has_opcode(p_optimized, GDScriptFunction::OPCODE_OPERATOR, GDScriptFunction::OPCODE_OPERATOR_VECTOR3);
+	}
+	if (name == "test_constant_propagation") {
+		// The branch on scale is always taken, so only the loop condition jumps remain.
+		return p_optimized->get_code_size() < p_unoptimized->get_code_size() && !_has_opcode(p_optimized, GDScriptFunction::OPCODE_JUMP_IF, GDScriptFunction::OPCODE_JUMP_IF_NOT);
+	}
+	if (name == "test_dead_stores") {
+		return p_optimized->get_code_size() < p_unoptimized->get_code_size();
+	}
+	if (name == "test_jump_threading") {
+		return _has_jump_to_jump(p_unoptimized) && !_has_jump_to_jump(p_optimized);
+	}
+	if (name == "test_stack_reuse") {
+		return p_optimized->get_max_stack_size() < p_unoptimized->get_max_stack_size();
+	}
+	return true;
+}
+
+static void _run_optimizer_tests() {
+
+	Ref<GDScript> scripts[2];
+	Vector<StringName> names;
+	Vector<Variant> results[2];
+	Vector<uint64_t> times[2];
+
+	for (int pass = 0; pass < 2; pass++) {
+		scripts[pass] = _compile_script(_optimizer_suite, pass == 1);
+		ERR_FAIL_COND(scripts[pass].is_null());
+		if (pass == 0) {
+			_get_method_names(scripts[pass], "test_", names);
+		}
+		_call_methods(scripts[pass], names, 1, results[pass], times[pass]);
+	}
+
+	int passed = 0;
+	for (int i = 0; i < names.size(); i++) {
+
+		const GDScriptFunction *unoptimized = scripts[0]->get_member_functions()[names[i]];
+		const GDScriptFunction *optimized = scripts[1]->get_member_functions()[names[i]];
+
+		bool pass = results[0][i] == results[1][i];
+		if (!pass) {
+			print_line(String(names[i]) + ": returned " + String(results[0][i]) + " unoptimized, " + String(results[1][i]) + " optimized");
+		}
+		if (pass && !_check_optimized(names[i], unoptimized, optimized)) {
+			print_line(String(names[i]) + ": bytecode not optimized");
+			pass = false;
+		}
+		if (pass) {
+			passed++;
+		}
+		OS::get_singleton()->print("\t%s: %s\n", String(names[i]).utf8().get_data(), pass ? "PASS" : "FAILED");
+	}
+
+	OS::get_singleton()->print("\n");
+	OS::get_singleton()->print("Passed %i of %i tests\n", passed, names.size());
+}
+
+// Compiled for debug and release exports, asserts only run (and only evaluate their condition) in debug code.
+static const char *_compiled_buffer_script =
+		"extends Reference\n"
+		"\n"
+		"var checks = 0\n"
+		"\n"
+		"func _check():\n"
+		"\tchecks += 1\n"
+		"\treturn true\n"
+		"\n"
+		"func run():\n"
+		"\tassert(_check())\n"
+		"\tvar total = 0\n"
+		"\tfor i in 10:\n"
+		"\t\ttotal += i\n"
+		"\treturn [total, checks]\n";
+
+static Variant _call_run(const Ref<GDScript> &p_script) {
+
+	Reference *ref = memnew(Reference);
+	Ref<Reference> holder = ref;
+	ref->set_script(p_script);
+	Callable::CallError ce;
+	Variant result = ref->call("run", NULL, 0, ce);
+	return ce.error == Callable::CallError::CALL_OK ? result : Variant();
+}
+
+static Vector<uint8_t> _export_compiled(bool p_debug, Ref<GDScript> &r_script) {
+
+	r_script.instance();
+	r_script->set_script_path("res://compiled_buffer_test.gd");
+	r_script->set_source_code(_compiled_buffer_script);
+	if (r_script->reload_for_export(p_debug) != OK) {
+		return Vector<uint8_t>();
+	}
+
+	GDScriptCompiledBuffer compiled;
+	return compiled.save(r_script, GDScriptTokenizerBuffer::parse_code_string(_compiled_buffer_script));
+}
+
+static bool _has_debug_code(const Ref<GDScript> &p_script) {
+
+	for (const Map<StringName, GDScriptFunction *>::Element *E = p_script->get_member_functions().front(); E; E = E->next()) {
+		if (_has_opcode(E->get(), GDScriptFunction::OPCODE_ASSERT, GDScriptFunction::OPCODE_LINE)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// Debug exports keep the local variable names, for a game run with the debugger.
+static bool _has_local_names(const Ref<GDScript> &p_script) {
+
+	const Map<StringName, GDScriptFunction *>::Element *E = p_script->get_member_functions().find("run");
+	ERR_FAIL_COND_V(!E, false);
+
+	List<Pair<StringName, int> > locals;
+	E->get()->debug_get_stack_member_state(13, &locals); // In the loop.
+	for (List<Pair<StringName, int> >::Element *F = locals.front(); F; F = F->next()) {
+		if (F->get().first == "total") {
+			return true;
+		}
+	}
+	return false;
+}
+
+static Array _make_result(int p_total, int p_checks) {
+
+	Array result;
+	result.push_back(p_total);
+	result.push_back(p_checks);
+	return result;
+}
+
+bool test_debug_export() {
+
+	Ref<GDScript> exported;
+	Vector<uint8_t> buffer = _export_compiled(true, exported);
+	if (buffer.empty() || !_has_debug_code(exported) || !_has_local_names(exported)) {
+		return false;
+	}
+
+	// Accepted by this (debug) build, no need to compile the tokens.
+	Ref<GDScript> loaded;
+	loaded.instance();
+	loaded->set_script_path("res://compiled_buffer_test.gd");
+	GDScriptCompiledBuffer compiled;
+	if (compiled.load(loaded.ptr(), buffer) != OK) {
+		print_line("\t" + compiled.get_error());
+		return false;
+	}
+
+	loaded.instance();
+	loaded->set_script_path("res://compiled_buffer_test.gd");
+	if (loaded->load_byte_code_buffer(buffer) != OK) {
+		return false;
+	}
+	return _has_debug_code(loaded) && _has_local_names(loaded) && _call_run(loaded) == Variant(_make_result(45, 1));
+}
+
+bool test_release_export() {
+
+	Ref<GDScript> exported;
+	Vector<uint8_t> buffer = _export_compiled(false, exported);
+	if (buffer.empty()) {
+		return false;
+	}
+
+	// Release code has no line, assert or breakpoint opcodes, the assert condition isn't evaluated.
+	if (_has_debug_code(exported) || _has_local_names(exported) || _call_run(exported) != Variant(_make_result(45, 0))) {
+		return false;
+	}
+
+	// Debug builds refuse it, and compile the tokens instead.
+	Ref<GDScript> loaded;
+	loaded.instance();
+	loaded->set_script_path("res://compiled_buffer_test.gd");
+	GDScriptCompiledBuffer compiled;
+	if (compiled.load(loaded.ptr(), buffer) != ERR_FILE_UNRECOGNIZED) {
+		return false;
+	}
+
+	loaded.instance();
+	loaded->set_script_path("res://compiled_buffer_test.gd");
+	if (loaded->load_byte_code_buffer(buffer) != OK) {
+		return false;
+	}
+	return _has_debug_code(loaded) && _call_run(loaded) == Variant(_make_result(45, 1));
+}
+
+// A function run on an instance of another script, with fewer members than it was compiled for, fails instead of
+// reading past them.
+bool test_mismatched_instance() {
+
+	Ref<GDScript> with_members;
+	Vector<uint8_t> buffer = _export_compiled(true, with_members);
+	const Map<StringName, GDScriptFunction *>::Element *E = with_members->get_member_functions().find("_check");
+	if (buffer.empty() || !E) {
+		return false;
+	}
+
+	Ref<GDScript> without_members = _compile_script("extends Reference\n", false);
+	if (without_members.is_null()) {
+		return false;
+	}
+	Reference *ref = memnew(Reference);
+	Ref<Reference> holder = ref;
+	ref->set_script(without_members);
+	GDScriptInstance *instance = static_cast<GDScriptInstance *>(ref->get_script_instance());
+
+	Callable::CallError ce;
+	Variant result = E->get()->call(instance, NULL, 0, ce);
+	return result.get_type() == Variant::NIL;
+}
+
+typedef bool (*TestFunc)(void);
+
+TestFunc compiled_buffer_test_funcs[] = {
+	test_debug_export,
+	test_release_export,
+	test_mismatched_instance,
+	NULL
+};
+
+static void _run_compiled_buffer_tests() {
+
+	int count = 0;
+	int passed = 0;
+
+	while (true) {
+		if (!compiled_buffer_test_funcs[count])
+			break;
+		bool pass = compiled_buffer_test_funcs[count]();
+		if (pass)
+			passed++;
+		OS::get_singleton()->print("\t%s\n", pass ? "PASS" : "FAILED");
+
+		count++;
+	}
+	OS::get_singleton()->print("\n");
+	OS::get_singleton()->print("Passed %i of %i tests\n", passed, count);
+}
+
+// Loaded many times by the load benchmark, with $INDEX replaced by the number of each copy.
+static const char *_load_benchmark_script =
+		"extends Reference\n"
+		"\n"
+		"const INDEX = $INDEX\n"
+		"const LIMIT = 16\n"
+		"enum { IDLE, RUNNING, DONE }\n"
+		"\n"
+		"signal finished(result)\n"
+		"\n"
+		"var state = IDLE\n"
+		"var items := []\n"
+		"var label := \"script_$INDEX\"\n"
+		"var total: float = 0.0\n"
+		"\n"
+		"class Item:\n"
+		"\tvar id: int\n"
+		"\tvar weight := 1.0\n"
+		"\n"
+		"\tfunc _init(p_id):\n"
+		"\t\tid = p_id\n"
+		"\t\tweight = p_id * 0.5\n"
+		"\n"
+		"\tfunc score(p_factor: float) -> float:\n"
+		"\t\treturn weight * p_factor + id\n"
+		"\n"
+		"func _init():\n"
+		"\tfor i in LIMIT:\n"
+		"\t\titems.append(Item.new(i + INDEX))\n"
+		"\n"
+		"func run(p_factor = 2.0):\n"
+		"\tstate = RUNNING\n"
+		"\ttotal = 0.0\n"
+		"\tfor item in items:\n"
+		"\t\ttotal += item.score(p_factor)\n"
+		"\tstate = DONE\n"
+		"\temit_signal(\"finished\", total)\n"
+		"\treturn total\n"
+		"\n"
+		"func describe() -> String:\n"
+		"\tvar parts := []\n"
+		"\tfor item in items:\n"
+		"\t\tif item.id % 2 == 0:\n"
+		"\t\t\tparts.append(str(item.id))\n"
+		"\t\telif item.weight > 4.0:\n"
+		"\t\t\tparts.append(\"heavy\")\n"
+		"\treturn label + \": \" + str(parts)\n"
+		"\n"
+		"func find(p_id: int):\n"
+		"\tfor item in items:\n"
+		"\t\tif item.id == p_id:\n"
+		"\t\t\treturn item\n"
+		"\treturn null\n"
+		"\n"
+		"func classify(p_value):\n"
+		"\tmatch typeof(p_value):\n"
+		"\t\tTYPE_INT, TYPE_REAL:\n"
+		"\t\t\treturn \"number\"\n"
+		"\t\tTYPE_STRING:\n"
+		"\t\t\treturn \"string\"\n"
+		"\t\tTYPE_ARRAY:\n"
+		"\t\t\treturn \"array of \" + str(p_value.size())\n"
+		"\t\t_:\n"
+		"\t\t\treturn \"other\"\n"
+		"\n"
+		"func transform(p_points: Array, p_offset := Vector2(1, 1)) -> Array:\n"
+		"\tvar result = []\n"
+		"\tfor p in p_points:\n"
+		"\t\tvar v: Vector2 = p * 2.0 + p_offset\n"
+		"\t\tresult.append(v.rotated(0.5).normalized())\n"
+		"\treturn result\n";
+
+// Loads a script preloading copies of the benchmark script, which get tokenized in parallel when there are
+// processors to spare. Compared with loading the same files one by one, dependencies first, where there's
+// nothing left to tokenize ahead.
+static void _run_dependency_load_benchmark() {
+
+	const int count = 64;
+	const int runs = 3;
+
+	String dir = "user://gd_load_benchmark";
+	DirAccess *da = DirAccess::create(DirAccess::ACCESS_USERDATA);
+	da->make_dir_recursive(dir);
+
+	Vector<String> paths;
+	String root_source = "extends Reference\n\n";
+	for (int i = 0; i <= count; i++) {
+
+		String path = dir.plus_file(i < count ? "dependency_" + itos(i) + ".gd" : "root.gd");
+		String source = i < count ? String(_load_benchmark_script).replace("$INDEX", itos(i)) : root_source;
+		root_source += "const DEPENDENCY_" + itos(i) + " = preload(\"" + path + "\")\n";
+
+		FileAccess *f = FileAccess::open(path, FileAccess::WRITE);
+		ERR_FAIL_COND_MSG(!f, "Can't write " + path + ".");
+		f->store_string(source);
+		memdelete(f);
+		paths.push_back(path);
+	}
+
+	const char *modes[2] = { "one by one", "through preloads" };
+	uint64_t best[2] = { 0, 0 };
+
+	for (int mode = 0; mode < 2; mode++) {
+		for (int run = 0; run < runs; run++) {
+
+			Vector<RES> loaded; // Kept until the end, so they stay cached.
+			uint64_t begin = OS::get_singleton()->get_ticks_usec();
+			for (int i = mode == 0 ? 0 : count; i <= count; i++) {
+				loaded.push_back(ResourceLoader::load(paths[i]));
+				ERR_FAIL_COND_MSG(loaded[loaded.size() - 1].is_null(), "Loading " + paths[i] + " failed.");
+			}
+			uint64_t time = OS::get_singleton()->get_ticks_usec() - begin;
+			if (run == 0 || time < best[mode]) {
+				best[mode] = time;
+			}
+		}
+	}
+
+	for (int i = 0; i < paths.size(); i++) {
+		da->remove(paths[i]);
+	}
+	da->remove(dir);
+	memdelete(da);
+
+	int processors = OS::get_singleton()->get_processor_count();
+	String ratio = best[1] ? String::num(double(best[0]) / best[1], 2) : "-";
+	for (int mode = 0; mode < 2; mode++) {
+		print_line(String(modes[mode]) + ": " + itos(best[mode]) + " usec for " + itos(count + 1) + " scripts from files");
+	}
+	print_line("Tokenizing dependencies in parallel: " + ratio + "x with " + itos(processors) + (processors > 1 ? " processors" : " processor, so it's disabled"));
+}
+
+// Loads copies of a script from source, from tokens and from precompiled code, keeping the best of a few runs.
+static void _run_load_benchmark() {
+
+	const int count = 300;
+	const int runs = 3;
+
+	Vector<String> sources;
+	Vector<Vector<uint8_t> > tokens;
+	Vector<Vector<uint8_t> > compiled;
+
+	for (int i = 0; i < count; i++) {
+
+		String source = String(_load_benchmark_script).replace("$INDEX", itos(i));
+		Vector<uint8_t> token_buffer = GDScriptTokenizerBuffer::parse_code_string(source);
+
+		Ref<GDScript> gds;
+		gds.instance();
+		gds->set_source_code(source);
+		Error err = gds->reload();
+		if (err) {
+			print_line("Compile Error: " + itos(err));
+			return;
+		}
+
+		GDScriptCompiledBuffer compiled_buffer;
+		Vector<uint8_t> buffer = compiled_buffer.save(gds, token_buffer);
+		if (buffer.empty()) {
+			print_line("Can't save precompiled code: " + compiled_buffer.get_error());
+			return;
+		}
+
+		sources.push_back(source);
+		tokens.push_back(token_buffer);
+		compiled.push_back(buffer);
+	}
+
+	const char *modes[3] = { "source", "tokens", "precompiled" };
+	Variant results[3];
+
+	for (int mode = 0; mode < 3; mode++) {
+
+		uint64_t best = 0;
+		for (int run = 0; run < runs; run++) {
+
+			uint64_t begin = OS::get_singleton()->get_ticks_usec();
+			for (int i = 0; i < count; i++) {
+
+				Ref<GDScript> gds;
+				gds.instance();
+				Error err;
+				if (mode == 0) {
+					gds->set_source_code(sources[i]);
+					err = gds->reload();
+				} else {
+					err = gds->load_byte_code_buffer(mode == 1 ? tokens[i] : compiled[i]);
+				}
+				ERR_FAIL_COND_MSG(err != OK, "Loading from " + String(modes[mode]) + " failed.");
+
+				if (i == count - 1 && run == 0) {
+					Ref<Reference> obj = memnew(Reference);
+					obj->set_script(gds);
+					Array result;
+					result.push_back(obj->call("run"));
+					result.push_back(obj->call("describe"));
+					results[mode] = result;
+				}
+			}
+			uint64_t time = OS::get_singleton()->get_ticks_usec() - begin;
+			if (run == 0 || time < best) {
+				best = time;
+			}
+		}
+
+		print_line(String(modes[mode]) + ": " + itos(best) + " usec for " + itos(count) + " scripts");
+	}
+
+	if (results[0] != results[1] || results[0] != results[2]) {
+		print_line("Results differ: " + String(results[0]) + ", " + String(results[1]) + ", " + String(results[2]));
+	}
+
+	_run_dependency_load_benchmark();
+}
+
 MainLoop *test(TestType p_type) {
 
 	List<String> cmdlargs = OS::get_singleton()->get_cmdline_args();
 
+	if (p_type == TEST_BENCHMARK && (cmdlargs.empty() || !cmdlargs.back()->get().ends_with(".gd"))) {
+		_run_benchmarks(_benchmark_suite);
+		return NULL;
+	}
+
+	if (p_type == TEST_LOAD_BENCHMARK) {
+		_run_load_benchmark();
+		return NULL;
+	}
+
+	if (p_type == TEST_OPTIMIZER) {
+		_run_optimizer_tests();
+		return NULL;
+	}
+
+	if (p_type == TEST_COMPILED_BUFFER) {
+		_run_compiled_buffer_tests();
+		return NULL;
+	}
+
 	if (cmdlargs.empty()) {
 		return NULL;
 	}
@@ -1072,9 +1892,28 @@ MainLoop *test(TestType p_type) {
 			current = current->get_base();
 		}
 
+	} else if (p_type == TEST_BENCHMARK) {
+
+		_run_benchmarks(code);
+
 	} else if (p_type == TEST_BYTECODE) {
 
 		Vector<uint8_t> buf2 = GDScriptTokenizerBuffer::parse_code_string(code);
+
+		Ref<GDScript> gds;
+		gds.instance();
+		gds->set_script_path(test);
+		gds->set_source_code(code);
+		if (!buf2.empty() && gds->reload() == OK) {
+			GDScriptCompiledBuffer compiled;
+			Vector<uint8_t> buf3 = compiled.save(gds, buf2);
+			if (buf3.empty()) {
+				print_line("Saving tokens only: " + compiled.get_error());
+			} else {
+				buf2 = buf3;
+			}
+		}
+
 		String dst = test.get_basename() + ".gdc";
 		FileAccess *fw = FileAccess::open(dst, FileAccess::WRITE);
 		fw->store_buffer(buf2.ptr(), buf2.size());
@@ -40,6 +40,10 @@ enum TestType {
 	TEST_PARSER,
 	TEST_COMPILER,
 	TEST_BYTECODE,
+	TEST_BENCHMARK,
+	TEST_LOAD_BENCHMARK,
+	TEST_OPTIMIZER,
+	TEST_COMPILED_BUFFER,
 };
 
 MainLoop *test(TestType p_type);
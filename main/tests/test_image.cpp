@@ -0,0 +1,594 @@
+/*************************************************************************/
+/*  test_image.cpp                                                       */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2020 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2020 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "test_image.h"
+
+#include "core/image.h"
+#include "core/os/os.h"
+#include "core/os/thread.h"
+
+namespace TestImage {
+
+// The serial resampling kernels from before images were processed in bands of rows.
+// Resizing must give the same bytes, only bicubic half-float scaling is fixed here.
+
+static double _reference_cubic_kernel(double x) {
+
+	x = ABS(x);
+
+	double bc = 0;
+
+	if (x <= 1)
+		bc = (1.5 * x - 2.5) * x * x + 1;
+	else if (x < 2)
+		bc = ((-0.5 * x + 2.5) * x - 4) * x + 2;
+
+	return bc;
+}
+
+template <int CC, class T>
+static void _reference_cubic(const uint8_t *p_src, uint8_t *p_dst, uint32_t p_src_width, uint32_t p_src_height, uint32_t p_dst_width, uint32_t p_dst_height) {
+
+	int width = p_src_width;
+	int height = p_src_height;
+	double xfac = (double)width / p_dst_width;
+	double yfac = (double)height / p_dst_height;
+	int ymax = height - 1;
+	int xmax = width - 1;
+
+	for (uint32_t y = 0; y < p_dst_height; y++) {
+		double oy = (double)y * yfac - 0.5f;
+		int oy1 = (int)oy;
+		double dy = oy - (double)oy1;
+
+		for (uint32_t x = 0; x < p_dst_width; x++) {
+			double ox = (double)x * xfac - 0.5f;
+			int ox1 = (int)ox;
+			double dx = ox - (double)ox1;
+
+			T *dst = ((T *)p_dst) + (y * p_dst_width + x) * CC;
+
+			double color[CC];
+			for (int i = 0; i < CC; i++) {
+				color[i] = 0;
+			}
+
+			for (int n = -1; n < 3; n++) {
+				double k1 = _reference_cubic_kernel(dy - (double)n);
+				int oy2 = CLAMP(oy1 + n, 0, ymax);
+
+				for (int m = -1; m < 3; m++) {
+					double k2 = k1 * _reference_cubic_kernel((double)m - dx);
+					int ox2 = CLAMP(ox1 + m, 0, xmax);
+
+					const T *p = ((const T *)p_src) + (oy2 * p_src_width + ox2) * CC;
+
+					for (int i = 0; i < CC; i++) {
+						if (sizeof(T) == 2) { //half float, used to overwrite the color with each sample
+							color[i] += Math::half_to_float(p[i]) * k2;
+						} else {
+							color[i] += p[i] * k2;
+						}
+					}
+				}
+			}
+
+			for (int i = 0; i < CC; i++) {
+				if (sizeof(T) == 1) { //byte
+					dst[i] = CLAMP(Math::fast_ftoi(color[i]), 0, 255);
+				} else if (sizeof(T) == 2) { //half float
+					dst[i] = Math::make_half_float(color[i]);
+				} else {
+					dst[i] = color[i];
+				}
+			}
+		}
+	}
+}
+
+template <int CC, class T>
+static void _reference_bilinear(const uint8_t *p_src, uint8_t *p_dst, uint32_t p_src_width, uint32_t p_src_height, uint32_t p_dst_width, uint32_t p_dst_height) {
+
+	enum {
+		FRAC_BITS = 8,
+		FRAC_LEN = (1 << FRAC_BITS),
+		FRAC_MASK = FRAC_LEN - 1
+	};
+
+	for (uint32_t i = 0; i < p_dst_height; i++) {
+
+		uint32_t src_yofs_up_fp = (i * p_src_height * FRAC_LEN / p_dst_height);
+		uint32_t src_yofs_frac = src_yofs_up_fp & FRAC_MASK;
+		uint32_t src_yofs_up = src_yofs_up_fp >> FRAC_BITS;
+
+		uint32_t src_yofs_down = (i + 1) * p_src_height / p_dst_height;
+		if (src_yofs_down >= p_src_height)
+			src_yofs_down = p_src_height - 1;
+
+		uint32_t y_ofs_up = src_yofs_up * p_src_width * CC;
+		uint32_t y_ofs_down = src_yofs_down * p_src_width * CC;
+
+		for (uint32_t j = 0; j < p_dst_width; j++) {
+
+			uint32_t src_xofs_left_fp = (j * p_src_width * FRAC_LEN / p_dst_width);
+			uint32_t src_xofs_frac = src_xofs_left_fp & FRAC_MASK;
+			uint32_t src_xofs_left = src_xofs_left_fp >> FRAC_BITS;
+			uint32_t src_xofs_right = (j + 1) * p_src_width / p_dst_width;
+			if (src_xofs_right >= p_src_width)
+				src_xofs_right = p_src_width - 1;
+
+			src_xofs_left *= CC;
+			src_xofs_right *= CC;
+
+			for (uint32_t l = 0; l < CC; l++) {
+
+				if (sizeof(T) == 1) { //uint8
+					uint32_t p00 = p_src[y_ofs_up + src_xofs_left + l] << FRAC_BITS;
+					uint32_t p10 = p_src[y_ofs_up + src_xofs_right + l] << FRAC_BITS;
+					uint32_t p01 = p_src[y_ofs_down + src_xofs_left + l] << FRAC_BITS;
+					uint32_t p11 = p_src[y_ofs_down + src_xofs_right + l] << FRAC_BITS;
+
+					uint32_t interp_up = p00 + (((p10 - p00) * src_xofs_frac) >> FRAC_BITS);
+					uint32_t interp_down = p01 + (((p11 - p01) * src_xofs_frac) >> FRAC_BITS);
+					uint32_t interp = interp_up + (((interp_down - interp_up) * src_yofs_frac) >> FRAC_BITS);
+					interp >>= FRAC_BITS;
+					p_dst[i * p_dst_width * CC + j * CC + l] = interp;
+				} else {
+
+					float xofs_frac = float(src_xofs_frac) / (1 << FRAC_BITS);
+					float yofs_frac = float(src_yofs_frac) / (1 << FRAC_BITS);
+					const T *src = ((const T *)p_src);
+					T *dst = ((T *)p_dst);
+
+					float p00, p10, p01, p11;
+					if (sizeof(T) == 2) { //half float
+						p00 = Math::half_to_float(src[y_ofs_up + src_xofs_left + l]);
+						p10 = Math::half_to_float(src[y_ofs_up + src_xofs_right + l]);
+						p01 = Math::half_to_float(src[y_ofs_down + src_xofs_left + l]);
+						p11 = Math::half_to_float(src[y_ofs_down + src_xofs_right + l]);
+					} else {
+						p00 = src[y_ofs_up + src_xofs_left + l];
+						p10 = src[y_ofs_up + src_xofs_right + l];
+						p01 = src[y_ofs_down + src_xofs_left + l];
+						p11 = src[y_ofs_down + src_xofs_right + l];
+					}
+
+					float interp_up = p00 + (p10 - p00) * xofs_frac;
+					float interp_down = p01 + (p11 - p01) * xofs_frac;
+					float interp = interp_up + ((interp_down - interp_up) * yofs_frac);
+
+					if (sizeof(T) == 2) {
+						dst[i * p_dst_width * CC + j * CC + l] = Math::make_half_float(interp);
+					} else {
+						dst[i * p_dst_width * CC + j * CC + l] = interp;
+					}
+				}
+			}
+		}
+	}
+}
+
+template <int CC, class T>
+static void _reference_nearest(const uint8_t *p_src, uint8_t *p_dst, uint32_t p_src_width, uint32_t p_src_height, uint32_t p_dst_width, uint32_t p_dst_height) {
+
+	for (uint32_t i = 0; i < p_dst_height; i++) {
+
+		uint32_t y_ofs = (i * p_src_height / p_dst_height) * p_src_width * CC;
+
+		for (uint32_t j = 0; j < p_dst_width; j++) {
+
+			uint32_t src_xofs = (j * p_src_width / p_dst_width) * CC;
+
+			for (uint32_t l = 0; l < CC; l++) {
+				((T *)p_dst)[i * p_dst_width * CC + j * CC + l] = ((const T *)p_src)[y_ofs + src_xofs + l];
+			}
+		}
+	}
+}
+
+static float _reference_lanczos_kernel(float p_x) {
+
+	return Math::abs(p_x) >= 3 ? 0 : Math::sincn(p_x) * Math::sincn(p_x / 3);
+}
+
+template <int CC, class T>
+static void _reference_lanczos(const uint8_t *p_src, uint8_t *p_dst, uint32_t p_src_width, uint32_t p_src_height, uint32_t p_dst_width, uint32_t p_dst_height) {
+
+	int32_t src_width = p_src_width;
+	int32_t src_height = p_src_height;
+	int32_t dst_height = p_dst_height;
+	int32_t dst_width = p_dst_width;
+
+	float *buffer = memnew_arr(float, src_height * dst_width * CC);
+
+	{ // Horizontal pass.
+
+		float x_scale = float(src_width) / float(dst_width);
+		float scale_factor = MAX(x_scale, 1);
+		int32_t half_kernel = 3 * scale_factor;
+
+		float *kernel = memnew_arr(float, half_kernel * 2);
+
+		for (int32_t buffer_x = 0; buffer_x < dst_width; buffer_x++) {
+
+			float src_x = (buffer_x + 0.5f) * x_scale;
+			int32_t start_x = MAX(0, int32_t(src_x) - half_kernel + 1);
+			int32_t end_x = MIN(src_width - 1, int32_t(src_x) + half_kernel);
+
+			for (int32_t target_x = start_x; target_x <= end_x; target_x++)
+				kernel[target_x - start_x] = _reference_lanczos_kernel((target_x + 0.5f - src_x) / scale_factor);
+
+			for (int32_t buffer_y = 0; buffer_y < src_height; buffer_y++) {
+
+				float pixel[CC] = { 0 };
+				float weight = 0;
+
+				for (int32_t target_x = start_x; target_x <= end_x; target_x++) {
+
+					float lanczos_val = kernel[target_x - start_x];
+					weight += lanczos_val;
+
+					const T *src_data = ((const T *)p_src) + (buffer_y * src_width + target_x) * CC;
+
+					for (uint32_t i = 0; i < CC; i++) {
+						if (sizeof(T) == 2) //half float
+							pixel[i] += Math::half_to_float(src_data[i]) * lanczos_val;
+						else
+							pixel[i] += src_data[i] * lanczos_val;
+					}
+				}
+
+				float *dst_data = buffer + (buffer_y * dst_width + buffer_x) * CC;
+
+				for (uint32_t i = 0; i < CC; i++)
+					dst_data[i] = pixel[i] / weight;
+			}
+		}
+
+		memdelete_arr(kernel);
+	}
+
+	{ // Vertical pass.
+
+		float y_scale = float(src_height) / float(dst_height);
+		float scale_factor = MAX(y_scale, 1);
+		int32_t half_kernel = 3 * scale_factor;
+
+		float *kernel = memnew_arr(float, half_kernel * 2);
+
+		for (int32_t dst_y = 0; dst_y < dst_height; dst_y++) {
+
+			float buffer_y = (dst_y + 0.5f) * y_scale;
+			int32_t start_y = MAX(0, int32_t(buffer_y) - half_kernel + 1);
+			int32_t end_y = MIN(src_height - 1, int32_t(buffer_y) + half_kernel);
+
+			for (int32_t target_y = start_y; target_y <= end_y; target_y++)
+				kernel[target_y - start_y] = _reference_lanczos_kernel((target_y + 0.5f - buffer_y) / scale_factor);
+
+			for (int32_t dst_x = 0; dst_x < dst_width; dst_x++) {
+
+				float pixel[CC] = { 0 };
+				float weight = 0;
+
+				for (int32_t target_y = start_y; target_y <= end_y; target_y++) {
+
+					float lanczos_val = kernel[target_y - start_y];
+					weight += lanczos_val;
+
+					float *buffer_data = buffer + (target_y * dst_width + dst_x) * CC;
+
+					for (uint32_t i = 0; i < CC; i++)
+						pixel[i] += buffer_data[i] * lanczos_val;
+				}
+
+				T *dst_data = ((T *)p_dst) + (dst_y * dst_width + dst_x) * CC;
+
+				for (uint32_t i = 0; i < CC; i++) {
+					pixel[i] /= weight;
+
+					if (sizeof(T) == 1) //byte
+						dst_data[i] = CLAMP(Math::fast_ftoi(pixel[i]), 0, 255);
+					else if (sizeof(T) == 2) //half float
+						dst_data[i] = Math::make_half_float(pixel[i]);
+					else // float
+						dst_data[i] = pixel[i];
+				}
+			}
+		}
+
+		memdelete_arr(kernel);
+	}
+
+	memdelete_arr(buffer);
+}
+
+template <int CC, class T>
+static Vector<uint8_t> _reference_resize_format(const Ref<Image> &p_image, int p_width, int p_height, Image::Interpolation p_interpolation) {
+
+	Vector<uint8_t> src = p_image->get_data();
+	Vector<uint8_t> dst;
+	dst.resize(p_width * p_height * CC * sizeof(T));
+
+	switch (p_interpolation) {
+		case Image::INTERPOLATE_NEAREST: _reference_nearest<CC, T>(src.ptr(), dst.ptrw(), p_image->get_width(), p_image->get_height(), p_width, p_height); break;
+		case Image::INTERPOLATE_BILINEAR: _reference_bilinear<CC, T>(src.ptr(), dst.ptrw(), p_image->get_width(), p_image->get_height(), p_width, p_height); break;
+		case Image::INTERPOLATE_CUBIC: _reference_cubic<CC, T>(src.ptr(), dst.ptrw(), p_image->get_width(), p_image->get_height(), p_width, p_height); break;
+		case Image::INTERPOLATE_LANCZOS: _reference_lanczos<CC, T>(src.ptr(), dst.ptrw(), p_image->get_width(), p_image->get_height(), p_width, p_height); break;
+		default: ERR_FAIL_V(Vector<uint8_t>());
+	}
+	return dst;
+}
+
+static Vector<uint8_t> _reference_resize(const Ref<Image> &p_image, int p_width, int p_height, Image::Interpolation p_interpolation) {
+
+	switch (p_image->get_format()) {
+		case Image::FORMAT_RGB8: return _reference_resize_format<3, uint8_t>(p_image, p_width, p_height, p_interpolation);
+		case Image::FORMAT_RGBA8: return _reference_resize_format<4, uint8_t>(p_image, p_width, p_height, p_interpolation);
+		case Image::FORMAT_RGBAF: return _reference_resize_format<4, float>(p_image, p_width, p_height, p_interpolation);
+		case Image::FORMAT_RGBAH: return _reference_resize_format<4, uint16_t>(p_image, p_width, p_height, p_interpolation);
+		default: ERR_FAIL_V(Vector<uint8_t>());
+	}
+}
+
+static float _srgb_to_linear(uint8_t p_value) {
+
+	float c = p_value / 255.0f;
+	return c < 0.04045f ? c * (1.0f / 12.92f) : Math::pow((c + 0.055f) * (1.0f / 1.055f), 2.4f);
+}
+
+// Averages colors in linear space, picking the sRGB value with the nearest linear intensity.
+static uint8_t _reference_average(uint8_t p_a, uint8_t p_b, uint8_t p_c, uint8_t p_d, bool p_srgb) {
+
+	if (!p_srgb) {
+		return (p_a + p_b + p_c + p_d + 2) >> 2;
+	}
+
+	float linear = (_srgb_to_linear(p_a) + _srgb_to_linear(p_b) + _srgb_to_linear(p_c) + _srgb_to_linear(p_d)) * 0.25f;
+	int value = 0;
+	while (value < 255 && linear > (_srgb_to_linear(value) + _srgb_to_linear(value + 1)) * 0.5f) {
+		value++;
+	}
+	return value;
+}
+
+static float _reference_average(float p_a, float p_b, float p_c, float p_d, bool p_srgb) {
+
+	return (p_a + p_b + p_c + p_d) * 0.25f;
+}
+
+template <class T>
+static Vector<uint8_t> _reference_mipmaps(const Ref<Image> &p_image, bool p_srgb) {
+
+	int channels = Image::get_format_pixel_size(p_image->get_format()) / sizeof(T);
+	// Alpha, the last channel of two and four channel formats, is not gamma encoded.
+	int color_channels = (channels == 2 || channels == 4) ? channels - 1 : channels;
+
+	Ref<Image> image = p_image->duplicate();
+	image->clear_mipmaps();
+	image->generate_mipmaps(); // Only for the size of the data, every level is written below.
+	Vector<uint8_t> data = image->get_data();
+	uint8_t *w = data.ptrw();
+
+	for (int i = 1; i <= image->get_mipmap_count(); i++) {
+
+		int src_ofs, src_size, src_w, src_h;
+		int dst_ofs, dst_size, dst_w, dst_h;
+		image->get_mipmap_offset_size_and_dimensions(i - 1, src_ofs, src_size, src_w, src_h);
+		image->get_mipmap_offset_size_and_dimensions(i, dst_ofs, dst_size, dst_w, dst_h);
+		const T *src = (const T *)&w[src_ofs];
+		T *dst = (T *)&w[dst_ofs];
+
+		int right = src_w == 1 ? 0 : channels;
+		int down = src_h == 1 ? 0 : src_w * channels;
+
+		for (int y = 0; y < dst_h; y++) {
+			for (int x = 0; x < dst_w; x++) {
+				const T *up = src + y * 2 * down + x * 2 * right;
+				for (int c = 0; c < channels; c++) {
+					dst[(y * dst_w + x) * channels + c] = _reference_average(up[c], up[c + right], up[c + down], up[c + down + right], p_srgb && c < color_channels);
+				}
+			}
+		}
+	}
+	return data;
+}
+
+static Ref<Image> _make_image(int p_width, int p_height, Image::Format p_format) {
+
+	Ref<Image> image;
+	image.instance();
+	image->create(p_width, p_height, false, p_format);
+	for (int y = 0; y < p_height; y++) {
+		for (int x = 0; x < p_width; x++) {
+			// Gradients and sharp edges, so resampling has to clamp.
+			image->set_pixel(x, y, Color(((x * 7 + y * 3) % 256) / 255.0, ((x ^ y) & 255) / 255.0, ((x * y) % 251) / 250.0, ((x + y * 5) % 256) / 255.0));
+		}
+	}
+	return image;
+}
+
+static bool _same_data(const Vector<uint8_t> &p_a, const Vector<uint8_t> &p_b) {
+
+	return p_a.size() == p_b.size() && memcmp(p_a.ptr(), p_b.ptr(), p_a.size()) == 0;
+}
+
+static const Image::Format resize_formats[] = { Image::FORMAT_RGB8, Image::FORMAT_RGBA8, Image::FORMAT_RGBAF, Image::FORMAT_RGBAH };
+static const Image::Interpolation interpolations[] = { Image::INTERPOLATE_NEAREST, Image::INTERPOLATE_BILINEAR, Image::INTERPOLATE_CUBIC, Image::INTERPOLATE_LANCZOS };
+static const char *interpolation_names[] = { "nearest", "bilinear", "cubic", "lanczos" };
+
+bool test_resize() {
+
+	OS::get_singleton()->print("\n\nTest 1: Resizing gives the same bytes as the serial kernels\n");
+
+	// Upscaling and downscaling, both large enough to be split in bands.
+	const int sizes[2][2] = { { 1031, 467 }, { 300, 230 } };
+
+	bool ok = true;
+	for (int i = 0; i < 4; i++) {
+		for (int j = 0; j < 4; j++) {
+			for (int k = 0; k < 2; k++) {
+				Ref<Image> image = _make_image(517, 300, resize_formats[i]);
+				Vector<uint8_t> expected = _reference_resize(image, sizes[k][0], sizes[k][1], interpolations[j]);
+				image->resize(sizes[k][0], sizes[k][1], interpolations[j]);
+				if (!_same_data(image->get_data(), expected)) {
+					OS::get_singleton()->print("\t%s, %s to %ix%i differs\n", Image::get_format_name(resize_formats[i]).utf8().get_data(), interpolation_names[j], sizes[k][0], sizes[k][1]);
+					ok = false;
+				}
+			}
+		}
+	}
+	return ok;
+}
+
+bool test_half_cubic() {
+
+	OS::get_singleton()->print("\n\nTest 2: Bicubic scaling of half-float images agrees with float images\n");
+
+	Ref<Image> half = _make_image(517, 300, Image::FORMAT_RGBAH);
+	Ref<Image> full = _make_image(517, 300, Image::FORMAT_RGBAF);
+	half->resize(1031, 467, Image::INTERPOLATE_CUBIC);
+	full->resize(1031, 467, Image::INTERPOLATE_CUBIC);
+
+	float max_error = 0;
+	for (int y = 0; y < 467; y++) {
+		for (int x = 0; x < 1031; x++) {
+			Color a = half->get_pixel(x, y);
+			Color b = full->get_pixel(x, y);
+			for (int i = 0; i < 4; i++) {
+				max_error = MAX(max_error, Math::abs(a.components[i] - b.components[i]));
+			}
+		}
+	}
+
+	OS::get_singleton()->print("\tLargest difference: %f\n", max_error);
+	return max_error < 0.01;
+}
+
+bool test_mipmaps() {
+
+	OS::get_singleton()->print("\n\nTest 3: Mipmaps are the same as the serial average of each 2x2 block\n");
+
+	const Image::Format formats[] = { Image::FORMAT_L8, Image::FORMAT_LA8, Image::FORMAT_RGB8, Image::FORMAT_RGBA8, Image::FORMAT_RGBAF };
+
+	bool ok = true;
+	for (int i = 0; i < 5; i++) {
+		for (int srgb = 0; srgb < 2; srgb++) {
+			Ref<Image> image = _make_image(1030, 600, formats[i]);
+			Vector<uint8_t> expected = formats[i] == Image::FORMAT_RGBAF ? _reference_mipmaps<float>(image, false) : _reference_mipmaps<uint8_t>(image, srgb);
+			image->generate_mipmaps(false, srgb);
+			if (!_same_data(image->get_data(), expected)) {
+				OS::get_singleton()->print("\t%s%s differs\n", Image::get_format_name(formats[i]).utf8().get_data(), srgb ? " (sRGB)" : "");
+				ok = false;
+			}
+		}
+	}
+
+	// Black and white average to a darker gray in sRGB space than in linear space.
+	Ref<Image> checker;
+	checker.instance();
+	checker->create(2, 2, false, Image::FORMAT_L8);
+	checker->set_pixel(0, 0, Color(1, 1, 1));
+	checker->set_pixel(1, 1, Color(1, 1, 1));
+	Ref<Image> linear = checker->duplicate();
+	checker->generate_mipmaps(false, true);
+	linear->generate_mipmaps();
+	int gray = checker->get_data()[4];
+	int dark_gray = linear->get_data()[4];
+	OS::get_singleton()->print("\tBlack and white checker: %i in linear space, %i in sRGB space\n", gray, dark_gray);
+	return ok && gray == 188 && dark_gray == 128;
+}
+
+struct ResizeThread {
+
+	Ref<Image> image;
+	Thread *thread;
+
+	static void resize(void *p_userdata) {
+
+		ResizeThread *rt = (ResizeThread *)p_userdata;
+		rt->image->resize(1031, 467, Image::INTERPOLATE_LANCZOS);
+	}
+};
+
+bool test_threads() {
+
+	OS::get_singleton()->print("\n\nTest 4: Images resized from several threads at once\n");
+
+	// Only one of them gets the work pool, the others resize on their own thread.
+	Ref<Image> image = _make_image(517, 300, Image::FORMAT_RGBA8);
+	Vector<uint8_t> expected = _reference_resize(image, 1031, 467, Image::INTERPOLATE_LANCZOS);
+
+	ResizeThread threads[4];
+	for (int i = 0; i < 4; i++) {
+		threads[i].image = image->duplicate();
+		threads[i].thread = Thread::create(ResizeThread::resize, &threads[i]);
+	}
+
+	bool ok = true;
+	for (int i = 0; i < 4; i++) {
+		Thread::wait_to_finish(threads[i].thread);
+		memdelete(threads[i].thread);
+		ok = ok && _same_data(threads[i].image->get_data(), expected);
+	}
+	return ok;
+}
+
+typedef bool (*TestFunc)(void);
+
+TestFunc test_funcs[] = {
+	test_resize,
+	test_half_cubic,
+	test_mipmaps,
+	test_threads,
+	NULL
+};
+
+MainLoop *test() {
+
+	int count = 0;
+	int passed = 0;
+
+	while (true) {
+		if (!test_funcs[count])
+			break;
+		bool pass = test_funcs[count]();
+		if (pass)
+			passed++;
+		OS::get_singleton()->print("\t%s\n", pass ? "PASS" : "FAILED");
+
+		count++;
+	}
+	OS::get_singleton()->print("\n");
+	OS::get_singleton()->print("Passed %i of %i tests\n", passed, count);
+
+	return NULL;
+}
+
+} // namespace TestImage
@@ -34,16 +34,25 @@
 #ifdef DEBUG_ENABLED
 
 #include "test_astar.h"
+#include "test_canvas_batch.h"
 #include "test_gdscript.h"
 #include "test_gui.h"
+#include "test_image.h"
 #include "test_math.h"
+#include "test_mesh_lod.h"
+#include "test_navigation.h"
 #include "test_oa_hash_map.h"
 #include "test_ordered_hash_map.h"
+#include "test_packed_scene.h"
 #include "test_physics.h"
 #include "test_physics_2d.h"
+#include "test_pck.h"
 #include "test_render.h"
+#include "test_resource_loader.h"
+#include "test_scene_pool.h"
 #include "test_shader_lang.h"
 #include "test_string.h"
+#include "test_variant_parser.h"
 
 const char **tests_get_names() {
 
@@ -60,8 +69,21 @@ const char **tests_get_names() {
 		"gd_parser",
 		"gd_compiler",
 		"gd_bytecode",
+		"gd_benchmark",
+		"gd_load_benchmark",
+		"gd_optimizer",
+		"gd_compiled_buffer",
 		"ordered_hash_map",
 		"astar",
+		"canvas_batch",
+		"mesh_lod",
+		"pck",
+		"resource_loader",
+		"scene_pool",
+		"variant_parser",
+		"navigation",
+		"packed_scene",
+		"image",
 		NULL
 	};
 
@@ -132,6 +154,26 @@ MainLoop *test_main(String p_test, const List<String> &p_args) {
 		return TestGDScript::test(TestGDScript::TEST_BYTECODE);
 	}
 
+	if (p_test == "gd_benchmark") {
+
+		return TestGDScript::test(TestGDScript::TEST_BENCHMARK);
+	}
+
+	if (p_test == "gd_load_benchmark") {
+
+		return TestGDScript::test(TestGDScript::TEST_LOAD_BENCHMARK);
+	}
+
+	if (p_test == "gd_optimizer") {
+
+		return TestGDScript::test(TestGDScript::TEST_OPTIMIZER);
+	}
+
+	if (p_test == "gd_compiled_buffer") {
+
+		return TestGDScript::test(TestGDScript::TEST_COMPILED_BUFFER);
+	}
+
 	if (p_test == "ordered_hash_map") {
 
 		return TestOrderedHashMap::test();
@@ -142,6 +184,51 @@ MainLoop *test_main(String p_test, const List<String> &p_args) {
 		return TestAStar::test();
 	}
 
+	if (p_test == "canvas_batch") {
+
+		return TestCanvasBatch::test();
+	}
+
+	if (p_test == "mesh_lod") {
+
+		return TestMeshLOD::test();
+	}
+
+	if (p_test == "pck") {
+
+		return TestPCK::test();
+	}
+
+	if (p_test == "resource_loader") {
+
+		return TestResourceLoader::test();
+	}
+
+	if (p_test == "scene_pool") {
+
+		return TestScenePool::test();
+	}
+
+	if (p_test == "variant_parser") {
+
+		return TestVariantParser::test();
+	}
+
+	if (p_test == "navigation") {
+
+		return TestNavigation::test();
+	}
+
+	if (p_test == "packed_scene") {
+
+		return TestPackedScene::test();
+	}
+
+	if (p_test == "image") {
+
+		return TestImage::test();
+	}
+
 	print_line("Unknown test: " + p_test);
 	return NULL;
 }
@@ -0,0 +1,317 @@
+/*************************************************************************/
+/*  test_mesh_lod.cpp                                                    */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2020 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2020 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "test_mesh_lod.h"
+
+#include "core/hash_map.h"
+#include "core/os/os.h"
+#include "scene/resources/surface_tool.h"
+
+namespace TestMeshLOD {
+
+static void make_grid(int p_size, Vector<Vector3> &r_vertices, Vector<int> &r_indices) {
+
+	r_vertices.clear();
+	r_indices.clear();
+
+	for (int z = 0; z <= p_size; z++) {
+		for (int x = 0; x <= p_size; x++) {
+			r_vertices.push_back(Vector3(x, 0, z));
+		}
+	}
+
+	for (int z = 0; z < p_size; z++) {
+		for (int x = 0; x < p_size; x++) {
+			int i = z * (p_size + 1) + x;
+			r_indices.push_back(i);
+			r_indices.push_back(i + 1);
+			r_indices.push_back(i + p_size + 1);
+			r_indices.push_back(i + 1);
+			r_indices.push_back(i + p_size + 2);
+			r_indices.push_back(i + p_size + 1);
+		}
+	}
+}
+
+static void make_sphere(int p_rings, int p_segments, Vector<Vector3> &r_vertices, Vector<int> &r_indices) {
+
+	r_vertices.clear();
+	r_indices.clear();
+
+	//closed sphere, the poles and the seam share their vertices
+	r_vertices.push_back(Vector3(0, 1, 0));
+	for (int r = 1; r < p_rings; r++) {
+		float phi = Math_PI * r / p_rings;
+		for (int s = 0; s < p_segments; s++) {
+			float theta = Math_PI * 2.0 * s / p_segments;
+			r_vertices.push_back(Vector3(Math::sin(phi) * Math::cos(theta), Math::cos(phi), Math::sin(phi) * Math::sin(theta)));
+		}
+	}
+	r_vertices.push_back(Vector3(0, -1, 0));
+	int bottom = r_vertices.size() - 1;
+
+	for (int s = 0; s < p_segments; s++) {
+		int next = (s + 1) % p_segments;
+		r_indices.push_back(0);
+		r_indices.push_back(1 + next);
+		r_indices.push_back(1 + s);
+
+		for (int r = 0; r < p_rings - 2; r++) {
+			int a = 1 + r * p_segments;
+			int b = a + p_segments;
+			r_indices.push_back(a + s);
+			r_indices.push_back(a + next);
+			r_indices.push_back(b + s);
+			r_indices.push_back(a + next);
+			r_indices.push_back(b + next);
+			r_indices.push_back(b + s);
+		}
+
+		int last = 1 + (p_rings - 2) * p_segments;
+		r_indices.push_back(bottom);
+		r_indices.push_back(last + s);
+		r_indices.push_back(last + next);
+	}
+}
+
+static Vector3 get_normal(const Vector<Vector3> &p_vertices, const Vector<int> &p_indices, int p_triangle) {
+
+	const Vector3 &a = p_vertices[p_indices[p_triangle * 3 + 0]];
+	const Vector3 &b = p_vertices[p_indices[p_triangle * 3 + 1]];
+	const Vector3 &c = p_vertices[p_indices[p_triangle * 3 + 2]];
+	return (b - a).cross(c - a);
+}
+
+//triangles reference existing vertices, and none is degenerate
+static bool is_valid(const Vector<Vector3> &p_vertices, const Vector<int> &p_indices) {
+
+	if (p_indices.size() % 3 != 0) {
+		return false;
+	}
+
+	for (int i = 0; i < p_indices.size(); i++) {
+		if (p_indices[i] < 0 || p_indices[i] >= p_vertices.size()) {
+			return false;
+		}
+	}
+
+	for (int i = 0; i < p_indices.size() / 3; i++) {
+		if (get_normal(p_vertices, p_indices, i).length() < CMP_EPSILON) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+//every edge is shared by exactly two triangles, in opposite directions
+static bool is_closed(const Vector<int> &p_indices) {
+
+	HashMap<uint64_t, int> edges;
+	for (int i = 0; i < p_indices.size(); i += 3) {
+		for (int j = 0; j < 3; j++) {
+			uint64_t a = p_indices[i + j];
+			uint64_t b = p_indices[i + (j + 1) % 3];
+			if (edges.has((a << 32) | b)) {
+				return false;
+			}
+			edges.set((a << 32) | b, 1);
+		}
+	}
+
+	const uint64_t *K = NULL;
+	while ((K = edges.next(K))) {
+		if (!edges.has((*K << 32) | (*K >> 32))) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool test_grid() {
+
+	Vector<Vector3> vertices;
+	Vector<int> indices;
+	make_grid(16, vertices, indices);
+
+	float error = -1;
+	Vector<int> lod = SurfaceTool::simplify_indices(vertices, indices, indices.size() / 4, &error);
+
+	bool ok = is_valid(vertices, lod);
+	ok = ok && lod.size() <= indices.size() / 2;
+	ok = ok && error >= 0 && error < CMP_EPSILON; //a plane simplifies without error
+
+	//same facing and same covered area, so no triangle flipped or overlaps another
+	float area = 0;
+	for (int i = 0; i < lod.size() / 3; i++) {
+		Vector3 normal = get_normal(vertices, lod, i);
+		ok = ok && normal.y < 0;
+		area += normal.length() * 0.5;
+	}
+	ok = ok && Math::is_equal_approx(area, 16 * 16);
+
+	OS::get_singleton()->print("\tgrid: %i -> %i indices, error %f\n", indices.size(), lod.size(), error);
+	return ok;
+}
+
+bool test_grid_borders_locked() {
+
+	Vector<Vector3> vertices;
+	Vector<int> indices;
+	make_grid(8, vertices, indices);
+
+	Vector<int> lod = SurfaceTool::simplify_indices(vertices, indices, 0);
+
+	//open borders are kept, so adjacent tiles don't crack
+	Vector<bool> used;
+	used.resize(vertices.size());
+	for (int i = 0; i < used.size(); i++) {
+		used.write[i] = false;
+	}
+	for (int i = 0; i < lod.size(); i++) {
+		used.write[lod[i]] = true;
+	}
+
+	bool ok = is_valid(vertices, lod) && lod.size() < indices.size();
+	for (int i = 0; i < vertices.size(); i++) {
+		const Vector3 &v = vertices[i];
+		if (v.x == 0 || v.z == 0 || v.x == 8 || v.z == 8) {
+			ok = ok && used[i];
+		}
+	}
+	return ok;
+}
+
+bool test_seams_locked() {
+
+	Vector<Vector3> vertices;
+	Vector<int> indices;
+	make_grid(8, vertices, indices);
+
+	//split the middle column like a UV seam, the right side gets its own vertices
+	int first_seam_vertex = vertices.size();
+	for (int z = 0; z <= 8; z++) {
+		vertices.push_back(Vector3(4, 0, z));
+	}
+	for (int i = 0; i < indices.size(); i += 3) {
+		bool right = false;
+		for (int j = 0; j < 3; j++) {
+			right = right || vertices[indices[i + j]].x > 4;
+		}
+		for (int j = 0; right && j < 3; j++) {
+			if (vertices[indices[i + j]].x == 4) {
+				indices.write[i + j] = first_seam_vertex + int(vertices[indices[i + j]].z);
+			}
+		}
+	}
+
+	Vector<int> lod = SurfaceTool::simplify_indices(vertices, indices, 0);
+
+	bool ok = is_valid(vertices, lod) && lod.size() < indices.size();
+	for (int z = 0; z <= 8; z++) {
+		ok = ok && lod.find(first_seam_vertex + z) != -1 && lod.find(z * 9 + 4) != -1;
+	}
+	return ok;
+}
+
+bool test_sphere() {
+
+	Vector<Vector3> vertices;
+	Vector<int> indices;
+	make_sphere(16, 32, vertices, indices);
+
+	if (!is_closed(indices)) {
+		return false;
+	}
+
+	float error = -1;
+	Vector<int> lod = SurfaceTool::simplify_indices(vertices, indices, indices.size() * 3 / 10, &error);
+
+	bool ok = is_valid(vertices, lod) && is_closed(lod);
+	ok = ok && lod.size() <= indices.size() / 2;
+	ok = ok && error > 0 && error < 0.5;
+
+	for (int i = 0; i < lod.size() / 3; i++) {
+		Vector3 center = (vertices[lod[i * 3 + 0]] + vertices[lod[i * 3 + 1]] + vertices[lod[i * 3 + 2]]) / 3.0;
+		ok = ok && get_normal(vertices, lod, i).dot(center) > 0; //still facing outwards
+	}
+
+	OS::get_singleton()->print("\tsphere: %i -> %i indices, error %f\n", indices.size(), lod.size(), error);
+	return ok;
+}
+
+bool test_target_reached() {
+
+	Vector<Vector3> vertices;
+	Vector<int> indices;
+	make_grid(4, vertices, indices);
+
+	//nothing to do when the mesh is already under the target
+	Vector<int> lod = SurfaceTool::simplify_indices(vertices, indices, indices.size());
+	bool ok = lod.size() == indices.size();
+	for (int i = 0; ok && i < lod.size(); i++) {
+		ok = lod[i] == indices[i];
+	}
+	return ok;
+}
+
+typedef bool (*TestFunc)(void);
+
+TestFunc test_funcs[] = {
+	test_grid,
+	test_grid_borders_locked,
+	test_seams_locked,
+	test_sphere,
+	test_target_reached,
+	NULL
+};
+
+MainLoop *test() {
+
+	int count = 0;
+	int passed = 0;
+
+	while (true) {
+		if (!test_funcs[count])
+			break;
+		bool pass = test_funcs[count]();
+		if (pass)
+			passed++;
+		OS::get_singleton()->print("\t%s\n", pass ? "PASS" : "FAILED");
+
+		count++;
+	}
+	OS::get_singleton()->print("\n");
+	OS::get_singleton()->print("Passed %i of %i tests\n", passed, count);
+	return NULL;
+}
+
+} // namespace TestMeshLOD
@@ -0,0 +1,813 @@
+/*************************************************************************/
+/*  test_navigation.cpp                                                  */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2020 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2020 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "test_navigation.h"
+
+#include "core/os/os.h"
+
+#include "modules/modules_enabled.gen.h"
+#ifdef MODULE_GDNAVIGATION_ENABLED
+
+#include "core/math/geometry.h"
+#include "core/math/random_pcg.h"
+#include "modules/gdnavigation/gd_navigation_server.h"
+#include "modules/gdnavigation/nav_map.h"
+#include "modules/gdnavigation/nav_region.h"
+#include "scene/resources/navigation_mesh.h"
+
+#include <algorithm>
+
+namespace TestNavigation {
+
+// The queries as NavMap did them before its polygon BVH and open list heap: scanning all the polygons to find the closest
+// ones, and all the open polygons to find the cheapest. They are the reference the results must be identical to.
+
+static const gd::Polygon *_get_closest_polygon_linear(const NavMap &p_map, const Vector3 &p_point, Vector3 &r_closest_point, Face3 *r_face = NULL) {
+
+	const std::vector<gd::Polygon> &polygons = p_map.get_polygons();
+	const gd::Polygon *closest_poly = NULL;
+	float closest_d = 1e20;
+
+	for (size_t i(0); i < polygons.size(); i++) {
+		const gd::Polygon &p = polygons[i];
+
+		for (size_t point_id = 2; point_id < p.points.size(); point_id++) {
+
+			Face3 f(p.points[point_id - 2].pos, p.points[point_id - 1].pos, p.points[point_id].pos);
+			Vector3 spoint = f.get_closest_point_to(p_point);
+			float dpoint = spoint.distance_to(p_point);
+			if (dpoint < closest_d) {
+				closest_d = dpoint;
+				closest_poly = &p;
+				r_closest_point = spoint;
+				if (r_face) {
+					*r_face = f;
+				}
+			}
+		}
+	}
+
+	return closest_poly;
+}
+
+static void _clip_path_linear(const NavMap &p_map, const std::vector<gd::NavigationPoly> &p_navigation_polys, Vector<Vector3> &path, const gd::NavigationPoly *from_poly, const Vector3 &p_to_point, const gd::NavigationPoly *p_to_poly) {
+
+	Vector3 from = path[path.size() - 1];
+
+	if (from.distance_to(p_to_point) < CMP_EPSILON)
+		return;
+	Plane cut_plane;
+	cut_plane.normal = (from - p_to_point).cross(p_map.get_up());
+	if (cut_plane.normal == Vector3())
+		return;
+	cut_plane.normal.normalize();
+	cut_plane.d = cut_plane.normal.dot(from);
+
+	while (from_poly != p_to_poly) {
+
+		int back_nav_edge = from_poly->back_navigation_edge;
+		Vector3 a = from_poly->poly->points[back_nav_edge].pos;
+		Vector3 b = from_poly->poly->points[(back_nav_edge + 1) % from_poly->poly->points.size()].pos;
+
+		ERR_FAIL_COND(from_poly->prev_navigation_poly_id == -1);
+		from_poly = &p_navigation_polys[from_poly->prev_navigation_poly_id];
+
+		if (a.distance_to(b) > CMP_EPSILON) {
+
+			Vector3 inters;
+			if (cut_plane.intersects_segment(a, b, &inters)) {
+				if (inters.distance_to(p_to_point) > CMP_EPSILON && inters.distance_to(path[path.size() - 1]) > CMP_EPSILON) {
+					path.push_back(inters);
+				}
+			}
+		}
+	}
+}
+
+static Vector<Vector3> _get_path_linear(const NavMap &p_map, Vector3 p_origin, Vector3 p_destination, bool p_optimize) {
+
+	const Vector3 up = p_map.get_up();
+
+	Vector3 begin_point;
+	Vector3 end_point;
+	const gd::Polygon *begin_poly = _get_closest_polygon_linear(p_map, p_origin, begin_point);
+	const gd::Polygon *end_poly = _get_closest_polygon_linear(p_map, p_destination, end_point);
+
+	if (!begin_poly || !end_poly) {
+		return Vector<Vector3>();
+	}
+
+	if (begin_poly == end_poly) {
+
+		Vector<Vector3> path;
+		path.resize(2);
+		path.write[0] = begin_point;
+		path.write[1] = end_point;
+		return path;
+	}
+
+	std::vector<gd::NavigationPoly> navigation_polys;
+
+	int least_cost_id(-1);
+	List<uint32_t> open_list;
+	bool found_route = false;
+
+	navigation_polys.push_back(gd::NavigationPoly(begin_poly));
+	least_cost_id = 0;
+	navigation_polys[0].self_id = 0;
+	navigation_polys[0].entry = begin_point;
+
+	open_list.push_back(0);
+
+	const gd::Polygon *reachable_end = NULL;
+	float reachable_d = 1e30;
+	bool is_reachable = true;
+
+	while (found_route == false) {
+
+		for (size_t i = 0; i < navigation_polys[least_cost_id].poly->edges.size(); i++) {
+			gd::NavigationPoly *least_cost_poly = &navigation_polys[least_cost_id];
+
+			const gd::Edge &edge = least_cost_poly->poly->edges[i];
+			if (!edge.other_polygon)
+				continue;
+
+			Vector3 edge_line[2] = {
+				least_cost_poly->poly->points[i].pos,
+				least_cost_poly->poly->points[(i + 1) % least_cost_poly->poly->points.size()].pos
+			};
+
+			const Vector3 new_entry = Geometry::get_closest_point_to_segment(least_cost_poly->entry, edge_line);
+			const float new_distance = least_cost_poly->entry.distance_to(new_entry) + least_cost_poly->traveled_distance;
+
+			auto it = std::find(
+					navigation_polys.begin(),
+					navigation_polys.end(),
+					gd::NavigationPoly(edge.other_polygon));
+
+			if (it != navigation_polys.end()) {
+				if (it->traveled_distance > new_distance) {
+
+					it->prev_navigation_poly_id = least_cost_id;
+					it->back_navigation_edge = edge.other_edge;
+					it->traveled_distance = new_distance;
+					it->entry = new_entry;
+				}
+			} else {
+
+				navigation_polys.push_back(gd::NavigationPoly(edge.other_polygon));
+				gd::NavigationPoly *np = &navigation_polys[navigation_polys.size() - 1];
+
+				np->self_id = navigation_polys.size() - 1;
+				np->prev_navigation_poly_id = least_cost_id;
+				np->back_navigation_edge = edge.other_edge;
+				np->traveled_distance = new_distance;
+				np->entry = new_entry;
+				open_list.push_back(navigation_polys.size() - 1);
+			}
+		}
+
+		open_list.erase(least_cost_id);
+
+		if (open_list.size() == 0) {
+			ERR_BREAK(is_reachable == false);
+			is_reachable = false;
+			if (reachable_end == NULL) {
+				break;
+			}
+
+			end_poly = reachable_end;
+			float end_d = 1e20;
+			for (size_t point_id = 2; point_id < end_poly->points.size(); point_id++) {
+				Face3 f(end_poly->points[point_id - 2].pos, end_poly->points[point_id - 1].pos, end_poly->points[point_id].pos);
+				Vector3 spoint = f.get_closest_point_to(p_destination);
+				float dpoint = spoint.distance_to(p_destination);
+				if (dpoint < end_d) {
+					end_point = spoint;
+					end_d = dpoint;
+				}
+			}
+
+			gd::NavigationPoly np = navigation_polys[0];
+			navigation_polys.clear();
+			navigation_polys.push_back(np);
+			open_list.clear();
+			open_list.push_back(0);
+			least_cost_id = 0; // The old code kept the last id here, past the end of the cleared polys.
+
+			reachable_end = NULL;
+
+			continue;
+		}
+
+		least_cost_id = -1;
+		float least_cost = 1e30;
+
+		for (List<uint32_t>::Element *element = open_list.front(); element != NULL; element = element->next()) {
+			gd::NavigationPoly *np = &navigation_polys[element->get()];
+			float cost = np->traveled_distance + np->entry.distance_to(end_point);
+			if (cost < least_cost) {
+				least_cost_id = np->self_id;
+				least_cost = cost;
+			}
+		}
+
+		if (is_reachable) {
+			float d = navigation_polys[least_cost_id].entry.distance_to(p_destination);
+			if (reachable_d > d) {
+				reachable_d = d;
+				reachable_end = navigation_polys[least_cost_id].poly;
+			}
+		}
+
+		ERR_BREAK(least_cost_id == -1);
+
+		if (navigation_polys[least_cost_id].poly == end_poly) {
+			found_route = true;
+			break;
+		}
+	}
+
+	if (!found_route) {
+		return Vector<Vector3>();
+	}
+
+	Vector<Vector3> path;
+	if (p_optimize) {
+
+		// String pulling
+		gd::NavigationPoly *apex_poly = &navigation_polys[least_cost_id];
+		Vector3 apex_point = end_point;
+		Vector3 portal_left = apex_point;
+		Vector3 portal_right = apex_point;
+		gd::NavigationPoly *left_poly = apex_poly;
+		gd::NavigationPoly *right_poly = apex_poly;
+		gd::NavigationPoly *p = apex_poly;
+
+		path.push_back(end_point);
+
+		while (p) {
+
+			Vector3 left;
+			Vector3 right;
+
+#define CLOCK_TANGENT(m_a, m_b, m_c) (((m_a) - (m_c)).cross((m_a) - (m_b)))
+
+			if (p->poly == begin_poly) {
+				left = begin_point;
+				right = begin_point;
+			} else {
+				int prev = p->back_navigation_edge;
+				int prev_n = (p->back_navigation_edge + 1) % p->poly->points.size();
+				left = p->poly->points[prev].pos;
+				right = p->poly->points[prev_n].pos;
+
+				if (p->poly->clockwise) {
+					SWAP(left, right);
+				}
+			}
+
+			bool skip = false;
+
+			if (CLOCK_TANGENT(apex_point, portal_left, left).dot(up) >= 0) {
+				if (portal_left == apex_point || CLOCK_TANGENT(apex_point, left, portal_right).dot(up) > 0) {
+					left_poly = p;
+					portal_left = left;
+				} else {
+
+					_clip_path_linear(p_map, navigation_polys, path, apex_poly, portal_right, right_poly);
+
+					apex_point = portal_right;
+					p = right_poly;
+					left_poly = p;
+					apex_poly = p;
+					portal_left = apex_point;
+					portal_right = apex_point;
+					path.push_back(apex_point);
+					skip = true;
+				}
+			}
+
+			if (!skip && CLOCK_TANGENT(apex_point, portal_right, right).dot(up) <= 0) {
+				if (portal_right == apex_point || CLOCK_TANGENT(apex_point, right, portal_left).dot(up) < 0) {
+					right_poly = p;
+					portal_right = right;
+				} else {
+
+					_clip_path_linear(p_map, navigation_polys, path, apex_poly, portal_left, left_poly);
+
+					apex_point = portal_left;
+					p = left_poly;
+					right_poly = p;
+					apex_poly = p;
+					portal_right = apex_point;
+					portal_left = apex_point;
+					path.push_back(apex_point);
+				}
+			}
+
+#undef CLOCK_TANGENT
+
+			if (p->prev_navigation_poly_id != -1)
+				p = &navigation_polys[p->prev_navigation_poly_id];
+			else
+				p = NULL;
+		}
+
+		if (path[path.size() - 1] != begin_point)
+			path.push_back(begin_point);
+
+		path.invert();
+
+	} else {
+		path.push_back(end_point);
+
+		int np_id = least_cost_id;
+		while (np_id != -1) {
+			path.push_back(navigation_polys[np_id].entry);
+			np_id = navigation_polys[np_id].prev_navigation_poly_id;
+		}
+
+		path.invert();
+	}
+
+	return path;
+}
+
+// A grid of quads on the XZ plane with walls every 20 rows, each with a gap, and an unreachable island beside it.
+struct TestMap {
+
+	Ref<NavigationMesh> mesh;
+	NavMap map;
+	NavRegion region;
+	int size;
+
+	TestMap(int p_size) {
+
+		size = p_size;
+
+		Vector<Vector3> vertices;
+		for (int z = 0; z <= size; z++) {
+			for (int x = 0; x <= size; x++) {
+				vertices.push_back(Vector3(x, 0, z));
+			}
+		}
+		int island = vertices.size();
+		for (int i = 0; i < 4; i++) {
+			vertices.push_back(Vector3(size + 50 + i, 0, 0));
+			vertices.push_back(Vector3(size + 50 + i, 0, 1));
+		}
+
+		mesh.instance();
+		mesh->set_vertices(vertices);
+
+		for (int z = 0; z < size; z++) {
+			for (int x = 0; x < size; x++) {
+				if (z % 20 == 10 && (x + z * 7) % size > 3) {
+					continue;
+				}
+				Vector<int> quad;
+				quad.push_back(z * (size + 1) + x);
+				quad.push_back(z * (size + 1) + x + 1);
+				quad.push_back((z + 1) * (size + 1) + x + 1);
+				quad.push_back((z + 1) * (size + 1) + x);
+				mesh->add_polygon(quad);
+			}
+		}
+		for (int i = 0; i < 3; i++) {
+			Vector<int> quad;
+			quad.push_back(island + i * 2);
+			quad.push_back(island + i * 2 + 2);
+			quad.push_back(island + i * 2 + 3);
+			quad.push_back(island + i * 2 + 1);
+			mesh->add_polygon(quad);
+		}
+
+		map.set_edge_connection_margin(0.0);
+		region.set_map(&map);
+		region.set_mesh(mesh);
+		map.add_region(&region);
+		map.sync();
+	}
+
+	~TestMap() {
+		map.remove_region(&region);
+	}
+
+	Vector3 random_point(RandomPCG &p_rng) const {
+		return Vector3(p_rng.randf() * size, p_rng.randf() * 2 - 1, p_rng.randf() * size);
+	}
+
+	Vector3 island_point() const {
+		return Vector3(size + 51.5, 0, 0.5);
+	}
+};
+
+static TestMap *small_map = NULL;
+
+static bool _same_path(const Vector<Vector3> &p_a, const Vector<Vector3> &p_b) {
+
+	if (p_a.size() != p_b.size()) {
+		return false;
+	}
+	for (int i = 0; i < p_a.size(); i++) {
+		if (p_a[i] != p_b[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool test_map() {
+
+	OS::get_singleton()->print("\n\nTest 1: Build a navigation map\n");
+
+	small_map = memnew(TestMap(100));
+	OS::get_singleton()->print("\t%i polygons\n", (int)small_map->map.get_polygons().size());
+
+	const std::vector<gd::Polygon> &polygons = small_map->map.get_polygons();
+	ERR_FAIL_COND_V(polygons.size() != (size_t)small_map->mesh->get_polygon_count(), false);
+
+	int linked = 0;
+	for (size_t i = 0; i < polygons.size(); i++) {
+		for (size_t j = 0; j < polygons[i].edges.size(); j++) {
+			linked += polygons[i].edges[j].other_polygon != NULL;
+		}
+	}
+	ERR_FAIL_COND_V(linked == 0, false);
+	return true;
+}
+
+bool test_closest_point() {
+
+	OS::get_singleton()->print("\n\nTest 2: Closest points are the same as scanning all polygons\n");
+
+	RandomPCG rng(1);
+	const NavMap &map = small_map->map;
+
+	for (int i = 0; i < 2000; i++) {
+
+		Vector3 point = small_map->random_point(rng);
+		if (i % 10 == 0) {
+			point += Vector3(rng.randf() * 400 - 200, rng.randf() * 40 - 20, rng.randf() * 400 - 200); // Far from the mesh too.
+		}
+
+		Vector3 expected;
+		Face3 face;
+		const gd::Polygon *poly = _get_closest_polygon_linear(map, point, expected, &face);
+		ERR_FAIL_COND_V(!poly, false);
+
+		if (map.get_closest_point(point) != expected || map.get_closest_point_normal(point) != face.get_plane().normal || map.get_closest_point_owner(point) != poly->owner->get_self()) {
+			OS::get_singleton()->print("\tDifferent closest point to (%f, %f, %f)\n", point.x, point.y, point.z);
+			return false;
+		}
+	}
+	return true;
+}
+
+bool test_path() {
+
+	OS::get_singleton()->print("\n\nTest 3: Paths are the same as with a linear open list\n");
+
+	RandomPCG rng(2);
+	const NavMap &map = small_map->map;
+
+	int unreachable = 0;
+	for (int i = 0; i < 200; i++) {
+
+		Vector3 from = small_map->random_point(rng);
+		Vector3 to = small_map->random_point(rng);
+		if (i % 7 == 3) {
+			to = small_map->island_point(); // The closest reachable point is used instead.
+			unreachable++;
+		} else if (i % 11 == 5) {
+			to = from + Vector3(0.1, 0, 0.1); // Within the same polygon most times.
+		}
+		bool optimize = i & 1;
+
+		Vector<Vector3> expected = _get_path_linear(map, from, to, optimize);
+		Vector<Vector3> path = map.get_path(from, to, optimize);
+		if (!_same_path(path, expected) || path.size() < 2) {
+			OS::get_singleton()->print("\tDifferent path from (%f, %f, %f) to (%f, %f, %f): %i points, expected %i\n", from.x, from.y, from.z, to.x, to.y, to.z, path.size(), expected.size());
+			return false;
+		}
+	}
+
+	OS::get_singleton()->print("\t200 paths, %i to the unreachable island\n", unreachable);
+	return true;
+}
+
+bool test_benchmark() {
+
+	OS::get_singleton()->print("\n\nTest 4: Query a 100k polygon map\n");
+
+	uint64_t t = OS::get_singleton()->get_ticks_usec();
+	TestMap *large_map = memnew(TestMap(316));
+	uint64_t build_usec = OS::get_singleton()->get_ticks_usec() - t;
+	const NavMap &map = large_map->map;
+
+	RandomPCG rng(3);
+	const int linear_paths = 2;
+	const int paths = 50;
+	const int points = 2000;
+	bool ok = true;
+
+	uint64_t path_usec = 0;
+	uint64_t linear_path_usec = 0;
+	for (int i = 0; i < paths && ok; i++) {
+
+		Vector3 from = large_map->random_point(rng);
+		Vector3 to = large_map->random_point(rng);
+
+		t = OS::get_singleton()->get_ticks_usec();
+		Vector<Vector3> path = map.get_path(from, to, true);
+		path_usec += OS::get_singleton()->get_ticks_usec() - t;
+
+		if (i < linear_paths) {
+			t = OS::get_singleton()->get_ticks_usec();
+			Vector<Vector3> expected = _get_path_linear(map, from, to, true);
+			linear_path_usec += OS::get_singleton()->get_ticks_usec() - t;
+			ok = _same_path(path, expected);
+		}
+	}
+
+	uint64_t point_usec = 0;
+	uint64_t linear_point_usec = 0;
+	for (int i = 0; i < points && ok; i++) {
+
+		Vector3 point = large_map->random_point(rng);
+
+		t = OS::get_singleton()->get_ticks_usec();
+		Vector3 closest = map.get_closest_point(point);
+		point_usec += OS::get_singleton()->get_ticks_usec() - t;
+
+		if (i < points / 100) {
+			Vector3 expected;
+			t = OS::get_singleton()->get_ticks_usec();
+			_get_closest_polygon_linear(map, point, expected);
+			linear_point_usec += OS::get_singleton()->get_ticks_usec() - t;
+			ok = closest == expected;
+		}
+	}
+
+	OS::get_singleton()->print("\t%i polygons, built in %.1f ms\n", (int)map.get_polygons().size(), build_usec / 1000.0);
+	OS::get_singleton()->print("\tget_path: %.3f ms, linear: %.1f ms\n", path_usec / 1000.0 / paths, linear_path_usec / 1000.0 / linear_paths);
+	OS::get_singleton()->print("\tget_closest_point: %.4f ms, linear: %.3f ms\n", point_usec / 1000.0 / points, linear_point_usec / 1000.0 / (points / 100));
+
+	memdelete(large_map);
+	return ok;
+}
+
+// The engine's server, or one made here when the tests run without the servers.
+static GdNavigationServer *server = NULL;
+static bool own_server = false;
+static RID server_map;
+static RID server_region;
+
+static RID _make_server_map(RID &r_region) {
+
+	RID map = server->map_create();
+	server->map_set_edge_connection_margin(map, 0.0);
+	server->map_set_active(map, true);
+	r_region = server->region_create();
+	server->region_set_map(r_region, map);
+	server->region_set_navmesh(r_region, small_map->mesh);
+	server->process(0); // Runs the commands and syncs the map.
+	return map;
+}
+
+static void _make_batch(RandomPCG &p_rng, int p_count, Vector<Vector3> &r_origins, Vector<Vector3> &r_destinations) {
+
+	r_origins.resize(p_count);
+	r_destinations.resize(p_count);
+	for (int i = 0; i < p_count; i++) {
+		r_origins.write[i] = small_map->random_point(p_rng);
+		r_destinations.write[i] = i % 7 == 3 ? small_map->island_point() : small_map->random_point(p_rng);
+	}
+}
+
+// Runs frames until the query is done, returns how many it took or -1 past p_max_frames.
+static int _run_until_done(RID p_query, int p_max_frames) {
+
+	int frames = 0;
+	while (!server->path_query_is_done(p_query)) {
+		if (frames == p_max_frames) {
+			return -1;
+		}
+		server->process(0);
+		OS::get_singleton()->delay_usec(1000);
+		frames++;
+	}
+	return frames;
+}
+
+static bool _same_paths(RID p_query, RID p_map, const Vector<Vector3> &p_origins, const Vector<Vector3> &p_destinations, bool p_optimize) {
+
+	for (int i = 0; i < p_origins.size(); i++) {
+		Vector<Vector3> path = server->path_query_get_path(p_query, i);
+		if (!_same_path(path, server->map_get_path(p_map, p_origins[i], p_destinations[i], p_optimize)) || path.size() < 2) {
+			OS::get_singleton()->print("\tDifferent path %i, %i points\n", i, path.size());
+			return false;
+		}
+	}
+	return true;
+}
+
+bool test_path_queries() {
+
+	OS::get_singleton()->print("\n\nTest 5: Batched path queries are the same as map_get_path\n");
+
+	if (NavigationServer::get_singleton()) {
+		server = static_cast<GdNavigationServer *>(NavigationServer::get_singleton_mut());
+	} else {
+		server = memnew(GdNavigationServer);
+		own_server = true;
+	}
+	server_map = _make_server_map(server_region);
+
+	RandomPCG rng(4);
+	Vector<Vector3> origins;
+	Vector<Vector3> destinations;
+	_make_batch(rng, 300, origins, destinations);
+
+	RID query = server->map_request_paths(server_map, origins, destinations, true);
+	RID plain_query = server->map_request_paths(server_map, origins, destinations, false);
+	int frames = _run_until_done(query, 1000);
+	bool ok = frames >= 0 && _run_until_done(plain_query, 1000) >= 0;
+	ok = ok && _same_paths(query, server_map, origins, destinations, true) && _same_paths(plain_query, server_map, origins, destinations, false);
+	server->free(query);
+	server->free(plain_query);
+
+	OS::get_singleton()->print("\t2 queries of 300 paths, in %i frames\n", frames);
+	return ok;
+}
+
+bool test_path_query_free() {
+
+	OS::get_singleton()->print("\n\nTest 6: Free a query and a map while their paths are pending\n");
+
+	const real_t time_budget = server->get_path_queries_time_budget();
+	server->set_path_queries_time_budget(1);
+
+	RandomPCG rng(5);
+	Vector<Vector3> origins;
+	Vector<Vector3> destinations;
+	_make_batch(rng, 100000, origins, destinations);
+	Vector<Vector3> short_origins;
+	Vector<Vector3> short_destinations;
+	_make_batch(rng, 10, short_origins, short_destinations);
+
+	// The long batch is searched first, the short one only gets its turn soon if the long one is cancelled.
+	RID query = server->map_request_paths(server_map, origins, destinations, true);
+	RID short_query = server->map_request_paths(server_map, short_origins, short_destinations, true);
+	server->process(0);
+	server->free(query);
+	int frames = _run_until_done(short_query, 50);
+	bool ok = frames >= 0 && _same_paths(short_query, server_map, short_origins, short_destinations, true);
+	server->free(short_query);
+
+	// The paths searched before the map is freed are kept, the others are returned empty.
+	RID region;
+	RID map = _make_server_map(region);
+	query = server->map_request_paths(map, origins, destinations, true);
+	server->process(0);
+	OS::get_singleton()->delay_usec(1000);
+	server->free(map);
+	server->free(region);
+	server->process(0);
+
+	int found = 0;
+	for (int i = 0; i < origins.size(); i++) {
+		found += server->path_query_get_path(query, i).size() > 0;
+	}
+	ok = ok && server->path_query_is_done(query) && found < origins.size();
+	server->free(query);
+
+	server->set_path_queries_time_budget(time_budget);
+
+	OS::get_singleton()->print("\tShort query done %i frames after the long one was freed, %i of %i paths found before the map was freed\n", frames, found, origins.size());
+	return ok;
+}
+
+bool test_path_query_time_budget() {
+
+	OS::get_singleton()->print("\n\nTest 7: Paths past the time budget are searched after the next process()\n");
+
+	const real_t time_budget = server->get_path_queries_time_budget();
+	server->set_path_queries_time_budget(1);
+
+	RandomPCG rng(6);
+	Vector<Vector3> origins;
+	Vector<Vector3> destinations;
+	_make_batch(rng, 2000, origins, destinations);
+
+	// Once the budget is spent no more paths are found until the next frame.
+	RID query = server->map_request_paths(server_map, origins, destinations, true);
+	server->process(0);
+	int found[2] = { 0, 0 };
+	for (int i = 0; i < 2; i++) {
+		OS::get_singleton()->delay_usec(20000);
+		for (int j = 0; j < origins.size(); j++) {
+			found[i] += server->path_query_get_path(query, j).size() > 0;
+		}
+	}
+	int frames = _run_until_done(query, 100000) + 1;
+	bool ok = found[0] == found[1] && found[0] < origins.size() && frames > 1 && _same_paths(query, server_map, origins, destinations, true);
+	server->free(query);
+
+	server->set_path_queries_time_budget(time_budget);
+
+	OS::get_singleton()->print("\t%i paths found in the first frame, 2000 in %i frames, with a budget of 1 ms\n", found[0], frames);
+	return ok;
+}
+
+typedef bool (*TestFunc)(void);
+
+TestFunc test_funcs[] = {
+	test_map,
+	test_closest_point,
+	test_path,
+	test_benchmark,
+	test_path_queries,
+	test_path_query_free,
+	test_path_query_time_budget,
+	NULL
+};
+
+MainLoop *test() {
+
+	int count = 0;
+	int passed = 0;
+
+	while (true) {
+		if (!test_funcs[count])
+			break;
+		bool pass = test_funcs[count]();
+		if (pass)
+			passed++;
+		OS::get_singleton()->print("\t%s\n", pass ? "PASS" : "FAILED");
+
+		count++;
+	}
+	OS::get_singleton()->print("\n");
+	OS::get_singleton()->print("Passed %i of %i tests\n", passed, count);
+
+	if (server) {
+		server->free(server_region);
+		server->free(server_map);
+		server->process(0);
+		if (own_server) {
+			memdelete(server);
+		}
+		server = NULL;
+	}
+
+	if (small_map) {
+		memdelete(small_map);
+		small_map = NULL;
+	}
+
+	return NULL;
+}
+
+} // namespace TestNavigation
+
+#else
+
+namespace TestNavigation {
+
+MainLoop *test() {
+	ERR_PRINT("The gdnavigation module is disabled, therefore navigation tests cannot be used.");
+	return NULL;
+}
+
+} // namespace TestNavigation
+
+#endif
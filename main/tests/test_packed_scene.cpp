@@ -0,0 +1,253 @@
+/*************************************************************************/
+/*  test_packed_scene.cpp                                                */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2020 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2020 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "test_packed_scene.h"
+
+#include "core/os/os.h"
+#include "scene/main/timer.h"
+#include "scene/resources/packed_scene.h"
+
+namespace TestPackedScene {
+
+// Instanced in the base scene, which the inherited scene extends.
+static Ref<PackedScene> child_scene;
+static Ref<PackedScene> base_scene;
+static Ref<PackedScene> inherited_scene;
+static Ref<PackedScene> flat_scene;
+
+static Timer *_add_timer(Node *p_parent, Node *p_owner, const String &p_name) {
+
+	Timer *timer = memnew(Timer);
+	timer->set_name(p_name);
+	p_parent->add_child(timer);
+	timer->set_owner(p_owner);
+	return timer;
+}
+
+// Stored properties and metadata of the whole tree, one line per item.
+static void _describe_tree(Node *p_root, Node *p_node, Vector<String> &r_lines) {
+
+	String prefix = String(p_root->get_path_to(p_node)) + " (" + p_node->get_class() + ", " + p_node->get_filename() + ")";
+	r_lines.push_back(prefix);
+
+	List<PropertyInfo> plist;
+	p_node->get_property_list(&plist);
+	for (List<PropertyInfo>::Element *E = plist.front(); E; E = E->next()) {
+		if (E->get().usage & PROPERTY_USAGE_STORAGE) {
+			r_lines.push_back(prefix + " property " + E->get().name + ": " + p_node->get(E->get().name).get_construct_string());
+		}
+	}
+
+	List<String> meta;
+	p_node->get_meta_list(&meta);
+	for (List<String>::Element *E = meta.front(); E; E = E->next()) {
+		r_lines.push_back(prefix + " meta " + E->get() + ": " + p_node->get_meta(E->get()).get_construct_string());
+	}
+
+	for (int i = 0; i < p_node->get_child_count(); i++) {
+		_describe_tree(p_root, p_node->get_child(i), r_lines);
+	}
+}
+
+static Vector<String> _describe_instance(const Ref<PackedScene> &p_scene, bool p_property_setters) {
+
+	SceneState::set_disable_property_setters(!p_property_setters);
+	Node *instance = p_scene->instance();
+	SceneState::set_disable_property_setters(false);
+
+	Vector<String> lines;
+	ERR_FAIL_COND_V(!instance, lines);
+	_describe_tree(instance, instance, lines);
+	memdelete(instance);
+	return lines;
+}
+
+// Same state from the property setters as from Object::set().
+static bool _check_scene(const Ref<PackedScene> &p_scene) {
+
+	Vector<String> direct = _describe_instance(p_scene, true);
+	Vector<String> set = _describe_instance(p_scene, false);
+	if (direct.empty()) {
+		return false;
+	}
+
+	bool ok = true;
+	for (int i = 0; i < MAX(direct.size(), set.size()); i++) {
+		String a = i < direct.size() ? direct[i] : String();
+		String b = i < set.size() ? set[i] : String();
+		if (a != b) {
+			OS::get_singleton()->print("\t%ls: \"%ls\" with setters, \"%ls\" with Object::set()\n", p_scene->get_path().c_str(), a.c_str(), b.c_str());
+			ok = false;
+		}
+	}
+	return ok;
+}
+
+bool test_pack() {
+
+	OS::get_singleton()->print("\n\nTest 1: Pack a scene, one that instances it and one that inherits that\n");
+
+	Timer *child = memnew(Timer);
+	child->set_name("Child");
+	child->set_wait_time(2.0);
+	child->set_one_shot(true);
+	Timer *inner = _add_timer(child, child, "Inner");
+	inner->set_autostart(true);
+	inner->set_meta("kind", "inner");
+
+	child_scene.instance();
+	child_scene->set_path("res://test_packed_scene_child.tscn");
+	Error err = child_scene->pack(child);
+	memdelete(child);
+	ERR_FAIL_COND_V(err != OK, false);
+
+	Timer *base = memnew(Timer);
+	base->set_name("Base");
+	base->set_wait_time(3.0);
+	base->set_timer_process_mode(Timer::TIMER_PROCESS_PHYSICS);
+	base->set_pause_mode(Node::PAUSE_MODE_PROCESS);
+	Timer *own = _add_timer(base, base, "Own");
+	own->set_one_shot(true);
+	own->set_process_priority(3);
+	own->set_import_path(NodePath("Imported/Own"));
+	Node *instanced = child_scene->instance();
+	base->add_child(instanced);
+	instanced->set_owner(base);
+	Object::cast_to<Timer>(instanced)->set_wait_time(5.0);
+	instanced->set_meta("overridden", true);
+
+	base_scene.instance();
+	base_scene->set_path("res://test_packed_scene_base.tscn");
+	err = base_scene->pack(base);
+	memdelete(base);
+	ERR_FAIL_COND_V(err != OK, false);
+
+	Node *inherited = base_scene->instance();
+	ERR_FAIL_COND_V(!inherited, false);
+	inherited->set_filename("");
+	inherited->set_scene_inherited_state(base_scene->get_state());
+	Object::cast_to<Timer>(inherited)->set_wait_time(7.0);
+	Object::cast_to<Timer>(inherited->get_node(NodePath("Own")))->set_one_shot(false);
+	Timer *added = _add_timer(inherited, inherited, "Added");
+	added->set_wait_time(9.0);
+	added->set_autostart(true);
+	added->set_process_priority(-2);
+
+	inherited_scene.instance();
+	inherited_scene->set_path("res://test_packed_scene_inherited.tscn");
+	err = inherited_scene->pack(inherited);
+	memdelete(inherited);
+	ERR_FAIL_COND_V(err != OK, false);
+
+	// Only nodes created from their own type use the setters, make sure the others are there to compare.
+	return base_scene->get_state()->get_node_instance(2) == child_scene && inherited_scene->get_state()->get_node_instance(0) == base_scene;
+}
+
+bool test_compare() {
+
+	OS::get_singleton()->print("\n\nTest 2: Property setters give the same state as Object::set()\n");
+
+	bool ok = _check_scene(child_scene);
+	ok = _check_scene(base_scene) && ok;
+	ok = _check_scene(inherited_scene) && ok;
+	return ok;
+}
+
+bool test_benchmark() {
+
+	OS::get_singleton()->print("\n\nTest 3: Instance times with property setters and with Object::set()\n");
+
+	Node *root = memnew(Node);
+	root->set_name("Root");
+	for (int i = 0; i < 100; i++) {
+		Timer *timer = _add_timer(root, root, "Timer" + itos(i));
+		timer->set_wait_time(1.0 + i);
+		timer->set_one_shot(true);
+		timer->set_autostart(true);
+		timer->set_process_priority(i);
+		timer->set_timer_process_mode(Timer::TIMER_PROCESS_PHYSICS);
+	}
+	flat_scene.instance();
+	flat_scene->set_path("res://test_packed_scene_flat.tscn");
+	Error err = flat_scene->pack(root);
+	memdelete(root);
+	ERR_FAIL_COND_V(err != OK, false);
+
+	const int count = 1000;
+	uint64_t usec[2];
+	for (int mode = 0; mode < 2; mode++) {
+		SceneState::set_disable_property_setters(mode == 1);
+		uint64_t t = OS::get_singleton()->get_ticks_usec();
+		for (int i = 0; i < count; i++) {
+			memdelete(flat_scene->instance());
+		}
+		usec[mode] = OS::get_singleton()->get_ticks_usec() - t;
+	}
+	SceneState::set_disable_property_setters(false);
+
+	OS::get_singleton()->print("\t%i instances of 100 nodes with 5 properties, setters: %.1f ms, Object::set(): %.1f ms\n", count, usec[0] / 1000.0, usec[1] / 1000.0);
+	return _check_scene(flat_scene);
+}
+
+typedef bool (*TestFunc)(void);
+
+TestFunc test_funcs[] = {
+	test_pack,
+	test_compare,
+	test_benchmark,
+	NULL
+};
+
+MainLoop *test() {
+
+	int count = 0;
+	int passed = 0;
+
+	while (true) {
+		if (!test_funcs[count])
+			break;
+		bool pass = test_funcs[count]();
+		if (pass)
+			passed++;
+		OS::get_singleton()->print("\t%s\n", pass ? "PASS" : "FAILED");
+
+		count++;
+	}
+	OS::get_singleton()->print("\n");
+	OS::get_singleton()->print("Passed %i of %i tests\n", passed, count);
+
+	flat_scene.unref();
+	inherited_scene.unref();
+	base_scene.unref();
+	child_scene.unref();
+	return NULL;
+}
+
+} // namespace TestPackedScene
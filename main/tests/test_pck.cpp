@@ -0,0 +1,480 @@
+/*************************************************************************/
+/*  test_pck.cpp                                                         */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2020 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2020 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "test_pck.h"
+
+#include "core/crypto/crypto_core.h"
+#include "core/io/compression.h"
+#include "core/io/file_access_pack.h"
+#include "core/io/marshalls.h"
+#include "core/io/pck_packer.h"
+#include "core/math/random_pcg.h"
+#include "core/os/dir_access.h"
+#include "core/os/file_access.h"
+#include "core/os/os.h"
+#include "core/version.h"
+
+namespace TestPCK {
+
+#define TEST_DIR "user://test_pck"
+#define TEST_FILE_COUNT 48
+#define TEST_ALIGNMENT 64
+
+static Vector<String> paths;
+static Vector<Vector<uint8_t> > contents;
+static Vector<String> created_files;
+
+static bool _write_file(const String &p_path, const Vector<uint8_t> &p_data) {
+
+	FileAccess *f = FileAccess::open(p_path, FileAccess::WRITE);
+	ERR_FAIL_COND_V(!f, false);
+	f->store_buffer(p_data.ptr(), p_data.size());
+	f->close();
+	memdelete(f);
+	created_files.push_back(p_path);
+	return true;
+}
+
+static Vector<uint8_t> _text(const String &p_text) {
+
+	CharString cs = p_text.utf8();
+	Vector<uint8_t> data;
+	data.resize(cs.length());
+	copymem(data.ptrw(), cs.get_data(), cs.length());
+	return data;
+}
+
+// Small files, compressible text and random bytes, so both stored and compressed entries get written.
+static Vector<uint8_t> _make_contents(int p_index, RandomPCG &r_rng) {
+
+	Vector<uint8_t> data;
+	switch (p_index % 3) {
+		case 0: {
+			data = _text("file " + itos(p_index));
+		} break;
+		case 1: {
+			String line = "line of text in file " + itos(p_index) + "\n";
+			String text;
+			while (text.length() < 1000 + p_index * 37) {
+				text += line;
+			}
+			data = _text(text);
+		} break;
+		case 2: {
+			data.resize(300 + p_index * 53);
+			for (int i = 0; i < data.size(); i++) {
+				data.write[i] = r_rng.rand() & 0xFF;
+			}
+		} break;
+	}
+	return data;
+}
+
+static bool _equal(const Vector<uint8_t> &p_a, const Vector<uint8_t> &p_b) {
+
+	return p_a.size() == p_b.size() && (p_a.size() == 0 || memcmp(p_a.ptr(), p_b.ptr(), p_a.size()) == 0);
+}
+
+static PackedData *_get_packed_data() {
+
+	if (!PackedData::get_singleton()) {
+		memnew(PackedData); // Main::setup() makes it, the test may run without.
+	}
+	return PackedData::get_singleton();
+}
+
+static bool _read_packed(const String &p_path, Vector<uint8_t> &r_data) {
+
+	FileAccess *f = _get_packed_data()->try_open_path(p_path);
+	if (!f)
+		return false;
+	r_data.resize(f->get_len());
+	int read = f->get_buffer(r_data.ptrw(), r_data.size());
+	bool eof = f->get_position() == f->get_len();
+	f->close();
+	memdelete(f);
+	return read == r_data.size() && eof;
+}
+
+static bool _read_text(const String &p_path, String &r_text) {
+
+	Vector<uint8_t> data;
+	if (!_read_packed(p_path, data))
+		return false;
+	r_text.parse_utf8((const char *)data.ptr(), data.size());
+	return true;
+}
+
+static Error _pack_texts(const String &p_pack, const Map<String, String> &p_files) {
+
+	Ref<PCKPacker> packer;
+	packer.instance();
+	Error err = packer->pck_start(p_pack);
+	ERR_FAIL_COND_V(err != OK, err);
+	for (const Map<String, String>::Element *E = p_files.front(); E; E = E->next()) {
+		String src = TEST_DIR "/src_" + itos(created_files.size()) + ".txt";
+		ERR_FAIL_COND_V(!_write_file(src, _text(E->get())), ERR_CANT_CREATE);
+		err = packer->add_file(E->key(), src);
+		ERR_FAIL_COND_V(err != OK, err);
+	}
+	err = packer->flush();
+	created_files.push_back(p_pack);
+	return err;
+}
+
+// Version 1 packs can't be written anymore, they're still loaded with their table.
+static bool _pack_texts_flat(const String &p_pack, const Map<String, String> &p_files) {
+
+	FileAccess *f = FileAccess::open(p_pack, FileAccess::WRITE);
+	ERR_FAIL_COND_V(!f, false);
+	created_files.push_back(p_pack);
+
+	f->store_32(PACK_HEADER_MAGIC);
+	f->store_32(PACK_FORMAT_VERSION_FLAT);
+	f->store_32(VERSION_MAJOR);
+	f->store_32(VERSION_MINOR);
+	f->store_32(VERSION_PATCH);
+	for (int i = 0; i < 16; i++) {
+		f->store_32(0);
+	}
+
+	uint64_t ofs = f->get_position() + 4;
+	for (const Map<String, String>::Element *E = p_files.front(); E; E = E->next()) {
+		ofs += 4 + E->key().utf8().length() + 8 + 8 + 16;
+	}
+
+	f->store_32(p_files.size());
+	for (const Map<String, String>::Element *E = p_files.front(); E; E = E->next()) {
+		CharString path = E->key().utf8();
+		Vector<uint8_t> data = _text(E->get());
+		uint8_t md5[16];
+		CryptoCore::md5(data.ptr(), data.size(), md5);
+		f->store_32(path.length());
+		f->store_buffer((const uint8_t *)path.get_data(), path.length());
+		f->store_64(ofs);
+		f->store_64(data.size());
+		f->store_buffer(md5, 16);
+		ofs += data.size();
+	}
+	for (const Map<String, String>::Element *E = p_files.front(); E; E = E->next()) {
+		Vector<uint8_t> data = _text(E->get());
+		f->store_buffer(data.ptr(), data.size());
+	}
+
+	f->close();
+	memdelete(f);
+	return true;
+}
+
+bool test_write() {
+
+	OS::get_singleton()->print("\n\nTest 1: Write a pack\n");
+
+	DirAccess *da = DirAccess::create(DirAccess::ACCESS_USERDATA);
+	da->make_dir_recursive(TEST_DIR);
+	memdelete(da);
+
+	Ref<PCKPacker> packer;
+	packer.instance();
+	ERR_FAIL_COND_V(packer->pck_start(TEST_DIR "/main.pck", TEST_ALIGNMENT) != OK, false);
+	created_files.push_back(TEST_DIR "/main.pck");
+
+	RandomPCG rng(1234);
+	for (int i = 0; i < TEST_FILE_COUNT; i++) {
+		String src = TEST_DIR "/file_" + itos(i) + ".bin";
+		paths.push_back("res://test_pck/dir_" + itos(i % 4) + "/file_" + itos(i) + ".bin");
+		contents.push_back(_make_contents(i, rng));
+		ERR_FAIL_COND_V(!_write_file(src, contents[i]), false);
+		ERR_FAIL_COND_V(packer->add_file(paths[i], src) != OK, false);
+	}
+
+	return packer->flush() == OK;
+}
+
+bool test_index() {
+
+	OS::get_singleton()->print("\n\nTest 2: Index is sorted, offsets are aligned and point at the files\n");
+
+	FileAccess *f = FileAccess::open(TEST_DIR "/main.pck", FileAccess::READ);
+	ERR_FAIL_COND_V(!f, false);
+	Vector<uint8_t> pack;
+	pack.resize(f->get_len());
+	f->get_buffer(pack.ptrw(), pack.size());
+	f->close();
+	memdelete(f);
+
+	const uint8_t *p = pack.ptr();
+	ERR_FAIL_COND_V(decode_uint32(p) != PACK_HEADER_MAGIC || decode_uint32(p + 4) != PACK_FORMAT_VERSION, false);
+
+	const uint8_t *index = p + 21 * 4;
+	uint32_t count = decode_uint32(index);
+	uint32_t strings_size = decode_uint32(index + 4);
+	const uint8_t *entries = index + 8;
+	const uint8_t *strings = entries + count * PACK_INDEX_ENTRY_SIZE;
+	uint64_t data_start = strings - p + strings_size;
+	if (count != (uint32_t)paths.size()) {
+		OS::get_singleton()->print("\tExpected %i files, index has %i\n", paths.size(), count);
+		return false;
+	}
+
+	bool ok = true;
+	int compressed = 0;
+	uint64_t prev_end = data_start;
+	Vector<bool> seen;
+	seen.resize(paths.size());
+	for (int i = 0; i < seen.size(); i++) {
+		seen.write[i] = false;
+	}
+
+	for (uint32_t i = 0; i < count; i++) {
+
+		const uint8_t *e = entries + i * PACK_INDEX_ENTRY_SIZE;
+		uint64_t key[2] = { decode_uint64(e), decode_uint64(e + 8) };
+		uint64_t ofs = decode_uint64(e + 16);
+		uint64_t size = decode_uint64(e + 24);
+		uint64_t compressed_size = decode_uint64(e + 32);
+		const uint8_t *md5 = e + 40;
+		String path;
+		path.parse_utf8((const char *)strings + decode_uint32(e + 56), decode_uint32(e + 60));
+
+		int file = paths.find(path);
+		if (file < 0 || seen[file]) {
+			OS::get_singleton()->print("\tUnexpected path in index: %ls\n", path.c_str());
+			ok = false;
+			continue;
+		}
+		seen.write[file] = true;
+
+		uint64_t path_key[2];
+		PackedData::get_path_key(path, path_key);
+		if (key[0] != path_key[0] || key[1] != path_key[1]) {
+			OS::get_singleton()->print("\tKey doesn't match path: %ls\n", path.c_str());
+			ok = false;
+		}
+		if (i > 0) {
+			const uint8_t *prev = e - PACK_INDEX_ENTRY_SIZE;
+			uint64_t prev_key[2] = { decode_uint64(prev), decode_uint64(prev + 8) };
+			if (prev_key[0] > key[0] || (prev_key[0] == key[0] && prev_key[1] >= key[1])) {
+				OS::get_singleton()->print("\tIndex not sorted at entry %i\n", i);
+				ok = false;
+			}
+		}
+
+		// Files are laid out in index order, each aligned past the previous one.
+		uint64_t stored_size = compressed_size ? compressed_size : size;
+		if (ofs % TEST_ALIGNMENT != 0 || ofs < prev_end || ofs + stored_size > (uint64_t)pack.size()) {
+			OS::get_singleton()->print("\tBad offset %i for %ls\n", (int)ofs, path.c_str());
+			ok = false;
+			continue;
+		}
+		prev_end = ofs + stored_size;
+
+		Vector<uint8_t> data;
+		data.resize(size);
+		if (compressed_size) {
+			compressed++;
+			int ret = Compression::decompress(data.ptrw(), data.size(), p + ofs, compressed_size, Compression::MODE_ZSTD);
+			if (ret != (int)size) {
+				OS::get_singleton()->print("\tCan't decompress %ls\n", path.c_str());
+				ok = false;
+				continue;
+			}
+		} else if (size) {
+			copymem(data.ptrw(), p + ofs, size);
+		}
+
+		uint8_t data_md5[16];
+		CryptoCore::md5(data.ptr(), data.size(), data_md5);
+		if (!_equal(data, contents[file]) || memcmp(md5, data_md5, 16) != 0) {
+			OS::get_singleton()->print("\tContents or md5 don't match for %ls\n", path.c_str());
+			ok = false;
+		}
+	}
+
+	OS::get_singleton()->print("\t%i of %i files compressed\n", compressed, count);
+	// Random bytes must stay stored, text must get compressed.
+	return ok && compressed > 0 && compressed < (int)count;
+}
+
+bool test_lookup() {
+
+	OS::get_singleton()->print("\n\nTest 3: Files are found and read back through the index\n");
+
+	PackedData *pd = _get_packed_data();
+	ERR_FAIL_COND_V(pd->add_pack(TEST_DIR "/main.pck", false) != OK, false);
+
+	bool ok = true;
+	for (int i = 0; i < paths.size(); i++) {
+		Vector<uint8_t> data;
+		if (!pd->has_path(paths[i]) || !_read_packed(paths[i], data) || !_equal(data, contents[i])) {
+			OS::get_singleton()->print("\tCan't read back %ls\n", paths[i].c_str());
+			ok = false;
+		}
+	}
+
+	const char *missing[] = { "res://test_pck/missing.bin", "res://test_pck/dir_0/file_1.bin", "res://test_pck/dir_0", "", NULL };
+	for (int i = 0; missing[i]; i++) {
+		if (pd->has_path(missing[i]) || pd->try_open_path(missing[i])) {
+			OS::get_singleton()->print("\tFound missing file %s\n", missing[i]);
+			ok = false;
+		}
+	}
+
+	return ok;
+}
+
+bool test_layers() {
+
+	OS::get_singleton()->print("\n\nTest 4: Later packs only override files with replace_files\n");
+
+	PackedData *pd = _get_packed_data();
+	const String shared = "res://test_pck/layers/shared.txt";
+	const char *packs[] = { "a", "b", "c", "d" };
+	// Pack "c" is a version 1 pack, so layering goes across both lookups.
+	const bool replace[] = { false, false, true, false };
+	const char *expected[] = { "a", "a", "c", "c" };
+
+	bool ok = true;
+	for (int i = 0; i < 4; i++) {
+
+		Map<String, String> files;
+		files[shared] = packs[i];
+		files["res://test_pck/layers/only_" + String(packs[i]) + ".txt"] = packs[i];
+		String pack = TEST_DIR "/layer_" + String(packs[i]) + ".pck";
+		if (i == 2) {
+			ERR_FAIL_COND_V(!_pack_texts_flat(pack, files), false);
+		} else {
+			ERR_FAIL_COND_V(_pack_texts(pack, files) != OK, false);
+		}
+		ERR_FAIL_COND_V(pd->add_pack(pack, replace[i]) != OK, false);
+
+		String text;
+		if (!_read_text(shared, text) || text != expected[i]) {
+			OS::get_singleton()->print("\tAfter pack %s, shared file reads \"%ls\", expected \"%s\"\n", packs[i], text.c_str(), expected[i]);
+			ok = false;
+		}
+		for (int j = 0; j <= i; j++) {
+			if (!_read_text("res://test_pck/layers/only_" + String(packs[j]) + ".txt", text) || text != packs[j]) {
+				OS::get_singleton()->print("\tAfter pack %s, file only in pack %s is lost\n", packs[i], packs[j]);
+				ok = false;
+			}
+		}
+	}
+
+	// Files of the earlier packs are still there.
+	Vector<uint8_t> data;
+	if (!_read_packed(paths[0], data) || !_equal(data, contents[0])) {
+		OS::get_singleton()->print("\tFiles of the first pack are lost\n");
+		ok = false;
+	}
+
+	return ok;
+}
+
+bool test_duplicates() {
+
+	OS::get_singleton()->print("\n\nTest 5: A path added twice is stored once, with the last source\n");
+
+	const String path = "res://test_pck/duplicates/file.txt";
+	const String other = "res://test_pck/duplicates/other.txt";
+	const String pack = TEST_DIR "/duplicates.pck";
+
+	Ref<PCKPacker> packer;
+	packer.instance();
+	ERR_FAIL_COND_V(packer->pck_start(pack) != OK, false);
+	created_files.push_back(pack);
+	const char *texts[] = { "first", "other", "last" };
+	const String targets[] = { path, other, path };
+	for (int i = 0; i < 3; i++) {
+		String src = TEST_DIR "/duplicate_" + itos(i) + ".txt";
+		ERR_FAIL_COND_V(!_write_file(src, _text(texts[i])), false);
+		ERR_FAIL_COND_V(packer->add_file(targets[i], src) != OK, false);
+	}
+	ERR_FAIL_COND_V(packer->flush() != OK, false);
+
+	// Equal index keys make the whole pack fail to load.
+	if (_get_packed_data()->add_pack(pack, false) != OK) {
+		OS::get_singleton()->print("\tPack with a duplicated path doesn't load\n");
+		return false;
+	}
+
+	String text;
+	bool ok = true;
+	if (!_read_text(path, text) || text != "last") {
+		OS::get_singleton()->print("\tDuplicated path reads \"%ls\", expected \"last\"\n", text.c_str());
+		ok = false;
+	}
+	if (!_read_text(other, text) || text != "other") {
+		OS::get_singleton()->print("\tOther file reads \"%ls\", expected \"other\"\n", text.c_str());
+		ok = false;
+	}
+	return ok;
+}
+
+typedef bool (*TestFunc)(void);
+
+TestFunc test_funcs[] = {
+	test_write,
+	test_index,
+	test_lookup,
+	test_layers,
+	test_duplicates,
+	NULL
+};
+
+MainLoop *test() {
+
+	int count = 0;
+	int passed = 0;
+
+	while (true) {
+		if (!test_funcs[count])
+			break;
+		bool pass = test_funcs[count]();
+		if (pass)
+			passed++;
+		OS::get_singleton()->print("\t%s\n", pass ? "PASS" : "FAILED");
+
+		count++;
+	}
+	OS::get_singleton()->print("\n");
+	OS::get_singleton()->print("Passed %i of %i tests\n", passed, count);
+
+	DirAccess *da = DirAccess::create(DirAccess::ACCESS_USERDATA);
+	for (int i = 0; i < created_files.size(); i++) {
+		da->remove(created_files[i]);
+	}
+	da->remove(TEST_DIR);
+	memdelete(da);
+
+	return NULL;
+}
+
+} // namespace TestPCK
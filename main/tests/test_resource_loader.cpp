@@ -0,0 +1,291 @@
+/*************************************************************************/
+/*  test_resource_loader.cpp                                             */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2020 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2020 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "test_resource_loader.h"
+
+#include "core/image.h"
+#include "core/io/resource_loader.h"
+#include "core/io/resource_saver.h"
+#include "core/os/dir_access.h"
+#include "core/os/os.h"
+
+namespace TestResourceLoader {
+
+#define TEST_DIR "user://test_resource_loader"
+#define LEAF_COUNT 512
+#define MID_COUNT 16
+#define MID_LEAF_COUNT 40 // More than LEAF_COUNT / MID_COUNT, so leaves are shared.
+#define IMAGE_SIZE 64
+
+static String _leaf_path(int p_leaf) {
+
+	return TEST_DIR "/leaf_" + itos(p_leaf) + ".res";
+}
+
+static String _mid_path(int p_mid) {
+
+	return TEST_DIR "/mid_" + itos(p_mid) + ".res";
+}
+
+static int _mid_leaf(int p_mid, int p_index) {
+
+	return (p_mid * (LEAF_COUNT / MID_COUNT) + p_index) % LEAF_COUNT;
+}
+
+static Vector<uint8_t> _leaf_data(int p_leaf) {
+
+	Vector<uint8_t> data;
+	data.resize(IMAGE_SIZE * IMAGE_SIZE * 4);
+	for (int i = 0; i < data.size(); i++) {
+		data.write[i] = ((i / 4) % IMAGE_SIZE) ^ ((i / 4) / IMAGE_SIZE) ^ p_leaf ^ (i & 3);
+	}
+	return data;
+}
+
+bool test_save() {
+
+	OS::get_singleton()->print("\n\nTest 1: Save a dependency graph of %i resources\n", 1 + MID_COUNT + LEAF_COUNT);
+
+	DirAccess *da = DirAccess::create(DirAccess::ACCESS_USERDATA);
+	da->make_dir_recursive(TEST_DIR);
+	memdelete(da);
+
+	Vector<RES> leaves;
+	for (int i = 0; i < LEAF_COUNT; i++) {
+		Ref<Image> image;
+		image.instance();
+		image->create(IMAGE_SIZE, IMAGE_SIZE, false, Image::FORMAT_RGBA8, _leaf_data(i));
+		ERR_FAIL_COND_V(ResourceSaver::save(_leaf_path(i), image, ResourceSaver::FLAG_COMPRESS) != OK, false);
+		image->set_path(_leaf_path(i)); // Saved as an external resource by the ones using it.
+		leaves.push_back(image);
+	}
+
+	Array mids;
+	for (int i = 0; i < MID_COUNT; i++) {
+		Array mid_leaves;
+		for (int j = 0; j < MID_LEAF_COUNT; j++) {
+			mid_leaves.push_back(leaves[_mid_leaf(i, j)]);
+		}
+		Ref<Resource> mid;
+		mid.instance();
+		mid->set_meta("leaves", mid_leaves);
+		ERR_FAIL_COND_V(ResourceSaver::save(_mid_path(i), mid) != OK, false);
+		mid->set_path(_mid_path(i));
+		mids.push_back(mid);
+	}
+
+	Ref<Resource> root;
+	root.instance();
+	root->set_meta("mids", mids);
+	return ResourceSaver::save(TEST_DIR "/root.res", root) == OK;
+}
+
+static bool _check_graph(const RES &p_root) {
+
+	ERR_FAIL_COND_V(p_root.is_null(), false);
+	Array mids = p_root->get_meta("mids");
+	ERR_FAIL_COND_V(mids.size() != MID_COUNT, false);
+
+	Vector<Object *> leaves;
+	leaves.resize(LEAF_COUNT);
+	for (int i = 0; i < LEAF_COUNT; i++) {
+		leaves.write[i] = NULL;
+	}
+
+	for (int i = 0; i < MID_COUNT; i++) {
+
+		RES mid = mids[i];
+		ERR_FAIL_COND_V(mid.is_null() || mid->get_path() != _mid_path(i), false);
+		Array mid_leaves = mid->get_meta("leaves");
+		ERR_FAIL_COND_V(mid_leaves.size() != MID_LEAF_COUNT, false);
+
+		for (int j = 0; j < MID_LEAF_COUNT; j++) {
+
+			int leaf = _mid_leaf(i, j);
+			Ref<Image> image = mid_leaves[j];
+			ERR_FAIL_COND_V(image.is_null() || image->get_path() != _leaf_path(leaf), false);
+			// Leaves shared by several resources are loaded once.
+			if (leaves[leaf]) {
+				ERR_FAIL_COND_V(leaves[leaf] != image.ptr(), false);
+				continue;
+			}
+			leaves.write[leaf] = image.ptr();
+
+			Vector<uint8_t> data = image->get_data();
+			Vector<uint8_t> expected = _leaf_data(leaf);
+			ERR_FAIL_COND_V(data.size() != expected.size() || memcmp(data.ptr(), expected.ptr(), data.size()) != 0, false);
+		}
+	}
+
+	return true;
+}
+
+static RES _load_threaded(const String &p_path, bool p_use_sub_threads) {
+
+	ERR_FAIL_COND_V(ResourceLoader::load_threaded_request(p_path, "", p_use_sub_threads) != OK, RES());
+	RES res = ResourceLoader::load_threaded_get(p_path);
+	// The task is gone once its only request got the resource.
+	ERR_FAIL_COND_V(ResourceLoader::load_threaded_get_status(p_path) != ResourceLoader::THREAD_LOAD_INVALID_RESOURCE, RES());
+	return res;
+}
+
+bool test_load() {
+
+	OS::get_singleton()->print("\n\nTest 2: Load the graph on the calling thread\n");
+
+	return _check_graph(ResourceLoader::load(TEST_DIR "/root.res"));
+}
+
+bool test_load_threaded() {
+
+	OS::get_singleton()->print("\n\nTest 3: Load the graph on a thread\n");
+
+	return _check_graph(_load_threaded(TEST_DIR "/root.res", false));
+}
+
+bool test_load_sub_threads() {
+
+	OS::get_singleton()->print("\n\nTest 4: Load the graph with its dependencies on the pool\n");
+
+	bool ok = true;
+	for (int i = 0; i < 4; i++) {
+		ok = ok && _check_graph(_load_threaded(TEST_DIR "/root.res", true));
+	}
+	return ok;
+}
+
+bool test_load_sub_threads_cached() {
+
+	OS::get_singleton()->print("\n\nTest 5: Load the graph on the pool while part of it is in use\n");
+
+	// Already loaded dependencies aren't queued again.
+	Vector<RES> in_use;
+	for (int i = 0; i < LEAF_COUNT; i += 3) {
+		in_use.push_back(ResourceLoader::load(_leaf_path(i)));
+	}
+	in_use.push_back(ResourceLoader::load(_mid_path(1)));
+
+	RES root = _load_threaded(TEST_DIR "/root.res", true);
+	if (!_check_graph(root)) {
+		return false;
+	}
+	Array mids = root->get_meta("mids");
+	Array mid_leaves = RES(mids[0])->get_meta("leaves");
+	return RES(mids[1]) == in_use[in_use.size() - 1] && RES(mid_leaves[0]) == in_use[0];
+}
+
+bool test_cache_hits() {
+
+	OS::get_singleton()->print("\n\nTest 6: Requests joining a threaded load count as cache hits\n");
+
+	const String path = _leaf_path(1);
+	ResourceCache::RetainStats before = ResourceCache::get_retain_stats();
+	ERR_FAIL_COND_V(ResourceLoader::load_threaded_request(path) != OK, false);
+	ERR_FAIL_COND_V(ResourceLoader::load_threaded_request(path) != OK, false);
+	RES first = ResourceLoader::load_threaded_get(path);
+	RES second = ResourceLoader::load_threaded_get(path);
+	ERR_FAIL_COND_V(first.is_null() || first != second, false);
+	ResourceCache::RetainStats after = ResourceCache::get_retain_stats();
+
+	uint64_t hits = after.hits - before.hits;
+	uint64_t misses = after.misses - before.misses;
+	if (hits != 1 || misses != 1) {
+		OS::get_singleton()->print("\t%i hits and %i misses, expected one of each\n", int(hits), int(misses));
+		return false;
+	}
+	return true;
+}
+
+bool test_benchmark() {
+
+	OS::get_singleton()->print("\n\nTest 7: Load times, %i processors\n", OS::get_singleton()->get_processor_count());
+
+	const char *names[] = { "calling thread", "thread", "thread and pool" };
+	for (int mode = 0; mode < 3; mode++) {
+
+		uint64_t best = 0;
+		for (int i = 0; i < 5; i++) {
+			uint64_t t = OS::get_singleton()->get_ticks_usec();
+			RES root = mode == 0 ? ResourceLoader::load(TEST_DIR "/root.res") : _load_threaded(TEST_DIR "/root.res", mode == 2);
+			t = OS::get_singleton()->get_ticks_usec() - t;
+			ERR_FAIL_COND_V(root.is_null(), false);
+			best = i == 0 ? t : MIN(best, t);
+		}
+		OS::get_singleton()->print("\t%s: %.2f ms\n", names[mode], best / 1000.0);
+	}
+	return true;
+}
+
+typedef bool (*TestFunc)(void);
+
+TestFunc test_funcs[] = {
+	test_save,
+	test_load,
+	test_load_threaded,
+	test_load_sub_threads,
+	test_load_sub_threads_cached,
+	test_cache_hits,
+	test_benchmark,
+	NULL
+};
+
+MainLoop *test() {
+
+	int count = 0;
+	int passed = 0;
+
+	while (true) {
+		if (!test_funcs[count])
+			break;
+		bool pass = test_funcs[count]();
+		if (pass)
+			passed++;
+		OS::get_singleton()->print("\t%s\n", pass ? "PASS" : "FAILED");
+
+		count++;
+	}
+	OS::get_singleton()->print("\n");
+	OS::get_singleton()->print("Passed %i of %i tests\n", passed, count);
+
+	DirAccess *da = DirAccess::create(DirAccess::ACCESS_USERDATA);
+	for (int i = 0; i < LEAF_COUNT; i++) {
+		da->remove(_leaf_path(i));
+	}
+	for (int i = 0; i < MID_COUNT; i++) {
+		da->remove(_mid_path(i));
+	}
+	da->remove(TEST_DIR "/root.res");
+	da->remove(TEST_DIR);
+	memdelete(da);
+
+	return NULL;
+}
+
+} // namespace TestResourceLoader
@@ -0,0 +1,474 @@
+/*************************************************************************/
+/*  test_scene_pool.cpp                                                  */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2020 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2020 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "test_scene_pool.h"
+
+#include "core/class_db.h"
+#include "core/os/os.h"
+#include "core/script_language.h"
+#include "scene/main/timer.h"
+#include "scene/resources/packed_scene.h"
+
+namespace TestScenePool {
+
+static Ref<PackedScene> scene;
+static Ref<PackedScene> projectile; // Scripted, when GDScript is there.
+
+static int error_count = 0;
+
+static void _count_errors(void *p_self, const char *p_func, const char *p_file, int p_line, const char *p_error, const char *p_message, ErrorHandlerType p_type) {
+
+	error_count++;
+}
+
+// Everything about an instance that a pooled one could differ in from a fresh one, one line per item.
+static void _describe_node(Node *p_root, Node *p_node, Vector<String> &r_lines) {
+
+	String path = p_root->get_path_to(p_node);
+	String prefix = path + " (" + p_node->get_class() + ")";
+	r_lines.push_back(prefix + " name: " + (p_node == p_root ? String(p_node->get_name()) : path));
+
+	List<PropertyInfo> plist;
+	p_node->get_property_list(&plist);
+	for (List<PropertyInfo>::Element *E = plist.front(); E; E = E->next()) {
+		if (E->get().usage & PROPERTY_USAGE_STORAGE) {
+			r_lines.push_back(prefix + " property " + E->get().name + ": " + p_node->get(E->get().name).get_construct_string());
+		}
+	}
+
+	List<Node::GroupInfo> groups;
+	p_node->get_groups(&groups);
+	for (List<Node::GroupInfo>::Element *E = groups.front(); E; E = E->next()) {
+		r_lines.push_back(prefix + " group: " + E->get().name + (E->get().persistent ? " (persistent)" : ""));
+	}
+
+	List<String> meta;
+	p_node->get_meta_list(&meta);
+	for (List<String>::Element *E = meta.front(); E; E = E->next()) {
+		r_lines.push_back(prefix + " meta " + E->get() + ": " + p_node->get_meta(E->get()).get_construct_string());
+	}
+
+	r_lines.push_back(prefix + " processing: " + itos(p_node->is_processing()) + itos(p_node->is_physics_processing()) + itos(p_node->is_processing_internal()) + itos(p_node->is_physics_processing_internal()) + itos(p_node->is_processing_input()) + itos(p_node->is_processing_unhandled_input()) + itos(p_node->is_processing_unhandled_key_input()));
+
+	List<Object::Connection> connections;
+	p_node->get_all_signal_connections(&connections);
+	for (List<Object::Connection>::Element *E = connections.front(); E; E = E->next()) {
+		Node *target = Object::cast_to<Node>(E->get().callable.get_object());
+		String to = target && (target == p_root || p_root->is_a_parent_of(target)) ? String(p_root->get_path_to(target)) : "outside";
+		r_lines.push_back(prefix + " connection: " + E->get().signal.get_name() + " -> " + to + "::" + E->get().callable.get_method() + " flags " + itos(E->get().flags));
+	}
+
+	connections.clear();
+	p_node->get_signals_connected_to_this(&connections);
+	for (List<Object::Connection>::Element *E = connections.front(); E; E = E->next()) {
+		Node *source = Object::cast_to<Node>(E->get().signal.get_object());
+		if (!source || (source != p_root && !p_root->is_a_parent_of(source))) {
+			r_lines.push_back(prefix + " connected from outside: " + E->get().signal.get_name());
+		}
+	}
+
+	for (int i = 0; i < p_node->get_child_count(); i++) {
+		_describe_node(p_root, p_node->get_child(i), r_lines);
+	}
+}
+
+// Compares with a fresh instance, printing what differs if asked to.
+static bool _is_like_fresh(const Ref<PackedScene> &p_scene, Node *p_instance, bool p_report = true) {
+
+	Node *fresh = p_scene->instance();
+	ERR_FAIL_COND_V(!fresh, false);
+
+	Vector<String> expected;
+	Vector<String> got;
+	_describe_node(fresh, fresh, expected);
+	_describe_node(p_instance, p_instance, got);
+	memdelete(fresh);
+
+	bool same = true;
+	for (int i = 0; i < expected.size(); i++) {
+		if (got.find(expected[i]) == -1) {
+			if (p_report) {
+				OS::get_singleton()->print("\tMissing: %s\n", expected[i].utf8().get_data());
+			}
+			same = false;
+		}
+	}
+	for (int i = 0; i < got.size(); i++) {
+		if (expected.find(got[i]) == -1) {
+			if (p_report) {
+				OS::get_singleton()->print("\tUnexpected: %s\n", got[i].utf8().get_data());
+			}
+			same = false;
+		}
+	}
+	return same;
+}
+
+bool test_pack() {
+
+	OS::get_singleton()->print("\n\nTest 1: Pack a scene\n");
+
+	Node *root = memnew(Node);
+	root->set_name("Enemy");
+	root->add_to_group("enemies", true);
+
+	Timer *timer = memnew(Timer);
+	timer->set_name("Timer");
+	timer->set_wait_time(2.0);
+	timer->set_one_shot(true);
+	root->add_child(timer);
+	timer->set_owner(root);
+
+	Node *body = memnew(Node);
+	body->set_name("Body");
+	body->set_process_priority(4);
+	root->add_child(body);
+	body->set_owner(root);
+
+	Node *leaf = memnew(Node);
+	leaf->set_name("Leaf");
+	leaf->add_to_group("leaves", true);
+	body->add_child(leaf);
+	leaf->set_owner(root);
+
+	timer->connect("timeout", Callable(leaf, "queue_free"), Vector<Variant>(), Object::CONNECT_PERSIST);
+	body->connect("renamed", Callable(timer, "start"), varray(1.0), Object::CONNECT_PERSIST | Object::CONNECT_DEFERRED);
+
+	scene.instance();
+	scene->set_path("res://test_scene_pool.tscn");
+	Error err = scene->pack(root);
+	memdelete(root);
+	ERR_FAIL_COND_V(err != OK, false);
+
+	Node *instance = scene->instance();
+	ERR_FAIL_COND_V(!instance, false);
+	ERR_FAIL_COND_V(instance->get_child_count() != 2 || !instance->has_node(NodePath("Body/Leaf")), false);
+	ERR_FAIL_COND_V(!instance->get_node(NodePath("Timer"))->is_connected("timeout", Callable(instance->get_node(NodePath("Body/Leaf")), "queue_free")), false);
+	memdelete(instance);
+	return true;
+}
+
+// Changes everything the pool has to undo.
+static void _change(Node *p_instance, Node *p_outside) {
+
+	Timer *timer = Object::cast_to<Timer>(p_instance->get_node(NodePath("Timer")));
+	Node *body = p_instance->get_node(NodePath("Body"));
+	Node *leaf = p_instance->get_node(NodePath("Body/Leaf"));
+
+	p_instance->set_name("Renamed");
+	p_instance->set_pause_mode(Node::PAUSE_MODE_PROCESS);
+	timer->set_wait_time(5.0);
+	timer->set_one_shot(false);
+	timer->set_autostart(true);
+	body->set_process_priority(-2);
+
+	p_instance->set_meta("hits", 3);
+	leaf->set_meta("path", Array());
+
+	p_instance->add_to_group("runtime");
+	p_instance->remove_from_group("enemies");
+	leaf->remove_from_group("leaves");
+	leaf->add_to_group("leaves");
+
+	timer->disconnect("timeout", Callable(leaf, "queue_free"));
+	timer->connect("timeout", Callable(body, "queue_free"));
+	p_outside->connect("renamed", Callable(p_instance, "queue_free"));
+	leaf->connect("renamed", Callable(p_outside, "queue_free"));
+
+	p_instance->set_process(true);
+	p_instance->set_physics_process(true);
+	timer->set_process_internal(true);
+	body->set_physics_process_internal(true);
+	leaf->set_process_input(true);
+	leaf->set_process_unhandled_input(true);
+	leaf->set_process_unhandled_key_input(true);
+}
+
+bool test_reset() {
+
+	OS::get_singleton()->print("\n\nTest 2: A recycled instance is like a fresh one\n");
+
+	Node *outside = memnew(Node);
+
+	Node *instance = scene->instance_pooled();
+	ERR_FAIL_COND_V(!instance, false);
+	ObjectID id = instance->get_instance_id();
+	_change(instance, outside);
+	ERR_FAIL_COND_V(_is_like_fresh(scene, instance, false), false); // Or the changes aren't seen.
+
+	scene->recycle(instance);
+	ERR_FAIL_COND_V(scene->get_pool_count() != 1, false);
+
+	instance = scene->instance_pooled();
+	ERR_FAIL_COND_V(instance->get_instance_id() != id, false);
+	bool ok = _is_like_fresh(scene, instance);
+
+	List<Object::Connection> connections;
+	outside->get_all_signal_connections(&connections);
+	outside->get_signals_connected_to_this(&connections);
+	if (connections.size()) {
+		OS::get_singleton()->print("\tThe node outside is still connected\n");
+		ok = false;
+	}
+
+	memdelete(instance);
+	memdelete(outside);
+	scene->clear_pool();
+	return ok;
+}
+
+bool test_cycles() {
+
+	OS::get_singleton()->print("\n\nTest 3: Connecting again after each recycle raises no errors\n");
+
+	Node *outside = memnew(Node);
+	ErrorHandlerList handler;
+	handler.errfunc = _count_errors;
+	handler.userdata = NULL;
+	error_count = 0;
+	add_error_handler(&handler);
+
+	Node *instance = NULL;
+	for (int i = 0; i < 100; i++) {
+		instance = scene->instance_pooled();
+		_change(instance, outside);
+		scene->recycle(instance);
+	}
+	instance = scene->instance_pooled();
+
+	remove_error_handler(&handler);
+
+	bool ok = error_count == 0 && scene->get_pool_count() == 0 && _is_like_fresh(scene, instance);
+	memdelete(instance);
+	memdelete(outside);
+	scene->clear_pool();
+	return ok;
+}
+
+static Ref<Script> _make_gdscript(const String &p_code) {
+
+	Ref<Script> script;
+	for (int i = 0; i < ScriptServer::get_language_count() && script.is_null(); i++) {
+		if (ScriptServer::get_language(i)->get_name() == "GDScript") {
+			script = Ref<Script>(Object::cast_to<Script>(ClassDB::instance(ScriptServer::get_language(i)->get_type())));
+		}
+	}
+	if (script.is_valid()) {
+		script->set_source_code(p_code);
+		ERR_FAIL_COND_V(script->reload() != OK, Ref<Script>());
+	}
+	return script;
+}
+
+bool test_not_pooled() {
+
+	OS::get_singleton()->print("\n\nTest 4: Changed structure and scripts aren't pooled\n");
+
+	Node *instance = scene->instance_pooled();
+	instance->get_node(NodePath("Body"))->add_child(memnew(Node));
+	scene->recycle(instance);
+	ERR_FAIL_COND_V(scene->get_pool_count() != 0, false);
+	scene->clear_pool();
+
+	instance = scene->instance_pooled();
+	instance->get_node(NodePath("Body/Leaf"))->set_name("Other");
+	scene->recycle(instance);
+	ERR_FAIL_COND_V(scene->get_pool_count() != 0, false);
+	scene->clear_pool();
+
+	Ref<Script> script = _make_gdscript("extends Node\nvar hits = 0\n");
+	if (script.is_null()) {
+		OS::get_singleton()->print("\tNo GDScript, skipping scripts\n");
+		return true;
+	}
+
+	instance = scene->instance_pooled();
+	instance->get_node(NodePath("Body"))->set_script(script);
+	ERR_FAIL_COND_V(!instance->get_node(NodePath("Body"))->get_script_instance(), false);
+	scene->recycle(instance);
+	ERR_FAIL_COND_V(scene->get_pool_count() != 0, false);
+	scene->clear_pool();
+
+	return true;
+}
+
+// Members set up by the initializer and _init(), and an exported one stored in the scene.
+static const char *_projectile_script =
+		"extends Node\n"
+		"\n"
+		"export var speed = 10\n"
+		"var hits = 0\n"
+		"var trail = []\n"
+		"\n"
+		"func _init():\n"
+		"\ttrail.append(\"init\")\n"
+		"\n"
+		"func hit():\n"
+		"\thits += 1\n"
+		"\ttrail.append(hits)\n"
+		"\n"
+		"func wait():\n"
+		"\tyield($Timer, \"timeout\")\n"
+		"\thits = -1\n";
+
+bool test_scripted() {
+
+	OS::get_singleton()->print("\n\nTest 5: Scripted nodes are reset by their script\n");
+
+	Ref<Script> script = _make_gdscript(_projectile_script);
+	if (script.is_null()) {
+		OS::get_singleton()->print("\tNo GDScript, skipping\n");
+		return true;
+	}
+
+	Node *root = memnew(Node);
+	root->set_name("Projectile");
+	root->set_script(script);
+	root->set("speed", 25);
+	Timer *timer = memnew(Timer);
+	timer->set_name("Timer");
+	root->add_child(timer);
+	timer->set_owner(root);
+
+	projectile.instance();
+	projectile->set_path("res://test_scene_pool_projectile.tscn");
+	Error err = projectile->pack(root);
+	memdelete(root);
+	ERR_FAIL_COND_V(err != OK, false);
+
+	Node *instance = projectile->instance_pooled();
+	ERR_FAIL_COND_V(!instance || !instance->get_script_instance(), false);
+	ObjectID id = instance->get_instance_id();
+	instance->call("hit");
+	instance->call("hit");
+	instance->set("speed", 40);
+	ERR_FAIL_COND_V(int(instance->get("hits")) != 2, false);
+
+	projectile->recycle(instance);
+	ERR_FAIL_COND_V(projectile->get_pool_count() != 1, false);
+	instance = projectile->instance_pooled();
+	ERR_FAIL_COND_V(instance->get_instance_id() != id, false);
+
+	// Members that aren't stored in the scene too.
+	bool ok = _is_like_fresh(projectile, instance);
+	Node *fresh = projectile->instance();
+	const char *members[] = { "speed", "hits", "trail", NULL };
+	for (int i = 0; members[i]; i++) {
+		Variant value = instance->get(members[i]);
+		Variant expected = fresh->get(members[i]);
+		if (value != expected) {
+			OS::get_singleton()->print("\tMember %s is %s, %s in a new instance\n", members[i], value.get_construct_string().utf8().get_data(), expected.get_construct_string().utf8().get_data());
+			ok = false;
+		}
+	}
+	memdelete(fresh);
+
+	// Resuming would run on the reset instance.
+	instance->call("wait");
+	projectile->recycle(instance);
+	if (projectile->get_pool_count() != 0) {
+		OS::get_singleton()->print("\tInstance waiting in a yield was pooled\n");
+		ok = false;
+	}
+	projectile->clear_pool();
+
+	return ok;
+}
+
+static bool _benchmark(Ref<PackedScene> p_scene, const char *p_name) {
+
+	const int count = 10000;
+
+	uint64_t t = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < count; i++) {
+		memdelete(p_scene->instance());
+	}
+	uint64_t fresh_usec = OS::get_singleton()->get_ticks_usec() - t;
+
+	p_scene->prewarm_pool(1);
+	t = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < count; i++) {
+		p_scene->recycle(p_scene->instance_pooled());
+	}
+	uint64_t pooled_usec = OS::get_singleton()->get_ticks_usec() - t;
+	bool ok = p_scene->get_pool_count() == 1;
+	p_scene->clear_pool();
+
+	OS::get_singleton()->print("\t%i %s instances, new: %.1f ms, pooled: %.1f ms\n", count, p_name, fresh_usec / 1000.0, pooled_usec / 1000.0);
+	return ok;
+}
+
+bool test_benchmark() {
+
+	OS::get_singleton()->print("\n\nTest 6: Pooled instances against new ones\n");
+
+	bool ok = _benchmark(scene, "plain");
+	if (projectile.is_valid()) {
+		ok = _benchmark(projectile, "scripted") && ok;
+	}
+	return ok;
+}
+
+typedef bool (*TestFunc)(void);
+
+TestFunc test_funcs[] = {
+	test_pack,
+	test_reset,
+	test_cycles,
+	test_not_pooled,
+	test_scripted,
+	test_benchmark,
+	NULL
+};
+
+MainLoop *test() {
+
+	int count = 0;
+	int passed = 0;
+
+	while (true) {
+		if (!test_funcs[count])
+			break;
+		bool pass = test_funcs[count]();
+		if (pass)
+			passed++;
+		OS::get_singleton()->print("\t%s\n", pass ? "PASS" : "FAILED");
+
+		count++;
+	}
+	OS::get_singleton()->print("\n");
+	OS::get_singleton()->print("Passed %i of %i tests\n", passed, count);
+
+	projectile.unref();
+	scene.unref();
+	return NULL;
+}
+
+} // namespace TestScenePool
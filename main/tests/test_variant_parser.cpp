@@ -0,0 +1,481 @@
+/*************************************************************************/
+/*  test_variant_parser.cpp                                              */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2020 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2020 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "test_variant_parser.h"
+
+#include "core/math/random_pcg.h"
+#include "core/os/dir_access.h"
+#include "core/os/file_access.h"
+#include "core/os/os.h"
+#include "core/variant_parser.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace TestVariantParser {
+
+#define TEST_FILE "user://test_variant_parser.txt"
+static const int READAHEAD_SIZE = 2048; // Size of the readahead buffer of VariantParser::Stream.
+
+static bool _write_file(const String &p_text) {
+
+	FileAccess *f = FileAccess::open(TEST_FILE, FileAccess::WRITE);
+	ERR_FAIL_COND_V(!f, false);
+	CharString utf8 = p_text.utf8();
+	f->store_buffer((const uint8_t *)utf8.get_data(), utf8.length());
+	f->close();
+	memdelete(f);
+	return true;
+}
+
+static bool _parse_string(const String &p_text, Variant &r_value) {
+
+	VariantParser::StreamString ss;
+	ss.s = p_text;
+	String error;
+	int line = 0;
+	return VariantParser::parse(&ss, r_value, error, line) == OK;
+}
+
+static bool _parse_file(const String &p_text, Variant &r_value) {
+
+	ERR_FAIL_COND_V(!_write_file(p_text), false);
+	VariantParser::StreamFile sf;
+	sf.f = FileAccess::open(TEST_FILE, FileAccess::READ);
+	ERR_FAIL_COND_V(!sf.f, false);
+	String error;
+	int line = 0;
+	Error err = VariantParser::parse(&sf, r_value, error, line);
+	sf.f->close();
+	memdelete(sf.f);
+	return err == OK;
+}
+
+static bool _same_bits(double p_a, double p_b) {
+
+	return memcmp(&p_a, &p_b, sizeof(double)) == 0;
+}
+
+// Numbers are built while tokenizing when that is exact, else with String::to_double(), so both must agree.
+static bool _check_float(const String &p_text) {
+
+	Variant value;
+	if (!_parse_string(p_text, value) || value.get_type() != Variant::FLOAT) {
+		OS::get_singleton()->print("\tCan't parse %s as a float\n", p_text.utf8().get_data());
+		return false;
+	}
+	double expected = p_text.to_double();
+	if (!_same_bits(value, expected)) {
+		OS::get_singleton()->print("\t%s parsed as %.17g, expected %.17g\n", p_text.utf8().get_data(), double(value), expected);
+		return false;
+	}
+	return true;
+}
+
+static bool _check_int(const String &p_text) {
+
+	Variant value;
+	if (!_parse_string(p_text, value) || value.get_type() != Variant::INT) {
+		OS::get_singleton()->print("\tCan't parse %s as an int\n", p_text.utf8().get_data());
+		return false;
+	}
+	if (int64_t(value) != p_text.to_int64()) {
+		OS::get_singleton()->print("\t%s parsed as %lli\n", p_text.utf8().get_data(), (long long)int64_t(value));
+		return false;
+	}
+	return true;
+}
+
+bool test_floats() {
+
+	OS::get_singleton()->print("\n\nTest 1: Float literals\n");
+
+	const char *floats[] = {
+		"0.0", "-0.0", "1.0", "-1.0", "0.1", "-0.1", "0.5", "3.25", "-273.15",
+		"1e0", "1e5", "1e-5", "1.0e+5", "1.0e-5", "-2.5e3", "7e22", "1e22", "1e23", "-1e-22", "1e-23",
+		"4.35e-7", "123.456e-2", "0.000001", "100000000000000000000.0",
+		"9007199254740992.0", "9007199254740993.0", "-9007199254740993.0", "18014398509481985.0",
+		"0.30000000000000004", "1234567890123456789.0", "12345678901234567890123.0",
+		"3.14159265358979323846264338327950288419716939937510",
+		"-2.71828182845904523536028747135266249775724709369995",
+		"0.1000000000000000055511151231257827021181583404541015625",
+		"1.7976931348623157e308", "2.2250738585072014e-308", "4.9e-324", "1e-400", "1e400", "-1e400",
+		NULL
+	};
+
+	bool ok = true;
+	for (int i = 0; floats[i]; i++) {
+		ok = _check_float(floats[i]) && ok;
+	}
+	return ok;
+}
+
+bool test_float_round_trip() {
+
+	OS::get_singleton()->print("\n\nTest 2: Floats written with up to 15 digits parse back exactly\n");
+
+	// Up to 15 significant digits and small exponents are converted while tokenizing, and must be correctly rounded.
+	// Longer literals go through String::to_double(), which test_floats() checks the parser agrees with.
+	RandomPCG rng(42);
+	bool ok = true;
+	for (int i = 0; i < 20000 && ok; i++) {
+
+		double value;
+		switch (i % 4) {
+			case 0: {
+				value = rng.random(-1000.0, 1000.0); // Typical coordinates.
+			} break;
+			case 1: {
+				value = rng.random(0.0, 1.0);
+			} break;
+			case 2: {
+				value = Math::pow(10.0, rng.random(-6.0, 6.0)) * ((rng.rand() & 1) ? -1 : 1);
+			} break;
+			default: {
+				value = double(int64_t(rng.rand()) - 0x80000000) / 1024.0; // Exact binary fractions.
+			} break;
+		}
+
+		char buf[64];
+		snprintf(buf, 64, (i & 1) ? "%.15g" : "%.6f", value);
+		String text = buf;
+		if (text.find(".") == -1 && text.find("e") == -1) {
+			text += ".0";
+		}
+
+		Variant parsed;
+		if (!_parse_string(text, parsed) || !_same_bits(parsed, strtod(buf, NULL))) {
+			OS::get_singleton()->print("\t%s doesn't parse back to %.17g\n", buf, strtod(buf, NULL));
+			ok = false;
+		}
+	}
+	return ok;
+}
+
+bool test_ints() {
+
+	OS::get_singleton()->print("\n\nTest 3: Integer literals\n");
+
+	const char *ints[] = {
+		"0", "-0", "7", "-7", "007", "2147483647", "-2147483648", "4294967296",
+		"123456789012345678", "-123456789012345678", "999999999999999999",
+		"1234567890123456789", "-1234567890123456789",
+		"9223372036854775807", "-9223372036854775807",
+		NULL
+	};
+
+	bool ok = true;
+	for (int i = 0; ints[i]; i++) {
+		ok = _check_int(ints[i]) && ok;
+	}
+	return ok;
+}
+
+bool test_inf_nan() {
+
+	OS::get_singleton()->print("\n\nTest 4: Infinities and NaN are written and parsed back\n");
+
+	Array values;
+	values.push_back(Math_INF);
+	values.push_back(-Math_INF);
+	values.push_back(Math_NAN);
+	values.push_back(Vector3(Math_INF, -Math_INF, 1.5));
+	Vector<float> floats;
+	floats.push_back(-Math_INF);
+	floats.push_back(Math_NAN);
+	floats.push_back(0.25);
+	values.push_back(floats);
+
+	String text;
+	ERR_FAIL_COND_V(VariantWriter::write_to_string(values, text) != OK, false);
+	Variant parsed;
+	if (!_parse_string(text, parsed) || parsed.get_type() != Variant::ARRAY) {
+		OS::get_singleton()->print("\tCan't parse %s\n", text.utf8().get_data());
+		return false;
+	}
+
+	Array result = parsed;
+	ERR_FAIL_COND_V(result.size() != values.size(), false);
+	ERR_FAIL_COND_V(result[0].get_type() != Variant::FLOAT || double(result[0]) != Math_INF, false);
+	ERR_FAIL_COND_V(result[1].get_type() != Variant::FLOAT || double(result[1]) != -Math_INF, false);
+	ERR_FAIL_COND_V(result[2].get_type() != Variant::FLOAT || !Math::is_nan(double(result[2])), false);
+	ERR_FAIL_COND_V(Vector3(result[3]) != Vector3(Math_INF, -Math_INF, 1.5), false);
+	Vector<float> parsed_floats = result[4];
+	ERR_FAIL_COND_V(parsed_floats.size() != 3 || parsed_floats[0] != -Math_INF || !Math::is_nan(parsed_floats[1]) || parsed_floats[2] != 0.25, false);
+
+	return true;
+}
+
+static bool _check_tokens_at_end(const String &p_text, const Variant &p_expected) {
+
+	Variant from_string;
+	Variant from_file;
+	bool ok = _parse_string(p_text, from_string) && _parse_file(p_text, from_file);
+	ok = ok && from_string == p_expected && from_file == p_expected && from_string.get_type() == p_expected.get_type();
+	if (!ok) {
+		OS::get_singleton()->print("\tWrong value parsed from \"%s\"\n", p_text.utf8().get_data());
+	}
+	return ok;
+}
+
+bool test_eof() {
+
+	OS::get_singleton()->print("\n\nTest 5: Tokens ending the stream\n");
+
+	bool ok = true;
+	ok = _check_tokens_at_end("123", 123) && ok;
+	ok = _check_tokens_at_end("-1.5", -1.5) && ok;
+	ok = _check_tokens_at_end("1e3", 1000.0) && ok;
+	ok = _check_tokens_at_end("\"abc\"", "abc") && ok;
+	ok = _check_tokens_at_end(String::utf8("\"h\xc3\xa9llo\""), String::utf8("h\xc3\xa9llo")) && ok;
+	ok = _check_tokens_at_end("true", true) && ok;
+	ok = _check_tokens_at_end("  7  ", 7) && ok;
+
+	// The token after the last one is EOF, every time it's asked for.
+	VariantParser::StreamString ss;
+	ss.s = "42";
+	VariantParser::Token token;
+	String error;
+	int line = 0;
+	ERR_FAIL_COND_V(VariantParser::get_token(&ss, token, line, error) != OK || token.type != VariantParser::TK_NUMBER || int(token.value) != 42, false);
+	for (int i = 0; i < 3; i++) {
+		ERR_FAIL_COND_V(VariantParser::get_token(&ss, token, line, error) != OK || token.type != VariantParser::TK_EOF, false);
+	}
+
+	// Unterminated tokens are errors.
+	Variant value;
+	ok = !_parse_string("\"abc", value) && !_parse_file("\"abc", value) && ok;
+	ok = !_parse_string("[1, 2", value) && !_parse_file("[1, 2", value) && ok;
+	return ok;
+}
+
+bool test_buffer_boundaries() {
+
+	OS::get_singleton()->print("\n\nTest 6: Tokens across the readahead buffer\n");
+
+	Array expected;
+	expected.push_back(1.25);
+	expected.push_back(String::utf8("h\xc3\xa9llo \xe2\x82\xac"));
+	expected.push_back(12345678);
+	expected.push_back(Vector2(3.5, -4));
+	expected.push_back(-0.0078125);
+	String tail = String::utf8("[1.25, \"h\xc3\xa9llo \xe2\x82\xac\", 12345678, Vector2( 3.5, -4 ), -7.8125e-3]");
+
+	bool ok = true;
+	// Every token boundary, including inside the multibyte characters of the file, lands on the end of the buffer once.
+	for (int pad = READAHEAD_SIZE - tail.utf8().length() - 2; pad <= READAHEAD_SIZE + 2; pad++) {
+
+		String text;
+		for (int i = 0; i < pad; i++) {
+			text += i % 64 == 63 ? "\n" : " ";
+		}
+		text += tail;
+
+		Variant from_string;
+		Variant from_file;
+		if (!_parse_string(text, from_string) || !_parse_file(text, from_file) || from_string != Variant(expected) || from_file != Variant(expected)) {
+			OS::get_singleton()->print("\tWrong value with %i characters before\n", pad);
+			ok = false;
+		}
+	}
+
+	// Tokens longer than the buffer.
+	String long_string;
+	for (int i = 0; i < READAHEAD_SIZE * 3; i++) {
+		long_string += CharType('a' + i % 26);
+	}
+	String long_number = "0.";
+	for (int i = 0; i < READAHEAD_SIZE + 10; i++) {
+		long_number += CharType('0' + (i * 7) % 10);
+	}
+	ok = _check_tokens_at_end("\"" + long_string + "\"", long_string) && ok;
+	ok = _check_tokens_at_end(long_number, long_number.to_double()) && ok;
+	return ok;
+}
+
+bool test_stream_file_position() {
+
+	OS::get_singleton()->print("\n\nTest 7: Without readahead, the file stays right after each tag\n");
+
+	// As ResourceLoaderText::rename_dependencies() reads it, copying the text after the tags it changes.
+	String text = "[gd_resource type=\"Resource\" load_steps=3 format=2]\n\n";
+	text += "[ext_resource path=\"res://a.png\" type=\"Texture\" id=1]\n";
+	text += "[ext_resource path=\"res://b.tres\" type=\"Resource\" id=2]\n\n";
+	text += "[resource]\nvalue = ExtResource( 1 )\n";
+	for (int i = 0; i < READAHEAD_SIZE / 32; i++) {
+		text += "padding_" + itos(i) + " = " + itos(i) + "\n";
+	}
+	ERR_FAIL_COND_V(!_write_file(text), false);
+
+	VariantParser::StreamFile stream(false);
+	stream.f = FileAccess::open(TEST_FILE, FileAccess::READ);
+	ERR_FAIL_COND_V(!stream.f, false);
+
+	const char *tags[] = { "gd_resource", "ext_resource", "ext_resource", "resource", NULL };
+	bool ok = true;
+	int tag_end = 0;
+	for (int i = 0; tags[i]; i++) {
+
+		VariantParser::Tag tag;
+		String error;
+		int line = 0;
+		if (VariantParser::parse_tag(&stream, line, error, tag) != OK || tag.name != tags[i]) {
+			OS::get_singleton()->print("\tCan't parse tag %s\n", tags[i]);
+			ok = false;
+			break;
+		}
+		tag_end = text.find("]", tag_end) + 1;
+		if (stream.f->get_position() != (size_t)tag_end) {
+			OS::get_singleton()->print("\tFile at %i after tag %s, expected %i\n", (int)stream.f->get_position(), tags[i], tag_end);
+			ok = false;
+		}
+	}
+
+	stream.f->close();
+	memdelete(stream.f);
+	return ok;
+}
+
+static String _make_benchmark_text() {
+
+	// Like a large .tres: sub resources with long vector and int arrays and small dictionaries.
+	RandomPCG rng(7);
+	String text = "[gd_resource type=\"Resource\" load_steps=41 format=2]\n\n";
+	for (int i = 0; i < 40; i++) {
+
+		text += "[sub_resource type=\"ArrayMesh\" id=" + itos(i + 1) + "]\n";
+		text += "vertices = PackedVector3Array( ";
+		for (int j = 0; j < 6000; j++) {
+			text += String(j ? ", " : "") + rtos(rng.random(-100.0, 100.0)) + ", " + rtos(rng.random(-100.0, 100.0)) + ", " + rtos(rng.random(-100.0, 100.0));
+		}
+		text += " )\nindices = PackedInt32Array( ";
+		for (int j = 0; j < 6000; j++) {
+			text += String(j ? ", " : "") + itos(rng.rand() % 6000);
+		}
+		text += " )\nmetadata = { \"name\": \"mesh_" + itos(i) + "\", \"lod\": " + itos(i % 4) + ", \"scale\": 1.5 }\n\n";
+	}
+	return text;
+}
+
+static bool _parse_benchmark(VariantParser::Stream *p_stream, int &r_values) {
+
+	VariantParser::Tag tag;
+	String error;
+	int line = 0;
+	r_values = 0;
+	while (true) {
+		String assign;
+		Variant value;
+		Error err = VariantParser::parse_tag_assign_eof(p_stream, line, error, tag, assign, value);
+		if (err == ERR_FILE_EOF) {
+			return true;
+		}
+		ERR_FAIL_COND_V_MSG(err != OK, false, error);
+		if (assign != String()) {
+			r_values++;
+		}
+	}
+}
+
+bool test_benchmark() {
+
+	OS::get_singleton()->print("\n\nTest 8: Parse a large text resource\n");
+
+	String text = _make_benchmark_text();
+	ERR_FAIL_COND_V(!_write_file(text), false);
+
+	uint64_t best_string = 0;
+	uint64_t best_file = 0;
+	for (int i = 0; i < 3; i++) {
+
+		int values = 0;
+		VariantParser::StreamString ss;
+		ss.s = text;
+		uint64_t t = OS::get_singleton()->get_ticks_usec();
+		ERR_FAIL_COND_V(!_parse_benchmark(&ss, values) || values != 120, false);
+		t = OS::get_singleton()->get_ticks_usec() - t;
+		best_string = i == 0 ? t : MIN(best_string, t);
+
+		VariantParser::StreamFile sf;
+		sf.f = FileAccess::open(TEST_FILE, FileAccess::READ);
+		ERR_FAIL_COND_V(!sf.f, false);
+		t = OS::get_singleton()->get_ticks_usec();
+		bool parsed = _parse_benchmark(&sf, values);
+		t = OS::get_singleton()->get_ticks_usec() - t;
+		sf.f->close();
+		memdelete(sf.f);
+		ERR_FAIL_COND_V(!parsed || values != 120, false);
+		best_file = i == 0 ? t : MIN(best_file, t);
+	}
+
+	OS::get_singleton()->print("\t%.1f MB, from a string: %.1f ms, from a file: %.1f ms\n", text.utf8().length() / (1024.0 * 1024.0), best_string / 1000.0, best_file / 1000.0);
+	return true;
+}
+
+typedef bool (*TestFunc)(void);
+
+TestFunc test_funcs[] = {
+	test_floats,
+	test_float_round_trip,
+	test_ints,
+	test_inf_nan,
+	test_eof,
+	test_buffer_boundaries,
+	test_stream_file_position,
+	test_benchmark,
+	NULL
+};
+
+MainLoop *test() {
+
+	int count = 0;
+	int passed = 0;
+
+	while (true) {
+		if (!test_funcs[count])
+			break;
+		bool pass = test_funcs[count]();
+		if (pass)
+			passed++;
+		OS::get_singleton()->print("\t%s\n", pass ? "PASS" : "FAILED");
+
+		count++;
+	}
+	OS::get_singleton()->print("\n");
+	OS::get_singleton()->print("Passed %i of %i tests\n", passed, count);
+
+	DirAccess *da = DirAccess::create(DirAccess::ACCESS_USERDATA);
+	da->remove(TEST_FILE);
+	memdelete(da);
+
+	return NULL;
+}
+
+} // namespace TestVariantParser
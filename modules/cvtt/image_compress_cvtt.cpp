@@ -30,8 +30,6 @@
 
 #include "image_compress_cvtt.h"
 
-#include "core/os/os.h"
-#include "core/os/thread.h"
 #include "core/print_string.h"
 
 #include <ConvectionKernels.h>
@@ -52,13 +50,6 @@ struct CVTTCompressionRowTask {
 	int height;
 };
 
-struct CVTTCompressionJobQueue {
-	CVTTCompressionJobParams job_params;
-	const CVTTCompressionRowTask *job_tasks;
-	uint32_t num_tasks;
-	uint32_t current_task;
-};
-
 static void _digest_row_task(const CVTTCompressionJobParams &p_job_params, const CVTTCompressionRowTask &p_row_task) {
 	const uint8_t *in_bytes = p_row_task.in_mm_bytes;
 	uint8_t *out_bytes = p_row_task.out_mm_bytes;
@@ -128,12 +119,16 @@ static void _digest_row_task(const CVTTCompressionJobParams &p_job_params, const
 	}
 }
 
-static void _digest_job_queue(void *p_job_queue) {
-	CVTTCompressionJobQueue *job_queue = static_cast<CVTTCompressionJobQueue *>(p_job_queue);
+static void _compress_cvtt_blocks(const uint8_t *p_src, int p_width, int p_height, int p_from_y, int p_to_y, uint8_t *p_dst, void *p_userdata) {
 
-	for (uint32_t next_task = atomic_increment(&job_queue->current_task); next_task <= job_queue->num_tasks; next_task = atomic_increment(&job_queue->current_task)) {
-		_digest_row_task(job_queue->job_params, job_queue->job_tasks[next_task - 1]);
-	}
+	CVTTCompressionRowTask row_task;
+	row_task.in_mm_bytes = p_src;
+	row_task.out_mm_bytes = p_dst;
+	row_task.y_start = p_from_y;
+	row_task.width = p_width;
+	row_task.height = p_height;
+
+	_digest_row_task(*static_cast<const CVTTCompressionJobParams *>(p_userdata), row_task);
 }
 
 void image_compress_cvtt(Image *p_image, float p_lossy_quality, Image::UsedChannels p_channels) {
@@ -195,88 +190,13 @@ void image_compress_cvtt(Image *p_image, float p_lossy_quality, Image::UsedChann
 		p_image->convert(Image::FORMAT_RGBA8); //still uses RGBA to convert
 	}
 
-	const uint8_t *rb = p_image->get_data().ptr();
-
-	Vector<uint8_t> data;
-	int target_size = Image::get_image_data_size(w, h, target_format, p_image->has_mipmaps());
-	int mm_count = p_image->has_mipmaps() ? Image::get_image_required_mipmaps(w, h, target_format) : 0;
-	data.resize(target_size);
-	int shift = Image::get_format_pixel_rshift(target_format);
-
-	uint8_t *wb = data.ptrw();
-
-	int dst_ofs = 0;
-
-	CVTTCompressionJobQueue job_queue;
-	job_queue.job_params.is_hdr = is_hdr;
-	job_queue.job_params.is_signed = is_signed;
-	job_queue.job_params.options = options;
-	job_queue.job_params.bytes_per_pixel = is_hdr ? 6 : 4;
-
-#ifdef NO_THREADS
-	int num_job_threads = 0;
-#else
-	int num_job_threads = OS::get_singleton()->can_use_threads() ? (OS::get_singleton()->get_processor_count() - 1) : 0;
-#endif
-
-	Vector<CVTTCompressionRowTask> tasks;
-
-	for (int i = 0; i <= mm_count; i++) {
-
-		int bw = w % 4 != 0 ? w + (4 - w % 4) : w;
-		int bh = h % 4 != 0 ? h + (4 - h % 4) : h;
-
-		int src_ofs = p_image->get_mipmap_offset(i);
-
-		const uint8_t *in_bytes = &rb[src_ofs];
-		uint8_t *out_bytes = &wb[dst_ofs];
-
-		for (int y_start = 0; y_start < h; y_start += 4) {
-			CVTTCompressionRowTask row_task;
-			row_task.width = w;
-			row_task.height = h;
-			row_task.y_start = y_start;
-			row_task.in_mm_bytes = in_bytes;
-			row_task.out_mm_bytes = out_bytes;
-
-			if (num_job_threads > 0) {
-				tasks.push_back(row_task);
-			} else {
-				_digest_row_task(job_queue.job_params, row_task);
-			}
-
-			out_bytes += 16 * (bw / 4);
-		}
-
-		dst_ofs += (MAX(4, bw) * MAX(4, bh)) >> shift;
-		w = MAX(w / 2, 1);
-		h = MAX(h / 2, 1);
-	}
-
-	if (num_job_threads > 0) {
-		Vector<Thread *> threads;
-		threads.resize(num_job_threads);
-
-		Thread **threads_wb = threads.ptrw();
-
-		const CVTTCompressionRowTask *tasks_rb = tasks.ptr();
-
-		job_queue.job_tasks = &tasks_rb[0];
-		job_queue.current_task = 0;
-		job_queue.num_tasks = static_cast<uint32_t>(tasks.size());
-
-		for (int i = 0; i < num_job_threads; i++) {
-			threads_wb[i] = Thread::create(_digest_job_queue, &job_queue);
-		}
-		_digest_job_queue(&job_queue);
-
-		for (int i = 0; i < num_job_threads; i++) {
-			Thread::wait_to_finish(threads_wb[i]);
-			memdelete(threads_wb[i]);
-		}
-	}
+	CVTTCompressionJobParams job_params;
+	job_params.is_hdr = is_hdr;
+	job_params.is_signed = is_signed;
+	job_params.options = options;
+	job_params.bytes_per_pixel = is_hdr ? 6 : 4;
 
-	p_image->create(p_image->get_width(), p_image->get_height(), p_image->has_mipmaps(), target_format, data);
+	p_image->compress_blocks(target_format, _compress_cvtt_blocks, &job_params);
 }
 
 void image_decompress_cvtt(Image *p_image) {
@@ -31,6 +31,9 @@
 #include "gd_navigation_server.h"
 
 #include "core/os/mutex.h"
+#include "core/os/os.h"
+#include "core/project_settings.h"
+#include <algorithm>
 
 #ifndef _3D_DISABLED
 #include "navigation_mesh_generator.h"
@@ -40,6 +43,10 @@
 	@author AndreaCatania
 */
 
+/// Without threads the path queries run in `process`, so they always get a
+/// time budget there.
+#define PATH_QUERIES_MAIN_THREAD_TIME_BUDGET_USEC 2000
+
 /// Creates a struct for each function and a function that once called creates
 /// an instance of that struct with the submited parameters.
 /// Then, that struct is stored in an array; the `sync` function consume that array.
@@ -115,11 +122,38 @@
 
 GdNavigationServer::GdNavigationServer() :
 		NavigationServer(),
-		active(true) {
+		active(true),
+		path_query_threads_working(0),
+		path_query_threads_exit(false),
+		path_queries_open(false),
+		path_queries_deadline(0) {
+
+	const float time_budget = GLOBAL_DEF("navigation/path_queries/time_budget_msec", 0.0);
+	ProjectSettings::get_singleton()->set_custom_property_info("navigation/path_queries/time_budget_msec", PropertyInfo(Variant::FLOAT, "navigation/path_queries/time_budget_msec", PROPERTY_HINT_RANGE, "0,100,0.1,or_greater"));
+	set_path_queries_time_budget(time_budget);
 }
 
 GdNavigationServer::~GdNavigationServer() {
+	_stop_path_queries();
+
+	path_query_threads_exit = true;
+	for (int i(0); i < path_query_threads.size(); i++) {
+		path_query_start_semaphore.post();
+	}
+	for (int i(0); i < path_query_threads.size(); i++) {
+		Thread::wait_to_finish(path_query_threads[i]);
+		memdelete(path_query_threads[i]);
+	}
+
 	flush_queries();
+
+	List<RID> owned_queries;
+	path_query_owner.get_owned_list(&owned_queries);
+	for (List<RID>::Element *E = owned_queries.front(); E; E = E->next()) {
+		NavPathQuery *query = path_query_owner.getornull(E->get());
+		path_query_owner.free(E->get());
+		memdelete(query);
+	}
 }
 
 void GdNavigationServer::add_command(SetCommand *command) const {
@@ -236,6 +270,49 @@ RID GdNavigationServer::map_get_closest_point_owner(RID p_map, const Vector3 &p_
 	return map->get_closest_point_owner(p_point);
 }
 
+RID GdNavigationServer::map_request_paths(RID p_map, const Vector<Vector3> &p_origins, const Vector<Vector3> &p_destinations, bool p_optimize, Object *p_receiver, StringName p_method, Variant p_udata) const {
+	auto mut_this = const_cast<GdNavigationServer *>(this);
+	NavMap *map = map_owner.getornull(p_map);
+	ERR_FAIL_COND_V(map == NULL, RID());
+	ERR_FAIL_COND_V_MSG(p_origins.size() != p_destinations.size(), RID(), "Each origin needs a destination.");
+
+	NavPathQuery *query = memnew(NavPathQuery);
+	query->map = map;
+	query->optimize = p_optimize;
+	query->origins = p_origins;
+	query->destinations = p_destinations;
+	query->paths.resize(p_origins.size());
+	if (p_receiver) {
+		query->callback.id = p_receiver->get_instance_id();
+		query->callback.method = p_method;
+		query->callback.udata = p_udata;
+	}
+
+	RID rid = path_query_owner.make_rid(query);
+	query->set_self(rid);
+
+	MutexLock lock(path_queries_mutex);
+	mut_this->path_queries.push_back(query);
+	return rid;
+}
+
+bool GdNavigationServer::path_query_is_done(RID p_query) const {
+	const NavPathQuery *query = path_query_owner.getornull(p_query);
+	ERR_FAIL_COND_V(query == NULL, false);
+
+	MutexLock lock(path_queries_mutex);
+	return query->is_done();
+}
+
+Vector<Vector3> GdNavigationServer::path_query_get_path(RID p_query, int p_index) const {
+	const NavPathQuery *query = path_query_owner.getornull(p_query);
+	ERR_FAIL_COND_V(query == NULL, Vector<Vector3>());
+	ERR_FAIL_INDEX_V(p_index, query->paths.size(), Vector<Vector3>());
+
+	MutexLock lock(path_queries_mutex);
+	return query->paths[p_index];
+}
+
 RID GdNavigationServer::region_create() const {
 	auto mut_this = const_cast<GdNavigationServer *>(this);
 	MutexLock lock(mut_this->operations_mutex);
@@ -429,6 +506,18 @@ COMMAND_1(free, RID, p_object) {
 			agents[i]->set_map(NULL);
 		}
 
+		// The paths not searched yet on this map are returned empty.
+		{
+			MutexLock lock(path_queries_mutex);
+			for (size_t i(0); i < path_queries.size(); i++) {
+				if (path_queries[i]->map == map) {
+					path_queries[i]->map = NULL;
+					path_queries[i]->done_paths += path_queries[i]->origins.size() - path_queries[i]->next_path;
+					path_queries[i]->next_path = path_queries[i]->origins.size();
+				}
+			}
+		}
+
 		active_maps.erase(map);
 		map_owner.free(p_object);
 		memdelete(map);
@@ -457,6 +546,21 @@ COMMAND_1(free, RID, p_object) {
 		agent_owner.free(p_object);
 		memdelete(agent);
 
+	} else if (path_query_owner.owns(p_object)) {
+		NavPathQuery *query = path_query_owner.getornull(p_object);
+
+		// Cancels the paths not searched yet.
+		{
+			MutexLock lock(path_queries_mutex);
+			std::vector<NavPathQuery *>::iterator it = std::find(path_queries.begin(), path_queries.end(), query);
+			if (it != path_queries.end()) {
+				path_queries.erase(it);
+			}
+		}
+
+		path_query_owner.free(p_object);
+		memdelete(query);
+
 	} else {
 		ERR_FAIL_COND("Invalid ID.");
 	}
@@ -480,21 +584,165 @@ void GdNavigationServer::flush_queries() {
 	commands.clear();
 }
 
+void GdNavigationServer::_path_query_thread_func(void *p_udata) {
+	GdNavigationServer *server = static_cast<GdNavigationServer *>(p_udata);
+
+	while (true) {
+		server->path_query_start_semaphore.wait();
+		if (server->path_query_threads_exit) {
+			break;
+		}
+		server->_process_path_queries();
+		server->path_query_done_semaphore.post();
+	}
+}
+
+void GdNavigationServer::_process_path_queries() {
+	while (true) {
+		NavPathQuery *query = NULL;
+		int path_id = -1;
+
+		{
+			MutexLock lock(path_queries_mutex);
+			if (!path_queries_open || (path_queries_deadline && OS::get_singleton()->get_ticks_usec() >= path_queries_deadline)) {
+				return;
+			}
+
+			for (size_t i(0); i < path_queries.size(); i++) {
+				if (path_queries[i]->next_path < path_queries[i]->origins.size()) {
+					query = path_queries[i];
+					break;
+				}
+			}
+
+			if (query == NULL) {
+				return;
+			}
+			path_id = query->next_path++;
+		}
+
+		// The maps don't change while the queries are open, so no lock is
+		// needed to search the path.
+		Vector<Vector3> path = query->map->get_path(query->origins[path_id], query->destinations[path_id], query->optimize);
+
+		{
+			MutexLock lock(path_queries_mutex);
+			query->paths.write[path_id] = path;
+			query->done_paths++;
+		}
+	}
+}
+
+void GdNavigationServer::_start_path_queries() {
+	{
+		MutexLock lock(path_queries_mutex);
+		if (path_queries.empty()) {
+			return;
+		}
+		uint64_t time_budget = path_queries_time_budget;
+		if (time_budget == 0 && !OS::get_singleton()->can_use_threads()) {
+			time_budget = PATH_QUERIES_MAIN_THREAD_TIME_BUDGET_USEC;
+		}
+		path_queries_open = true;
+		path_queries_deadline = time_budget ? OS::get_singleton()->get_ticks_usec() + time_budget : 0;
+	}
+
+	if (!OS::get_singleton()->can_use_threads()) {
+		// Search the paths right away, still within the time budget.
+		_process_path_queries();
+		path_queries_open = false;
+		return;
+	}
+
+	if (path_query_threads.empty()) {
+		const int thread_count = MAX(1, OS::get_singleton()->get_processor_count() - 1);
+		for (int i(0); i < thread_count; i++) {
+			path_query_threads.push_back(Thread::create(_path_query_thread_func, this));
+		}
+	}
+
+	path_query_threads_working = path_query_threads.size();
+	for (int i(0); i < path_query_threads_working; i++) {
+		path_query_start_semaphore.post();
+	}
+}
+
+void GdNavigationServer::_stop_path_queries() {
+	{
+		MutexLock lock(path_queries_mutex);
+		path_queries_open = false;
+	}
+
+	// Each thread returns once its current path is found.
+	for (int i(0); i < path_query_threads_working; i++) {
+		path_query_done_semaphore.wait();
+	}
+	path_query_threads_working = 0;
+}
+
+void GdNavigationServer::_dispatch_path_query_callbacks() {
+	// The callbacks may request new paths, so take the done queries first.
+	std::vector<NavPathQuery *> done_queries;
+	{
+		MutexLock lock(path_queries_mutex);
+		for (size_t i(0); i < path_queries.size();) {
+			if (path_queries[i]->is_done()) {
+				done_queries.push_back(path_queries[i]);
+				path_queries.erase(path_queries.begin() + i);
+			} else {
+				i++;
+			}
+		}
+	}
+
+	for (size_t i(0); i < done_queries.size(); i++) {
+		const NavPathQuery::QueryDoneCallback &callback = done_queries[i]->callback;
+		if (callback.id.is_null()) {
+			continue;
+		}
+		Object *obj = ObjectDB::get_instance(callback.id);
+		if (obj == NULL) {
+			continue;
+		}
+
+		Variant query = done_queries[i]->get_self();
+		const Variant *vp[2] = { &query, &callback.udata };
+		int argc = (callback.udata.get_type() == Variant::NIL) ? 1 : 2;
+		Callable::CallError ce;
+		obj->call(callback.method, vp, argc, ce);
+	}
+}
+
 void GdNavigationServer::process(real_t p_delta_time) {
+	// The path queries read the maps, so stop them before changing the maps.
+	_stop_path_queries();
 	flush_queries();
 
 	if (!active) {
 		return;
 	}
 
-	// In c++ we can't be sure that this is performed in the main thread
-	// even with mutable functions.
-	MutexLock lock(operations_mutex);
-	for (int i(0); i < active_maps.size(); i++) {
-		active_maps[i]->sync();
-		active_maps[i]->step(p_delta_time);
-		active_maps[i]->dispatch_callbacks();
+	{
+		// In c++ we can't be sure that this is performed in the main thread
+		// even with mutable functions.
+		MutexLock lock(operations_mutex);
+		for (int i(0); i < active_maps.size(); i++) {
+			active_maps[i]->sync();
+			active_maps[i]->step(p_delta_time);
+			active_maps[i]->dispatch_callbacks();
+		}
 	}
+
+	_dispatch_path_query_callbacks();
+	_start_path_queries();
+}
+
+void GdNavigationServer::set_path_queries_time_budget(real_t p_msec) {
+	path_queries_time_budget = uint64_t(MAX(p_msec, 0) * 1000);
+}
+
+real_t GdNavigationServer::get_path_queries_time_budget() const {
+	return path_queries_time_budget / 1000.0;
 }
 
 #undef COMMAND_1
@@ -31,11 +31,14 @@
 #ifndef GD_NAVIGATION_SERVER_H
 #define GD_NAVIGATION_SERVER_H
 
+#include "core/os/semaphore.h"
+#include "core/os/thread.h"
 #include "core/rid.h"
 #include "core/rid_owner.h"
 #include "servers/navigation_server.h"
 
 #include "nav_map.h"
+#include "nav_path_query.h"
 #include "nav_region.h"
 #include "rvo_agent.h"
 
@@ -81,6 +84,30 @@ class GdNavigationServer : public NavigationServer {
 	bool active;
 	Vector<NavMap *> active_maps;
 
+	/// Mutex used to access the path queries from the path query threads.
+	Mutex path_queries_mutex;
+	mutable RID_PtrOwner<NavPathQuery, true> path_query_owner;
+
+	/// The queries not reported as done yet, in request order.
+	std::vector<NavPathQuery *> path_queries;
+
+	/// The path query threads search the queued paths between two `process`
+	/// calls, when the maps don't change, until the frame time budget ends.
+	Vector<Thread *> path_query_threads;
+	Semaphore path_query_start_semaphore;
+	Semaphore path_query_done_semaphore;
+	int path_query_threads_working;
+	bool path_query_threads_exit;
+	bool path_queries_open;
+	uint64_t path_queries_deadline;
+	uint64_t path_queries_time_budget;
+
+	static void _path_query_thread_func(void *p_udata);
+	void _process_path_queries();
+	void _start_path_queries();
+	void _stop_path_queries();
+	void _dispatch_path_query_callbacks();
+
 public:
 	GdNavigationServer();
 	virtual ~GdNavigationServer();
@@ -107,6 +134,10 @@ public:
 	virtual Vector3 map_get_closest_point_normal(RID p_map, const Vector3 &p_point) const;
 	virtual RID map_get_closest_point_owner(RID p_map, const Vector3 &p_point) const;
 
+	virtual RID map_request_paths(RID p_map, const Vector<Vector3> &p_origins, const Vector<Vector3> &p_destinations, bool p_optimize, Object *p_receiver = NULL, StringName p_method = StringName(), Variant p_udata = Variant()) const;
+	virtual bool path_query_is_done(RID p_query) const;
+	virtual Vector<Vector3> path_query_get_path(RID p_query, int p_index) const;
+
 	virtual RID region_create() const;
 	COMMAND_2(region_set_map, RID, p_region, RID, p_map);
 	COMMAND_2(region_set_transform, RID, p_region, Transform, p_transform);
@@ -133,6 +164,10 @@ public:
 
 	void flush_queries();
 	virtual void process(real_t p_delta_time);
+
+	/// How long the path queries may run after each `process`, 0 for no limit.
+	void set_path_queries_time_budget(real_t p_msec);
+	real_t get_path_queries_time_budget() const;
 };
 
 #undef COMMAND_1
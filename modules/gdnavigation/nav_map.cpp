@@ -47,6 +47,7 @@ NavMap::NavMap() :
 		edge_connection_margin(5.0),
 		regenerate_polygons(true),
 		regenerate_links(true),
+		polygons_bvh_root(-1),
 		agents_dirty(false),
 		deltatime(0.0),
 		map_update_id(0) {}
@@ -79,41 +80,102 @@ gd::PointKey NavMap::get_point_key(const Vector3 &p_pos) const {
 	return p;
 }
 
-Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p_optimize) const {
-
-	const gd::Polygon *begin_poly = NULL;
-	const gd::Polygon *end_poly = NULL;
-	Vector3 begin_point;
-	Vector3 end_point;
-	float begin_d = 1e20;
-	float end_d = 1e20;
+/// Min-heap of the open `NavigationPoly` ids, ordered by cost and then by id
+/// so the polys having the same cost are taken in discovery order.
+class NavigationPolyHeap {
+	std::vector<gd::NavigationPoly> &polys;
+	std::vector<uint32_t> heap;
 
-	// Find the initial poly and the end poly on this map.
-	for (size_t i(0); i < polygons.size(); i++) {
-		const gd::Polygon &p = polygons[i];
+	_FORCE_INLINE_ bool is_less(uint32_t p_a, uint32_t p_b) const {
+		const gd::NavigationPoly &a = polys[p_a];
+		const gd::NavigationPoly &b = polys[p_b];
+		return a.cost < b.cost || (a.cost == b.cost && a.self_id < b.self_id);
+	}
 
-		// For each point cast a face and check the distance between the origin/destination
-		for (size_t point_id = 2; point_id < p.points.size(); point_id++) {
+	_FORCE_INLINE_ void set(int p_index, uint32_t p_id) {
+		heap[p_index] = p_id;
+		polys[p_id].heap_index = p_index;
+	}
 
-			Face3 f(p.points[point_id - 2].pos, p.points[point_id - 1].pos, p.points[point_id].pos);
-			Vector3 spoint = f.get_closest_point_to(p_origin);
-			float dpoint = spoint.distance_to(p_origin);
-			if (dpoint < begin_d) {
-				begin_d = dpoint;
-				begin_poly = &p;
-				begin_point = spoint;
+	void sift_up(int p_index) {
+		const uint32_t id = heap[p_index];
+		while (p_index > 0) {
+			const int parent = (p_index - 1) / 2;
+			if (!is_less(id, heap[parent])) {
+				break;
 			}
+			set(p_index, heap[parent]);
+			p_index = parent;
+		}
+		set(p_index, id);
+	}
 
-			spoint = f.get_closest_point_to(p_destination);
-			dpoint = spoint.distance_to(p_destination);
-			if (dpoint < end_d) {
-				end_d = dpoint;
-				end_poly = &p;
-				end_point = spoint;
+	void sift_down(int p_index) {
+		const uint32_t id = heap[p_index];
+		const int size = heap.size();
+		while (true) {
+			int child = p_index * 2 + 1;
+			if (child >= size) {
+				break;
+			}
+			if (child + 1 < size && is_less(heap[child + 1], heap[child])) {
+				child++;
+			}
+			if (!is_less(heap[child], id)) {
+				break;
 			}
+			set(p_index, heap[child]);
+			p_index = child;
 		}
+		set(p_index, id);
 	}
 
+public:
+	bool is_empty() const {
+		return heap.empty();
+	}
+
+	void push(uint32_t p_id) {
+		heap.push_back(p_id);
+		sift_up(heap.size() - 1);
+	}
+
+	uint32_t pop() {
+		const uint32_t id = heap[0];
+		polys[id].heap_index = -1;
+		heap[0] = heap.back();
+		heap.pop_back();
+		if (!heap.empty()) {
+			sift_down(0);
+		}
+		return id;
+	}
+
+	/// Restores the order after the cost of an open poly changed.
+	void update(uint32_t p_id) {
+		sift_up(polys[p_id].heap_index);
+		sift_down(polys[p_id].heap_index);
+	}
+
+	void clear() {
+		for (size_t i(0); i < heap.size(); i++) {
+			polys[heap[i]].heap_index = -1;
+		}
+		heap.clear();
+	}
+
+	NavigationPolyHeap(std::vector<gd::NavigationPoly> &p_polys) :
+			polys(p_polys) {}
+};
+
+Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p_optimize) const {
+
+	// Find the initial poly and the end poly on this map.
+	Vector3 begin_point;
+	Vector3 end_point;
+	const gd::Polygon *begin_poly = get_closest_polygon(p_origin, begin_point);
+	const gd::Polygon *end_poly = get_closest_polygon(p_destination, end_point);
+
 	if (!begin_poly || !end_poly) {
 		// No path
 		return Vector<Vector3>();
@@ -131,9 +193,12 @@ Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p
 	std::vector<gd::NavigationPoly> navigation_polys;
 	navigation_polys.reserve(polygons.size() * 0.75);
 
+	// The `navigation_polys` id of each map polygon, -1 when not visited yet.
+	std::vector<int> polygon_navigation_ids(polygons.size(), -1);
+
 	// The elements indices in the `navigation_polys`.
 	int least_cost_id(-1);
-	List<uint32_t> open_list;
+	NavigationPolyHeap open_list(navigation_polys);
 	bool found_route = false;
 
 	navigation_polys.push_back(gd::NavigationPoly(begin_poly));
@@ -143,8 +208,7 @@ Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p
 		least_cost_poly->self_id = least_cost_id;
 		least_cost_poly->entry = begin_point;
 	}
-
-	open_list.push_back(0);
+	polygon_navigation_ids[begin_poly - polygons.data()] = 0;
 
 	const gd::Polygon *reachable_end = NULL;
 	float reachable_d = 1e30;
@@ -169,25 +233,29 @@ Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p
 
 				const Vector3 new_entry = Geometry::get_closest_point_to_segment(least_cost_poly->entry, edge_line);
 				const float new_distance = least_cost_poly->entry.distance_to(new_entry) + least_cost_poly->traveled_distance;
+				const float new_cost = new_distance + new_entry.distance_to(end_point);
 #else
 				const float new_distance = least_cost_poly->poly->center.distance_to(edge.other_polygon->center) + least_cost_poly->traveled_distance;
+				const float new_cost = new_distance + edge.other_polygon->center.distance_to(end_point);
 #endif
 
-				auto it = std::find(
-						navigation_polys.begin(),
-						navigation_polys.end(),
-						gd::NavigationPoly(edge.other_polygon));
+				int &navigation_id = polygon_navigation_ids[edge.other_polygon - polygons.data()];
 
-				if (it != navigation_polys.end()) {
+				if (navigation_id != -1) {
 					// Oh this was visited already, can we win the cost?
+					gd::NavigationPoly *it = &navigation_polys[navigation_id];
 					if (it->traveled_distance > new_distance) {
 
 						it->prev_navigation_poly_id = least_cost_id;
 						it->back_navigation_edge = edge.other_edge;
 						it->traveled_distance = new_distance;
+						it->cost = new_cost;
 #ifdef USE_ENTRY_POINT
 						it->entry = new_entry;
 #endif
+						if (it->heap_index != -1) {
+							open_list.update(navigation_id);
+						}
 					}
 				} else {
 					// Add to open neighbours
@@ -199,18 +267,17 @@ Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p
 					np->prev_navigation_poly_id = least_cost_id;
 					np->back_navigation_edge = edge.other_edge;
 					np->traveled_distance = new_distance;
+					np->cost = new_cost;
 #ifdef USE_ENTRY_POINT
 					np->entry = new_entry;
 #endif
-					open_list.push_back(navigation_polys.size() - 1);
+					navigation_id = np->self_id;
+					open_list.push(np->self_id);
 				}
 			}
 		}
 
-		// Removes the least cost polygon from the open list so we can advance.
-		open_list.erase(least_cost_id);
-
-		if (open_list.size() == 0) {
+		if (open_list.is_empty()) {
 			// When the open list is empty at this point the End Polygon is not reachable
 			// so use the further reachable polygon
 			ERR_BREAK_MSG(is_reachable == false, "It's not expect to not find the most reachable polygons");
@@ -222,7 +289,7 @@ Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p
 
 			// Set as end point the furthest reachable point.
 			end_poly = reachable_end;
-			end_d = 1e20;
+			float end_d = 1e20;
 			for (size_t point_id = 2; point_id < end_poly->points.size(); point_id++) {
 				Face3 f(end_poly->points[point_id - 2].pos, end_poly->points[point_id - 1].pos, end_poly->points[point_id].pos);
 				Vector3 spoint = f.get_closest_point_to(p_destination);
@@ -233,12 +300,15 @@ Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p
 				}
 			}
 
-			// Reset open and navigation_polys
+			// Reset open and navigation_polys, then restart from the begin poly.
+			for (size_t i(0); i < navigation_polys.size(); i++) {
+				polygon_navigation_ids[navigation_polys[i].poly - polygons.data()] = -1;
+			}
 			gd::NavigationPoly np = navigation_polys[0];
 			navigation_polys.clear();
 			navigation_polys.push_back(np);
-			open_list.clear();
-			open_list.push_back(0);
+			polygon_navigation_ids[np.poly - polygons.data()] = 0;
+			least_cost_id = 0;
 
 			reachable_end = NULL;
 
@@ -246,22 +316,7 @@ Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p
 		}
 
 		// Now take the new least_cost_poly from the open list.
-		least_cost_id = -1;
-		float least_cost = 1e30;
-
-		for (auto element = open_list.front(); element != NULL; element = element->next()) {
-			gd::NavigationPoly *np = &navigation_polys[element->get()];
-			float cost = np->traveled_distance;
-#ifdef USE_ENTRY_POINT
-			cost += np->entry.distance_to(end_point);
-#else
-			cost += np->poly->center.distance_to(end_point);
-#endif
-			if (cost < least_cost) {
-				least_cost_id = np->self_id;
-				least_cost = cost;
-			}
-		}
+		least_cost_id = open_list.pop();
 
 		// Stores the further reachable end polygon, in case our goal is not reachable.
 		if (is_reachable) {
@@ -272,8 +327,6 @@ Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p
 			}
 		}
 
-		ERR_BREAK(least_cost_id == -1);
-
 		// Check if we reached the end
 		if (navigation_polys[least_cost_id].poly == end_poly) {
 			// Yep, done!!
@@ -457,42 +510,53 @@ Vector3 NavMap::get_closest_point_to_segment(const Vector3 &p_from, const Vector
 	return closest_point;
 }
 
-Vector3 NavMap::get_closest_point(const Vector3 &p_point) const {
-	// TODO this is really not optimal, please redesign the API to directly return all this data
+static _FORCE_INLINE_ real_t _get_aabb_distance_squared(const AABB &p_aabb, const Vector3 &p_point) {
+	const Vector3 end = p_aabb.position + p_aabb.size;
+	Vector3 closest;
+	for (int i = 0; i < 3; i++) {
+		closest[i] = CLAMP(p_point[i], p_aabb.position[i], end[i]);
+	}
+	return closest.distance_squared_to(p_point);
+}
 
-	Vector3 closest_point;
-	real_t closest_point_d = 1e20;
+const gd::Polygon *NavMap::get_closest_polygon(const Vector3 &p_point, Vector3 &r_closest_point, Face3 *r_face) const {
 
-	// Find the initial poly and the end poly on this map.
-	for (size_t i(0); i < polygons.size(); i++) {
-		const gd::Polygon &p = polygons[i];
+	if (polygons_bvh_root == -1) {
+		return NULL;
+	}
 
-		// For each point cast a face and check the distance to the point
-		for (size_t point_id = 2; point_id < p.points.size(); point_id += 1) {
+	int closest_polygon = -1;
+	real_t closest_point_d = 1e20;
 
-			const Face3 f(p.points[point_id - 2].pos, p.points[point_id - 1].pos, p.points[point_id].pos);
-			const Vector3 inters = f.get_closest_point_to(p_point);
-			const real_t d = inters.distance_to(p_point);
-			if (d < closest_point_d) {
-				closest_point = inters;
-				closest_point_d = d;
-			}
-		}
-	}
+	// The tree is balanced, so its depth can't exceed the bits of the polygons count.
+	int stack[64];
+	int stack_size = 0;
+	stack[stack_size++] = polygons_bvh_root;
 
-	return closest_point;
-}
+	while (stack_size) {
+		const gd::PolygonBVH &node = polygons_bvh[stack[--stack_size]];
 
-Vector3 NavMap::get_closest_point_normal(const Vector3 &p_point) const {
-	// TODO this is really not optimal, please redesign the API to directly return all this data
+		// Skip the nodes farther than the closest point found so far, the
+		// equal ones are still checked to keep the lower polygon id on ties.
+		if (Math::sqrt(_get_aabb_distance_squared(node.aabb, p_point)) > closest_point_d) {
+			continue;
+		}
 
-	Vector3 closest_point;
-	Vector3 closest_point_normal;
-	real_t closest_point_d = 1e20;
+		if (node.polygon == -1) {
+			// Push the farthest child first, so the nearest one is checked first.
+			const real_t left_d = _get_aabb_distance_squared(polygons_bvh[node.left].aabb, p_point);
+			const real_t right_d = _get_aabb_distance_squared(polygons_bvh[node.right].aabb, p_point);
+			if (left_d < right_d) {
+				stack[stack_size++] = node.right;
+				stack[stack_size++] = node.left;
+			} else {
+				stack[stack_size++] = node.left;
+				stack[stack_size++] = node.right;
+			}
+			continue;
+		}
 
-	// Find the initial poly and the end poly on this map.
-	for (size_t i(0); i < polygons.size(); i++) {
-		const gd::Polygon &p = polygons[i];
+		const gd::Polygon &p = polygons[node.polygon];
 
 		// For each point cast a face and check the distance to the point
 		for (size_t point_id = 2; point_id < p.points.size(); point_id += 1) {
@@ -500,43 +564,45 @@ Vector3 NavMap::get_closest_point_normal(const Vector3 &p_point) const {
 			const Face3 f(p.points[point_id - 2].pos, p.points[point_id - 1].pos, p.points[point_id].pos);
 			const Vector3 inters = f.get_closest_point_to(p_point);
 			const real_t d = inters.distance_to(p_point);
-			if (d < closest_point_d) {
-				closest_point = inters;
-				closest_point_normal = f.get_plane().normal;
+			if (d < closest_point_d || (d == closest_point_d && node.polygon < closest_polygon)) {
+				closest_polygon = node.polygon;
 				closest_point_d = d;
+				r_closest_point = inters;
+				if (r_face) {
+					*r_face = f;
+				}
 			}
 		}
 	}
 
-	return closest_point_normal;
+	return closest_polygon != -1 ? &polygons[closest_polygon] : NULL;
 }
 
-RID NavMap::get_closest_point_owner(const Vector3 &p_point) const {
-	// TODO this is really not optimal, please redesign the API to directly return all this data
+Vector3 NavMap::get_closest_point(const Vector3 &p_point) const {
 
 	Vector3 closest_point;
-	RID closest_point_owner;
-	real_t closest_point_d = 1e20;
-
-	// Find the initial poly and the end poly on this map.
-	for (size_t i(0); i < polygons.size(); i++) {
-		const gd::Polygon &p = polygons[i];
+	get_closest_polygon(p_point, closest_point);
+	return closest_point;
+}
 
-		// For each point cast a face and check the distance to the point
-		for (size_t point_id = 2; point_id < p.points.size(); point_id += 1) {
+Vector3 NavMap::get_closest_point_normal(const Vector3 &p_point) const {
 
-			const Face3 f(p.points[point_id - 2].pos, p.points[point_id - 1].pos, p.points[point_id].pos);
-			const Vector3 inters = f.get_closest_point_to(p_point);
-			const real_t d = inters.distance_to(p_point);
-			if (d < closest_point_d) {
-				closest_point = inters;
-				closest_point_owner = p.owner->get_self();
-				closest_point_d = d;
-			}
-		}
+	Vector3 closest_point;
+	Face3 closest_face;
+	if (!get_closest_polygon(p_point, closest_point, &closest_face)) {
+		return Vector3();
 	}
+	return closest_face.get_plane().normal;
+}
+
+RID NavMap::get_closest_point_owner(const Vector3 &p_point) const {
 
-	return closest_point_owner;
+	Vector3 closest_point;
+	const gd::Polygon *closest_polygon = get_closest_polygon(p_point, closest_point);
+	if (!closest_polygon) {
+		return RID();
+	}
+	return closest_polygon->owner->get_self();
 }
 
 void NavMap::add_region(NavRegion *p_region) {
@@ -587,6 +653,43 @@ void NavMap::remove_agent_as_controlled(RvoAgent *agent) {
 	}
 }
 
+struct PolygonBVHCmp {
+	const std::vector<gd::PolygonBVH> *nodes;
+	int axis;
+
+	bool operator()(int p_left, int p_right) const {
+		const AABB &left = (*nodes)[p_left].aabb;
+		const AABB &right = (*nodes)[p_right].aabb;
+		return (left.position[axis] + left.size[axis] * 0.5) < (right.position[axis] + right.size[axis] * 0.5);
+	}
+};
+
+int NavMap::build_polygons_bvh(int *p_polygon_ids, int p_count) {
+
+	if (p_count == 1) {
+		// The leaves are the first nodes, one per polygon.
+		return p_polygon_ids[0];
+	}
+
+	AABB aabb = polygons_bvh[p_polygon_ids[0]].aabb;
+	for (int i = 1; i < p_count; i++) {
+		aabb.merge_with(polygons_bvh[p_polygon_ids[i]].aabb);
+	}
+
+	// Split at the median of the longest axis.
+	PolygonBVHCmp cmp;
+	cmp.nodes = &polygons_bvh;
+	cmp.axis = aabb.get_longest_axis_index();
+	std::nth_element(p_polygon_ids, p_polygon_ids + p_count / 2, p_polygon_ids + p_count, cmp);
+
+	gd::PolygonBVH node;
+	node.aabb = aabb;
+	node.left = build_polygons_bvh(p_polygon_ids, p_count / 2);
+	node.right = build_polygons_bvh(p_polygon_ids + p_count / 2, p_count - p_count / 2);
+	polygons_bvh.push_back(node);
+	return polygons_bvh.size() - 1;
+}
+
 void NavMap::sync() {
 
 	if (regenerate_polygons) {
@@ -731,6 +834,34 @@ void NavMap::sync() {
 				}
 			}
 		}
+
+		// Rebuilds the polygons BVH.
+		polygons_bvh.clear();
+		polygons_bvh_root = -1;
+
+		std::vector<int> polygon_ids;
+		polygon_ids.reserve(polygons.size());
+		polygons_bvh.reserve(polygons.size() * 2);
+
+		for (size_t poly_id(0); poly_id < polygons.size(); poly_id++) {
+			const gd::Polygon &poly(polygons[poly_id]);
+
+			gd::PolygonBVH leaf;
+			leaf.polygon = poly_id;
+			for (size_t p(0); p < poly.points.size(); p++) {
+				if (p == 0) {
+					leaf.aabb.position = poly.points[p].pos;
+				} else {
+					leaf.aabb.expand_to(poly.points[p].pos);
+				}
+			}
+			polygons_bvh.push_back(leaf);
+			polygon_ids.push_back(poly_id);
+		}
+
+		if (polygon_ids.size()) {
+			polygons_bvh_root = build_polygons_bvh(polygon_ids.data(), polygon_ids.size());
+		}
 	}
 
 	if (regenerate_links) {
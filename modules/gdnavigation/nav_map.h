@@ -33,6 +33,7 @@
 
 #include "nav_rid.h"
 
+#include "core/math/face3.h"
 #include "core/math/math_defs.h"
 #include "nav_utils.h"
 #include <KdTree.h>
@@ -65,6 +66,11 @@ class NavMap : public NavRid {
 	/// Map polygons
 	std::vector<gd::Polygon> polygons;
 
+	/// Bounding volume hierarchy of the map polygons, used to find the
+	/// polygon closest to a point without scanning all of them.
+	std::vector<gd::PolygonBVH> polygons_bvh;
+	int polygons_bvh_root;
+
 	/// Rvo world
 	RVO::KdTree rvo;
 
@@ -115,6 +121,10 @@ public:
 		return regions;
 	}
 
+	const std::vector<gd::Polygon> &get_polygons() const {
+		return polygons;
+	}
+
 	bool has_agent(RvoAgent *agent) const;
 	void add_agent(RvoAgent *agent);
 	void remove_agent(RvoAgent *agent);
@@ -134,6 +144,9 @@ public:
 	void dispatch_callbacks();
 
 private:
+	int build_polygons_bvh(int *p_polygon_ids, int p_count);
+	const gd::Polygon *get_closest_polygon(const Vector3 &p_point, Vector3 &r_closest_point, Face3 *r_face = NULL) const;
+
 	void compute_single_step(uint32_t index, RvoAgent **agent);
 	void clip_path(const std::vector<gd::NavigationPoly> &p_navigation_polys, Vector<Vector3> &path, const gd::NavigationPoly *from_poly, const Vector3 &p_to_point, const gd::NavigationPoly *p_to_poly) const;
 };
@@ -0,0 +1,79 @@
+/*************************************************************************/
+/*  nav_path_query.h                                                     */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2020 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2020 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef NAV_PATH_QUERY_H
+#define NAV_PATH_QUERY_H
+
+#include "nav_rid.h"
+
+#include "core/math/vector3.h"
+#include "core/object.h"
+#include "core/vector.h"
+
+class NavMap;
+
+/// A batch of paths requested on a map, searched on the path query threads.
+class NavPathQuery : public NavRid {
+public:
+	struct QueryDoneCallback {
+		ObjectID id;
+		StringName method;
+		Variant udata;
+	};
+
+	/// The map to search, `NULL` once the map is freed.
+	NavMap *map;
+	bool optimize;
+
+	Vector<Vector3> origins;
+	Vector<Vector3> destinations;
+
+	/// The found paths, at the same index of their origin.
+	Vector<Vector<Vector3> > paths;
+
+	/// The id of the next path to search.
+	int next_path;
+	/// The number of paths searched so far.
+	int done_paths;
+
+	QueryDoneCallback callback;
+
+	NavPathQuery() :
+			map(NULL),
+			optimize(false),
+			next_path(0),
+			done_paths(0) {}
+
+	bool is_done() const {
+		return done_paths == origins.size();
+	}
+};
+
+#endif // NAV_PATH_QUERY_H
@@ -31,6 +31,7 @@
 #ifndef NAV_UTILS_H
 #define NAV_UTILS_H
 
+#include "core/math/aabb.h"
 #include "core/math/vector3.h"
 #include <vector>
 
@@ -138,13 +139,19 @@ struct NavigationPoly {
 	Vector3 entry;
 	/// The distance to the destination.
 	float traveled_distance;
+	/// The `traveled_distance` plus the estimated distance to the end point.
+	float cost;
+	/// The position of this poly in the open list heap, -1 when it's not open.
+	int heap_index;
 
 	NavigationPoly(const Polygon *p_poly) :
 			self_id(0),
 			poly(p_poly),
 			prev_navigation_poly_id(-1),
 			back_navigation_edge(0),
-			traveled_distance(0.0) {
+			traveled_distance(0.0),
+			cost(0.0),
+			heap_index(-1) {
 	}
 
 	bool operator==(const NavigationPoly &other) const {
@@ -156,6 +163,22 @@ struct NavigationPoly {
 	}
 };
 
+struct PolygonBVH {
+	/// The bounds of this node.
+	AABB aabb;
+	/// The children node ids, -1 for the leaves.
+	int left;
+	int right;
+	/// The polygon id in the map `polygons` for the leaves, -1 otherwise.
+	int polygon;
+
+	PolygonBVH() :
+			left(-1),
+			right(-1),
+			polygon(-1) {
+	}
+};
+
 struct FreeEdge {
 	bool is_free;
 	Polygon *poly;
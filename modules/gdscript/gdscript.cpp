@@ -39,7 +39,9 @@
 #include "core/os/file_access.h"
 #include "core/os/os.h"
 #include "core/project_settings.h"
+#include "gdscript_compiled_buffer.h"
 #include "gdscript_compiler.h"
+#include "gdscript_sampler.h"
 
 ///////////////////////////
 
@@ -528,8 +530,68 @@ void GDScript::_set_subclass_path(Ref<GDScript> &p_sc, const String &p_path) {
 	}
 }
 
+void GDScript::_update_rpc_methods() {
+
+	// Copy the base rpc methods so we don't mask their IDs.
+	rpc_functions.clear();
+	rpc_variables.clear();
+	if (base.is_valid()) {
+		rpc_functions = base->rpc_functions;
+		rpc_variables = base->rpc_variables;
+	}
+
+	GDScript *cscript = this;
+	Map<StringName, Ref<GDScript> >::Element *sub_E = subclasses.front();
+	while (cscript) {
+		// RPC Methods
+		for (Map<StringName, GDScriptFunction *>::Element *E = cscript->member_functions.front(); E; E = E->next()) {
+			if (E->get()->get_rpc_mode() != MultiplayerAPI::RPC_MODE_DISABLED) {
+				ScriptNetData nd;
+				nd.name = E->key();
+				nd.mode = E->get()->get_rpc_mode();
+				if (-1 == rpc_functions.find(nd)) {
+					rpc_functions.push_back(nd);
+				}
+			}
+		}
+		// RSet
+		for (Map<StringName, MemberInfo>::Element *E = cscript->member_indices.front(); E; E = E->next()) {
+			if (E->get().rpc_mode != MultiplayerAPI::RPC_MODE_DISABLED) {
+				ScriptNetData nd;
+				nd.name = E->key();
+				nd.mode = E->get().rpc_mode;
+				if (-1 == rpc_variables.find(nd)) {
+					rpc_variables.push_back(nd);
+				}
+			}
+		}
+
+		if (cscript != this)
+			sub_E = sub_E->next();
+
+		if (sub_E)
+			cscript = sub_E->get().ptr();
+		else
+			cscript = NULL;
+	}
+
+	// Sort so we are 100% that they are always the same.
+	rpc_functions.sort_custom<SortNetData>();
+	rpc_variables.sort_custom<SortNetData>();
+}
+
 Error GDScript::reload(bool p_keep_state) {
 
+	return _reload(p_keep_state, NULL);
+}
+
+Error GDScript::reload_for_export(bool p_debug) {
+
+	return _reload(false, NULL, p_debug, true);
+}
+
+Error GDScript::_reload(bool p_keep_state, GDScriptTokenizerRecorded *p_tokens, bool p_debug_code, bool p_export) {
+
 	bool has_instances;
 	{
 		MutexLock lock(GDScriptLanguage::singleton->lock);
@@ -554,7 +616,7 @@ Error GDScript::reload(bool p_keep_state) {
 
 	valid = false;
 	GDScriptParser parser;
-	Error err = parser.parse(source, basedir, false, path);
+	Error err = p_tokens ? parser.parse_recorded(p_tokens, basedir, path) : parser.parse(source, basedir, false, path);
 	if (err) {
 		if (ScriptDebugger::get_singleton()) {
 			GDScriptLanguage::get_singleton()->debug_break_parse(get_path(), parser.get_error_line(), "Parser Error: " + parser.get_error());
@@ -566,6 +628,11 @@ Error GDScript::reload(bool p_keep_state) {
 	bool can_run = ScriptServer::is_scripting_enabled() || parser.is_tool_script();
 
 	GDScriptCompiler compiler;
+	compiler.set_debug_code(p_debug_code);
+	if (p_export) {
+		// Exports are compiled in the editor, which has no debugger, for games which may run with one.
+		compiler.set_debug_stack(p_debug_code);
+	}
 	err = compiler.compile(&parser, this, p_keep_state);
 
 	if (err) {
@@ -597,52 +664,7 @@ Error GDScript::reload(bool p_keep_state) {
 		_set_subclass_path(E->get(), path);
 	}
 
-	// Copy the base rpc methods so we don't mask their IDs.
-	rpc_functions.clear();
-	rpc_variables.clear();
-	if (base.is_valid()) {
-		rpc_functions = base->rpc_functions;
-		rpc_variables = base->rpc_variables;
-	}
-
-	GDScript *cscript = this;
-	Map<StringName, Ref<GDScript> >::Element *sub_E = subclasses.front();
-	while (cscript) {
-		// RPC Methods
-		for (Map<StringName, GDScriptFunction *>::Element *E = cscript->member_functions.front(); E; E = E->next()) {
-			if (E->get()->get_rpc_mode() != MultiplayerAPI::RPC_MODE_DISABLED) {
-				ScriptNetData nd;
-				nd.name = E->key();
-				nd.mode = E->get()->get_rpc_mode();
-				if (-1 == rpc_functions.find(nd)) {
-					rpc_functions.push_back(nd);
-				}
-			}
-		}
-		// RSet
-		for (Map<StringName, MemberInfo>::Element *E = cscript->member_indices.front(); E; E = E->next()) {
-			if (E->get().rpc_mode != MultiplayerAPI::RPC_MODE_DISABLED) {
-				ScriptNetData nd;
-				nd.name = E->key();
-				nd.mode = E->get().rpc_mode;
-				if (-1 == rpc_variables.find(nd)) {
-					rpc_variables.push_back(nd);
-				}
-			}
-		}
-
-		if (cscript != this)
-			sub_E = sub_E->next();
-
-		if (sub_E)
-			cscript = sub_E->get().ptr();
-		else
-			cscript = NULL;
-	}
-
-	// Sort so we are 100% that they are always the same.
-	rpc_functions.sort_custom<SortNetData>();
-	rpc_variables.sort_custom<SortNetData>();
+	_update_rpc_methods();
 
 	return OK;
 }
@@ -850,6 +872,27 @@ Error GDScript::load_byte_code(const String &p_path) {
 	ERR_FAIL_COND_V(bytecode.size() == 0, ERR_PARSE_ERROR);
 	path = p_path;
 
+	return load_byte_code_buffer(bytecode);
+}
+
+Error GDScript::load_byte_code_buffer(const Vector<uint8_t> &p_bytecode) {
+
+	Vector<uint8_t> bytecode = p_bytecode;
+
+	if (GDScriptCompiledBuffer::is_compiled_buffer(bytecode)) {
+
+		GDScriptCompiledBuffer compiled;
+		if (compiled.load(this, bytecode) == OK) {
+			_finish_byte_code_load();
+			return OK;
+		}
+
+		// Exported by an incompatible build or missing dependencies, the tokens are still usable.
+		print_verbose("GDScript: Can't load the precompiled code of '" + path + "': " + compiled.get_error() + " Compiling it from tokens.");
+		bytecode = GDScriptCompiledBuffer::get_token_buffer(bytecode);
+		ERR_FAIL_COND_V(bytecode.size() == 0, ERR_PARSE_ERROR);
+	}
+
 	String basedir = path;
 
 	if (basedir == "")
@@ -874,6 +917,12 @@ Error GDScript::load_byte_code(const String &p_path) {
 		ERR_FAIL_V(ERR_COMPILATION_FAILED);
 	}
 
+	_finish_byte_code_load();
+	return OK;
+}
+
+void GDScript::_finish_byte_code_load() {
+
 	valid = true;
 
 	for (Map<StringName, Ref<GDScript> >::Element *E = subclasses.front(); E; E = E->next()) {
@@ -881,17 +930,16 @@ Error GDScript::load_byte_code(const String &p_path) {
 		_set_subclass_path(E->get(), path);
 	}
 
-	return OK;
+	_update_rpc_methods();
 }
 
-Error GDScript::load_source_code(const String &p_path) {
+Error GDScript::_read_source_code(const String &p_path, String &r_source) {
 
 	Vector<uint8_t> sourcef;
 	Error err;
 	FileAccess *f = FileAccess::open(p_path, FileAccess::READ, &err);
 	if (err) {
-
-		ERR_FAIL_COND_V(err, err);
+		return err;
 	}
 
 	int len = f->get_len();
@@ -900,14 +948,23 @@ Error GDScript::load_source_code(const String &p_path) {
 	int r = f->get_buffer(w, len);
 	f->close();
 	memdelete(f);
-	ERR_FAIL_COND_V(r != len, ERR_CANT_OPEN);
+	if (r != len) {
+		return ERR_CANT_OPEN;
+	}
 	w[len] = 0;
 
-	String s;
-	if (s.parse_utf8((const char *)w)) {
-
-		ERR_FAIL_V_MSG(ERR_INVALID_DATA, "Script '" + p_path + "' contains invalid unicode (UTF-8), so it was not loaded. Please ensure that scripts are saved in valid UTF-8 unicode.");
+	if (r_source.parse_utf8((const char *)w)) {
+		return ERR_INVALID_DATA;
 	}
+	return OK;
+}
+
+Error GDScript::load_source_code(const String &p_path) {
+
+	String s;
+	Error err = _read_source_code(p_path, s);
+	ERR_FAIL_COND_V_MSG(err == ERR_INVALID_DATA, err, "Script '" + p_path + "' contains invalid unicode (UTF-8), so it was not loaded. Please ensure that scripts are saved in valid UTF-8 unicode.");
+	ERR_FAIL_COND_V(err, err);
 
 	source = s;
 #ifdef TOOLS_ENABLED
@@ -980,6 +1037,11 @@ GDScript::GDScript() :
 		script_list(this) {
 
 	valid = false;
+#ifdef DEBUG_ENABLED
+	debug_code = true;
+#else
+	debug_code = false;
+#endif
 	subclass_count = 0;
 	initializer = NULL;
 	_base = NULL;
@@ -1034,6 +1096,7 @@ GDScript::~GDScript() {
 	for (Map<StringName, GDScriptFunction *>::Element *E = member_functions.front(); E; E = E->next()) {
 		memdelete(E->get());
 	}
+	GDScriptFunction::invalidate_inline_caches();
 
 	_save_orphaned_subclasses();
 
@@ -1443,15 +1506,38 @@ void GDScriptInstance::reload_members() {
 #endif
 }
 
+bool GDScriptInstance::reset_state() {
+
+	// A new instance has no calls waiting to resume, these would run on the reset one.
+	if (pending_func_states.first()) {
+		return false;
+	}
+
+	// Like _create_instance(): members start out null, and the initializer sets them and runs _init() up the inheritance chain.
+	for (int i = 0; i < members.size(); i++) {
+		members.write[i] = Variant();
+	}
+
+	Callable::CallError ce;
+	script->initializer->call(this, NULL, 0, ce);
+	return ce.error == Callable::CallError::CALL_OK;
+}
+
 GDScriptInstance::GDScriptInstance() {
 	owner = NULL;
 	base_ref = false;
 }
 
 GDScriptInstance::~GDScriptInstance() {
-	if (script.is_valid() && owner) {
-		MutexLock lock(GDScriptLanguage::singleton->lock);
 
+	MutexLock lock(GDScriptLanguage::singleton->lock);
+
+	// The states check the owner is still there when resumed, they only need to leave the list.
+	while (SelfList<GDScriptFunctionState> *E = pending_func_states.first()) {
+		pending_func_states.remove(E);
+	}
+
+	if (script.is_valid() && owner) {
 		script->instances.erase(owner);
 	}
 }
@@ -1532,6 +1618,10 @@ void GDScriptLanguage::init() {
 
 		_add_global(E->get().name, E->get().ptr);
 	}
+
+	if (GLOBAL_GET("debug/gdscript/sampling_profiler/enable")) {
+		sampler->start(GLOBAL_GET("debug/gdscript/sampling_profiler/interval_usec"));
+	}
 }
 
 String GDScriptLanguage::get_type() const {
@@ -1548,6 +1638,18 @@ Error GDScriptLanguage::execute_file(const String &p_path) {
 	return OK;
 }
 void GDScriptLanguage::finish() {
+
+	if (!sampler->is_running()) {
+		return;
+	}
+
+	sampler->stop();
+	sampler->print_profile();
+
+	String output_path = GLOBAL_GET("debug/gdscript/sampling_profiler/output_path");
+	if (output_path != "" && sampler->save_speedscope_profile(output_path) == OK) {
+		print_line("GDScript profile saved to: " + output_path);
+	}
 }
 
 void GDScriptLanguage::profiling_start() {
@@ -1815,6 +1917,10 @@ void GDScriptLanguage::frame() {
 
 	calls = 0;
 
+	if (GDScriptSampler::active) {
+		sampler->drain();
+	}
+
 #ifdef DEBUG_ENABLED
 	if (profiling) {
 		MutexLock lock(this->lock);
@@ -2212,6 +2318,14 @@ GDScriptLanguage::GDScriptLanguage() {
 		_call_stack = NULL;
 	}
 
+	GLOBAL_DEF("debug/gdscript/optimizer/enable", true);
+
+	sampler = memnew(GDScriptSampler);
+	GLOBAL_DEF("debug/gdscript/sampling_profiler/enable", false);
+	GLOBAL_DEF("debug/gdscript/sampling_profiler/interval_usec", 1000);
+	ProjectSettings::get_singleton()->set_custom_property_info("debug/gdscript/sampling_profiler/interval_usec", PropertyInfo(Variant::INT, "debug/gdscript/sampling_profiler/interval_usec", PROPERTY_HINT_RANGE, "100,100000,1,or_greater"));
+	GLOBAL_DEF("debug/gdscript/sampling_profiler/output_path", "user://gdscript_profile.json");
+
 #ifdef DEBUG_ENABLED
 	GLOBAL_DEF("debug/gdscript/warnings/enable", true);
 	GLOBAL_DEF("debug/gdscript/warnings/treat_warnings_as_errors", false);
@@ -2227,6 +2341,9 @@ GDScriptLanguage::GDScriptLanguage() {
 
 GDScriptLanguage::~GDScriptLanguage() {
 
+	memdelete(sampler);
+	GDScriptFunction::clear_frame_pool();
+
 	if (_call_stack) {
 		memdelete_arr(_call_stack);
 	}
@@ -2251,6 +2368,164 @@ Ref<GDScript> GDScriptLanguage::get_orphan_subclass(const String &p_qualified_na
 
 /*************** RESOURCE ***************/
 
+void ResourceFormatLoaderGDScript::_tokenize_script(uint32_t p_index, TokenizeJob *p_job) {
+
+	TokenizedScript &script = p_job->results[p_index];
+	script.tokens = NULL;
+	if (GDScript::_read_source_code(p_job->paths[p_index], script.source) != OK) {
+		return; // Loading it will report the error.
+	}
+
+	script.tokens = memnew(GDScriptTokenizerRecorded);
+	script.tokens->set_code(script.source);
+}
+
+void ResourceFormatLoaderGDScript::_scan_dependencies(const String &p_path, const String &p_source, Set<String> &r_dependencies) {
+
+	// Only looks for what the parser loads: preloads, extended paths and global classes.
+	// A quick scan of the text instead of tokenizing, which is most of the work to save.
+	// Missing some is fine, they'll be tokenized when loaded.
+	const CharType *src = p_source.ptr();
+	int length = p_source.length();
+	int pos = 0;
+	bool extends = false; // Last word was "extends".
+	bool preload = false; // Last word was "preload", maybe followed by "(".
+
+	while (pos < length) {
+
+		CharType c = src[pos];
+
+		if (c == '#') {
+			while (pos < length && src[pos] != '\n') {
+				pos++;
+			}
+			continue;
+		}
+
+		if (c == '"' || c == '\'') {
+			bool triple = pos + 2 < length && src[pos + 1] == c && src[pos + 2] == c;
+			int quotes = triple ? 3 : 1;
+			int begin = pos + quotes;
+			pos = begin;
+			while (pos < length) {
+				if (src[pos] == '\\') {
+					pos += 2;
+				} else if (src[pos] == c && (!triple || (pos + 2 < length && src[pos + 1] == c && src[pos + 2] == c))) {
+					break;
+				} else {
+					pos++;
+				}
+			}
+			if ((extends || preload) && pos < length) {
+				r_dependencies.insert(String(&src[begin], pos - begin));
+			}
+			pos += quotes;
+			extends = false;
+			preload = false;
+			continue;
+		}
+
+		if (c == '_' || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')) {
+			int begin = pos;
+			while (pos < length && (src[pos] == '_' || (src[pos] >= 'a' && src[pos] <= 'z') || (src[pos] >= 'A' && src[pos] <= 'Z') || (src[pos] >= '0' && src[pos] <= '9'))) {
+				pos++;
+			}
+			String word(&src[begin], pos - begin);
+			extends = word == "extends";
+			preload = word == "preload";
+			if (!extends && !preload) {
+				StringName identifier = StringName::search(word); // Global classes are named already.
+				if (identifier != StringName() && ScriptServer::is_global_class(identifier)) {
+					r_dependencies.insert(ScriptServer::get_global_class_path(identifier));
+				}
+			}
+			continue;
+		}
+
+		if (c == '(' && preload) {
+			pos++;
+			continue;
+		}
+
+		if (c != ' ' && c != '\t') {
+			extends = false;
+			preload = false;
+		}
+		pos++;
+	}
+
+	Set<String> scanned = r_dependencies;
+	r_dependencies.clear();
+	for (Set<String>::Element *E = scanned.front(); E; E = E->next()) {
+		String dependency = E->get();
+		if (!dependency.is_abs_path()) {
+			dependency = p_path.get_base_dir().plus_file(dependency);
+		}
+		dependency = dependency.replace("///", "//").simplify_path();
+		if (dependency.get_extension() == "gd" && !ResourceCache::has(dependency) && ResourceLoader::path_remap(dependency) == dependency) {
+			r_dependencies.insert(dependency);
+		}
+	}
+}
+
+void ResourceFormatLoaderGDScript::_tokenize_dependencies(const String &p_path, const String &p_source) {
+
+	Set<String> dependencies;
+	_scan_dependencies(p_path, p_source, dependencies);
+
+	TokenizeJob job;
+	{
+		MutexLock lock(tokenized_lock);
+		for (Set<String>::Element *E = dependencies.front(); E; E = E->next()) {
+			if (!tokenized_scripts.has(E->get()) && !loading_scripts.has(E->get())) {
+				job.paths.push_back(E->get());
+			}
+		}
+	}
+
+	// A single script is tokenized just as fast when it gets loaded.
+	if (job.paths.size() < 2) {
+		return;
+	}
+
+	// Scripts loaded from several threads at once don't wait for the pool, they tokenize on load.
+	bool busy = false;
+	if (!tokenize_pool_busy.compare_exchange_strong(busy, true)) {
+		return;
+	}
+	if (!tokenize_pool_started) {
+		tokenize_pool.init();
+		tokenize_pool_started = true;
+	}
+
+	Vector<TokenizedScript> results;
+	results.resize(job.paths.size());
+	job.results = results.ptrw();
+	tokenize_pool.do_work(job.paths.size(), this, &ResourceFormatLoaderGDScript::_tokenize_script, &job);
+
+	tokenize_pool_busy.store(false);
+
+	MutexLock lock(tokenized_lock);
+	for (int i = 0; i < job.paths.size(); i++) {
+		if (!job.results[i].tokens) {
+			continue;
+		}
+		if (tokenized_scripts.has(job.paths[i])) {
+			memdelete(job.results[i].tokens); // Another thread was faster.
+			continue;
+		}
+		tokenized_scripts[job.paths[i]] = job.results[i];
+	}
+}
+
+void ResourceFormatLoaderGDScript::_clear_tokenized_scripts() {
+
+	for (Map<String, TokenizedScript>::Element *E = tokenized_scripts.front(); E; E = E->next()) {
+		memdelete(E->get().tokens);
+	}
+	tokenized_scripts.clear();
+}
+
 RES ResourceFormatLoaderGDScript::load(const String &p_path, const String &p_original_path, Error *r_error, bool p_use_sub_threads, float *r_progress) {
 
 	if (r_error)
@@ -2268,13 +2543,47 @@ RES ResourceFormatLoaderGDScript::load(const String &p_path, const String &p_ori
 		ERR_FAIL_COND_V_MSG(err != OK, RES(), "Cannot load byte code from file '" + p_path + "'.");
 
 	} else {
-		Error err = script->load_source_code(p_path);
-		ERR_FAIL_COND_V_MSG(err != OK, RES(), "Cannot load source code from file '" + p_path + "'.");
+		GDScriptTokenizerRecorded *tokens = NULL; // Set when tokenized along with the script depending on it.
+		{
+			MutexLock lock(tokenized_lock);
+			Map<String, TokenizedScript>::Element *E = tokenized_scripts.find(p_path);
+			if (E) {
+				script->set_source_code(E->get().source);
+				tokens = E->get().tokens;
+				tokenized_scripts.erase(E);
+			}
+		}
+
+		if (!tokens) {
+			Error err = script->load_source_code(p_path);
+			ERR_FAIL_COND_V_MSG(err != OK, RES(), "Cannot load source code from file '" + p_path + "'.");
+		}
 
 		script->set_script_path(p_original_path); // script needs this.
 		script->set_path(p_original_path);
 
-		script->reload();
+		// Dependencies are only tokenized ahead with threads to spare.
+		bool parallel = OS::get_singleton()->get_processor_count() > 1;
+		if (parallel) {
+			{
+				MutexLock lock(tokenized_lock);
+				loading_scripts.insert(p_path);
+			}
+			_tokenize_dependencies(p_original_path, script->get_source_code());
+		}
+
+		script->_reload(false, tokens);
+		if (tokens) {
+			memdelete(tokens);
+		}
+
+		if (parallel) {
+			MutexLock lock(tokenized_lock);
+			loading_scripts.erase(p_path);
+			if (loading_scripts.empty()) {
+				_clear_tokenized_scripts(); // Not needed after all.
+			}
+		}
 	}
 	if (r_error)
 		*r_error = OK;
@@ -2282,6 +2591,18 @@ RES ResourceFormatLoaderGDScript::load(const String &p_path, const String &p_ori
 	return scriptres;
 }
 
+ResourceFormatLoaderGDScript::ResourceFormatLoaderGDScript() {
+
+	tokenize_pool_busy.store(false);
+	tokenize_pool_started = false;
+}
+
+ResourceFormatLoaderGDScript::~ResourceFormatLoaderGDScript() {
+
+	tokenize_pool.finish();
+	_clear_tokenized_scripts();
+}
+
 void ResourceFormatLoaderGDScript::get_recognized_extensions(List<String> *p_extensions) const {
 
 	p_extensions->push_back("gd");
@@ -34,8 +34,12 @@
 #include "core/io/resource_loader.h"
 #include "core/io/resource_saver.h"
 #include "core/script_language.h"
+#include "core/thread_work_pool.h"
 #include "gdscript_function.h"
 
+class GDScriptSampler;
+class GDScriptTokenizerRecorded;
+
 class GDScriptNativeClass : public Reference {
 
 	GDCLASS(GDScriptNativeClass, Reference);
@@ -58,6 +62,7 @@ class GDScript : public Script {
 	GDCLASS(GDScript, Script);
 	bool tool;
 	bool valid;
+	bool debug_code; // Compiled with line, assert and breakpoint opcodes.
 
 	struct MemberInfo {
 		int index;
@@ -70,8 +75,10 @@ class GDScript : public Script {
 	friend class GDScriptInstance;
 	friend class GDScriptFunction;
 	friend class GDScriptCompiler;
+	friend class GDScriptCompiledBuffer;
 	friend class GDScriptFunctions;
 	friend class GDScriptLanguage;
+	friend class ResourceFormatLoaderGDScript;
 
 	Ref<GDScriptNativeClass> native;
 	Ref<GDScript> base;
@@ -118,6 +125,10 @@ class GDScript : public Script {
 	GDScriptInstance *_create_instance(const Variant **p_args, int p_argcount, Object *p_owner, bool p_isref, Callable::CallError &r_error);
 
 	void _set_subclass_path(Ref<GDScript> &p_sc, const String &p_path);
+	void _update_rpc_methods();
+	Error _reload(bool p_keep_state, GDScriptTokenizerRecorded *p_tokens, bool p_debug_code = true, bool p_export = false);
+	static Error _read_source_code(const String &p_path, String &r_source);
+	void _finish_byte_code_load();
 
 #ifdef TOOLS_ENABLED
 	Set<PlaceHolderScriptInstance *> placeholders;
@@ -185,10 +196,13 @@ public:
 	virtual void update_exports();
 
 	virtual Error reload(bool p_keep_state = false);
+	// Compiles for the build an export targets, release builds don't run debug only code.
+	Error reload_for_export(bool p_debug);
 
 	void set_script_path(const String &p_path) { path = p_path; } //because subclasses need a path too...
 	Error load_source_code(const String &p_path);
 	Error load_byte_code(const String &p_path);
+	Error load_byte_code_buffer(const Vector<uint8_t> &p_bytecode);
 
 	Vector<uint8_t> get_as_byte_code() const;
 
@@ -237,6 +251,7 @@ public:
 class GDScriptInstance : public ScriptInstance {
 	friend class GDScript;
 	friend class GDScriptFunction;
+	friend class GDScriptFunctionState;
 	friend class GDScriptFunctions;
 	friend class GDScriptCompiler;
 
@@ -249,6 +264,8 @@ class GDScriptInstance : public ScriptInstance {
 	Vector<Variant> members;
 	bool base_ref;
 
+	SelfList<GDScriptFunctionState>::List pending_func_states; // Yielded calls not resumed yet.
+
 	void _ml_call_reversed(GDScript *sptr, const StringName &p_method, const Variant **p_args, int p_argcount);
 
 public:
@@ -277,6 +294,7 @@ public:
 	void set_path(const String &p_path);
 
 	void reload_members();
+	virtual bool reset_state();
 
 	virtual Vector<ScriptNetData> get_rpc_methods() const;
 	virtual uint16_t get_rpc_method_id(const StringName &p_method) const;
@@ -368,6 +386,7 @@ class GDScriptLanguage : public ScriptLanguage {
 	void _add_global(const StringName &p_name, const Variant &p_value);
 
 	friend class GDScriptInstance;
+	friend class GDScriptFunctionState;
 
 	Mutex lock;
 
@@ -380,6 +399,8 @@ class GDScriptLanguage : public ScriptLanguage {
 	bool profiling;
 	uint64_t script_frame_time;
 
+	GDScriptSampler *sampler;
+
 	Map<String, ObjectID> orphan_subclasses;
 
 public:
@@ -541,12 +562,43 @@ public:
 };
 
 class ResourceFormatLoaderGDScript : public ResourceFormatLoader {
+
+	// As soon as a script is loaded, the scripts it depends on are read and tokenized in
+	// parallel on a pool kept for it, while parsing, compiling and linking them stays serial.
+	// Entries are consumed when the dependencies get loaded, leftovers are dropped once no
+	// script is loading.
+	struct TokenizedScript {
+		String source;
+		GDScriptTokenizerRecorded *tokens;
+	};
+
+	struct TokenizeJob {
+		Vector<String> paths;
+		TokenizedScript *results;
+	};
+
+	Mutex tokenized_lock;
+	Map<String, TokenizedScript> tokenized_scripts;
+	Set<String> loading_scripts;
+
+	ThreadWorkPool tokenize_pool;
+	std::atomic<bool> tokenize_pool_busy;
+	bool tokenize_pool_started;
+
+	void _tokenize_script(uint32_t p_index, TokenizeJob *p_job);
+	static void _scan_dependencies(const String &p_path, const String &p_source, Set<String> &r_dependencies);
+	void _tokenize_dependencies(const String &p_path, const String &p_source);
+	void _clear_tokenized_scripts();
+
 public:
 	virtual RES load(const String &p_path, const String &p_original_path = "", Error *r_error = NULL, bool p_use_sub_threads = false, float *r_progress = nullptr);
 	virtual void get_recognized_extensions(List<String> *p_extensions) const;
 	virtual bool handles_type(const String &p_type) const;
 	virtual String get_resource_type(const String &p_path) const;
 	virtual void get_dependencies(const String &p_path, List<String> *p_dependencies, bool p_add_types = false);
+
+	ResourceFormatLoaderGDScript();
+	~ResourceFormatLoaderGDScript();
 };
 
 class ResourceFormatSaverGDScript : public ResourceFormatSaver {
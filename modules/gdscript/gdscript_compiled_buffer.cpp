@@ -0,0 +1,1026 @@
+/*************************************************************************/
+/*  gdscript_compiled_buffer.cpp                                         */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2020 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2020 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "gdscript_compiled_buffer.h"
+
+#include "core/io/marshalls.h"
+#include "gdscript_optimizer.h"
+
+void GDScriptCompiledBuffer::_put_u32(uint32_t p_value) {
+
+	int pos = data.size();
+	data.resize(pos + 4);
+	encode_uint32(p_value, &data.write[pos]);
+}
+
+void GDScriptCompiledBuffer::_put_string(const String &p_string) {
+
+	CharString utf8 = p_string.utf8();
+	_put_u32(utf8.length());
+	int pos = data.size();
+	data.resize(pos + utf8.length());
+	for (int i = 0; i < utf8.length(); i++) {
+		data.write[pos + i] = utf8[i];
+	}
+}
+
+void GDScriptCompiledBuffer::_put_name(const StringName &p_name) {
+
+	Map<StringName, int>::Element *E = name_map.find(p_name);
+	if (E) {
+		_put_u32(E->get());
+		return;
+	}
+
+	int index = names.size();
+	name_map[p_name] = index;
+	names.push_back(p_name);
+	_put_u32(index);
+}
+
+bool GDScriptCompiledBuffer::_has_objects(const Variant &p_value) {
+
+	switch (p_value.get_type()) {
+		case Variant::OBJECT: {
+			return true;
+		}
+		case Variant::ARRAY: {
+			Array array = p_value;
+			for (int i = 0; i < array.size(); i++) {
+				if (_has_objects(array[i])) {
+					return true;
+				}
+			}
+		} break;
+		case Variant::DICTIONARY: {
+			Dictionary dict = p_value;
+			List<Variant> keys;
+			dict.get_key_list(&keys);
+			for (List<Variant>::Element *E = keys.front(); E; E = E->next()) {
+				if (_has_objects(E->get()) || _has_objects(dict[E->get()])) {
+					return true;
+				}
+			}
+		} break;
+		default: {
+		}
+	}
+
+	return false;
+}
+
+bool GDScriptCompiledBuffer::_put_variant(const Variant &p_value) {
+
+	if (p_value.get_type() == Variant::OBJECT) {
+
+		Object *obj = p_value.get_validated_object();
+		if (!obj) {
+			_put_u32(VALUE_NULL_OBJECT);
+			return true;
+		}
+
+		GDScriptNativeClass *native = Object::cast_to<GDScriptNativeClass>(obj);
+		if (native) {
+			// Store the name it's registered with as a global, which drops the underscore of wrapped singletons.
+			String name = native->get_name();
+			if (!GDScriptLanguage::get_singleton()->get_global_map().has(name) && name.begins_with("_")) {
+				name = name.substr(1, name.length() - 1);
+			}
+			_put_u32(VALUE_NATIVE_CLASS);
+			_put_name(name);
+			return true;
+		}
+
+		Script *script = Object::cast_to<Script>(obj);
+		if (script) {
+			_put_u32(VALUE_SCRIPT);
+			return _put_script(Ref<Script>(script));
+		}
+
+		Resource *resource = Object::cast_to<Resource>(obj);
+		if (resource && resource->get_path().is_resource_file()) {
+			_put_u32(VALUE_RESOURCE);
+			_put_string(resource->get_path());
+			return true;
+		}
+
+		error = "Constant of type '" + obj->get_class() + "' can't be stored.";
+		return false;
+	}
+
+	if (_has_objects(p_value)) {
+		error = "Constant containing objects can't be stored.";
+		return false;
+	}
+
+	int len;
+	Error err = encode_variant(p_value, NULL, len);
+	if (err != OK) {
+		error = "Constant of type '" + Variant::get_type_name(p_value.get_type()) + "' can't be encoded.";
+		return false;
+	}
+
+	_put_u32(VALUE_VARIANT);
+	_put_u32(len);
+	int pos = data.size();
+	data.resize(pos + len);
+	encode_variant(p_value, &data.write[pos], len);
+	return true;
+}
+
+bool GDScriptCompiledBuffer::_put_script(const Ref<Script> &p_script) {
+
+	if (p_script.is_null()) {
+		_put_u32(SCRIPT_NONE);
+		return true;
+	}
+
+	Ref<GDScript> gdscript = p_script;
+	if (gdscript.is_null()) {
+		if (!p_script->get_path().is_resource_file()) {
+			error = "Reference to a built-in script can't be stored.";
+			return false;
+		}
+		_put_u32(SCRIPT_EXTERNAL);
+		_put_string(p_script->get_path());
+		_put_u32(0);
+		return true;
+	}
+
+	// Inner classes are referenced through the file they're declared in.
+	Vector<StringName> inner;
+	GDScript *file = gdscript.ptr();
+	while (file->_owner) {
+		inner.push_back(file->name);
+		file = file->_owner;
+	}
+	inner.invert();
+
+	if (file == root || (file->path == root_path && root_path != String())) {
+		_put_u32(SCRIPT_LOCAL);
+	} else {
+		if (!file->get_path().is_resource_file()) {
+			error = "Reference to a built-in script can't be stored.";
+			return false;
+		}
+		_put_u32(SCRIPT_EXTERNAL);
+		_put_string(file->get_path());
+	}
+
+	_put_u32(inner.size());
+	for (int i = 0; i < inner.size(); i++) {
+		_put_name(inner[i]);
+	}
+	return true;
+}
+
+bool GDScriptCompiledBuffer::_put_data_type(const GDScriptDataType &p_type) {
+
+	_put_u32(p_type.has_type);
+	_put_u32(p_type.kind);
+	_put_u32(p_type.builtin_type);
+	_put_name(p_type.native_type);
+	return _put_script(p_type.script_type);
+}
+
+bool GDScriptCompiledBuffer::_put_function(const GDScriptFunction *p_function) {
+
+	_put_name(p_function->name);
+	_put_u32(p_function->_static);
+	_put_u32(p_function->rpc_mode);
+	_put_u32(p_function->_argument_count);
+	_put_u32(p_function->_stack_size);
+	_put_u32(p_function->_call_size);
+	_put_u32(p_function->_coroutine);
+	_put_u32(p_function->_inline_cache_count);
+	_put_u32(p_function->_initial_line);
+
+	if (!_put_data_type(p_function->return_type)) {
+		return false;
+	}
+	_put_u32(p_function->argument_types.size());
+	for (int i = 0; i < p_function->argument_types.size(); i++) {
+		if (!_put_data_type(p_function->argument_types[i])) {
+			return false;
+		}
+	}
+
+#ifdef TOOLS_ENABLED
+	_put_u32(p_function->arg_names.size());
+	for (int i = 0; i < p_function->arg_names.size(); i++) {
+		_put_name(p_function->arg_names[i]);
+	}
+#else
+	_put_u32(0);
+#endif
+
+	_put_u32(p_function->constants.size());
+	for (int i = 0; i < p_function->constants.size(); i++) {
+		if (!_put_variant(p_function->constants[i])) {
+			error = "Function '" + String(p_function->name) + "': " + error;
+			return false;
+		}
+	}
+
+	_put_u32(p_function->global_names.size());
+	for (int i = 0; i < p_function->global_names.size(); i++) {
+		_put_name(p_function->global_names[i]);
+	}
+
+	_put_u32(p_function->default_arguments.size());
+	for (int i = 0; i < p_function->default_arguments.size(); i++) {
+		_put_u32(p_function->default_arguments[i]);
+	}
+
+	const Vector<int> &code = p_function->code;
+	_put_u32(code.size());
+	for (int i = 0; i < code.size(); i++) {
+		_put_u32(code[i]);
+	}
+
+	// Global addresses are indices into the global array of the running engine, store their names instead.
+	Vector<int> global_positions;
+	Vector<StringName> global_identifiers;
+	Vector<int> addresses;
+	int ip = 0;
+	while (ip < code.size()) {
+
+		int size = GDScriptOptimizer::get_instruction_size(&code[ip], code.size() - ip);
+		if (!size) {
+			error = "Function '" + String(p_function->name) + "': unknown instruction at " + itos(ip) + ".";
+			return false;
+		}
+
+		GDScriptOptimizer::get_address_positions(&code[ip], size, addresses);
+		for (int i = 0; i < addresses.size(); i++) {
+
+			int address = code[ip + addresses[i]];
+			int index = address & GDScriptFunction::ADDR_MASK;
+			StringName identifier;
+
+			switch ((address & GDScriptFunction::ADDR_TYPE_MASK) >> GDScriptFunction::ADDR_BITS) {
+				case GDScriptFunction::ADDR_TYPE_GLOBAL: {
+					Map<int, StringName>::Element *E = global_names.find(index);
+					ERR_FAIL_COND_V(!E, false);
+					identifier = E->get();
+				} break;
+#ifdef TOOLS_ENABLED
+				case GDScriptFunction::ADDR_TYPE_NAMED_GLOBAL: {
+					ERR_FAIL_INDEX_V(index, p_function->named_globals.size(), false);
+					identifier = p_function->named_globals[index];
+				} break;
+#endif
+				default: {
+					continue;
+				}
+			}
+
+			global_positions.push_back(ip + addresses[i]);
+			global_identifiers.push_back(identifier);
+		}
+
+		ip += size;
+	}
+
+	_put_u32(global_positions.size());
+	for (int i = 0; i < global_positions.size(); i++) {
+		_put_u32(global_positions[i]);
+		_put_name(global_identifiers[i]);
+	}
+
+	_put_u32(p_function->stack_debug.size());
+	for (const List<GDScriptFunction::StackDebug>::Element *E = p_function->stack_debug.front(); E; E = E->next()) {
+		_put_u32(E->get().line);
+		_put_u32(E->get().pos);
+		_put_u32(E->get().added);
+		_put_name(E->get().identifier);
+	}
+
+	return true;
+}
+
+bool GDScriptCompiledBuffer::_put_class(const GDScript *p_class) {
+
+	_put_u32(p_class->tool);
+	_put_name(p_class->name);
+
+	if (p_class->native.is_valid()) {
+		if (!_put_variant(p_class->native)) {
+			return false;
+		}
+	} else {
+		_put_u32(VALUE_NULL_OBJECT);
+	}
+	if (!_put_script(p_class->base)) {
+		return false;
+	}
+
+	_put_u32(p_class->members.size());
+	for (const Set<StringName>::Element *E = p_class->members.front(); E; E = E->next()) {
+		_put_name(E->get());
+	}
+
+	// Inherited members are included, so the base doesn't have to be loaded first.
+	_put_u32(p_class->member_indices.size());
+	for (const Map<StringName, GDScript::MemberInfo>::Element *E = p_class->member_indices.front(); E; E = E->next()) {
+		_put_name(E->key());
+		_put_u32(E->get().index);
+		_put_name(E->get().setter);
+		_put_name(E->get().getter);
+		_put_u32(E->get().rpc_mode);
+		if (!_put_data_type(E->get().data_type)) {
+			return false;
+		}
+	}
+
+	_put_u32(p_class->member_info.size());
+	for (const Map<StringName, PropertyInfo>::Element *E = p_class->member_info.front(); E; E = E->next()) {
+		_put_name(E->key());
+		_put_variant(Dictionary(E->get()));
+	}
+
+	_put_u32(p_class->constants.size());
+	for (const Map<StringName, Variant>::Element *E = p_class->constants.front(); E; E = E->next()) {
+		_put_name(E->key());
+		if (!_put_variant(E->get())) {
+			error = "Constant '" + String(E->key()) + "': " + error;
+			return false;
+		}
+	}
+
+	_put_u32(p_class->_signals.size());
+	for (const Map<StringName, Vector<StringName> >::Element *E = p_class->_signals.front(); E; E = E->next()) {
+		_put_name(E->key());
+		_put_u32(E->get().size());
+		for (int i = 0; i < E->get().size(); i++) {
+			_put_name(E->get()[i]);
+		}
+	}
+
+	_put_u32(p_class->member_functions.size());
+	for (const Map<StringName, GDScriptFunction *>::Element *E = p_class->member_functions.front(); E; E = E->next()) {
+		if (!_put_function(E->get())) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void GDScriptCompiledBuffer::_put_class_tree(GDScript *p_class) {
+
+	classes.push_back(p_class);
+
+	_put_u32(p_class->subclasses.size());
+	for (Map<StringName, Ref<GDScript> >::Element *E = p_class->subclasses.front(); E; E = E->next()) {
+		_put_name(E->key());
+		_put_class_tree(E->get().ptr());
+	}
+}
+
+uint32_t GDScriptCompiledBuffer::_get_u32() {
+
+	if (read_pos + 4 > read_size) {
+		read_error = true;
+		return 0;
+	}
+
+	uint32_t value = decode_uint32(&read_ptr[read_pos]);
+	read_pos += 4;
+	return value;
+}
+
+String GDScriptCompiledBuffer::_get_string() {
+
+	uint32_t len = _get_u32();
+	if (len > uint32_t(read_size - read_pos)) {
+		read_error = true;
+		return String();
+	}
+
+	String string;
+	string.parse_utf8((const char *)&read_ptr[read_pos], len);
+	read_pos += len;
+	return string;
+}
+
+StringName GDScriptCompiledBuffer::_get_name() {
+
+	uint32_t index = _get_u32();
+	if (index >= uint32_t(names.size())) {
+		read_error = true;
+		return StringName();
+	}
+
+	return names[index];
+}
+
+bool GDScriptCompiledBuffer::_get_variant(Variant &r_value) {
+
+	switch (_get_u32()) {
+		case VALUE_VARIANT: {
+			uint32_t len = _get_u32();
+			if (read_error || len > uint32_t(read_size - read_pos)) {
+				read_error = true;
+				return false;
+			}
+			Error err = decode_variant(r_value, &read_ptr[read_pos], len);
+			read_pos += len;
+			return err == OK;
+		}
+		case VALUE_NULL_OBJECT: {
+			r_value = Variant((Object *)NULL);
+			return true;
+		}
+		case VALUE_NATIVE_CLASS: {
+			StringName name = _get_name();
+			const Map<StringName, int> &global_map = GDScriptLanguage::get_singleton()->get_global_map();
+			const Map<StringName, int>::Element *E = global_map.find(name);
+			if (!E) {
+				error = "Native class '" + String(name) + "' not found.";
+				return false;
+			}
+			r_value = GDScriptLanguage::get_singleton()->get_global_array()[E->get()];
+			return true;
+		}
+		case VALUE_SCRIPT: {
+			Ref<Script> script;
+			if (!_get_script(script)) {
+				return false;
+			}
+			r_value = script;
+			return true;
+		}
+		case VALUE_RESOURCE: {
+			String path = _get_string();
+			if (read_error) {
+				return false;
+			}
+			RES resource = ResourceLoader::load(path);
+			if (resource.is_null()) {
+				error = "Can't load resource '" + path + "'.";
+				return false;
+			}
+			r_value = resource;
+			return true;
+		}
+		default: {
+			read_error = true;
+			return false;
+		}
+	}
+}
+
+bool GDScriptCompiledBuffer::_get_script(Ref<Script> &r_script) {
+
+	GDScript *file = NULL;
+
+	switch (_get_u32()) {
+		case SCRIPT_NONE: {
+			r_script = Ref<Script>();
+			return true;
+		}
+		case SCRIPT_LOCAL: {
+			file = root;
+		} break;
+		case SCRIPT_EXTERNAL: {
+			String path = _get_string();
+			if (read_error) {
+				return false;
+			}
+			r_script = ResourceLoader::load(path);
+			if (r_script.is_null()) {
+				error = "Can't load script '" + path + "'.";
+				return false;
+			}
+			file = Object::cast_to<GDScript>(r_script.ptr());
+		} break;
+		default: {
+			read_error = true;
+			return false;
+		}
+	}
+
+	uint32_t inner_count = _get_u32();
+	if (!inner_count) {
+		if (file == root) {
+			r_script = Ref<Script>(root);
+		}
+		return !read_error;
+	}
+
+	GDScript *script = file;
+	for (uint32_t i = 0; i < inner_count && script; i++) {
+		StringName name = _get_name();
+		Map<StringName, Ref<GDScript> >::Element *E = script->subclasses.find(name);
+		script = E ? E->get().ptr() : NULL;
+	}
+
+	if (!script || read_error) {
+		error = "Inner class not found.";
+		return false;
+	}
+
+	r_script = Ref<Script>(script);
+	return true;
+}
+
+bool GDScriptCompiledBuffer::_get_data_type(GDScriptDataType &r_type) {
+
+	r_type.has_type = _get_u32();
+	switch (_get_u32()) {
+		case GDScriptDataType::UNINITIALIZED: {
+			r_type.kind = GDScriptDataType::UNINITIALIZED;
+		} break;
+		case GDScriptDataType::BUILTIN: {
+			r_type.kind = GDScriptDataType::BUILTIN;
+		} break;
+		case GDScriptDataType::NATIVE: {
+			r_type.kind = GDScriptDataType::NATIVE;
+		} break;
+		case GDScriptDataType::SCRIPT: {
+			r_type.kind = GDScriptDataType::SCRIPT;
+		} break;
+		case GDScriptDataType::GDSCRIPT: {
+			r_type.kind = GDScriptDataType::GDSCRIPT;
+		} break;
+		default: {
+			read_error = true;
+			return false;
+		}
+	}
+	r_type.builtin_type = Variant::Type(_get_u32());
+	r_type.native_type = _get_name();
+	return _get_script(r_type.script_type) && !read_error;
+}
+
+bool GDScriptCompiledBuffer::_get_function(GDScript *p_class, GDScriptFunction *r_function) {
+
+	r_function->name = _get_name();
+	r_function->_static = _get_u32();
+	r_function->rpc_mode = MultiplayerAPI::RPCMode(_get_u32());
+	r_function->_argument_count = _get_u32();
+	r_function->_stack_size = _get_u32();
+	r_function->_call_size = _get_u32();
+	r_function->_coroutine = _get_u32();
+	int inline_cache_count = _get_u32();
+	r_function->_initial_line = _get_u32();
+
+	if (!_get_data_type(r_function->return_type)) {
+		return false;
+	}
+	uint32_t argument_count = _get_u32();
+	if (read_error || argument_count > uint32_t(read_size - read_pos)) {
+		return false;
+	}
+	r_function->argument_types.resize(argument_count);
+	for (uint32_t i = 0; i < argument_count; i++) {
+		if (!_get_data_type(r_function->argument_types.write[i])) {
+			return false;
+		}
+	}
+
+	uint32_t arg_name_count = _get_u32();
+	for (uint32_t i = 0; i < arg_name_count && !read_error; i++) {
+#ifdef TOOLS_ENABLED
+		r_function->arg_names.push_back(_get_name());
+#else
+		_get_name();
+#endif
+	}
+
+	uint32_t constant_count = _get_u32();
+	if (read_error || constant_count > uint32_t(read_size - read_pos)) {
+		return false;
+	}
+	r_function->constants.resize(constant_count);
+	for (uint32_t i = 0; i < constant_count; i++) {
+		if (!_get_variant(r_function->constants.write[i])) {
+			return false;
+		}
+	}
+
+	uint32_t global_name_count = _get_u32();
+	if (read_error || global_name_count > uint32_t(read_size - read_pos)) {
+		return false;
+	}
+	r_function->global_names.resize(global_name_count);
+	for (uint32_t i = 0; i < global_name_count; i++) {
+		r_function->global_names.write[i] = _get_name();
+	}
+
+	uint32_t default_argument_count = _get_u32();
+	if (read_error || default_argument_count > uint32_t(read_size - read_pos)) {
+		return false;
+	}
+	r_function->default_arguments.resize(default_argument_count);
+	for (uint32_t i = 0; i < default_argument_count; i++) {
+		r_function->default_arguments.write[i] = _get_u32();
+	}
+
+	uint32_t code_size = _get_u32();
+	if (read_error || code_size > uint32_t(read_size - read_pos) / 4) {
+		return false;
+	}
+	r_function->code.resize(code_size);
+	int *code = r_function->code.ptrw();
+	for (uint32_t i = 0; i < code_size; i++) {
+		code[i] = _get_u32();
+	}
+
+	const Map<StringName, int> &global_map = GDScriptLanguage::get_singleton()->get_global_map();
+	uint32_t global_count = _get_u32();
+	for (uint32_t i = 0; i < global_count && !read_error; i++) {
+
+		uint32_t position = _get_u32();
+		StringName identifier = _get_name();
+		if (position >= code_size) {
+			read_error = true;
+			break;
+		}
+
+		const Map<StringName, int>::Element *E = global_map.find(identifier);
+		if (E) {
+			code[position] = E->get() | (GDScriptFunction::ADDR_TYPE_GLOBAL << GDScriptFunction::ADDR_BITS);
+			continue;
+		}
+
+#ifdef TOOLS_ENABLED
+		// Autoloads are only named globals while editing.
+		if (GDScriptLanguage::get_singleton()->get_named_globals_map().has(identifier)) {
+			int index = r_function->named_globals.find(identifier);
+			if (index == -1) {
+				index = r_function->named_globals.size();
+				r_function->named_globals.push_back(identifier);
+			}
+			code[position] = index | (GDScriptFunction::ADDR_TYPE_NAMED_GLOBAL << GDScriptFunction::ADDR_BITS);
+			continue;
+		}
+#endif
+
+		error = "Identifier not found: " + String(identifier);
+		return false;
+	}
+
+	uint32_t stack_debug_count = _get_u32();
+	for (uint32_t i = 0; i < stack_debug_count && !read_error; i++) {
+		GDScriptFunction::StackDebug sd;
+		sd.line = _get_u32();
+		sd.pos = _get_u32();
+		sd.added = _get_u32();
+		sd.identifier = _get_name();
+		r_function->stack_debug.push_back(sd);
+	}
+
+	if (read_error) {
+		return false;
+	}
+
+	r_function->_constant_count = r_function->constants.size();
+	r_function->_constants_ptr = r_function->_constant_count ? r_function->constants.ptrw() : NULL;
+	r_function->_global_names_count = r_function->global_names.size();
+	r_function->_global_names_ptr = r_function->_global_names_count ? r_function->global_names.ptr() : NULL;
+#ifdef TOOLS_ENABLED
+	r_function->_named_globals_count = r_function->named_globals.size();
+	r_function->_named_globals_ptr = r_function->_named_globals_count ? r_function->named_globals.ptr() : NULL;
+#endif
+	r_function->_code_size = r_function->code.size();
+	r_function->_code_ptr = r_function->_code_size ? r_function->code.ptr() : NULL;
+	r_function->_default_arg_count = r_function->default_arguments.size() ? r_function->default_arguments.size() - 1 : 0;
+	r_function->_default_arg_ptr = r_function->default_arguments.size() ? r_function->default_arguments.ptr() : NULL;
+
+	if (inline_cache_count) {
+		r_function->_inline_cache_count = inline_cache_count;
+		r_function->_inline_caches = memnew_arr(GDScriptFunction::InlineCache, inline_cache_count);
+		for (int i = 0; i < inline_cache_count; i++) {
+			r_function->_inline_caches[i].epoch = 0;
+		}
+	}
+
+	r_function->_script = p_class;
+	r_function->source = root->get_path();
+
+	if (!r_function->_validate_code()) {
+		return false;
+	}
+
+#ifdef DEBUG_ENABLED
+	if (ScriptDebugger::get_singleton()) {
+		String signature = root->get_path() + "::" + itos(r_function->_initial_line);
+		if (p_class->name != StringName()) {
+			signature += "::" + String(p_class->name) + "." + String(r_function->name);
+		} else {
+			signature += "::" + String(r_function->name);
+		}
+		r_function->profile.signature = signature;
+	}
+
+	r_function->func_cname = (String(r_function->source) + " - " + String(r_function->name)).utf8();
+	r_function->_func_cname = r_function->func_cname.get_data();
+#endif
+
+	return true;
+}
+
+bool GDScriptCompiledBuffer::_get_class(GDScript *p_class) {
+
+	p_class->tool = _get_u32();
+	p_class->name = _get_name();
+
+	Variant native;
+	if (!_get_variant(native)) {
+		return false;
+	}
+	p_class->native = native;
+
+	Ref<Script> base;
+	if (!_get_script(base)) {
+		return false;
+	}
+	p_class->base = base;
+	p_class->_base = p_class->base.ptr();
+	if (base.is_valid() != p_class->base.is_valid() || (base.is_null() && p_class->native.is_null())) {
+		error = "Invalid inheritance.";
+		return false;
+	}
+
+	uint32_t count = _get_u32();
+	for (uint32_t i = 0; i < count && !read_error; i++) {
+		p_class->members.insert(_get_name());
+	}
+
+	count = _get_u32();
+	for (uint32_t i = 0; i < count && !read_error; i++) {
+		StringName name = _get_name();
+		GDScript::MemberInfo minfo;
+		minfo.index = _get_u32();
+		if (minfo.index < 0 || minfo.index >= (int)count) {
+			error = "Invalid member index.";
+			return false;
+		}
+		minfo.setter = _get_name();
+		minfo.getter = _get_name();
+		minfo.rpc_mode = MultiplayerAPI::RPCMode(_get_u32());
+		if (!_get_data_type(minfo.data_type)) {
+			return false;
+		}
+		p_class->member_indices[name] = minfo;
+	}
+
+	count = _get_u32();
+	for (uint32_t i = 0; i < count && !read_error; i++) {
+		StringName name = _get_name();
+		Variant info;
+		if (!_get_variant(info)) {
+			return false;
+		}
+		p_class->member_info[name] = PropertyInfo::from_dict(info);
+	}
+
+	count = _get_u32();
+	for (uint32_t i = 0; i < count && !read_error; i++) {
+		StringName name = _get_name();
+		Variant value;
+		if (!_get_variant(value)) {
+			return false;
+		}
+		p_class->constants[name] = value;
+	}
+
+	count = _get_u32();
+	for (uint32_t i = 0; i < count && !read_error; i++) {
+		StringName name = _get_name();
+		uint32_t argument_count = _get_u32();
+		Vector<StringName> arguments;
+		for (uint32_t j = 0; j < argument_count && !read_error; j++) {
+			arguments.push_back(_get_name());
+		}
+		p_class->_signals[name] = arguments;
+	}
+
+	count = _get_u32();
+	for (uint32_t i = 0; i < count && !read_error; i++) {
+		GDScriptFunction *function = memnew(GDScriptFunction);
+		if (!_get_function(p_class, function)) {
+			memdelete(function);
+			return false;
+		}
+		if (p_class->member_functions.has(function->name)) {
+			memdelete(p_class->member_functions[function->name]);
+		}
+		p_class->member_functions[function->name] = function;
+#ifdef TOOLS_ENABLED
+		p_class->member_lines[function->name] = function->_initial_line;
+#endif
+	}
+
+	if (p_class->member_functions.has("_init")) {
+		p_class->initializer = p_class->member_functions["_init"];
+	}
+
+	return !read_error;
+}
+
+void GDScriptCompiledBuffer::_get_class_tree(GDScript *p_class) {
+
+	classes.push_back(p_class);
+	p_class->subclasses.clear();
+
+	uint32_t count = _get_u32();
+	for (uint32_t i = 0; i < count && !read_error; i++) {
+
+		StringName name = _get_name();
+
+		Ref<GDScript> subclass;
+		subclass.instance();
+		subclass->_owner = p_class;
+		subclass->fully_qualified_name = p_class->fully_qualified_name + "::" + name;
+		p_class->subclasses.insert(name, subclass);
+
+		_get_class_tree(subclass.ptr());
+	}
+}
+
+bool GDScriptCompiledBuffer::is_compiled_buffer(const Vector<uint8_t> &p_buffer) {
+
+	return p_buffer.size() >= HEADER_SIZE && p_buffer[0] == 'G' && p_buffer[1] == 'D' && p_buffer[2] == 'S' && p_buffer[3] == 'P';
+}
+
+Vector<uint8_t> GDScriptCompiledBuffer::get_token_buffer(const Vector<uint8_t> &p_buffer) {
+
+	ERR_FAIL_COND_V(!is_compiled_buffer(p_buffer), Vector<uint8_t>());
+
+	uint32_t token_size = decode_uint32(&p_buffer[16]);
+	ERR_FAIL_COND_V(token_size > uint32_t(p_buffer.size() - HEADER_SIZE), Vector<uint8_t>());
+
+	return p_buffer.subarray(HEADER_SIZE, HEADER_SIZE + token_size - 1);
+}
+
+Vector<uint8_t> GDScriptCompiledBuffer::save(const Ref<GDScript> &p_script, const Vector<uint8_t> &p_token_buffer) {
+
+	ERR_FAIL_COND_V(p_script.is_null() || !p_script->is_valid(), Vector<uint8_t>());
+	ERR_FAIL_COND_V(p_token_buffer.empty(), Vector<uint8_t>());
+
+	root = const_cast<GDScript *>(p_script.ptr());
+	root_path = root->path;
+	classes.clear();
+	error = String();
+	data.clear();
+	names.clear();
+	name_map.clear();
+	global_names.clear();
+
+	const Map<StringName, int> &global_map = GDScriptLanguage::get_singleton()->get_global_map();
+	for (const Map<StringName, int>::Element *E = global_map.front(); E; E = E->next()) {
+		global_names[E->get()] = E->key();
+	}
+
+	_put_class_tree(root);
+	for (int i = 0; i < classes.size(); i++) {
+		if (!_put_class(classes[i])) {
+			return Vector<uint8_t>();
+		}
+	}
+
+	Vector<uint8_t> payload = data;
+	data.clear();
+
+	data.resize(4);
+	data.write[0] = 'G';
+	data.write[1] = 'D';
+	data.write[2] = 'S';
+	data.write[3] = 'P';
+	_put_u32(FORMAT_VERSION);
+	_put_u32(GDScriptFunction::OPCODE_END);
+	_put_u32(root->debug_code ? FLAG_DEBUG_CODE : 0);
+	_put_u32(p_token_buffer.size());
+	data.append_array(p_token_buffer);
+
+	_put_u32(names.size());
+	for (int i = 0; i < names.size(); i++) {
+		_put_string(names[i]);
+	}
+
+	data.append_array(payload);
+
+	Vector<uint8_t> result = data;
+	data.clear();
+	return result;
+}
+
+Error GDScriptCompiledBuffer::load(GDScript *p_script, const Vector<uint8_t> &p_buffer) {
+
+	ERR_FAIL_COND_V(!p_script, ERR_INVALID_PARAMETER);
+	ERR_FAIL_COND_V(!is_compiled_buffer(p_buffer), ERR_INVALID_DATA);
+
+	root = p_script;
+	classes.clear();
+	error = String();
+	names.clear();
+
+	read_ptr = p_buffer.ptr();
+	read_size = p_buffer.size();
+	read_pos = 4;
+	read_error = false;
+
+	if (_get_u32() != FORMAT_VERSION || _get_u32() != GDScriptFunction::OPCODE_END) {
+		error = "Compiled with an incompatible engine version.";
+		return ERR_FILE_UNRECOGNIZED;
+	}
+
+	// Debug builds need the line opcodes for errors and the debugger, release builds must not run asserts.
+	bool debug_code = _get_u32() & FLAG_DEBUG_CODE;
+#ifdef DEBUG_ENABLED
+	if (!debug_code) {
+		error = "Compiled for release builds.";
+		return ERR_FILE_UNRECOGNIZED;
+	}
+#else
+	if (debug_code) {
+		error = "Compiled for debug builds.";
+		return ERR_FILE_UNRECOGNIZED;
+	}
+#endif
+
+	uint32_t token_size = _get_u32();
+	if (token_size > uint32_t(read_size - read_pos)) {
+		return ERR_FILE_CORRUPT;
+	}
+	read_pos += token_size;
+
+	uint32_t name_count = _get_u32();
+	if (read_error || name_count > uint32_t(read_size - read_pos)) {
+		return ERR_FILE_CORRUPT;
+	}
+	names.resize(name_count);
+	for (uint32_t i = 0; i < name_count; i++) {
+		names.write[i] = _get_string();
+	}
+
+	p_script->fully_qualified_name = p_script->path;
+	p_script->_owner = NULL;
+	_get_class_tree(p_script);
+
+	bool ok = !read_error;
+	for (int i = 0; i < classes.size() && ok; i++) {
+		ok = _get_class(classes[i]);
+	}
+
+	if (!ok) {
+		// Leave the script empty, so it can still be compiled from the tokens.
+		for (int i = 0; i < classes.size(); i++) {
+			for (Map<StringName, GDScriptFunction *>::Element *E = classes[i]->member_functions.front(); E; E = E->next()) {
+				memdelete(E->get());
+			}
+			classes[i]->member_functions.clear();
+			classes[i]->initializer = NULL;
+		}
+		p_script->subclasses.clear();
+		if (error.empty()) {
+			error = "Corrupt compiled script data.";
+		}
+		return read_error ? ERR_FILE_CORRUPT : ERR_CANT_RESOLVE;
+	}
+
+	for (int i = 0; i < classes.size(); i++) {
+		classes[i]->valid = true;
+	}
+
+	return OK;
+}
+
+GDScriptCompiledBuffer::GDScriptCompiledBuffer() {
+
+	root = NULL;
+	read_ptr = NULL;
+	read_size = 0;
+	read_pos = 0;
+	read_error = false;
+}
@@ -0,0 +1,116 @@
+/*************************************************************************/
+/*  gdscript_compiled_buffer.h                                           */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2020 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2020 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+
+#ifndef GDSCRIPT_COMPILED_BUFFER_H
+#define GDSCRIPT_COMPILED_BUFFER_H
+
+#include "gdscript.h"
+
+// Serialized form of a compiled script and its inner classes, so exported projects
+// can skip parsing and compiling at load time. The token buffer of the script is
+// stored alongside, and used instead when the compiled data can't be loaded by this
+// build (format changes, missing globals or dependencies).
+class GDScriptCompiledBuffer {
+
+	enum {
+		FORMAT_VERSION = 3,
+		HEADER_SIZE = 20,
+	};
+
+	enum Flags {
+		FLAG_DEBUG_CODE = 1, // Has line, assert and breakpoint opcodes, only loaded by debug builds.
+	};
+
+	enum ValueType {
+		VALUE_VARIANT,
+		VALUE_NULL_OBJECT,
+		VALUE_NATIVE_CLASS,
+		VALUE_SCRIPT,
+		VALUE_RESOURCE,
+	};
+
+	enum ScriptReference {
+		SCRIPT_NONE,
+		SCRIPT_LOCAL, // The file being loaded or one of its inner classes.
+		SCRIPT_EXTERNAL,
+	};
+
+	GDScript *root;
+	String root_path;
+	Vector<GDScript *> classes; // Root and inner classes, in the order they are stored.
+	String error;
+
+	Vector<uint8_t> data;
+	Vector<StringName> names;
+	Map<StringName, int> name_map;
+	Map<int, StringName> global_names;
+
+	const uint8_t *read_ptr;
+	int read_size;
+	int read_pos;
+	bool read_error;
+
+	void _put_u32(uint32_t p_value);
+	void _put_string(const String &p_string);
+	void _put_name(const StringName &p_name);
+	bool _put_variant(const Variant &p_value);
+	bool _put_script(const Ref<Script> &p_script);
+	bool _put_data_type(const GDScriptDataType &p_type);
+	bool _put_function(const GDScriptFunction *p_function);
+	bool _put_class(const GDScript *p_class);
+	void _put_class_tree(GDScript *p_class);
+
+	uint32_t _get_u32();
+	String _get_string();
+	StringName _get_name();
+	bool _get_variant(Variant &r_value);
+	bool _get_script(Ref<Script> &r_script);
+	bool _get_data_type(GDScriptDataType &r_type);
+	bool _get_function(GDScript *p_class, GDScriptFunction *r_function);
+	bool _get_class(GDScript *p_class);
+	void _get_class_tree(GDScript *p_class);
+
+	static bool _has_objects(const Variant &p_value);
+
+public:
+	static bool is_compiled_buffer(const Vector<uint8_t> &p_buffer);
+	static Vector<uint8_t> get_token_buffer(const Vector<uint8_t> &p_buffer);
+
+	// Returns an empty buffer if the script references something that can't be stored.
+	Vector<uint8_t> save(const Ref<GDScript> &p_script, const Vector<uint8_t> &p_token_buffer);
+	Error load(GDScript *p_script, const Vector<uint8_t> &p_buffer);
+
+	const String &get_error() const { return error; }
+
+	GDScriptCompiledBuffer();
+};
+
+#endif // GDSCRIPT_COMPILED_BUFFER_H
@@ -30,7 +30,9 @@
 
 #include "gdscript_compiler.h"
 
+#include "core/project_settings.h"
 #include "gdscript.h"
+#include "gdscript_optimizer.h"
 
 bool GDScriptCompiler::_is_class_member_property(CodeGen &codegen, const StringName &p_name) {
 
@@ -74,6 +76,68 @@ void GDScriptCompiler::_set_error(const String &p_error, const GDScriptParser::N
 	}
 }
 
+// Picks a type specialized instruction for operators whose operand types the parser could infer.
+// The VM still checks the actual types, so a wrong guess only costs going through the generic path.
+static GDScriptFunction::Opcode _get_operator_opcode(Variant::Operator p_op, const GDScriptParser::DataType &p_a, const GDScriptParser::DataType &p_b) {
+
+	if (!p_a.has_type || !p_b.has_type || p_a.is_meta_type || p_b.is_meta_type || p_a.kind != GDScriptParser::DataType::BUILTIN || p_b.kind != GDScriptParser::DataType::BUILTIN) {
+		return GDScriptFunction::OPCODE_OPERATOR;
+	}
+
+	switch (p_op) {
+		case Variant::OP_NOT:
+		case Variant::OP_AND:
+		case Variant::OP_OR:
+		case Variant::OP_XOR:
+		case Variant::OP_IN:
+			return GDScriptFunction::OPCODE_OPERATOR;
+		default:
+			break;
+	}
+
+	const Variant::Type a = p_a.builtin_type;
+	const Variant::Type b = p_b.builtin_type;
+	const bool number_a = a == Variant::INT || a == Variant::FLOAT;
+	const bool number_b = b == Variant::INT || b == Variant::FLOAT;
+
+	if (a == Variant::INT && b == Variant::INT) {
+		return GDScriptFunction::OPCODE_OPERATOR_INT;
+	}
+	if (number_a && number_b) {
+		return GDScriptFunction::OPCODE_OPERATOR_FLOAT;
+	}
+	if ((a == Variant::VECTOR2 && (b == Variant::VECTOR2 || number_b)) || (number_a && b == Variant::VECTOR2)) {
+		return GDScriptFunction::OPCODE_OPERATOR_VECTOR2;
+	}
+	if ((a == Variant::VECTOR3 && (b == Variant::VECTOR3 || number_b)) || (number_a && b == Variant::VECTOR3)) {
+		return GDScriptFunction::OPCODE_OPERATOR_VECTOR3;
+	}
+	return GDScriptFunction::OPCODE_OPERATOR;
+}
+
+// Whether indexing p_base with p_index can use the typed array get/set instructions.
+static bool _is_indexed_array_access(const GDScriptParser::DataType &p_base, const GDScriptParser::DataType &p_index) {
+
+	if (!p_base.has_type || !p_index.has_type || p_base.is_meta_type || p_base.kind != GDScriptParser::DataType::BUILTIN || p_index.kind != GDScriptParser::DataType::BUILTIN || p_index.builtin_type != Variant::INT) {
+		return false;
+	}
+
+	switch (p_base.builtin_type) {
+		case Variant::ARRAY:
+		case Variant::PACKED_BYTE_ARRAY:
+		case Variant::PACKED_INT32_ARRAY:
+		case Variant::PACKED_INT64_ARRAY:
+		case Variant::PACKED_FLOAT32_ARRAY:
+		case Variant::PACKED_FLOAT64_ARRAY:
+		case Variant::PACKED_VECTOR2_ARRAY:
+		case Variant::PACKED_VECTOR3_ARRAY:
+		case Variant::PACKED_COLOR_ARRAY:
+			return true;
+		default:
+			return false;
+	}
+}
+
 bool GDScriptCompiler::_create_unary_operator(CodeGen &codegen, const GDScriptParser::OperatorNode *on, Variant::Operator op, int p_stack_level) {
 
 	ERR_FAIL_COND_V(on->arguments.size() != 1, false);
@@ -82,7 +146,8 @@ bool GDScriptCompiler::_create_unary_operator(CodeGen &codegen, const GDScriptPa
 	if (src_address_a < 0)
 		return false;
 
-	codegen.opcodes.push_back(GDScriptFunction::OPCODE_OPERATOR); // perform operator
+	const GDScriptParser::DataType &type_a = on->arguments[0]->get_datatype();
+	codegen.opcodes.push_back(_get_operator_opcode(op, type_a, type_a)); // perform operator
 	codegen.opcodes.push_back(op); //which operator
 	codegen.opcodes.push_back(src_address_a); // argument 1
 	codegen.opcodes.push_back(src_address_a); // argument 2 (repeated)
@@ -104,7 +169,7 @@ bool GDScriptCompiler::_create_binary_operator(CodeGen &codegen, const GDScriptP
 	if (src_address_b < 0)
 		return false;
 
-	codegen.opcodes.push_back(GDScriptFunction::OPCODE_OPERATOR); // perform operator
+	codegen.opcodes.push_back(_get_operator_opcode(op, on->arguments[0]->get_datatype(), on->arguments[1]->get_datatype())); // perform operator
 	codegen.opcodes.push_back(op); //which operator
 	codegen.opcodes.push_back(src_address_a); // argument 1
 	codegen.opcodes.push_back(src_address_b); // argument 2 (unary only takes one parameter)
@@ -659,8 +724,12 @@ int GDScriptCompiler::_parse_expression(CodeGen &codegen, const GDScriptParser::
 						codegen.opcodes.push_back(p_root ? GDScriptFunction::OPCODE_CALL : GDScriptFunction::OPCODE_CALL_RETURN); // perform operator
 						codegen.opcodes.push_back(on->arguments.size() - 2);
 						codegen.alloc_call(on->arguments.size() - 2);
-						for (int i = 0; i < arguments.size(); i++)
+						for (int i = 0; i < arguments.size(); i++) {
 							codegen.opcodes.push_back(arguments[i]);
+							if (i == 1) {
+								codegen.opcodes.push_back(codegen.alloc_inline_cache()); // after base and method name
+							}
+						}
 					}
 				} break;
 				case GDScriptParser::OperatorNode::OP_YIELD: {
@@ -681,6 +750,8 @@ int GDScriptCompiler::_parse_expression(CodeGen &codegen, const GDScriptParser::
 						arguments.push_back(ret);
 					}
 
+					codegen.has_yield = true;
+
 					//push call bytecode
 					codegen.opcodes.push_back(arguments.size() == 0 ? GDScriptFunction::OPCODE_YIELD : GDScriptFunction::OPCODE_YIELD_SIGNAL); // basic type constructor
 					for (int i = 0; i < arguments.size(); i++)
@@ -749,9 +820,18 @@ int GDScriptCompiler::_parse_expression(CodeGen &codegen, const GDScriptParser::
 						}
 					}
 
-					codegen.opcodes.push_back(named ? GDScriptFunction::OPCODE_GET_NAMED : GDScriptFunction::OPCODE_GET); // perform operator
+					if (named) {
+						codegen.opcodes.push_back(GDScriptFunction::OPCODE_GET_NAMED); // perform operator
+					} else if (_is_indexed_array_access(on->arguments[0]->get_datatype(), on->arguments[1]->get_datatype())) {
+						codegen.opcodes.push_back(GDScriptFunction::OPCODE_GET_INDEXED_ARRAY);
+					} else {
+						codegen.opcodes.push_back(GDScriptFunction::OPCODE_GET);
+					}
 					codegen.opcodes.push_back(from); // argument 1
 					codegen.opcodes.push_back(index); // argument 2 (unary only takes one parameter)
+					if (named) {
+						codegen.opcodes.push_back(codegen.alloc_inline_cache());
+					}
 
 				} break;
 				case GDScriptParser::OperatorNode::OP_AND: {
@@ -1054,6 +1134,9 @@ int GDScriptCompiler::_parse_expression(CodeGen &codegen, const GDScriptParser::
 							codegen.opcodes.push_back(named ? GDScriptFunction::OPCODE_GET_NAMED : GDScriptFunction::OPCODE_GET);
 							codegen.opcodes.push_back(prev_pos);
 							codegen.opcodes.push_back(key_idx);
+							if (named) {
+								codegen.opcodes.push_back(codegen.alloc_inline_cache());
+							}
 							slevel++;
 							codegen.alloc_stack(slevel);
 							int dst_pos = (GDScriptFunction::ADDR_TYPE_STACK << GDScriptFunction::ADDR_BITS) | slevel;
@@ -1063,6 +1146,9 @@ int GDScriptCompiler::_parse_expression(CodeGen &codegen, const GDScriptParser::
 							//add in reverse order, since it will be reverted
 
 							setchain.push_back(dst_pos);
+							if (named) {
+								setchain.push_back(codegen.alloc_inline_cache());
+							}
 							setchain.push_back(key_idx);
 							setchain.push_back(prev_pos);
 							setchain.push_back(named ? GDScriptFunction::OPCODE_SET_NAMED : GDScriptFunction::OPCODE_SET);
@@ -1097,9 +1183,18 @@ int GDScriptCompiler::_parse_expression(CodeGen &codegen, const GDScriptParser::
 						if (set_value < 0) //error
 							return set_value;
 
-						codegen.opcodes.push_back(named ? GDScriptFunction::OPCODE_SET_NAMED : GDScriptFunction::OPCODE_SET);
+						if (named) {
+							codegen.opcodes.push_back(GDScriptFunction::OPCODE_SET_NAMED);
+						} else if (_is_indexed_array_access(op->arguments[0]->get_datatype(), op->arguments[1]->get_datatype())) {
+							codegen.opcodes.push_back(GDScriptFunction::OPCODE_SET_INDEXED_ARRAY);
+						} else {
+							codegen.opcodes.push_back(GDScriptFunction::OPCODE_SET);
+						}
 						codegen.opcodes.push_back(prev_pos);
 						codegen.opcodes.push_back(set_index);
+						if (named) {
+							codegen.opcodes.push_back(codegen.alloc_inline_cache());
+						}
 						codegen.opcodes.push_back(set_value);
 
 						for (int i = 0; i < setchain.size(); i++) {
@@ -1275,8 +1370,10 @@ Error GDScriptCompiler::_parse_block(CodeGen &codegen, const GDScriptParser::Blo
 			case GDScriptParser::Node::TYPE_NEWLINE: {
 #ifdef DEBUG_ENABLED
 				const GDScriptParser::NewLineNode *nl = static_cast<const GDScriptParser::NewLineNode *>(s);
-				codegen.opcodes.push_back(GDScriptFunction::OPCODE_LINE);
-				codegen.opcodes.push_back(nl->line);
+				if (debug_code) {
+					codegen.opcodes.push_back(GDScriptFunction::OPCODE_LINE);
+					codegen.opcodes.push_back(nl->line);
+				}
 				codegen.current_line = nl->line;
 #endif
 			} break;
@@ -1514,6 +1611,10 @@ Error GDScriptCompiler::_parse_block(CodeGen &codegen, const GDScriptParser::Blo
 			} break;
 			case GDScriptParser::Node::TYPE_ASSERT: {
 #ifdef DEBUG_ENABLED
+				if (!debug_code) {
+					break; // The condition isn't evaluated either.
+				}
+
 				// try subblocks
 
 				const GDScriptParser::AssertNode *as = static_cast<const GDScriptParser::AssertNode *>(s);
@@ -1537,7 +1638,9 @@ Error GDScriptCompiler::_parse_block(CodeGen &codegen, const GDScriptParser::Blo
 			case GDScriptParser::Node::TYPE_BREAKPOINT: {
 #ifdef DEBUG_ENABLED
 				// try subblocks
-				codegen.opcodes.push_back(GDScriptFunction::OPCODE_BREAKPOINT);
+				if (debug_code) {
+					codegen.opcodes.push_back(GDScriptFunction::OPCODE_BREAKPOINT);
+				}
 #endif
 			} break;
 			case GDScriptParser::Node::TYPE_LOCAL_VAR: {
@@ -1579,7 +1682,9 @@ Error GDScriptCompiler::_parse_function(GDScript *p_script, const GDScriptParser
 	codegen.stack_max = 0;
 	codegen.current_line = 0;
 	codegen.call_max = 0;
-	codegen.debug_stack = ScriptDebugger::get_singleton() != NULL;
+	codegen.inline_cache_max = 0;
+	codegen.has_yield = false;
+	codegen.debug_stack = debug_stack;
 	Vector<StringName> argnames;
 
 	int stack_level = 0;
@@ -1738,6 +1843,14 @@ Error GDScriptCompiler::_parse_function(GDScript *p_script, const GDScriptParser
 	}
 #endif
 
+	int stack_size = codegen.stack_max;
+	if (optimize && codegen.opcodes.size()) {
+		GDScriptOptimizer optimizer;
+		optimizer.optimize(codegen.opcodes, gdfunc->constants, defarg_addr, codegen.stack_debug, p_func ? p_func->arguments.size() : 0, stack_size);
+		gdfunc->_constant_count = gdfunc->constants.size();
+		gdfunc->_constants_ptr = gdfunc->_constant_count ? gdfunc->constants.ptrw() : NULL;
+	}
+
 	if (codegen.opcodes.size()) {
 
 		gdfunc->code = codegen.opcodes;
@@ -1761,8 +1874,16 @@ Error GDScriptCompiler::_parse_function(GDScript *p_script, const GDScriptParser
 	}
 
 	gdfunc->_argument_count = p_func ? p_func->arguments.size() : 0;
-	gdfunc->_stack_size = codegen.stack_max;
+	gdfunc->_stack_size = stack_size;
 	gdfunc->_call_size = codegen.call_max;
+	gdfunc->_coroutine = codegen.has_yield;
+	if (codegen.inline_cache_max) {
+		gdfunc->_inline_cache_count = codegen.inline_cache_max;
+		gdfunc->_inline_caches = memnew_arr(GDScriptFunction::InlineCache, codegen.inline_cache_max);
+		for (int i = 0; i < codegen.inline_cache_max; i++) {
+			gdfunc->_inline_caches[i].epoch = 0;
+		}
+	}
 	gdfunc->name = func_name;
 #ifdef DEBUG_ENABLED
 	if (ScriptDebugger::get_singleton()) {
@@ -1815,6 +1936,11 @@ Error GDScriptCompiler::_parse_function(GDScript *p_script, const GDScriptParser
 	if (is_initializer)
 		p_script->initializer = gdfunc;
 
+	if (!gdfunc->_validate_code()) {
+		_set_error("Compiler bug: invalid bytecode generated for function '" + String(func_name) + "'.", p_func);
+		return ERR_BUG;
+	}
+
 	return OK;
 }
 
@@ -1846,6 +1972,7 @@ Error GDScriptCompiler::_parse_class_level(GDScript *p_script, const GDScriptPar
 	}
 	p_script->member_functions.clear();
 	p_script->member_indices.clear();
+	GDScriptFunction::invalidate_inline_caches();
 	p_script->member_info.clear();
 	p_script->_signals.clear();
 	p_script->initializer = NULL;
@@ -2155,6 +2282,8 @@ Error GDScriptCompiler::compile(const GDScriptParser *p_parser, GDScript *p_scri
 	ERR_FAIL_COND_V(root->type != GDScriptParser::Node::TYPE_CLASS, ERR_INVALID_DATA);
 
 	source = p_script->get_path();
+	optimize = GLOBAL_GET("debug/gdscript/optimizer/enable");
+	p_script->debug_code = debug_code;
 
 	// The best fully qualified name for a base level script is its file path
 	p_script->fully_qualified_name = p_script->path;
@@ -2176,6 +2305,18 @@ Error GDScriptCompiler::compile(const GDScriptParser *p_parser, GDScript *p_scri
 	return OK;
 }
 
+void GDScriptCompiler::set_debug_code(bool p_enable) {
+
+#ifdef DEBUG_ENABLED
+	debug_code = p_enable;
+#endif
+}
+
+void GDScriptCompiler::set_debug_stack(bool p_enable) {
+
+	debug_stack = p_enable;
+}
+
 String GDScriptCompiler::get_error() const {
 
 	return error;
@@ -2190,4 +2331,12 @@ int GDScriptCompiler::get_error_column() const {
 }
 
 GDScriptCompiler::GDScriptCompiler() {
+
+	optimize = false;
+#ifdef DEBUG_ENABLED
+	debug_code = true;
+#else
+	debug_code = false;
+#endif
+	debug_stack = ScriptDebugger::get_singleton() != NULL;
 }
@@ -128,10 +128,15 @@ class GDScriptCompiler {
 		void alloc_call(int p_params) {
 			if (p_params >= call_max) call_max = p_params;
 		}
+		int alloc_inline_cache() {
+			return inline_cache_max++;
+		}
 
 		int current_line;
 		int stack_max;
 		int call_max;
+		int inline_cache_max;
+		bool has_yield;
 	};
 
 	bool _is_class_member_property(CodeGen &codegen, const StringName &p_name);
@@ -155,10 +160,18 @@ class GDScriptCompiler {
 	int err_column;
 	StringName source;
 	String error;
+	bool optimize;
+	bool debug_code;
+	bool debug_stack;
 
 public:
 	Error compile(const GDScriptParser *p_parser, GDScript *p_script, bool p_keep_state = false);
 
+	// Line, assert and breakpoint opcodes, only generated by debug builds. Disabled when exporting for release.
+	void set_debug_code(bool p_enable);
+	// Local variable names for the debugger, by default only kept when running with one.
+	void set_debug_stack(bool p_enable);
+
 	String get_error() const;
 	int get_error_line() const;
 	int get_error_column() const;
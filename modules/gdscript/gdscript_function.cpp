@@ -30,9 +30,14 @@
 
 #include "gdscript_function.h"
 
+#include "core/core_string_names.h"
 #include "core/os/os.h"
+#include "core/safe_refcount.h"
+#include "core/variant_internal.h"
 #include "gdscript.h"
 #include "gdscript_functions.h"
+#include "gdscript_optimizer.h"
+#include "gdscript_sampler.h"
 
 Variant *GDScriptFunction::_get_variant(int p_address, GDScriptInstance *p_instance, GDScript *p_script, Variant &self, Variant &static_ref, Variant *p_stack, String &r_error) const {
 
@@ -61,6 +66,11 @@ Variant *GDScriptFunction::_get_variant(int p_address, GDScriptInstance *p_insta
 				return NULL;
 			}
 #endif
+			// The instance may not match the script this function was compiled for, or may have been reloaded.
+			if (unlikely(address >= p_instance->members.size())) {
+				r_error = "Member index out of bounds.";
+				return NULL;
+			}
 			//member indexing is O(1)
 			return &p_instance->members.write[address];
 		} break;
@@ -190,14 +200,709 @@ String GDScriptFunction::_get_call_error(const Callable::CallError &p_err, const
 	return err_text;
 }
 
+uint32_t GDScriptFunction::inline_cache_epoch = 1;
+
+void GDScriptFunction::invalidate_inline_caches() {
+
+	if (atomic_increment(&inline_cache_epoch) == 0) {
+		// Epoch 0 marks never used caches, skip it on wrap around.
+		atomic_increment(&inline_cache_epoch);
+	}
+}
+
+BinaryMutex GDScriptFunction::frame_pool_mutex;
+uint8_t *GDScriptFunction::frame_pool[FRAME_POOL_CLASSES] = {};
+uint32_t GDScriptFunction::frame_pool_free[FRAME_POOL_CLASSES] = {};
+
+static _FORCE_INLINE_ int _get_frame_class(uint32_t p_size) {
+
+	int frame_class = 0;
+	while ((64u << frame_class) < p_size) {
+		frame_class++;
+	}
+	return frame_class;
+}
+
+uint8_t *GDScriptFunction::_alloc_frame(uint32_t p_size) {
+
+	int frame_class = _get_frame_class(p_size);
+	if (frame_class >= FRAME_POOL_CLASSES) {
+		return (uint8_t *)memalloc(p_size);
+	}
+
+	{
+		MutexLock lock(frame_pool_mutex);
+		uint8_t *frame = frame_pool[frame_class];
+		if (frame) {
+			// Free frames are linked through their first bytes.
+			frame_pool[frame_class] = *(uint8_t **)frame;
+			frame_pool_free[frame_class]--;
+			return frame;
+		}
+	}
+
+	return (uint8_t *)memalloc(64u << frame_class);
+}
+
+void GDScriptFunction::_free_frame(uint8_t *p_frame, uint32_t p_size) {
+
+	int frame_class = _get_frame_class(p_size);
+	if (frame_class < FRAME_POOL_CLASSES) {
+		MutexLock lock(frame_pool_mutex);
+		if (frame_pool_free[frame_class] < (FRAME_POOL_MAX_BYTES >> 6 >> frame_class)) {
+			*(uint8_t **)p_frame = frame_pool[frame_class];
+			frame_pool[frame_class] = p_frame;
+			frame_pool_free[frame_class]++;
+			return;
+		}
+	}
+
+	memfree(p_frame);
+}
+
+void GDScriptFunction::clear_frame_pool() {
+
+	MutexLock lock(frame_pool_mutex);
+	for (int i = 0; i < FRAME_POOL_CLASSES; i++) {
+		while (frame_pool[i]) {
+			uint8_t *frame = frame_pool[i];
+			frame_pool[i] = *(uint8_t **)frame;
+			memfree(frame);
+		}
+		frame_pool_free[i] = 0;
+	}
+}
+
+#if defined(PTRCALL_ENABLED) && defined(DEBUG_METHODS_ENABLED)
+#define MAX_PTRCALL_ARGS 8
+#endif
+
+static bool _can_ptrcall(MethodBind *p_method) {
+
+#if defined(PTRCALL_ENABLED) && defined(DEBUG_METHODS_ENABLED)
+	if (p_method->is_vararg() || p_method->get_argument_count() > MAX_PTRCALL_ARGS) {
+		return false;
+	}
+	for (int i = -1; i < p_method->get_argument_count(); i++) {
+		if (!VariantInternal::is_ptrcall_type(p_method->get_argument_type(i))) {
+			return false;
+		}
+	}
+	// Enums and ObjectID are both INT without metadata but are encoded with different widths.
+	if (p_method->has_return() && p_method->get_argument_type(-1) == Variant::INT && p_method->get_argument_meta(-1) == GodotTypeInfo::METADATA_NONE) {
+		return false;
+	}
+	return true;
+#else
+	// Argument types are only known with method debug info.
+	return false;
+#endif
+}
+
+bool GDScriptFunction::_inline_cache_resolve(InlineCache::Entry &r_entry, InlineCacheSite p_site, Object *p_object, GDScriptInstance *p_instance, const StringName &p_name) {
+
+	if (p_site == INLINE_CACHE_CALL) {
+
+		if (p_name == CoreStringNames::get_singleton()->_free) {
+			return false; // Object::call() handles this one before anything else.
+		}
+
+		for (GDScript *sptr = p_instance ? p_instance->script.ptr() : NULL; sptr; sptr = sptr->_base) {
+			Map<StringName, GDScriptFunction *>::Element *E = sptr->member_functions.find(p_name);
+			if (E) {
+				r_entry.kind = InlineCache::KIND_SCRIPT_FUNCTION;
+				r_entry.function = E->get();
+				return true;
+			}
+		}
+
+		MethodBind *method = ClassDB::get_method(p_object->get_class_name(), p_name);
+		if (!method) {
+			return false;
+		}
+		r_entry.kind = InlineCache::KIND_NATIVE_METHOD;
+		r_entry.method = method;
+		r_entry.ptrcall = _can_ptrcall(method);
+		return true;
+	}
+
+	if (p_instance) {
+		GDScript *script = p_instance->script.ptr();
+
+		const Map<StringName, GDScript::MemberInfo>::Element *E = script->member_indices.find(p_name);
+		if (E) {
+			// Members with setget run script code and may fail over, leave them to the instance.
+			if ((p_site == INLINE_CACHE_GET && E->get().getter) || (p_site == INLINE_CACHE_SET && E->get().setter)) {
+				return false;
+			}
+			r_entry.kind = InlineCache::KIND_SCRIPT_MEMBER;
+			r_entry.index = E->get().index;
+			r_entry.member_type = &E->get().data_type;
+			return true;
+		}
+
+		// Anything the script could answer dynamically can't be cached as a native property.
+		const StringName &handler = p_site == INLINE_CACHE_GET ? GDScriptLanguage::get_singleton()->strings._get : GDScriptLanguage::get_singleton()->strings._set;
+		for (const GDScript *sptr = script; sptr; sptr = sptr->_base) {
+			if (sptr->member_functions.has(handler) || (p_site == INLINE_CACHE_GET && sptr->constants.has(p_name))) {
+				return false;
+			}
+		}
+	}
+
+	MethodBind *setter = NULL;
+	MethodBind *getter = NULL;
+	int index = -1;
+	if (!ClassDB::get_property_binds(p_object->get_class_name(), p_name, setter, getter, index)) {
+		return false;
+	}
+
+	if (p_site == INLINE_CACHE_GET) {
+		// Indexed getters go through Object::call(), so only plain binds are cached.
+		if (!getter || index >= 0) {
+			return false;
+		}
+		r_entry.method = getter;
+	} else {
+		if (!setter) {
+			return false;
+		}
+		r_entry.method = setter;
+	}
+	r_entry.kind = InlineCache::KIND_NATIVE_METHOD;
+	r_entry.index = index;
+	r_entry.ptrcall = index < 0 && _can_ptrcall(r_entry.method);
+	return true;
+}
+
+const GDScriptFunction::InlineCache::Entry *GDScriptFunction::_inline_cache_lookup(InlineCache *p_cache, InlineCacheSite p_site, const Variant *p_base, const StringName &p_name, Object *&r_object, GDScriptInstance *&r_instance) {
+
+	if (!p_cache || p_base->get_type() != Variant::OBJECT) {
+		return NULL;
+	}
+
+	Object *obj = p_base->operator Object *();
+#ifdef DEBUG_ENABLED
+	// Same check Variant does before calling into objects, freed ones go through the regular path to get reported.
+	if (obj && ScriptDebugger::get_singleton() && !p_base->is_ref()) {
+		obj = p_base->get_validated_object();
+	}
+#endif
+	if (!obj) {
+		return NULL; // Let the regular path report it.
+	}
+
+	GDScriptInstance *instance = NULL;
+	const GDScript *script = NULL;
+	ScriptInstance *si = obj->get_script_instance();
+	if (si) {
+		if (si->is_placeholder() || si->get_language() != GDScriptLanguage::get_singleton()) {
+			return NULL;
+		}
+		instance = static_cast<GDScriptInstance *>(si);
+		script = instance->script.ptr();
+	}
+
+	const void *native_class = obj->get_class_name().data_unique_pointer();
+
+	if (p_cache->epoch != inline_cache_epoch) {
+		p_cache->epoch = inline_cache_epoch;
+		p_cache->count = 0;
+		p_cache->failures = 0;
+		p_cache->next = 0;
+	}
+
+	r_object = obj;
+	r_instance = instance;
+
+	for (int i = 0; i < p_cache->count; i++) {
+		const InlineCache::Entry &entry = p_cache->entries[i];
+		if (entry.native_class == native_class && entry.script == script) {
+			return &entry;
+		}
+	}
+
+	if (p_cache->failures >= InlineCache::MAX_FAILURES) {
+		return NULL;
+	}
+
+	InlineCache::Entry entry;
+	entry.native_class = native_class;
+	entry.script = script;
+	entry.index = -1;
+	entry.ptrcall = false;
+	if (!_inline_cache_resolve(entry, p_site, obj, instance, p_name)) {
+		p_cache->failures++;
+		return NULL;
+	}
+
+	uint32_t slot;
+	if (p_cache->count < InlineCache::MAX_ENTRIES) {
+		slot = p_cache->count++;
+	} else {
+		// Polymorphic site with more receivers than entries, rotate.
+		slot = p_cache->next;
+		p_cache->next = (p_cache->next + 1) % InlineCache::MAX_ENTRIES;
+	}
+	p_cache->entries[slot] = entry;
+	return &p_cache->entries[slot];
+}
+
+bool GDScriptFunction::_inline_cache_ptrcall(MethodBind *p_method, Object *p_object, const Variant **p_args, int p_argcount, Variant &r_ret) {
+
+#if defined(PTRCALL_ENABLED) && defined(DEBUG_METHODS_ENABLED)
+	if (p_argcount != p_method->get_argument_count()) {
+		return false; // Default arguments are filled in by MethodBind::call().
+	}
+
+	const void *argptrs[MAX_PTRCALL_ARGS];
+	for (int i = 0; i < p_argcount; i++) {
+		Variant *arg = const_cast<Variant *>(p_args[i]);
+		Variant::Type type = p_method->get_argument_type(i);
+		if (type == Variant::NIL) {
+			argptrs[i] = arg;
+		} else if (arg->get_type() == type) {
+			argptrs[i] = VariantInternal::get_inline_pointer(arg);
+		} else {
+			return false; // Needs a conversion.
+		}
+	}
+
+	// r_ret must not alias the arguments, it's reset to the return type before the call.
+	p_method->ptrcall(p_object, argptrs, VariantInternal::initialize_inline(&r_ret, p_method->get_argument_type(-1)));
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool GDScriptFunction::_inline_cache_call(InlineCache *p_cache, const Variant *p_base, const StringName &p_method, const Variant **p_args, int p_argcount, Variant *r_ret, Callable::CallError &r_err) {
+
+	Object *obj;
+	GDScriptInstance *instance;
+	const InlineCache::Entry *entry = _inline_cache_lookup(p_cache, INLINE_CACHE_CALL, p_base, p_method, obj, instance);
+	if (!entry) {
+		return false;
+	}
+
+	r_err.error = Callable::CallError::CALL_OK;
+
+	Variant ret;
+	{
+#ifdef DEBUG_ENABLED
+		_ObjectDebugLock debug_lock(obj);
+#endif
+		if (entry->kind == InlineCache::KIND_SCRIPT_FUNCTION) {
+			ret = entry->function->call(instance, p_args, p_argcount, r_err);
+		} else if (!entry->ptrcall || !_inline_cache_ptrcall(entry->method, obj, p_args, p_argcount, ret)) {
+			ret = entry->method->call(obj, p_args, p_argcount, r_err);
+		}
+	}
+
+	if (r_ret) {
+		*r_ret = ret;
+	}
+	return true;
+}
+
+bool GDScriptFunction::_inline_cache_get(InlineCache *p_cache, const Variant *p_base, const StringName &p_name, Variant &r_ret) {
+
+	Object *obj;
+	GDScriptInstance *instance;
+	const InlineCache::Entry *entry = _inline_cache_lookup(p_cache, INLINE_CACHE_GET, p_base, p_name, obj, instance);
+	if (!entry) {
+		return false;
+	}
+
+	if (entry->kind == InlineCache::KIND_SCRIPT_MEMBER) {
+		// r_ret may be the base itself, copy first so the instance stays alive while reading.
+		Variant value = instance->members[entry->index];
+		r_ret = value;
+	} else if (entry->ptrcall) {
+		Variant value;
+		_inline_cache_ptrcall(entry->method, obj, NULL, 0, value);
+		r_ret = value;
+	} else {
+		Callable::CallError ce;
+		r_ret = entry->method->call(obj, NULL, 0, ce);
+	}
+	return true;
+}
+
+bool GDScriptFunction::_inline_cache_set(InlineCache *p_cache, const Variant *p_base, const StringName &p_name, const Variant &p_value, bool &r_valid) {
+
+	Object *obj;
+	GDScriptInstance *instance;
+	const InlineCache::Entry *entry = _inline_cache_lookup(p_cache, INLINE_CACHE_SET, p_base, p_name, obj, instance);
+	if (!entry) {
+		return false;
+	}
+
+	if (entry->kind == InlineCache::KIND_SCRIPT_MEMBER) {
+		if (!entry->member_type->is_type(p_value)) {
+			return false; // Needs a conversion, which the instance takes care of.
+		}
+		obj->_mark_edited();
+		instance->members.write[entry->index] = p_value;
+		r_valid = true;
+		return true;
+	}
+
+	obj->_mark_edited();
+
+	if (entry->ptrcall) {
+		const Variant *args[1] = { &p_value };
+		Variant ret;
+		if (_inline_cache_ptrcall(entry->method, obj, args, 1, ret)) {
+			r_valid = true;
+			return true;
+		}
+	}
+
+	Callable::CallError ce;
+	ce.error = Callable::CallError::CALL_OK;
+	if (entry->index >= 0) {
+		Variant index = entry->index;
+		const Variant *args[2] = { &index, &p_value };
+		entry->method->call(obj, args, 2, ce);
+	} else {
+		const Variant *args[1] = { &p_value };
+		entry->method->call(obj, args, 1, ce);
+	}
+	r_valid = ce.error == Callable::CallError::CALL_OK;
+	return true;
+}
+
+// Fast paths for the type specialized instructions the compiler emits when it knows the operand types.
+// They return false whenever the operands turn out to be something else, or the operation has to
+// report an error (like a division by zero), so the caller can fall back to the generic instruction.
+
+static _FORCE_INLINE_ bool _evaluate_int(Variant::Operator p_op, const Variant *p_a, const Variant *p_b, Variant *r_dst) {
+
+	if (unlikely(p_a->get_type() != Variant::INT || p_b->get_type() != Variant::INT)) {
+		return false;
+	}
+
+	const int64_t a = *VariantInternal::get_int(p_a);
+	const int64_t b = *VariantInternal::get_int(p_b);
+
+	switch (p_op) {
+		case Variant::OP_EQUAL: VariantInternal::set_bool(r_dst, a == b); return true;
+		case Variant::OP_NOT_EQUAL: VariantInternal::set_bool(r_dst, a != b); return true;
+		case Variant::OP_LESS: VariantInternal::set_bool(r_dst, a < b); return true;
+		case Variant::OP_LESS_EQUAL: VariantInternal::set_bool(r_dst, a <= b); return true;
+		case Variant::OP_GREATER: VariantInternal::set_bool(r_dst, a > b); return true;
+		case Variant::OP_GREATER_EQUAL: VariantInternal::set_bool(r_dst, a >= b); return true;
+		case Variant::OP_ADD: VariantInternal::set_int(r_dst, a + b); return true;
+		case Variant::OP_SUBTRACT: VariantInternal::set_int(r_dst, a - b); return true;
+		case Variant::OP_MULTIPLY: VariantInternal::set_int(r_dst, a * b); return true;
+		case Variant::OP_DIVIDE: {
+			if (b == 0) {
+				return false;
+			}
+			VariantInternal::set_int(r_dst, a / b);
+			return true;
+		}
+		case Variant::OP_MODULE: {
+			if (b == 0) {
+				return false;
+			}
+			VariantInternal::set_int(r_dst, a % b);
+			return true;
+		}
+		case Variant::OP_NEGATE: VariantInternal::set_int(r_dst, -a); return true;
+		case Variant::OP_POSITIVE: VariantInternal::set_int(r_dst, a); return true;
+		case Variant::OP_SHIFT_LEFT: {
+			if (b < 0 || b >= 64) {
+				return false;
+			}
+			VariantInternal::set_int(r_dst, a << b);
+			return true;
+		}
+		case Variant::OP_SHIFT_RIGHT: {
+			if (b < 0 || b >= 64) {
+				return false;
+			}
+			VariantInternal::set_int(r_dst, a >> b);
+			return true;
+		}
+		case Variant::OP_BIT_AND: VariantInternal::set_int(r_dst, a & b); return true;
+		case Variant::OP_BIT_OR: VariantInternal::set_int(r_dst, a | b); return true;
+		case Variant::OP_BIT_XOR: VariantInternal::set_int(r_dst, a ^ b); return true;
+		case Variant::OP_BIT_NEGATE: VariantInternal::set_int(r_dst, ~a); return true;
+		default: return false;
+	}
+}
+
+static _FORCE_INLINE_ bool _evaluate_float(Variant::Operator p_op, const Variant *p_a, const Variant *p_b, Variant *r_dst) {
+
+	const Variant::Type type_a = p_a->get_type();
+	const Variant::Type type_b = p_b->get_type();
+	// Mixed int and float operands promote to float, two ints are integer math.
+	if (unlikely((type_a != Variant::FLOAT && type_a != Variant::INT) || (type_b != Variant::FLOAT && type_b != Variant::INT) || (type_a == Variant::INT && type_b == Variant::INT))) {
+		return false;
+	}
+
+	const double a = VariantInternal::get_number(p_a);
+	const double b = VariantInternal::get_number(p_b);
+
+	switch (p_op) {
+		case Variant::OP_EQUAL: VariantInternal::set_bool(r_dst, a == b); return true;
+		case Variant::OP_NOT_EQUAL: VariantInternal::set_bool(r_dst, a != b); return true;
+		case Variant::OP_LESS: VariantInternal::set_bool(r_dst, a < b); return true;
+		case Variant::OP_LESS_EQUAL: VariantInternal::set_bool(r_dst, a <= b); return true;
+		case Variant::OP_GREATER: VariantInternal::set_bool(r_dst, a > b); return true;
+		case Variant::OP_GREATER_EQUAL: VariantInternal::set_bool(r_dst, a >= b); return true;
+		case Variant::OP_ADD: VariantInternal::set_float(r_dst, a + b); return true;
+		case Variant::OP_SUBTRACT: VariantInternal::set_float(r_dst, a - b); return true;
+		case Variant::OP_MULTIPLY: VariantInternal::set_float(r_dst, a * b); return true;
+		case Variant::OP_DIVIDE: {
+			if (b == 0) {
+				return false;
+			}
+			VariantInternal::set_float(r_dst, a / b);
+			return true;
+		}
+		case Variant::OP_NEGATE: VariantInternal::set_float(r_dst, -a); return true;
+		case Variant::OP_POSITIVE: VariantInternal::set_float(r_dst, a); return true;
+		default: return false;
+	}
+}
+
+template <class T>
+static _FORCE_INLINE_ const T &_get_vector(const Variant *p_v);
+template <>
+_FORCE_INLINE_ const Vector2 &_get_vector<Vector2>(const Variant *p_v) { return *VariantInternal::get_vector2(p_v); }
+template <>
+_FORCE_INLINE_ const Vector3 &_get_vector<Vector3>(const Variant *p_v) { return *VariantInternal::get_vector3(p_v); }
+
+static _FORCE_INLINE_ void _set_vector(Variant *r_v, const Vector2 &p_value) { VariantInternal::set_vector2(r_v, p_value); }
+static _FORCE_INLINE_ void _set_vector(Variant *r_v, const Vector3 &p_value) { VariantInternal::set_vector3(r_v, p_value); }
+
+template <class T, Variant::Type V>
+static _FORCE_INLINE_ bool _evaluate_vector(Variant::Operator p_op, const Variant *p_a, const Variant *p_b, Variant *r_dst) {
+
+	const Variant::Type type_a = p_a->get_type();
+	const Variant::Type type_b = p_b->get_type();
+
+	if (type_a == V && type_b == V) {
+		const T a = _get_vector<T>(p_a);
+		const T b = _get_vector<T>(p_b);
+		switch (p_op) {
+			case Variant::OP_EQUAL: VariantInternal::set_bool(r_dst, a == b); return true;
+			case Variant::OP_NOT_EQUAL: VariantInternal::set_bool(r_dst, a != b); return true;
+			case Variant::OP_ADD: _set_vector(r_dst, a + b); return true;
+			case Variant::OP_SUBTRACT: _set_vector(r_dst, a - b); return true;
+			case Variant::OP_MULTIPLY: _set_vector(r_dst, a * b); return true;
+			case Variant::OP_DIVIDE: _set_vector(r_dst, a / b); return true;
+			case Variant::OP_NEGATE: _set_vector(r_dst, -a); return true;
+			case Variant::OP_POSITIVE: _set_vector(r_dst, a); return true;
+			default: return false;
+		}
+	}
+
+	if (type_a == V && (type_b == Variant::FLOAT || type_b == Variant::INT)) {
+		const T a = _get_vector<T>(p_a);
+		const real_t b = VariantInternal::get_number(p_b);
+		switch (p_op) {
+			case Variant::OP_MULTIPLY: _set_vector(r_dst, a * b); return true;
+			case Variant::OP_DIVIDE: _set_vector(r_dst, a / b); return true;
+			default: return false;
+		}
+	}
+
+	if ((type_a == Variant::FLOAT || type_a == Variant::INT) && type_b == V && p_op == Variant::OP_MULTIPLY) {
+		_set_vector(r_dst, _get_vector<T>(p_b) * real_t(VariantInternal::get_number(p_a)));
+		return true;
+	}
+
+	return false;
+}
+
+// Indexing with an int into Array and the numeric packed arrays, out of bounds accesses are left to Variant.
+static _FORCE_INLINE_ bool _get_indexed_array(const Variant *p_base, const Variant *p_index, Variant *r_dst) {
+
+	if (unlikely(p_index->get_type() != Variant::INT)) {
+		return false;
+	}
+	int index = *VariantInternal::get_int(p_index);
+
+#define GET_PACKED(m_type, m_set)                                                   \
+	{                                                                               \
+		const Vector<m_type> *arr = VariantInternal::get_packed_array<m_type>(p_base); \
+		if (index < 0) {                                                            \
+			index += arr->size();                                                   \
+		}                                                                           \
+		if (index < 0 || index >= arr->size()) {                                    \
+			return false;                                                           \
+		}                                                                           \
+		const m_type value = arr->ptr()[index];                                     \
+		m_set;                                                                      \
+		return true;                                                                \
+	}
+
+	switch (p_base->get_type()) {
+		case Variant::ARRAY: {
+			const Array *arr = VariantInternal::get_array(p_base);
+			if (index < 0) {
+				index += arr->size();
+			}
+			if (index < 0 || index >= arr->size()) {
+				return false;
+			}
+			// The destination may be the array itself.
+			const Variant value = (*arr)[index];
+			*r_dst = value;
+			return true;
+		}
+		case Variant::PACKED_BYTE_ARRAY: GET_PACKED(uint8_t, VariantInternal::set_int(r_dst, value));
+		case Variant::PACKED_INT32_ARRAY: GET_PACKED(int32_t, VariantInternal::set_int(r_dst, value));
+		case Variant::PACKED_INT64_ARRAY: GET_PACKED(int64_t, VariantInternal::set_int(r_dst, value));
+		case Variant::PACKED_FLOAT32_ARRAY: GET_PACKED(float, VariantInternal::set_float(r_dst, value));
+		case Variant::PACKED_FLOAT64_ARRAY: GET_PACKED(double, VariantInternal::set_float(r_dst, value));
+		case Variant::PACKED_VECTOR2_ARRAY: GET_PACKED(Vector2, VariantInternal::set_vector2(r_dst, value));
+		case Variant::PACKED_VECTOR3_ARRAY: GET_PACKED(Vector3, VariantInternal::set_vector3(r_dst, value));
+		case Variant::PACKED_COLOR_ARRAY: GET_PACKED(Color, *r_dst = value);
+		default: return false;
+	}
+#undef GET_PACKED
+}
+
+static _FORCE_INLINE_ bool _set_indexed_array(Variant *p_base, const Variant *p_index, const Variant *p_value) {
+
+	if (unlikely(p_index->get_type() != Variant::INT)) {
+		return false;
+	}
+	int index = *VariantInternal::get_int(p_index);
+
+#define SET_PACKED(m_type, m_value_type, m_value)                                   \
+	{                                                                               \
+		if (p_value->get_type() != m_value_type) {                                  \
+			return false;                                                           \
+		}                                                                           \
+		Vector<m_type> *arr = VariantInternal::get_packed_array<m_type>(p_base);     \
+		if (index < 0) {                                                            \
+			index += arr->size();                                                   \
+		}                                                                           \
+		if (index < 0 || index >= arr->size()) {                                    \
+			return false;                                                           \
+		}                                                                           \
+		arr->set(index, m_value);                                                   \
+		return true;                                                                \
+	}
+
+	switch (p_base->get_type()) {
+		case Variant::ARRAY: {
+			Array *arr = VariantInternal::get_array(p_base);
+			if (index < 0) {
+				index += arr->size();
+			}
+			if (index < 0 || index >= arr->size()) {
+				return false;
+			}
+			(*arr)[index] = *p_value;
+			return true;
+		}
+		case Variant::PACKED_BYTE_ARRAY: SET_PACKED(uint8_t, Variant::INT, *VariantInternal::get_int(p_value));
+		case Variant::PACKED_INT32_ARRAY: SET_PACKED(int32_t, Variant::INT, *VariantInternal::get_int(p_value));
+		case Variant::PACKED_INT64_ARRAY: SET_PACKED(int64_t, Variant::INT, *VariantInternal::get_int(p_value));
+		case Variant::PACKED_FLOAT32_ARRAY: SET_PACKED(float, Variant::FLOAT, *VariantInternal::get_float(p_value));
+		case Variant::PACKED_FLOAT64_ARRAY: SET_PACKED(double, Variant::FLOAT, *VariantInternal::get_float(p_value));
+		case Variant::PACKED_VECTOR2_ARRAY: SET_PACKED(Vector2, Variant::VECTOR2, *VariantInternal::get_vector2(p_value));
+		case Variant::PACKED_VECTOR3_ARRAY: SET_PACKED(Vector3, Variant::VECTOR3, *VariantInternal::get_vector3(p_value));
+		default: return false;
+	}
+#undef SET_PACKED
+}
+
+bool GDScriptFunction::_validate_code() const {
+
+	// call() resolves most operands as base + index without checking them, so addresses must be in range.
+	Vector<int> positions;
+	int ip = 0;
+	while (ip < _code_size) {
+
+		int size = GDScriptOptimizer::get_instruction_size(&_code_ptr[ip], _code_size - ip);
+		ERR_FAIL_COND_V_MSG(size <= 0 || ip + size > _code_size, false, "Invalid opcode at address " + itos(ip) + " in function '" + String(name) + "'.");
+
+		positions.clear();
+		GDScriptOptimizer::get_address_positions(&_code_ptr[ip], size, positions);
+		for (int i = 0; i < positions.size(); i++) {
+
+			int address = _code_ptr[ip + positions[i]];
+			int index = address & ADDR_MASK;
+			bool valid;
+			switch ((address & ADDR_TYPE_MASK) >> ADDR_BITS) {
+				case ADDR_TYPE_SELF:
+				case ADDR_TYPE_CLASS:
+				case ADDR_TYPE_NIL: {
+					valid = index == 0;
+				} break;
+				case ADDR_TYPE_MEMBER: {
+					valid = _script && index < _script->member_indices.size();
+				} break;
+				case ADDR_TYPE_CLASS_CONSTANT: {
+					valid = index < _global_names_count;
+				} break;
+				case ADDR_TYPE_LOCAL_CONSTANT: {
+					valid = index < _constant_count;
+				} break;
+				case ADDR_TYPE_STACK:
+				case ADDR_TYPE_STACK_VARIABLE: {
+					valid = index < _stack_size;
+				} break;
+				case ADDR_TYPE_GLOBAL: {
+					valid = index < GDScriptLanguage::get_singleton()->get_global_array_size();
+				} break;
+#ifdef TOOLS_ENABLED
+				case ADDR_TYPE_NAMED_GLOBAL: {
+					valid = index < _named_globals_count;
+				} break;
+#endif
+				default: {
+					valid = false;
+				}
+			}
+			ERR_FAIL_COND_V_MSG(!valid, false, "Invalid address at " + itos(ip + positions[i]) + " in function '" + String(name) + "'.");
+		}
+
+		ip += size;
+	}
+
+	return true;
+}
+
+const void *const *GDScriptFunction::_build_handlers(const void *const *p_opcode_handlers, const void *p_invalid_handler) {
+
+	// Every position gets the handler its value would select, so jumping anywhere behaves as with the opcode table.
+	const void **handlers = (const void **)memalloc(sizeof(void *) * _code_size);
+	for (int i = 0; i < _code_size; i++) {
+		int opcode = _code_ptr[i];
+		handlers[i] = opcode >= 0 && opcode <= OPCODE_END ? p_opcode_handlers[opcode] : p_invalid_handler;
+	}
+
+	const void *const *expected = NULL;
+	if (!_handlers.compare_exchange_strong(expected, handlers, std::memory_order_acq_rel)) {
+		memfree(handlers); // Built by another thread meanwhile.
+		return expected;
+	}
+	return handlers;
+}
+
 #if defined(__GNUC__)
 #define OPCODES_TABLE                         \
 	static const void *switch_table_ops[] = { \
 		&&OPCODE_OPERATOR,                    \
+		&&OPCODE_OPERATOR_INT,                \
+		&&OPCODE_OPERATOR_FLOAT,              \
+		&&OPCODE_OPERATOR_VECTOR2,            \
+		&&OPCODE_OPERATOR_VECTOR3,            \
 		&&OPCODE_EXTENDS_TEST,                \
 		&&OPCODE_IS_BUILTIN,                  \
 		&&OPCODE_SET,                         \
+		&&OPCODE_SET_INDEXED_ARRAY,           \
 		&&OPCODE_GET,                         \
+		&&OPCODE_GET_INDEXED_ARRAY,           \
 		&&OPCODE_SET_NAMED,                   \
 		&&OPCODE_GET_NAMED,                   \
 		&&OPCODE_SET_MEMBER,                  \
@@ -225,6 +930,7 @@ String GDScriptFunction::_get_call_error(const Callable::CallError &p_err, const
 		&&OPCODE_JUMP,                        \
 		&&OPCODE_JUMP_IF,                     \
 		&&OPCODE_JUMP_IF_NOT,                 \
+		&&OPCODE_COMPARE_JUMP_IF_NOT,         \
 		&&OPCODE_JUMP_TO_DEF_ARGUMENT,        \
 		&&OPCODE_RETURN,                      \
 		&&OPCODE_ITERATE_BEGIN,               \
@@ -242,7 +948,7 @@ String GDScriptFunction::_get_call_error(const Callable::CallError &p_err, const
 	OPSEXIT:
 #define OPCODES_OUT \
 	OPSOUT:
-#define DISPATCH_OPCODE goto *switch_table_ops[_code_ptr[ip]]
+#define DISPATCH_OPCODE goto *handlers[ip]
 #define OPCODE_SWITCH(m_test) DISPATCH_OPCODE;
 #define OPCODE_BREAK goto OPSEXIT
 #define OPCODE_OUT goto OPSOUT
@@ -267,8 +973,18 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 		return Variant();
 	}
 
+#if defined(__GNUC__)
+	const void *const *handlers = _handlers.load(std::memory_order_acquire);
+	if (unlikely(!handlers)) {
+		handlers = _build_handlers(switch_table_ops, &&OPSEXIT);
+	}
+#endif
+
 	r_err.error = Callable::CallError::CALL_OK;
 
+	// Caches are not synchronized, other threads always take the regular lookups.
+	InlineCache *inline_caches = Thread::get_caller_id() == Thread::get_main_id() ? _inline_caches : NULL;
+
 	Variant self;
 	Variant static_ref;
 	Variant retvalue;
@@ -283,17 +999,20 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 #endif
 
 	uint32_t alloca_size = 0;
+	uint8_t *frame = NULL; // Only set for coroutines, which don't use alloca.
+	bool frame_moved = false;
 	GDScript *script;
 	int ip = 0;
 	int line = _initial_line;
 
 	if (p_state) {
 		//use existing (supplied) state (yielded)
-		stack = (Variant *)p_state->stack.ptr();
-		call_args = (Variant **)&p_state->stack.ptr()[sizeof(Variant) * p_state->stack_size]; //ptr() to avoid bounds check
+		frame = p_state->stack;
+		stack = (Variant *)frame;
+		call_args = (Variant **)&frame[sizeof(Variant) * p_state->stack_size];
 		line = p_state->line;
 		ip = p_state->ip;
-		alloca_size = p_state->stack.size();
+		alloca_size = p_state->alloca_size;
 		script = p_state->script.ptr();
 		p_instance = p_state->instance;
 		defarg = p_state->defarg;
@@ -325,7 +1044,14 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 
 		if (alloca_size) {
 
-			uint8_t *aptr = (uint8_t *)alloca(alloca_size);
+			uint8_t *aptr;
+			if (_coroutine) {
+				// The frame outlives this call if it yields, so it's handed to the function state instead of copied.
+				frame = _alloc_frame(alloca_size);
+				aptr = frame;
+			} else {
+				aptr = (uint8_t *)alloca(alloca_size);
+			}
 
 			if (_stack_size) {
 
@@ -344,6 +1070,12 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 							r_err.error = Callable::CallError::CALL_ERROR_INVALID_ARGUMENT;
 							r_err.argument = i;
 							r_err.expected = argument_types[i].kind == GDScriptDataType::BUILTIN ? argument_types[i].builtin_type : Variant::OBJECT;
+							for (int j = 0; j < i; j++) {
+								stack[j].~Variant();
+							}
+							if (frame) {
+								_free_frame(frame, alloca_size);
+							}
 							return Variant();
 						}
 					}
@@ -387,8 +1119,26 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 		}
 	}
 
+	// Base of each addressing mode, so operands resolve to base + index without decoding them in _get_variant().
+	// The ones left NULL need a lookup or an error, and still go through it. Members stay on the checked path,
+	// since any call can reload the instance and resize them.
+	Variant *variant_addresses[ADDR_TYPE_NIL + 1] = {};
+	if (p_instance) {
+		variant_addresses[ADDR_TYPE_SELF] = &self;
+	}
+	variant_addresses[ADDR_TYPE_CLASS] = &static_ref;
+	variant_addresses[ADDR_TYPE_LOCAL_CONSTANT] = _constants_ptr;
+	variant_addresses[ADDR_TYPE_STACK] = stack;
+	variant_addresses[ADDR_TYPE_STACK_VARIABLE] = stack;
+	variant_addresses[ADDR_TYPE_NIL] = &nil;
+
 	String err_text;
 
+	GDScriptSampler::Frame *sample_frame = NULL;
+	if (unlikely(GDScriptSampler::active)) {
+		sample_frame = GDScriptSampler::push_frame(this, line);
+	}
+
 #ifdef DEBUG_ENABLED
 
 	if (ScriptDebugger::get_singleton())
@@ -405,18 +1155,34 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 #define CHECK_SPACE(m_space) \
 	GD_ERR_BREAK((ip + m_space) > _code_size)
 
-#define GET_VARIANT_PTR(m_v, m_code_ofs)                                                                   \
-	Variant *m_v;                                                                                          \
-	m_v = _get_variant(_code_ptr[ip + m_code_ofs], p_instance, script, self, static_ref, stack, err_text); \
-	if (unlikely(!m_v))                                                                                    \
+#define GET_VARIANT_PTR(m_v, m_code_ofs)                                                              \
+	Variant *m_v;                                                                                     \
+	{                                                                                                 \
+		int m_v##_address = _code_ptr[ip + m_code_ofs];                                               \
+		Variant *m_v##_base = variant_addresses[(m_v##_address & ADDR_TYPE_MASK) >> ADDR_BITS];       \
+		if (likely(m_v##_base)) {                                                                     \
+			m_v = &m_v##_base[m_v##_address & ADDR_MASK];                                             \
+		} else {                                                                                      \
+			m_v = _get_variant(m_v##_address, p_instance, script, self, static_ref, stack, err_text); \
+		}                                                                                             \
+	}                                                                                                 \
+	if (unlikely(!m_v))                                                                               \
 		OPCODE_BREAK;
 
 #else
 #define GD_ERR_BREAK(m_cond)
 #define CHECK_SPACE(m_space)
-#define GET_VARIANT_PTR(m_v, m_code_ofs) \
-	Variant *m_v;                        \
-	m_v = _get_variant(_code_ptr[ip + m_code_ofs], p_instance, script, self, static_ref, stack, err_text);
+#define GET_VARIANT_PTR(m_v, m_code_ofs)                                                              \
+	Variant *m_v;                                                                                     \
+	{                                                                                                 \
+		int m_v##_address = _code_ptr[ip + m_code_ofs];                                               \
+		Variant *m_v##_base = variant_addresses[(m_v##_address & ADDR_TYPE_MASK) >> ADDR_BITS];       \
+		if (likely(m_v##_base)) {                                                                     \
+			m_v = &m_v##_base[m_v##_address & ADDR_MASK];                                             \
+		} else {                                                                                      \
+			m_v = _get_variant(m_v##_address, p_instance, script, self, static_ref, stack, err_text); \
+		}                                                                                             \
+	}
 
 #endif
 
@@ -445,6 +1211,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 		OPCODE_SWITCH(_code_ptr[ip]) {
 
 			OPCODE(OPCODE_OPERATOR) {
+			operator_generic: // Typed operators whose operands didn't match.
 
 				CHECK_SPACE(5);
 
@@ -481,6 +1248,70 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 			}
 			DISPATCH_OPCODE;
 
+			OPCODE(OPCODE_OPERATOR_INT) {
+
+				CHECK_SPACE(5);
+
+				Variant::Operator op = (Variant::Operator)_code_ptr[ip + 1];
+				GET_VARIANT_PTR(a, 2);
+				GET_VARIANT_PTR(b, 3);
+				GET_VARIANT_PTR(dst, 4);
+
+				if (unlikely(!_evaluate_int(op, a, b, dst))) {
+					goto operator_generic;
+				}
+				ip += 5;
+			}
+			DISPATCH_OPCODE;
+
+			OPCODE(OPCODE_OPERATOR_FLOAT) {
+
+				CHECK_SPACE(5);
+
+				Variant::Operator op = (Variant::Operator)_code_ptr[ip + 1];
+				GET_VARIANT_PTR(a, 2);
+				GET_VARIANT_PTR(b, 3);
+				GET_VARIANT_PTR(dst, 4);
+
+				if (unlikely(!_evaluate_float(op, a, b, dst))) {
+					goto operator_generic;
+				}
+				ip += 5;
+			}
+			DISPATCH_OPCODE;
+
+			OPCODE(OPCODE_OPERATOR_VECTOR2) {
+
+				CHECK_SPACE(5);
+
+				Variant::Operator op = (Variant::Operator)_code_ptr[ip + 1];
+				GET_VARIANT_PTR(a, 2);
+				GET_VARIANT_PTR(b, 3);
+				GET_VARIANT_PTR(dst, 4);
+
+				if (unlikely(!(_evaluate_vector<Vector2, Variant::VECTOR2>)(op, a, b, dst))) {
+					goto operator_generic;
+				}
+				ip += 5;
+			}
+			DISPATCH_OPCODE;
+
+			OPCODE(OPCODE_OPERATOR_VECTOR3) {
+
+				CHECK_SPACE(5);
+
+				Variant::Operator op = (Variant::Operator)_code_ptr[ip + 1];
+				GET_VARIANT_PTR(a, 2);
+				GET_VARIANT_PTR(b, 3);
+				GET_VARIANT_PTR(dst, 4);
+
+				if (unlikely(!(_evaluate_vector<Vector3, Variant::VECTOR3>)(op, a, b, dst))) {
+					goto operator_generic;
+				}
+				ip += 5;
+			}
+			DISPATCH_OPCODE;
+
 			OPCODE(OPCODE_EXTENDS_TEST) {
 
 				CHECK_SPACE(4);
@@ -579,6 +1410,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 			DISPATCH_OPCODE;
 
 			OPCODE(OPCODE_SET) {
+			set_generic: // Typed array sets that couldn't take the fast path.
 
 				CHECK_SPACE(3);
 
@@ -605,7 +1437,23 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 			}
 			DISPATCH_OPCODE;
 
+			OPCODE(OPCODE_SET_INDEXED_ARRAY) {
+
+				CHECK_SPACE(3);
+
+				GET_VARIANT_PTR(dst, 1);
+				GET_VARIANT_PTR(index, 2);
+				GET_VARIANT_PTR(value, 3);
+
+				if (unlikely(!_set_indexed_array(dst, index, value))) {
+					goto set_generic;
+				}
+				ip += 4;
+			}
+			DISPATCH_OPCODE;
+
 			OPCODE(OPCODE_GET) {
+			get_generic: // Typed array gets that couldn't take the fast path.
 
 				CHECK_SPACE(3);
 
@@ -638,20 +1486,40 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 			}
 			DISPATCH_OPCODE;
 
-			OPCODE(OPCODE_SET_NAMED) {
+			OPCODE(OPCODE_GET_INDEXED_ARRAY) {
 
 				CHECK_SPACE(3);
 
+				GET_VARIANT_PTR(src, 1);
+				GET_VARIANT_PTR(index, 2);
+				GET_VARIANT_PTR(dst, 3);
+
+				if (unlikely(!_get_indexed_array(src, index, dst))) {
+					goto get_generic;
+				}
+				ip += 4;
+			}
+			DISPATCH_OPCODE;
+
+			OPCODE(OPCODE_SET_NAMED) {
+
+				CHECK_SPACE(5);
+
 				GET_VARIANT_PTR(dst, 1);
-				GET_VARIANT_PTR(value, 3);
+				GET_VARIANT_PTR(value, 4);
 
 				int indexname = _code_ptr[ip + 2];
 
 				GD_ERR_BREAK(indexname < 0 || indexname >= _global_names_count);
 				const StringName *index = &_global_names_ptr[indexname];
 
+				int cache_idx = _code_ptr[ip + 3];
+				GD_ERR_BREAK(cache_idx < 0 || cache_idx >= _inline_cache_count);
+
 				bool valid;
-				dst->set_named(*index, *value, &valid);
+				if (!_inline_cache_set(inline_caches ? &inline_caches[cache_idx] : NULL, dst, *index, *value, valid)) {
+					dst->set_named(*index, *value, &valid);
+				}
 
 #ifdef DEBUG_ENABLED
 				if (!valid) {
@@ -660,29 +1528,38 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 					OPCODE_BREAK;
 				}
 #endif
-				ip += 4;
+				ip += 5;
 			}
 			DISPATCH_OPCODE;
 
 			OPCODE(OPCODE_GET_NAMED) {
 
-				CHECK_SPACE(4);
+				CHECK_SPACE(5);
 
 				GET_VARIANT_PTR(src, 1);
-				GET_VARIANT_PTR(dst, 3);
+				GET_VARIANT_PTR(dst, 4);
 
 				int indexname = _code_ptr[ip + 2];
 
 				GD_ERR_BREAK(indexname < 0 || indexname >= _global_names_count);
 				const StringName *index = &_global_names_ptr[indexname];
 
-				bool valid;
+				int cache_idx = _code_ptr[ip + 3];
+				GD_ERR_BREAK(cache_idx < 0 || cache_idx >= _inline_cache_count);
+				InlineCache *cache = inline_caches ? &inline_caches[cache_idx] : NULL;
+
+				bool valid = true;
 #ifdef DEBUG_ENABLED
 				//allow better error message in cases where src and dst are the same stack position
-				Variant ret = src->get_named(*index, &valid);
+				Variant ret;
+				if (!_inline_cache_get(cache, src, *index, ret)) {
+					ret = src->get_named(*index, &valid);
+				}
 
 #else
-				*dst = src->get_named(*index, &valid);
+				if (!_inline_cache_get(cache, src, *index, *dst)) {
+					*dst = src->get_named(*index, &valid);
+				}
 #endif
 #ifdef DEBUG_ENABLED
 				if (!valid) {
@@ -695,7 +1572,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				}
 				*dst = ret;
 #endif
-				ip += 4;
+				ip += 5;
 			}
 			DISPATCH_OPCODE;
 
@@ -788,7 +1665,11 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				Variant::Type var_type = (Variant::Type)_code_ptr[ip + 1];
 				GD_ERR_BREAK(var_type < 0 || var_type >= Variant::VARIANT_MAX);
 
-				if (src->get_type() != var_type) {
+				if (var_type == Variant::INT && src->get_type() == Variant::INT) {
+					VariantInternal::set_int(dst, *VariantInternal::get_int(src));
+				} else if (var_type == Variant::FLOAT && src->get_type() == Variant::FLOAT) {
+					VariantInternal::set_float(dst, *VariantInternal::get_float(src));
+				} else if (src->get_type() != var_type) {
 #ifdef DEBUG_ENABLED
 					if (Variant::can_convert_strict(src->get_type(), var_type)) {
 #endif // DEBUG_ENABLED
@@ -1064,7 +1945,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 			OPCODE(OPCODE_CALL_RETURN)
 			OPCODE(OPCODE_CALL) {
 
-				CHECK_SPACE(4);
+				CHECK_SPACE(5);
 				bool call_ret = _code_ptr[ip] == OPCODE_CALL_RETURN;
 
 				int argc = _code_ptr[ip + 1];
@@ -1074,8 +1955,12 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				GD_ERR_BREAK(nameg < 0 || nameg >= _global_names_count);
 				const StringName *methodname = &_global_names_ptr[nameg];
 
+				int cache_idx = _code_ptr[ip + 4];
+				GD_ERR_BREAK(cache_idx < 0 || cache_idx >= _inline_cache_count);
+				InlineCache *cache = inline_caches ? &inline_caches[cache_idx] : NULL;
+
 				GD_ERR_BREAK(argc < 0);
-				ip += 4;
+				ip += 5;
 				CHECK_SPACE(argc + 1);
 				Variant **argptrs = call_args;
 
@@ -1096,10 +1981,14 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				if (call_ret) {
 
 					GET_VARIANT_PTR(ret, argc);
-					base->call_ptr(*methodname, (const Variant **)argptrs, argc, ret, err);
+					if (!_inline_cache_call(cache, base, *methodname, (const Variant **)argptrs, argc, ret, err)) {
+						base->call_ptr(*methodname, (const Variant **)argptrs, argc, ret, err);
+					}
 				} else {
 
-					base->call_ptr(*methodname, (const Variant **)argptrs, argc, NULL, err);
+					if (!_inline_cache_call(cache, base, *methodname, (const Variant **)argptrs, argc, NULL, err)) {
+						base->call_ptr(*methodname, (const Variant **)argptrs, argc, NULL, err);
+					}
 				}
 #ifdef DEBUG_ENABLED
 				if (GDScriptLanguage::get_singleton()->profiling) {
@@ -1277,11 +2166,12 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				Ref<GDScriptFunctionState> gdfs = memnew(GDScriptFunctionState);
 				gdfs->function = this;
 
-				gdfs->state.stack.resize(alloca_size);
-				//copy variant stack
-				for (int i = 0; i < _stack_size; i++) {
-					memnew_placement(&gdfs->state.stack.write[sizeof(Variant) * i], Variant(stack[i]));
+				// Only coroutines yield, the state takes over their frame as is.
+				gdfs->state.stack = frame;
+				if (p_state) {
+					p_state->stack = NULL;
 				}
+				frame_moved = true;
 				gdfs->state.stack_size = _stack_size;
 				gdfs->state.self = self;
 				gdfs->state.alloca_size = alloca_size;
@@ -1293,6 +2183,10 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				gdfs->state.defarg = defarg;
 				gdfs->state.instance = p_instance;
 				gdfs->function = this;
+				if (p_instance) {
+					MutexLock lock(GDScriptLanguage::get_singleton()->lock);
+					p_instance->pending_func_states.add(&gdfs->instances_list);
+				}
 
 				retvalue = gdfs;
 
@@ -1413,6 +2307,30 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 			}
 			DISPATCH_OPCODE;
 
+			OPCODE(OPCODE_COMPARE_JUMP_IF_NOT) {
+
+				CHECK_SPACE(8);
+
+				Variant::Operator op = (Variant::Operator)_code_ptr[ip + 1];
+				GET_VARIANT_PTR(a, 2);
+				GET_VARIANT_PTR(b, 3);
+				GET_VARIANT_PTR(dst, 4);
+
+				// Anything but numbers runs the regular operator and then the jump after it.
+				if (unlikely(!_evaluate_int(op, a, b, dst) && !_evaluate_float(op, a, b, dst))) {
+					goto operator_generic;
+				}
+
+				if (*VariantInternal::get_bool(dst)) {
+					ip += 8;
+				} else {
+					int to = _code_ptr[ip + 7];
+					GD_ERR_BREAK(to < 0 || to > _code_size);
+					ip = to;
+				}
+			}
+			DISPATCH_OPCODE;
+
 			OPCODE(OPCODE_JUMP_TO_DEF_ARGUMENT) {
 
 				CHECK_SPACE(2);
@@ -1536,6 +2454,10 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				line = _code_ptr[ip + 1];
 				ip += 2;
 
+				if (sample_frame) {
+					sample_frame->line = line;
+				}
+
 				if (ScriptDebugger::get_singleton()) {
 					// line
 					bool do_break = false;
@@ -1607,6 +2529,10 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 	}
 
 	OPCODES_OUT
+	if (sample_frame) {
+		GDScriptSampler::pop_frame();
+	}
+
 #ifdef DEBUG_ENABLED
 	if (GDScriptLanguage::get_singleton()->profiling) {
 		uint64_t time_taken = OS::get_singleton()->get_ticks_usec() - function_start_time;
@@ -1626,10 +2552,17 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 			GDScriptLanguage::get_singleton()->exit_function();
 #endif
 
-		if (_stack_size) {
+		if (!frame_moved) {
 			//free stack
 			for (int i = 0; i < _stack_size; i++)
 				stack[i].~Variant();
+
+			if (frame) {
+				_free_frame(frame, alloca_size);
+				if (p_state) {
+					p_state->stack = NULL;
+				}
+			}
 		}
 
 #ifdef DEBUG_ENABLED
@@ -1764,6 +2697,10 @@ GDScriptFunction::GDScriptFunction() :
 
 	_stack_size = 0;
 	_call_size = 0;
+	_coroutine = false;
+	_inline_cache_count = 0;
+	_inline_caches = NULL;
+	_handlers = NULL;
 	rpc_mode = MultiplayerAPI::RPC_MODE_DISABLED;
 	name = "<anonymous>";
 #ifdef DEBUG_ENABLED
@@ -1789,6 +2726,22 @@ GDScriptFunction::GDScriptFunction() :
 }
 
 GDScriptFunction::~GDScriptFunction() {
+
+	// Other functions may have cached this one.
+	invalidate_inline_caches();
+
+	if (_inline_caches) {
+		memdelete_arr(_inline_caches);
+	}
+
+	if (_handlers) {
+		memfree((void *)_handlers.load());
+	}
+
+	if (GDScriptSampler::active) {
+		GDScriptSampler::get_singleton()->function_freed(this);
+	}
+
 #ifdef DEBUG_ENABLED
 
 	MutexLock lock(GDScriptLanguage::get_singleton()->lock);
@@ -1857,6 +2810,8 @@ Variant GDScriptFunctionState::resume(const Variant &p_arg) {
 #endif
 	}
 
+	_remove_from_instance();
+
 	state.result = p_arg;
 	Callable::CallError err;
 	Variant ret = function->call(NULL, NULL, 0, err, &state);
@@ -1886,13 +2841,9 @@ Variant GDScriptFunctionState::resume(const Variant &p_arg) {
 #ifdef DEBUG_ENABLED
 		if (ScriptDebugger::get_singleton())
 			GDScriptLanguage::get_singleton()->exit_function();
-		if (state.stack_size) {
-			//free stack
-			Variant *stack = (Variant *)state.stack.ptr();
-			for (int i = 0; i < state.stack_size; i++)
-				stack[i].~Variant();
-		}
 #endif
+		// Debug builds keep the frame alive until here, so the debugger can still show it.
+		_free_stack();
 	}
 
 	return ret;
@@ -1907,18 +2858,43 @@ void GDScriptFunctionState::_bind_methods() {
 	ADD_SIGNAL(MethodInfo("completed", PropertyInfo(Variant::NIL, "result", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_NIL_IS_VARIANT)));
 }
 
-GDScriptFunctionState::GDScriptFunctionState() {
+void GDScriptFunctionState::_remove_from_instance() {
+
+	MutexLock lock(GDScriptLanguage::get_singleton()->lock);
+
+	// Only in the list while the instance is there, it empties the list when freed.
+	if (instances_list.in_list()) {
+		state.instance->pending_func_states.remove(&instances_list);
+	}
+}
+
+GDScriptFunctionState::GDScriptFunctionState() :
+		instances_list(this) {
 
 	function = NULL;
+	state.stack = NULL;
+	state.stack_size = 0;
+	state.alloca_size = 0;
 }
 
-GDScriptFunctionState::~GDScriptFunctionState() {
+void GDScriptFunctionState::_free_stack() {
 
-	if (function != NULL) {
-		//never called, deinitialize stack
-		for (int i = 0; i < state.stack_size; i++) {
-			Variant *v = (Variant *)&state.stack[sizeof(Variant) * i];
-			v->~Variant();
-		}
+	if (!state.stack) {
+		return;
+	}
+
+	Variant *stack = (Variant *)state.stack;
+	for (int i = 0; i < state.stack_size; i++) {
+		stack[i].~Variant();
 	}
+	GDScriptFunction::_free_frame(state.stack, state.alloca_size);
+	state.stack = NULL;
+}
+
+GDScriptFunctionState::~GDScriptFunctionState() {
+
+	_remove_from_instance();
+
+	//never resumed, deinitialize stack
+	_free_stack();
 }
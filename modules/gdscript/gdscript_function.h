@@ -31,6 +31,7 @@
 #ifndef GDSCRIPT_FUNCTION_H
 #define GDSCRIPT_FUNCTION_H
 
+#include "core/os/mutex.h"
 #include "core/os/thread.h"
 #include "core/pair.h"
 #include "core/reference.h"
@@ -39,8 +40,11 @@
 #include "core/string_name.h"
 #include "core/variant.h"
 
+#include <atomic>
+
 class GDScriptInstance;
 class GDScript;
+class MethodBind;
 
 struct GDScriptDataType {
 	bool has_type;
@@ -156,10 +160,16 @@ class GDScriptFunction {
 public:
 	enum Opcode {
 		OPCODE_OPERATOR,
+		OPCODE_OPERATOR_INT,
+		OPCODE_OPERATOR_FLOAT,
+		OPCODE_OPERATOR_VECTOR2,
+		OPCODE_OPERATOR_VECTOR3,
 		OPCODE_EXTENDS_TEST,
 		OPCODE_IS_BUILTIN,
 		OPCODE_SET,
+		OPCODE_SET_INDEXED_ARRAY,
 		OPCODE_GET,
+		OPCODE_GET_INDEXED_ARRAY,
 		OPCODE_SET_NAMED,
 		OPCODE_GET_NAMED,
 		OPCODE_SET_MEMBER,
@@ -187,6 +197,7 @@ public:
 		OPCODE_JUMP,
 		OPCODE_JUMP_IF,
 		OPCODE_JUMP_IF_NOT,
+		OPCODE_COMPARE_JUMP_IF_NOT, // Comparison followed by the OPCODE_JUMP_IF_NOT using it, set up by the optimizer.
 		OPCODE_JUMP_TO_DEF_ARGUMENT,
 		OPCODE_RETURN,
 		OPCODE_ITERATE_BEGIN,
@@ -223,6 +234,61 @@ public:
 
 private:
 	friend class GDScriptCompiler;
+	friend class GDScriptCompiledBuffer;
+	friend class GDScriptSampler;
+
+	// Per call site cache for OPCODE_CALL, OPCODE_GET_NAMED and OPCODE_SET_NAMED.
+	// Entries are keyed by the receiver's native class and GDScript, and remember what the name resolved to.
+	struct InlineCache {
+		enum {
+			MAX_ENTRIES = 4,
+			MAX_FAILURES = 16, // Stop resolving at sites that keep hitting uncacheable receivers.
+		};
+
+		enum Kind {
+			KIND_SCRIPT_FUNCTION,
+			KIND_SCRIPT_MEMBER,
+			KIND_NATIVE_METHOD,
+		};
+
+		struct Entry {
+			const void *native_class;
+			const GDScript *script;
+			Kind kind;
+			bool ptrcall; // Native method whose signature allows skipping Variant conversions.
+			int index; // Member index, or the index passed to indexed native setters.
+			union {
+				GDScriptFunction *function;
+				MethodBind *method;
+				const GDScriptDataType *member_type;
+			};
+		};
+
+		uint32_t epoch;
+		uint16_t count;
+		uint16_t failures;
+		uint32_t next;
+		Entry entries[MAX_ENTRIES];
+	};
+
+	enum InlineCacheSite {
+		INLINE_CACHE_CALL,
+		INLINE_CACHE_GET,
+		INLINE_CACHE_SET,
+	};
+
+	static uint32_t inline_cache_epoch;
+
+	// Frames of coroutines are recycled by size class, from 64 bytes up to 32 KiB,
+	// keeping at most FRAME_POOL_MAX_BYTES of free frames per class.
+	enum {
+		FRAME_POOL_CLASSES = 10,
+		FRAME_POOL_MAX_BYTES = 1 << 20,
+	};
+
+	static BinaryMutex frame_pool_mutex;
+	static uint8_t *frame_pool[FRAME_POOL_CLASSES];
+	static uint32_t frame_pool_free[FRAME_POOL_CLASSES];
 
 	StringName source;
 
@@ -243,7 +309,13 @@ private:
 	int _stack_size;
 	int _call_size;
 	int _initial_line;
+	int _inline_cache_count;
+	InlineCache *_inline_caches;
+	// Handler to jump to for the instruction at each code position, so dispatching doesn't need to go
+	// through the opcode table. Built by the first call, since handlers are labels inside call().
+	std::atomic<const void *const *> _handlers;
 	bool _static;
+	bool _coroutine; // Contains a yield, so its stack lives in a pooled frame that can outlive the call.
 	MultiplayerAPI::RPCMode rpc_mode;
 
 	GDScript *_script;
@@ -268,6 +340,21 @@ private:
 	_FORCE_INLINE_ Variant *_get_variant(int p_address, GDScriptInstance *p_instance, GDScript *p_script, Variant &self, Variant &static_ref, Variant *p_stack, String &r_error) const;
 	_FORCE_INLINE_ String _get_call_error(const Callable::CallError &p_err, const String &p_where, const Variant **argptrs) const;
 
+	static bool _inline_cache_resolve(InlineCache::Entry &r_entry, InlineCacheSite p_site, Object *p_object, GDScriptInstance *p_instance, const StringName &p_name);
+	static const InlineCache::Entry *_inline_cache_lookup(InlineCache *p_cache, InlineCacheSite p_site, const Variant *p_base, const StringName &p_name, Object *&r_object, GDScriptInstance *&r_instance);
+	static bool _inline_cache_ptrcall(MethodBind *p_method, Object *p_object, const Variant **p_args, int p_argcount, Variant &r_ret);
+	static bool _inline_cache_call(InlineCache *p_cache, const Variant *p_base, const StringName &p_method, const Variant **p_args, int p_argcount, Variant *r_ret, Callable::CallError &r_err);
+	static bool _inline_cache_get(InlineCache *p_cache, const Variant *p_base, const StringName &p_name, Variant &r_ret);
+	static bool _inline_cache_set(InlineCache *p_cache, const Variant *p_base, const StringName &p_name, const Variant &p_value, bool &r_valid);
+
+	bool _validate_code() const;
+	const void *const *_build_handlers(const void *const *p_opcode_handlers, const void *p_invalid_handler);
+
+	static uint8_t *_alloc_frame(uint32_t p_size);
+	static void _free_frame(uint8_t *p_frame, uint32_t p_size);
+
+	friend class GDScriptFunctionState;
+
 	friend class GDScriptLanguage;
 
 	SelfList<GDScriptFunction> function_list;
@@ -295,7 +382,7 @@ public:
 
 		ObjectID instance_id;
 		GDScriptInstance *instance;
-		Vector<uint8_t> stack;
+		uint8_t *stack; // Frame of the suspended call, owned by the state until it resumes or is freed.
 		int stack_size;
 		Variant self;
 		uint32_t alloca_size;
@@ -308,6 +395,10 @@ public:
 
 	_FORCE_INLINE_ bool is_static() const { return _static; }
 
+	// Must be called whenever compiled functions, scripts or their member layout go away.
+	static void invalidate_inline_caches();
+	static void clear_frame_pool();
+
 	const int *get_code() const; //used for debug
 	int get_code_size() const;
 	Variant get_constant(int p_idx) const;
@@ -354,6 +445,11 @@ class GDScriptFunctionState : public Reference {
 	GDScriptFunction::CallState state;
 	Variant _signal_callback(const Variant **p_args, int p_argcount, Callable::CallError &r_error);
 	Ref<GDScriptFunctionState> first_state;
+	SelfList<GDScriptFunctionState> instances_list; // In the pending states of the instance until resumed.
+
+	void _remove_from_instance();
+
+	void _free_stack();
 
 protected:
 	static void _bind_methods();
@@ -0,0 +1,1259 @@
+/*************************************************************************/
+/*  gdscript_optimizer.cpp                                               */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2020 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2020 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "gdscript_optimizer.h"
+
+#define MAX_PASSES 8
+#define MAX_LIVENESS_VISITS 1024
+
+int GDScriptOptimizer::get_instruction_size(const int *p_code, int p_available) {
+
+	if (p_available < 1) {
+		return 0;
+	}
+
+	int size = 0;
+
+	switch (p_code[0]) {
+		case GDScriptFunction::OPCODE_OPERATOR:
+		case GDScriptFunction::OPCODE_OPERATOR_INT:
+		case GDScriptFunction::OPCODE_OPERATOR_FLOAT:
+		case GDScriptFunction::OPCODE_OPERATOR_VECTOR2:
+		case GDScriptFunction::OPCODE_OPERATOR_VECTOR3:
+		case GDScriptFunction::OPCODE_COMPARE_JUMP_IF_NOT:
+		case GDScriptFunction::OPCODE_SET_NAMED:
+		case GDScriptFunction::OPCODE_GET_NAMED:
+		case GDScriptFunction::OPCODE_ITERATE_BEGIN:
+		case GDScriptFunction::OPCODE_ITERATE: {
+			size = 5;
+		} break;
+		case GDScriptFunction::OPCODE_EXTENDS_TEST:
+		case GDScriptFunction::OPCODE_IS_BUILTIN:
+		case GDScriptFunction::OPCODE_SET:
+		case GDScriptFunction::OPCODE_SET_INDEXED_ARRAY:
+		case GDScriptFunction::OPCODE_GET:
+		case GDScriptFunction::OPCODE_GET_INDEXED_ARRAY:
+		case GDScriptFunction::OPCODE_ASSIGN_TYPED_BUILTIN:
+		case GDScriptFunction::OPCODE_ASSIGN_TYPED_NATIVE:
+		case GDScriptFunction::OPCODE_ASSIGN_TYPED_SCRIPT:
+		case GDScriptFunction::OPCODE_CAST_TO_BUILTIN:
+		case GDScriptFunction::OPCODE_CAST_TO_NATIVE:
+		case GDScriptFunction::OPCODE_CAST_TO_SCRIPT: {
+			size = 4;
+		} break;
+		case GDScriptFunction::OPCODE_SET_MEMBER:
+		case GDScriptFunction::OPCODE_GET_MEMBER:
+		case GDScriptFunction::OPCODE_ASSIGN:
+		case GDScriptFunction::OPCODE_YIELD_SIGNAL:
+		case GDScriptFunction::OPCODE_JUMP_IF:
+		case GDScriptFunction::OPCODE_JUMP_IF_NOT:
+		case GDScriptFunction::OPCODE_ASSERT: {
+			size = 3;
+		} break;
+		case GDScriptFunction::OPCODE_ASSIGN_TRUE:
+		case GDScriptFunction::OPCODE_ASSIGN_FALSE:
+		case GDScriptFunction::OPCODE_YIELD_RESUME:
+		case GDScriptFunction::OPCODE_JUMP:
+		case GDScriptFunction::OPCODE_RETURN:
+		case GDScriptFunction::OPCODE_LINE: {
+			size = 2;
+		} break;
+		case GDScriptFunction::OPCODE_YIELD:
+		case GDScriptFunction::OPCODE_JUMP_TO_DEF_ARGUMENT:
+		case GDScriptFunction::OPCODE_BREAKPOINT:
+		case GDScriptFunction::OPCODE_END: {
+			size = 1;
+		} break;
+		case GDScriptFunction::OPCODE_CONSTRUCT:
+		case GDScriptFunction::OPCODE_CALL_BUILT_IN:
+		case GDScriptFunction::OPCODE_CALL_SELF_BASE: {
+			if (p_available < 3) {
+				return 0;
+			}
+			size = 4 + p_code[2];
+		} break;
+		case GDScriptFunction::OPCODE_CONSTRUCT_ARRAY: {
+			if (p_available < 2) {
+				return 0;
+			}
+			size = 3 + p_code[1];
+		} break;
+		case GDScriptFunction::OPCODE_CONSTRUCT_DICTIONARY: {
+			if (p_available < 2) {
+				return 0;
+			}
+			size = 3 + p_code[1] * 2;
+		} break;
+		case GDScriptFunction::OPCODE_CALL:
+		case GDScriptFunction::OPCODE_CALL_RETURN: {
+			if (p_available < 2) {
+				return 0;
+			}
+			size = 6 + p_code[1];
+		} break;
+		default: {
+			// OPCODE_CALL_SELF is never emitted.
+			return 0;
+		}
+	}
+
+	return (size > 0 && size <= p_available) ? size : 0;
+}
+
+void GDScriptOptimizer::_update_operands(Instruction &r_instruction) {
+
+	const int *code = r_instruction.code.ptr();
+	Vector<int> &reads = r_instruction.reads;
+	Vector<int> &writes = r_instruction.writes;
+
+	reads.clear();
+	writes.clear();
+	r_instruction.jump = -1;
+
+	switch (code[0]) {
+		case GDScriptFunction::OPCODE_OPERATOR:
+		case GDScriptFunction::OPCODE_OPERATOR_INT:
+		case GDScriptFunction::OPCODE_OPERATOR_FLOAT:
+		case GDScriptFunction::OPCODE_OPERATOR_VECTOR2:
+		case GDScriptFunction::OPCODE_OPERATOR_VECTOR3: {
+			reads.push_back(2);
+			reads.push_back(3);
+			writes.push_back(4);
+		} break;
+		case GDScriptFunction::OPCODE_EXTENDS_TEST: {
+			reads.push_back(1);
+			reads.push_back(2);
+			writes.push_back(3);
+		} break;
+		case GDScriptFunction::OPCODE_IS_BUILTIN: {
+			reads.push_back(1);
+			writes.push_back(3);
+		} break;
+		case GDScriptFunction::OPCODE_SET:
+		case GDScriptFunction::OPCODE_SET_INDEXED_ARRAY: {
+			// The base is modified in place.
+			reads.push_back(1);
+			reads.push_back(2);
+			reads.push_back(3);
+			writes.push_back(1);
+		} break;
+		case GDScriptFunction::OPCODE_GET:
+		case GDScriptFunction::OPCODE_GET_INDEXED_ARRAY: {
+			reads.push_back(1);
+			reads.push_back(2);
+			writes.push_back(3);
+		} break;
+		case GDScriptFunction::OPCODE_SET_NAMED: {
+			reads.push_back(1);
+			reads.push_back(4);
+			writes.push_back(1);
+		} break;
+		case GDScriptFunction::OPCODE_GET_NAMED: {
+			reads.push_back(1);
+			writes.push_back(4);
+		} break;
+		case GDScriptFunction::OPCODE_SET_MEMBER: {
+			reads.push_back(2);
+		} break;
+		case GDScriptFunction::OPCODE_GET_MEMBER: {
+			writes.push_back(2);
+		} break;
+		case GDScriptFunction::OPCODE_ASSIGN: {
+			reads.push_back(2);
+			writes.push_back(1);
+		} break;
+		case GDScriptFunction::OPCODE_ASSIGN_TRUE:
+		case GDScriptFunction::OPCODE_ASSIGN_FALSE:
+		case GDScriptFunction::OPCODE_YIELD_RESUME: {
+			writes.push_back(1);
+		} break;
+		case GDScriptFunction::OPCODE_ASSIGN_TYPED_BUILTIN: {
+			reads.push_back(3);
+			writes.push_back(2);
+		} break;
+		case GDScriptFunction::OPCODE_ASSIGN_TYPED_NATIVE:
+		case GDScriptFunction::OPCODE_ASSIGN_TYPED_SCRIPT: {
+			reads.push_back(1);
+			reads.push_back(3);
+			writes.push_back(2);
+		} break;
+		case GDScriptFunction::OPCODE_CAST_TO_BUILTIN: {
+			reads.push_back(2);
+			writes.push_back(3);
+		} break;
+		case GDScriptFunction::OPCODE_CAST_TO_NATIVE:
+		case GDScriptFunction::OPCODE_CAST_TO_SCRIPT: {
+			reads.push_back(1);
+			reads.push_back(2);
+			writes.push_back(3);
+		} break;
+		case GDScriptFunction::OPCODE_CONSTRUCT:
+		case GDScriptFunction::OPCODE_CALL_BUILT_IN:
+		case GDScriptFunction::OPCODE_CALL_SELF_BASE: {
+			int argc = code[2];
+			for (int i = 0; i < argc; i++) {
+				reads.push_back(3 + i);
+			}
+			writes.push_back(3 + argc);
+		} break;
+		case GDScriptFunction::OPCODE_CONSTRUCT_ARRAY: {
+			int argc = code[1];
+			for (int i = 0; i < argc; i++) {
+				reads.push_back(2 + i);
+			}
+			writes.push_back(2 + argc);
+		} break;
+		case GDScriptFunction::OPCODE_CONSTRUCT_DICTIONARY: {
+			int argc = code[1] * 2;
+			for (int i = 0; i < argc; i++) {
+				reads.push_back(2 + i);
+			}
+			writes.push_back(2 + argc);
+		} break;
+		case GDScriptFunction::OPCODE_CALL:
+		case GDScriptFunction::OPCODE_CALL_RETURN: {
+			// Methods of builtin types may modify the base.
+			int argc = code[1];
+			reads.push_back(2);
+			for (int i = 0; i < argc; i++) {
+				reads.push_back(5 + i);
+			}
+			writes.push_back(2);
+			if (code[0] == GDScriptFunction::OPCODE_CALL_RETURN) {
+				writes.push_back(5 + argc);
+			}
+		} break;
+		case GDScriptFunction::OPCODE_YIELD_SIGNAL:
+		case GDScriptFunction::OPCODE_ASSERT: {
+			reads.push_back(1);
+			reads.push_back(2);
+		} break;
+		case GDScriptFunction::OPCODE_JUMP: {
+			r_instruction.jump = 1;
+		} break;
+		case GDScriptFunction::OPCODE_JUMP_IF:
+		case GDScriptFunction::OPCODE_JUMP_IF_NOT: {
+			reads.push_back(1);
+			r_instruction.jump = 2;
+		} break;
+		case GDScriptFunction::OPCODE_RETURN: {
+			reads.push_back(1);
+		} break;
+		case GDScriptFunction::OPCODE_ITERATE_BEGIN:
+		case GDScriptFunction::OPCODE_ITERATE: {
+			reads.push_back(1);
+			reads.push_back(2);
+			writes.push_back(1);
+			writes.push_back(4);
+			r_instruction.jump = 3;
+		} break;
+		default: {
+		}
+	}
+}
+
+void GDScriptOptimizer::_get_address_positions(const Instruction &p_instruction, Vector<int> &r_positions) {
+
+	r_positions = p_instruction.reads;
+	for (int i = 0; i < p_instruction.writes.size(); i++) {
+		if (r_positions.find(p_instruction.writes[i]) == -1) {
+			r_positions.push_back(p_instruction.writes[i]);
+		}
+	}
+
+	// Calls without return still carry a (never written) destination operand.
+	if (p_instruction.code[0] == GDScriptFunction::OPCODE_CALL) {
+		r_positions.push_back(5 + p_instruction.code[1]);
+	}
+}
+
+void GDScriptOptimizer::get_address_positions(const int *p_code, int p_size, Vector<int> &r_positions) {
+
+	Instruction instruction;
+	instruction.code.resize(p_size);
+	for (int i = 0; i < p_size; i++) {
+		instruction.code.write[i] = p_code[i];
+	}
+
+	// The fused comparison keeps the operator layout, its jump is decoded on its own.
+	if (p_code[0] == GDScriptFunction::OPCODE_COMPARE_JUMP_IF_NOT) {
+		instruction.code.write[0] = GDScriptFunction::OPCODE_OPERATOR;
+	}
+
+	_update_operands(instruction);
+	_get_address_positions(instruction, r_positions);
+}
+
+int GDScriptOptimizer::_get_result_position(const Instruction &p_instruction) {
+
+	const int *code = p_instruction.code.ptr();
+
+	switch (code[0]) {
+		case GDScriptFunction::OPCODE_OPERATOR:
+		case GDScriptFunction::OPCODE_OPERATOR_INT:
+		case GDScriptFunction::OPCODE_OPERATOR_FLOAT:
+		case GDScriptFunction::OPCODE_OPERATOR_VECTOR2:
+		case GDScriptFunction::OPCODE_OPERATOR_VECTOR3:
+		case GDScriptFunction::OPCODE_GET_NAMED:
+			return 4;
+		case GDScriptFunction::OPCODE_GET:
+		case GDScriptFunction::OPCODE_GET_INDEXED_ARRAY:
+			return 3;
+		case GDScriptFunction::OPCODE_GET_MEMBER:
+			return 2;
+		case GDScriptFunction::OPCODE_ASSIGN:
+			return 1;
+		case GDScriptFunction::OPCODE_CONSTRUCT:
+		case GDScriptFunction::OPCODE_CALL_BUILT_IN:
+			return 3 + code[2];
+		case GDScriptFunction::OPCODE_CONSTRUCT_ARRAY:
+			return 2 + code[1];
+		case GDScriptFunction::OPCODE_CONSTRUCT_DICTIONARY:
+			return 2 + code[1] * 2;
+		case GDScriptFunction::OPCODE_CALL_RETURN:
+			return 5 + code[1];
+		default:
+			return -1;
+	}
+}
+
+int GDScriptOptimizer::_next(int p_index) const {
+
+	while (p_index < instructions.size() && instructions[p_index].removed) {
+		p_index++;
+	}
+	return p_index;
+}
+
+int GDScriptOptimizer::_previous(int p_index) const {
+
+	p_index--;
+	while (p_index >= 0 && instructions[p_index].removed) {
+		p_index--;
+	}
+	return p_index;
+}
+
+void GDScriptOptimizer::_get_successors(int p_index, Vector<int> &r_successors) const {
+
+	r_successors.clear();
+	const Instruction &instruction = instructions[p_index];
+
+	switch (instruction.code[0]) {
+		case GDScriptFunction::OPCODE_JUMP: {
+			r_successors.push_back(_next(instruction.code[1]));
+		} break;
+		case GDScriptFunction::OPCODE_JUMP_IF:
+		case GDScriptFunction::OPCODE_JUMP_IF_NOT:
+		case GDScriptFunction::OPCODE_ITERATE_BEGIN:
+		case GDScriptFunction::OPCODE_ITERATE: {
+			r_successors.push_back(_next(instruction.code[instruction.jump]));
+			r_successors.push_back(_next(p_index + 1));
+		} break;
+		case GDScriptFunction::OPCODE_JUMP_TO_DEF_ARGUMENT: {
+			for (int i = 0; i < default_args.size(); i++) {
+				r_successors.push_back(_next(default_args[i]));
+			}
+		} break;
+		case GDScriptFunction::OPCODE_RETURN:
+		case GDScriptFunction::OPCODE_END: {
+		} break;
+		default: {
+			// Yields resume at the next instruction too.
+			r_successors.push_back(_next(p_index + 1));
+		}
+	}
+
+	for (int i = r_successors.size() - 1; i >= 0; i--) {
+		if (r_successors[i] >= instructions.size()) {
+			r_successors.remove(i);
+		}
+	}
+}
+
+void GDScriptOptimizer::_get_jump_targets(Vector<bool> &r_targets) const {
+
+	r_targets.resize(instructions.size() + 1);
+	for (int i = 0; i < r_targets.size(); i++) {
+		r_targets.write[i] = false;
+	}
+
+	for (int i = 0; i < instructions.size(); i++) {
+		const Instruction &instruction = instructions[i];
+		if (!instruction.removed && instruction.jump >= 0) {
+			r_targets.write[_next(instruction.code[instruction.jump])] = true;
+		}
+	}
+	for (int i = 0; i < default_args.size(); i++) {
+		r_targets.write[_next(default_args[i])] = true;
+	}
+}
+
+bool GDScriptOptimizer::_reads_slot(const Instruction &p_instruction, int p_slot) const {
+
+	for (int i = 0; i < p_instruction.reads.size(); i++) {
+		int address = p_instruction.code[p_instruction.reads[i]];
+		if (_is_stack_address(address) && (address & GDScriptFunction::ADDR_MASK) == p_slot) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool GDScriptOptimizer::_writes_slot(const Instruction &p_instruction, int p_slot) const {
+
+	for (int i = 0; i < p_instruction.writes.size(); i++) {
+		int address = p_instruction.code[p_instruction.writes[i]];
+		if (_is_stack_address(address) && (address & GDScriptFunction::ADDR_MASK) == p_slot) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool GDScriptOptimizer::_is_slot_read_after(int p_index, int p_slot) const {
+
+	Vector<bool> visited;
+	visited.resize(instructions.size());
+	for (int i = 0; i < visited.size(); i++) {
+		visited.write[i] = false;
+	}
+
+	Vector<int> pending;
+	Vector<int> successors;
+	_get_successors(p_index, pending);
+
+	int visits = 0;
+	while (pending.size()) {
+
+		int index = pending[pending.size() - 1];
+		pending.resize(pending.size() - 1);
+		if (visited[index]) {
+			continue;
+		}
+		visited.write[index] = true;
+
+		if (++visits > MAX_LIVENESS_VISITS) {
+			return true; // Too far away to tell, assume it's used.
+		}
+
+		const Instruction &instruction = instructions[index];
+		if (_reads_slot(instruction, p_slot)) {
+			return true;
+		}
+		if (_writes_slot(instruction, p_slot)) {
+			continue;
+		}
+
+		_get_successors(index, successors);
+		for (int i = 0; i < successors.size(); i++) {
+			if (!visited[successors[i]]) {
+				pending.push_back(successors[i]);
+			}
+		}
+	}
+
+	return false;
+}
+
+bool GDScriptOptimizer::_get_value_constant(int p_address, Variant &r_value) const {
+
+	if (((p_address & GDScriptFunction::ADDR_TYPE_MASK) >> GDScriptFunction::ADDR_BITS) != GDScriptFunction::ADDR_TYPE_LOCAL_CONSTANT) {
+		return false;
+	}
+
+	int index = p_address & GDScriptFunction::ADDR_MASK;
+	ERR_FAIL_INDEX_V(index, constants->size(), false);
+
+	// Only types copied by value, the rest are shared and may be modified through any of their copies.
+	const Variant &value = (*constants)[index];
+	if (value.get_type() >= Variant::OBJECT) {
+		return false;
+	}
+
+	r_value = value;
+	return true;
+}
+
+int GDScriptOptimizer::_add_constant(const Variant &p_value) {
+
+	int index = -1;
+	for (int i = 0; i < constants->size(); i++) {
+		const Variant &constant = (*constants)[i];
+		if (constant.get_type() == p_value.get_type() && constant.hash_compare(p_value)) {
+			index = i;
+			break;
+		}
+	}
+
+	if (index == -1) {
+		index = constants->size();
+		constants->push_back(p_value);
+	}
+
+	return index | (GDScriptFunction::ADDR_TYPE_LOCAL_CONSTANT << GDScriptFunction::ADDR_BITS);
+}
+
+bool GDScriptOptimizer::_propagate_constants() {
+
+	// Locals are always assigned where they're declared and can't be referenced before that,
+	// so a slot written exactly once, by a store of a constant, holds it wherever it's read.
+	// Arguments are written on entry and by default argument code, so they are left alone.
+
+	int slot_count = 0;
+	for (int i = 0; i < instructions.size(); i++) {
+		const Instruction &instruction = instructions[i];
+		if (instruction.removed) {
+			continue;
+		}
+		for (int j = 0; j < instruction.writes.size(); j++) {
+			int address = instruction.code[instruction.writes[j]];
+			if (_is_stack_address(address)) {
+				slot_count = MAX(slot_count, (address & GDScriptFunction::ADDR_MASK) + 1);
+			}
+		}
+	}
+
+	if (slot_count <= argument_count) {
+		return false;
+	}
+
+	Vector<int> writers; // Index of the only instruction writing to each slot, -1 if none, -2 if many.
+	writers.resize(slot_count);
+	for (int i = 0; i < slot_count; i++) {
+		writers.write[i] = -1;
+	}
+
+	for (int i = 0; i < instructions.size(); i++) {
+		const Instruction &instruction = instructions[i];
+		if (instruction.removed) {
+			continue;
+		}
+		for (int j = 0; j < instruction.writes.size(); j++) {
+			int address = instruction.code[instruction.writes[j]];
+			if (!_is_stack_address(address)) {
+				continue;
+			}
+			int slot = address & GDScriptFunction::ADDR_MASK;
+			if (writers[slot] != i) {
+				writers.write[slot] = writers[slot] == -1 ? i : -2;
+			}
+		}
+	}
+
+	Vector<int> values;
+	values.resize(slot_count);
+	bool found = false;
+
+	for (int slot = 0; slot < slot_count; slot++) {
+
+		values.write[slot] = -1;
+		if (slot < argument_count || writers[slot] < 0) {
+			continue;
+		}
+
+		const Instruction &writer = instructions[writers[slot]];
+		Variant value;
+		if (writer.code[0] == GDScriptFunction::OPCODE_ASSIGN) {
+			if (_get_value_constant(writer.code[2], value)) {
+				values.write[slot] = writer.code[2];
+			}
+		} else if (writer.code[0] == GDScriptFunction::OPCODE_ASSIGN_TYPED_BUILTIN) {
+			if (_get_value_constant(writer.code[3], value) && value.get_type() == writer.code[1]) {
+				values.write[slot] = writer.code[3];
+			}
+		}
+
+		found = found || values[slot] != -1;
+	}
+
+	if (!found) {
+		return false;
+	}
+
+	bool changed = false;
+
+	for (int i = 0; i < instructions.size(); i++) {
+		Instruction &instruction = instructions.write[i];
+		if (instruction.removed) {
+			continue;
+		}
+		for (int j = 0; j < instruction.reads.size(); j++) {
+			int position = instruction.reads[j];
+			int address = instruction.code[position];
+			if (!_is_stack_address(address) || instruction.writes.find(position) != -1) {
+				continue;
+			}
+			int slot = address & GDScriptFunction::ADDR_MASK;
+			if (slot < slot_count && values[slot] != -1) {
+				instruction.code.write[position] = values[slot];
+				changed = true;
+			}
+		}
+	}
+
+	return changed;
+}
+
+bool GDScriptOptimizer::_fold_constants() {
+
+	bool changed = false;
+
+	for (int i = 0; i < instructions.size(); i++) {
+
+		Instruction &instruction = instructions.write[i];
+		if (instruction.removed) {
+			continue;
+		}
+
+		const int *code = instruction.code.ptr();
+		int dst = 0;
+		Variant result;
+
+		switch (code[0]) {
+			case GDScriptFunction::OPCODE_OPERATOR:
+			case GDScriptFunction::OPCODE_OPERATOR_INT:
+			case GDScriptFunction::OPCODE_OPERATOR_FLOAT:
+			case GDScriptFunction::OPCODE_OPERATOR_VECTOR2:
+			case GDScriptFunction::OPCODE_OPERATOR_VECTOR3: {
+
+				Variant a;
+				Variant b;
+				if (!_get_value_constant(code[2], a) || !_get_value_constant(code[3], b)) {
+					continue;
+				}
+
+				// Invalid operations, such as division by zero, keep failing at run time.
+				bool valid;
+				Variant::evaluate(Variant::Operator(code[1]), a, b, result, valid);
+				if (!valid || result.get_type() >= Variant::OBJECT) {
+					continue;
+				}
+				dst = code[4];
+			} break;
+			case GDScriptFunction::OPCODE_ASSIGN_TYPED_BUILTIN:
+			case GDScriptFunction::OPCODE_CAST_TO_BUILTIN: {
+
+				bool assign = code[0] == GDScriptFunction::OPCODE_ASSIGN_TYPED_BUILTIN;
+				Variant::Type type = Variant::Type(code[1]);
+				Variant src;
+				if (!_get_value_constant(code[assign ? 3 : 2], src)) {
+					continue;
+				}
+
+				if (src.get_type() == type) {
+					result = src;
+				} else {
+					if (assign && !Variant::can_convert_strict(src.get_type(), type)) {
+						continue;
+					}
+					const Variant *args[1] = { &src };
+					Callable::CallError ce;
+					result = Variant::construct(type, args, 1, ce);
+					if (ce.error != Callable::CallError::CALL_OK || result.get_type() != type) {
+						continue;
+					}
+				}
+				dst = code[assign ? 2 : 3];
+			} break;
+			case GDScriptFunction::OPCODE_JUMP_IF:
+			case GDScriptFunction::OPCODE_JUMP_IF_NOT: {
+
+				Variant condition;
+				if (!_get_value_constant(code[1], condition)) {
+					continue;
+				}
+
+				if (condition.booleanize() == (code[0] == GDScriptFunction::OPCODE_JUMP_IF)) {
+					int target = code[2];
+					instruction.code.resize(2);
+					instruction.code.write[0] = GDScriptFunction::OPCODE_JUMP;
+					instruction.code.write[1] = target;
+					_update_operands(instruction);
+				} else {
+					instruction.removed = true;
+				}
+				changed = true;
+				continue;
+			}
+			default: {
+				continue;
+			}
+		}
+
+		int src = _add_constant(result);
+		instruction.code.resize(3);
+		instruction.code.write[0] = GDScriptFunction::OPCODE_ASSIGN;
+		instruction.code.write[1] = dst;
+		instruction.code.write[2] = src;
+		_update_operands(instruction);
+		changed = true;
+	}
+
+	return changed;
+}
+
+bool GDScriptOptimizer::_forward_stores() {
+
+	Vector<bool> targets;
+	_get_jump_targets(targets);
+
+	bool changed = false;
+
+	for (int i = 0; i < instructions.size(); i++) {
+
+		Instruction &instruction = instructions.write[i];
+		if (instruction.removed || instruction.code[0] != GDScriptFunction::OPCODE_ASSIGN || targets[i]) {
+			continue;
+		}
+
+		int dst = instruction.code[1];
+		int src = instruction.code[2];
+		if (!_is_stack_address(dst) || !_is_temporary_address(src)) {
+			continue;
+		}
+
+		int slot = src & GDScriptFunction::ADDR_MASK;
+		int dst_slot = dst & GDScriptFunction::ADDR_MASK;
+		if (slot == dst_slot || debug_slots.has(slot)) {
+			continue;
+		}
+
+		// A temporary computed right before being copied somewhere else can be computed there instead.
+		int previous = _previous(i);
+		if (previous < 0) {
+			continue;
+		}
+
+		Instruction &producer = instructions.write[previous];
+		int result = _get_result_position(producer);
+		if (result < 0 || producer.code[result] != src) {
+			continue;
+		}
+
+		// Operators and constructors finish reading their operands before storing the result,
+		// other producers could free the destination's old value while still using it.
+		bool reads_before_storing = false;
+		switch (producer.code[0]) {
+			case GDScriptFunction::OPCODE_OPERATOR:
+			case GDScriptFunction::OPCODE_OPERATOR_INT:
+			case GDScriptFunction::OPCODE_OPERATOR_FLOAT:
+			case GDScriptFunction::OPCODE_OPERATOR_VECTOR2:
+			case GDScriptFunction::OPCODE_OPERATOR_VECTOR3:
+			case GDScriptFunction::OPCODE_CONSTRUCT:
+			case GDScriptFunction::OPCODE_CONSTRUCT_ARRAY:
+			case GDScriptFunction::OPCODE_CONSTRUCT_DICTIONARY:
+			case GDScriptFunction::OPCODE_ASSIGN: {
+				reads_before_storing = true;
+			} break;
+			default: {
+			}
+		}
+		if (!reads_before_storing && _reads_slot(producer, dst_slot)) {
+			continue;
+		}
+
+		if (_is_slot_read_after(i, slot)) {
+			continue;
+		}
+
+		producer.code.write[result] = dst;
+		instruction.removed = true;
+		changed = true;
+	}
+
+	for (int i = 0; i < instructions.size(); i++) {
+
+		Instruction &instruction = instructions.write[i];
+		Variant value;
+		if (instruction.removed || instruction.code[0] != GDScriptFunction::OPCODE_ASSIGN || !_is_temporary_address(instruction.code[1]) || !_get_value_constant(instruction.code[2], value)) {
+			continue;
+		}
+
+		int slot = instruction.code[1] & GDScriptFunction::ADDR_MASK;
+		if (debug_slots.has(slot)) {
+			continue;
+		}
+
+		// A constant stored in a temporary only to be used by the next instruction can be used directly.
+		int next = _next(i + 1);
+		if (next >= instructions.size() || targets[next]) {
+			continue;
+		}
+
+		Instruction &user = instructions.write[next];
+		bool reads = false;
+		bool modifies = false;
+		for (int j = 0; j < user.reads.size(); j++) {
+			int address = user.code[user.reads[j]];
+			if (_is_stack_address(address) && (address & GDScriptFunction::ADDR_MASK) == slot) {
+				reads = true;
+				modifies = modifies || user.writes.find(user.reads[j]) != -1;
+			}
+		}
+		if (!reads || modifies) {
+			continue;
+		}
+
+		if (!_writes_slot(user, slot) && _is_slot_read_after(next, slot)) {
+			continue;
+		}
+
+		for (int j = 0; j < user.reads.size(); j++) {
+			int address = user.code[user.reads[j]];
+			if (_is_stack_address(address) && (address & GDScriptFunction::ADDR_MASK) == slot) {
+				user.code.write[user.reads[j]] = instruction.code[2];
+			}
+		}
+		instruction.removed = true;
+		changed = true;
+	}
+
+	return changed;
+}
+
+bool GDScriptOptimizer::_remove_dead_stores() {
+
+	Set<int> read_slots;
+	for (int i = 0; i < instructions.size(); i++) {
+		const Instruction &instruction = instructions[i];
+		if (instruction.removed) {
+			continue;
+		}
+		for (int j = 0; j < instruction.reads.size(); j++) {
+			int address = instruction.code[instruction.reads[j]];
+			if (_is_stack_address(address)) {
+				read_slots.insert(address & GDScriptFunction::ADDR_MASK);
+			}
+		}
+	}
+
+	bool changed = false;
+
+	for (int i = 0; i < instructions.size(); i++) {
+		Instruction &instruction = instructions.write[i];
+		if (instruction.removed) {
+			continue;
+		}
+
+		switch (instruction.code[0]) {
+			case GDScriptFunction::OPCODE_ASSIGN:
+			case GDScriptFunction::OPCODE_ASSIGN_TRUE:
+			case GDScriptFunction::OPCODE_ASSIGN_FALSE: {
+				int address = instruction.code[1];
+				int slot = address & GDScriptFunction::ADDR_MASK;
+				if (_is_temporary_address(address) && !read_slots.has(slot) && !debug_slots.has(slot)) {
+					instruction.removed = true;
+					changed = true;
+				}
+			} break;
+			default: {
+			}
+		}
+	}
+
+	return changed;
+}
+
+bool GDScriptOptimizer::_simplify_jumps() {
+
+	bool changed = false;
+
+	for (int i = 0; i < instructions.size(); i++) {
+
+		Instruction &instruction = instructions.write[i];
+		if (instruction.removed || instruction.jump < 0) {
+			continue;
+		}
+
+		int original = _next(instruction.code[instruction.jump]);
+		int target = original;
+
+		// Jumping to a jump goes straight to its destination.
+		for (int steps = 0; target < instructions.size() && instructions[target].code[0] == GDScriptFunction::OPCODE_JUMP && steps < instructions.size(); steps++) {
+			int next_target = _next(instructions[target].code[1]);
+			if (next_target == target) {
+				break;
+			}
+			target = next_target;
+		}
+
+		instruction.code.write[instruction.jump] = target;
+		if (target != original) {
+			changed = true;
+		}
+
+		switch (instruction.code[0]) {
+			case GDScriptFunction::OPCODE_JUMP:
+			case GDScriptFunction::OPCODE_JUMP_IF:
+			case GDScriptFunction::OPCODE_JUMP_IF_NOT: {
+				if (target == _next(i + 1)) {
+					instruction.removed = true;
+					changed = true;
+				}
+			} break;
+			default: {
+			}
+		}
+	}
+
+	return changed;
+}
+
+bool GDScriptOptimizer::_remove_unreachable() {
+
+	Vector<bool> reachable;
+	reachable.resize(instructions.size());
+	for (int i = 0; i < reachable.size(); i++) {
+		reachable.write[i] = false;
+	}
+
+	Vector<int> pending;
+	pending.push_back(_next(0));
+	for (int i = 0; i < default_args.size(); i++) {
+		pending.push_back(_next(default_args[i]));
+	}
+
+	Vector<int> successors;
+	while (pending.size()) {
+		int index = pending[pending.size() - 1];
+		pending.resize(pending.size() - 1);
+		if (index >= instructions.size() || reachable[index]) {
+			continue;
+		}
+		reachable.write[index] = true;
+
+		_get_successors(index, successors);
+		for (int i = 0; i < successors.size(); i++) {
+			pending.push_back(successors[i]);
+		}
+	}
+
+	bool changed = false;
+	for (int i = 0; i < instructions.size(); i++) {
+		if (!instructions[i].removed && !reachable[i]) {
+			instructions.write[i].removed = true;
+			changed = true;
+		}
+	}
+
+	return changed;
+}
+
+int GDScriptOptimizer::_compact_stack(List<GDScriptFunction::StackDebug> &r_stack_debug) {
+
+	// Renumber the slots still in use so they're contiguous, arguments keep their place.
+	// Locals the debugger shows keep a slot of their own, temporaries share theirs with
+	// any other temporary whose lifetime doesn't overlap.
+
+	Vector<int> positions;
+	int slot_count = argument_count;
+
+	for (int i = 0; i < instructions.size(); i++) {
+		const Instruction &instruction = instructions[i];
+		if (instruction.removed) {
+			continue;
+		}
+		_get_address_positions(instruction, positions);
+		for (int j = 0; j < positions.size(); j++) {
+			int address = instruction.code[positions[j]];
+			if (_is_stack_address(address)) {
+				slot_count = MAX(slot_count, (address & GDScriptFunction::ADDR_MASK) + 1);
+			}
+		}
+	}
+	for (List<GDScriptFunction::StackDebug>::Element *E = r_stack_debug.front(); E; E = E->next()) {
+		slot_count = MAX(slot_count, E->get().pos + 1);
+	}
+
+	Vector<int> slots; // -1 for unused slots, 0 for used ones until they're renumbered.
+	Vector<int> first; // Lifetime of each slot, as instruction indices.
+	Vector<int> last;
+	Vector<bool> fixed; // Slots that can't be shared.
+	slots.resize(slot_count);
+	first.resize(slot_count);
+	last.resize(slot_count);
+	fixed.resize(slot_count);
+	for (int i = 0; i < slot_count; i++) {
+		slots.write[i] = -1;
+		first.write[i] = instructions.size();
+		last.write[i] = -1;
+		fixed.write[i] = i < argument_count;
+	}
+
+	for (int i = 0; i < instructions.size(); i++) {
+		const Instruction &instruction = instructions[i];
+		if (instruction.removed) {
+			continue;
+		}
+		_get_address_positions(instruction, positions);
+		for (int j = 0; j < positions.size(); j++) {
+			int address = instruction.code[positions[j]];
+			if (_is_stack_address(address)) {
+				int slot = address & GDScriptFunction::ADDR_MASK;
+				slots.write[slot] = 0;
+				first.write[slot] = MIN(first[slot], i);
+				last.write[slot] = MAX(last[slot], i);
+				if (!_is_temporary_address(address)) {
+					fixed.write[slot] = true;
+				}
+			}
+		}
+	}
+	for (List<GDScriptFunction::StackDebug>::Element *E = r_stack_debug.front(); E; E = E->next()) {
+		slots.write[E->get().pos] = 0;
+		fixed.write[E->get().pos] = true;
+	}
+
+	// A value can only flow backwards through a loop, so a temporary used anywhere inside one
+	// stays alive for the whole loop. Forward jumps never leave the first to last use range.
+	bool extended = true;
+	while (extended) {
+		extended = false;
+		for (int i = 0; i < instructions.size(); i++) {
+			const Instruction &instruction = instructions[i];
+			if (instruction.removed || instruction.jump < 0 || instruction.code[instruction.jump] > i) {
+				continue;
+			}
+			int target = instruction.code[instruction.jump];
+			for (int j = 0; j < slot_count; j++) {
+				if (slots[j] == -1 || fixed[j] || first[j] > i || last[j] < target || (first[j] <= target && last[j] >= i)) {
+					continue;
+				}
+				first.write[j] = MIN(first[j], target);
+				last.write[j] = MAX(last[j], i);
+				extended = true;
+			}
+		}
+	}
+
+	int stack_size = argument_count;
+	Vector<TemporarySlot> temporaries;
+	for (int i = 0; i < slot_count; i++) {
+		if (i < argument_count) {
+			slots.write[i] = i;
+		} else if (slots[i] == 0 && fixed[i]) {
+			slots.write[i] = stack_size++;
+		} else if (slots[i] == 0) {
+			TemporarySlot temporary;
+			temporary.slot = i;
+			temporary.first = first[i];
+			temporaries.push_back(temporary);
+		}
+	}
+
+	// In order of first use, each temporary takes the first shared slot free by then. Lifetimes
+	// touching at one instruction still get different slots, as operands may not alias.
+	temporaries.sort();
+	Vector<int> shared_slots;
+	Vector<int> shared_last;
+	for (int i = 0; i < temporaries.size(); i++) {
+		int slot = temporaries[i].slot;
+		int shared = -1;
+		for (int j = 0; j < shared_slots.size(); j++) {
+			if (shared_last[j] < first[slot]) {
+				shared = j;
+				break;
+			}
+		}
+		if (shared == -1) {
+			shared = shared_slots.size();
+			shared_slots.push_back(stack_size++);
+			shared_last.push_back(last[slot]);
+		} else {
+			shared_last.write[shared] = last[slot];
+		}
+		slots.write[slot] = shared_slots[shared];
+	}
+
+	for (int i = 0; i < instructions.size(); i++) {
+		Instruction &instruction = instructions.write[i];
+		if (instruction.removed) {
+			continue;
+		}
+		_get_address_positions(instruction, positions);
+		for (int j = 0; j < positions.size(); j++) {
+			int address = instruction.code[positions[j]];
+			if (_is_stack_address(address)) {
+				instruction.code.write[positions[j]] = (address & GDScriptFunction::ADDR_TYPE_MASK) | slots[address & GDScriptFunction::ADDR_MASK];
+			}
+		}
+	}
+	for (List<GDScriptFunction::StackDebug>::Element *E = r_stack_debug.front(); E; E = E->next()) {
+		E->get().pos = slots[E->get().pos];
+	}
+
+	return stack_size;
+}
+
+void GDScriptOptimizer::_emit(Vector<int> &r_code, Vector<int> &r_default_args) const {
+
+	// Removed instructions take no space, so they end up at the position of the next one kept.
+	Vector<int> positions;
+	positions.resize(instructions.size() + 1);
+	int size = 0;
+	for (int i = 0; i < instructions.size(); i++) {
+		positions.write[i] = size;
+		if (!instructions[i].removed) {
+			size += instructions[i].code.size();
+		}
+	}
+	positions.write[instructions.size()] = size;
+
+	r_code.resize(size);
+	int *code = r_code.ptrw();
+
+	for (int i = 0; i < instructions.size(); i++) {
+		const Instruction &instruction = instructions[i];
+		if (instruction.removed) {
+			continue;
+		}
+		int *dst = &code[positions[i]];
+		for (int j = 0; j < instruction.code.size(); j++) {
+			dst[j] = instruction.code[j];
+		}
+		if (instruction.jump >= 0) {
+			dst[instruction.jump] = positions[instruction.code[instruction.jump]];
+		}
+	}
+
+	for (int i = 0; i < default_args.size(); i++) {
+		r_default_args.write[i] = positions[default_args[i]];
+	}
+}
+
+void GDScriptOptimizer::_fuse_instructions(Vector<int> &r_code) {
+
+	int *code = r_code.ptrw();
+	int size = r_code.size();
+	int ip = 0;
+
+	while (ip < size) {
+
+		int length = get_instruction_size(&code[ip], size - ip);
+		ERR_FAIL_COND(length == 0);
+
+		switch (code[ip]) {
+			case GDScriptFunction::OPCODE_OPERATOR:
+			case GDScriptFunction::OPCODE_OPERATOR_INT:
+			case GDScriptFunction::OPCODE_OPERATOR_FLOAT: {
+				// Comparisons branched on right away, the jump is kept in place for the generic path.
+				int op = code[ip + 1];
+				if (op >= Variant::OP_EQUAL && op <= Variant::OP_GREATER_EQUAL && ip + 8 <= size && code[ip + 5] == GDScriptFunction::OPCODE_JUMP_IF_NOT && code[ip + 6] == code[ip + 4]) {
+					code[ip] = GDScriptFunction::OPCODE_COMPARE_JUMP_IF_NOT;
+				}
+			} break;
+			default: {
+			}
+		}
+
+		ip += length;
+	}
+}
+
+void GDScriptOptimizer::optimize(Vector<int> &r_code, Vector<Variant> &r_constants, Vector<int> &r_default_args, List<GDScriptFunction::StackDebug> &r_stack_debug, int p_argument_count, int &r_stack_size) {
+
+	instructions.clear();
+	default_args.clear();
+	debug_slots.clear();
+	constants = &r_constants;
+	argument_count = p_argument_count;
+
+	for (List<GDScriptFunction::StackDebug>::Element *E = r_stack_debug.front(); E; E = E->next()) {
+		debug_slots.insert(E->get().pos);
+	}
+
+	// Decode, turning code positions into instruction indices.
+
+	const int *code = r_code.ptr();
+	int code_size = r_code.size();
+
+	Vector<int> indices;
+	indices.resize(code_size + 1);
+	for (int i = 0; i <= code_size; i++) {
+		indices.write[i] = -1;
+	}
+
+	int ip = 0;
+	while (ip < code_size) {
+		int length = get_instruction_size(&code[ip], code_size - ip);
+		ERR_FAIL_COND_MSG(length == 0, "Unknown bytecode layout at " + itos(ip) + ", function left unoptimized.");
+
+		Instruction instruction;
+		instruction.code.resize(length);
+		for (int i = 0; i < length; i++) {
+			instruction.code.write[i] = code[ip + i];
+		}
+		_update_operands(instruction);
+
+		indices.write[ip] = instructions.size();
+		instructions.push_back(instruction);
+		ip += length;
+	}
+	indices.write[code_size] = instructions.size();
+
+	for (int i = 0; i < instructions.size(); i++) {
+		Instruction &instruction = instructions.write[i];
+		if (instruction.jump < 0) {
+			continue;
+		}
+		int target = instruction.code[instruction.jump];
+		ERR_FAIL_COND_MSG(target < 0 || target > code_size || indices[target] < 0, "Jump into the middle of an instruction, function left unoptimized.");
+		instruction.code.write[instruction.jump] = indices[target];
+	}
+
+	for (int i = 0; i < r_default_args.size(); i++) {
+		int target = r_default_args[i];
+		ERR_FAIL_COND_MSG(target < 0 || target > code_size || indices[target] < 0, "Invalid default argument address, function left unoptimized.");
+		default_args.push_back(indices[target]);
+	}
+
+	for (int i = 0; i < MAX_PASSES; i++) {
+		bool changed = _propagate_constants();
+		changed = _fold_constants() || changed;
+		changed = _forward_stores() || changed;
+		changed = _remove_dead_stores() || changed;
+		changed = _simplify_jumps() || changed;
+		changed = _remove_unreachable() || changed;
+		if (!changed) {
+			break;
+		}
+	}
+
+	r_stack_size = _compact_stack(r_stack_debug);
+	_emit(r_code, r_default_args);
+	_fuse_instructions(r_code);
+}
+
+GDScriptOptimizer::GDScriptOptimizer() {
+
+	constants = NULL;
+	argument_count = 0;
+}
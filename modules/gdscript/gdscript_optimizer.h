@@ -0,0 +1,110 @@
+/*************************************************************************/
+/*  gdscript_optimizer.h                                                 */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2020 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2020 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef GDSCRIPT_OPTIMIZER_H
+#define GDSCRIPT_OPTIMIZER_H
+
+#include "core/set.h"
+#include "gdscript_function.h"
+
+// Peephole and data flow optimizations over the bytecode of a single function,
+// run by the compiler once code generation is done. Line opcodes are never moved
+// or merged, so breakpoints and error lines behave the same with it enabled.
+class GDScriptOptimizer {
+
+	struct Instruction {
+		Vector<int> code; // Opcode and operands, jump targets hold instruction indices.
+		Vector<int> reads; // Operand positions of the addresses read.
+		Vector<int> writes; // Operand positions of the addresses written.
+		int jump; // Operand position of the jump target, -1 if none.
+		bool removed;
+
+		Instruction() :
+				jump(-1),
+				removed(false) {}
+	};
+
+	struct TemporarySlot {
+		int slot;
+		int first; // Index of the first instruction it's alive in.
+
+		bool operator<(const TemporarySlot &p_other) const { return first < p_other.first || (first == p_other.first && slot < p_other.slot); }
+	};
+
+	Vector<Instruction> instructions;
+	Vector<int> default_args;
+	Vector<Variant> *constants;
+	Set<int> debug_slots; // Stack slots the debugger shows as locals.
+	int argument_count;
+
+	static int _get_result_position(const Instruction &p_instruction);
+	static void _update_operands(Instruction &r_instruction);
+	static void _get_address_positions(const Instruction &p_instruction, Vector<int> &r_positions);
+
+	_FORCE_INLINE_ static bool _is_stack_address(int p_address) {
+		int type = (p_address & GDScriptFunction::ADDR_TYPE_MASK) >> GDScriptFunction::ADDR_BITS;
+		return type == GDScriptFunction::ADDR_TYPE_STACK || type == GDScriptFunction::ADDR_TYPE_STACK_VARIABLE;
+	}
+	_FORCE_INLINE_ static bool _is_temporary_address(int p_address) {
+		return ((p_address & GDScriptFunction::ADDR_TYPE_MASK) >> GDScriptFunction::ADDR_BITS) == GDScriptFunction::ADDR_TYPE_STACK;
+	}
+
+	int _next(int p_index) const;
+	int _previous(int p_index) const;
+	void _get_successors(int p_index, Vector<int> &r_successors) const;
+	void _get_jump_targets(Vector<bool> &r_targets) const;
+	bool _reads_slot(const Instruction &p_instruction, int p_slot) const;
+	bool _writes_slot(const Instruction &p_instruction, int p_slot) const;
+	bool _is_slot_read_after(int p_index, int p_slot) const;
+
+	bool _get_value_constant(int p_address, Variant &r_value) const;
+	int _add_constant(const Variant &p_value);
+
+	bool _propagate_constants();
+	bool _fold_constants();
+	bool _forward_stores();
+	bool _remove_dead_stores();
+	bool _simplify_jumps();
+	bool _remove_unreachable();
+	int _compact_stack(List<GDScriptFunction::StackDebug> &r_stack_debug);
+	void _emit(Vector<int> &r_code, Vector<int> &r_default_args) const;
+	static void _fuse_instructions(Vector<int> &r_code);
+
+public:
+	static int get_instruction_size(const int *p_code, int p_available);
+	// Operand positions holding addresses in a complete instruction.
+	static void get_address_positions(const int *p_code, int p_size, Vector<int> &r_positions);
+
+	void optimize(Vector<int> &r_code, Vector<Variant> &r_constants, Vector<int> &r_default_args, List<GDScriptFunction::StackDebug> &r_stack_debug, int p_argument_count, int &r_stack_size);
+
+	GDScriptOptimizer();
+};
+
+#endif // GDSCRIPT_OPTIMIZER_H
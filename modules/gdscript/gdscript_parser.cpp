@@ -8570,6 +8570,17 @@ Error GDScriptParser::parse_bytecode(const Vector<uint8_t> &p_bytecode, const St
 	return ret;
 }
 
+Error GDScriptParser::parse_recorded(GDScriptTokenizerRecorded *p_tokens, const String &p_base_path, const String &p_self_path) {
+
+	clear();
+
+	self_path = p_self_path;
+	tokenizer = p_tokens;
+	Error ret = _parse(p_base_path);
+	tokenizer = NULL;
+	return ret;
+}
+
 Error GDScriptParser::parse(const String &p_code, const String &p_base_path, bool p_just_validate, const String &p_self_path, bool p_for_completion, Set<int> *r_safe_lines, bool p_dependencies_only) {
 
 	clear();
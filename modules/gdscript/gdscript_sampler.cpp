@@ -0,0 +1,480 @@
+/*************************************************************************/
+/*  gdscript_sampler.cpp                                                 */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2020 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2020 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+
+#include "gdscript_sampler.h"
+
+#include "core/io/json.h"
+#include "core/os/file_access.h"
+#include "core/os/os.h"
+#include "core/safe_refcount.h"
+#include "gdscript.h"
+#include "gdscript_function.h"
+
+GDScriptSampler *GDScriptSampler::singleton = NULL;
+uint32_t GDScriptSampler::generation = 0;
+thread_local GDScriptSampler::ThreadStack *GDScriptSampler::thread_stack = NULL;
+thread_local uint32_t GDScriptSampler::thread_stack_generation = 0;
+bool GDScriptSampler::active = false;
+
+GDScriptSampler::ThreadStack *GDScriptSampler::_register_thread() {
+
+	thread_stack_generation = generation;
+	thread_stack = NULL;
+
+	GDScriptSampler *sampler = singleton;
+	MutexLock lock(sampler->register_mutex);
+
+	uint32_t index = sampler->thread_count;
+	if (index >= MAX_THREADS) {
+		return NULL; // Scripts running on this thread won't be sampled.
+	}
+
+	ThreadStack *stack = memnew(ThreadStack);
+	stack->depth = 0;
+	sampler->thread_stacks[index] = stack;
+	sampler->main_thread[index] = Thread::get_caller_id() == Thread::get_main_id();
+	atomic_increment(&sampler->thread_count); // Publishes the stack to the timer thread.
+
+	thread_stack = stack;
+	return stack;
+}
+
+GDScriptSampler::Frame *GDScriptSampler::push_frame(const GDScriptFunction *p_function, int p_line) {
+
+	ThreadStack *stack = thread_stack;
+	if (unlikely(thread_stack_generation != generation)) {
+		stack = _register_thread();
+	}
+	if (unlikely(!stack || stack->depth >= MAX_STACK_DEPTH)) {
+		return NULL;
+	}
+
+	Frame *frame = &stack->frames[stack->depth];
+	frame->function = p_function;
+	frame->line = p_line;
+	atomic_increment(&stack->depth); // Only visible to the timer thread once written.
+	return frame;
+}
+
+void GDScriptSampler::pop_frame() {
+
+	atomic_decrement(&thread_stack->depth);
+}
+
+void GDScriptSampler::_thread_func(void *p_user) {
+
+	GDScriptSampler *sampler = (GDScriptSampler *)p_user;
+	while (!sampler->exit_thread) {
+		OS::get_singleton()->delay_usec(sampler->interval_usec);
+		sampler->_capture();
+		if (sampler->ring_write - sampler->ring_read >= RING_SIZE / 2) {
+			// Nothing drained it in time, e.g. a single call running for a long time.
+			sampler->drain();
+		}
+	}
+}
+
+void GDScriptSampler::_capture() {
+
+	MutexLock lock(capture_mutex);
+
+	uint32_t count = thread_count;
+	for (uint32_t i = 0; i < count; i++) {
+
+		const ThreadStack *stack = thread_stacks[i];
+		uint32_t depth = MIN(stack->depth, (uint32_t)MAX_STACK_DEPTH);
+		if (!depth) {
+			continue;
+		}
+
+		uint32_t write = ring_write;
+		if (write - ring_read >= RING_SIZE) {
+			atomic_increment(&dropped_samples);
+			continue;
+		}
+
+		// The thread keeps running while it's being copied, so the stack may be a mix of
+		// the frames before and after a call. Functions can't be freed meanwhile, though.
+		Sample &sample = ring[write & (RING_SIZE - 1)];
+		uint32_t skip = depth > MAX_SAMPLE_DEPTH ? depth - MAX_SAMPLE_DEPTH : 0;
+		sample.thread = i;
+		sample.depth = depth - skip;
+		for (uint32_t j = 0; j < sample.depth; j++) {
+			sample.frames[j].function = stack->frames[skip + j].function;
+			sample.frames[j].line = stack->frames[skip + j].line;
+		}
+
+		atomic_increment(&ring_write);
+	}
+}
+
+int GDScriptSampler::_get_frame(const GDScriptFunction *p_function) {
+
+	const Map<const GDScriptFunction *, int>::Element *E = function_frames.find(p_function);
+	if (E) {
+		return E->get();
+	}
+
+	FrameInfo info;
+	info.name = p_function->get_name();
+	const GDScript *script = p_function->get_script();
+	if (script && script->get_script_class_name() != String()) {
+		info.name = script->get_script_class_name() + "." + info.name;
+	}
+	info.file = p_function->get_source();
+	info.line = p_function->_initial_line;
+	info.self_samples = 0;
+	info.total_samples = 0;
+	info.last_sample = 0;
+
+	int frame = frames.size();
+	frames.push_back(info);
+	function_frames[p_function] = frame;
+	return frame;
+}
+
+int GDScriptSampler::_get_child(int p_node, int p_frame) {
+
+	const Map<int, int>::Element *E = nodes[p_node].children.find(p_frame);
+	if (E) {
+		return E->get();
+	}
+
+	Node node;
+	node.frame = p_frame;
+	node.parent = p_node;
+	node.self_samples = 0;
+	node.total_samples = 0;
+
+	int index = nodes.size();
+	nodes.push_back(node);
+	nodes.write[p_node].children[p_frame] = index;
+	return index;
+}
+
+void GDScriptSampler::_add_sample(const Sample &p_sample) {
+
+	while ((int)p_sample.thread >= thread_roots.size()) {
+		thread_roots.push_back(-1);
+	}
+
+	int node = thread_roots[p_sample.thread];
+	if (node == -1) {
+		Node root;
+		root.frame = -1;
+		root.parent = -1;
+		root.self_samples = 0;
+		root.total_samples = 0;
+		node = nodes.size();
+		nodes.push_back(root);
+		thread_roots.write[p_sample.thread] = node;
+	}
+
+	sample_count++;
+	nodes.write[node].total_samples++;
+
+	int frame = -1;
+	for (uint32_t i = 0; i < p_sample.depth; i++) {
+		frame = _get_frame(p_sample.frames[i].function);
+		node = _get_child(node, frame);
+		nodes.write[node].total_samples++;
+
+		FrameInfo &info = frames.write[frame];
+		if (info.last_sample != sample_count) {
+			info.last_sample = sample_count;
+			info.total_samples++;
+		}
+	}
+
+	nodes.write[node].self_samples++;
+	if (frame != -1) {
+		frames.write[frame].self_samples++;
+		line_samples[((uint64_t)frame << 32) | (uint32_t)p_sample.frames[p_sample.depth - 1].line]++;
+	}
+}
+
+void GDScriptSampler::drain() {
+
+	MutexLock lock(drain_mutex);
+
+	while (ring_read != ring_write) {
+		_add_sample(ring[ring_read & (RING_SIZE - 1)]);
+		atomic_increment(&ring_read); // Frees the slot for the timer thread.
+	}
+}
+
+void GDScriptSampler::function_freed(const GDScriptFunction *p_function) {
+
+	MutexLock lock(capture_mutex);
+	if (!active) {
+		return;
+	}
+
+	// Resolve the samples that may point to it before the address can be reused.
+	drain();
+	function_frames.erase(p_function);
+}
+
+Error GDScriptSampler::start(uint32_t p_interval_usec) {
+
+	ERR_FAIL_COND_V_MSG(thread, ERR_ALREADY_IN_USE, "The GDScript sampling profiler is already running.");
+
+	interval_usec = MAX(p_interval_usec, 1u);
+	if (!ring) {
+		ring = memnew_arr(Sample, RING_SIZE);
+	}
+	exit_thread = false;
+	thread = Thread::create(_thread_func, this);
+	ERR_FAIL_COND_V_MSG(!thread, ERR_CANT_CREATE, "Couldn't create the GDScript sampling profiler thread.");
+
+	active = true;
+	return OK;
+}
+
+void GDScriptSampler::stop() {
+
+	if (!thread) {
+		return;
+	}
+
+	exit_thread = true;
+	Thread::wait_to_finish(thread);
+	memdelete(thread);
+	thread = NULL;
+
+	MutexLock lock(capture_mutex);
+	drain();
+	// Functions aren't tracked while stopped, so the addresses can't be trusted anymore.
+	function_frames.clear();
+	active = false;
+}
+
+void GDScriptSampler::clear() {
+
+	MutexLock lock(drain_mutex);
+
+	frames.clear();
+	nodes.clear();
+	thread_roots.clear();
+	line_samples.clear();
+	function_frames.clear();
+	sample_count = 0;
+	dropped_samples = 0;
+}
+
+struct _FlatEntrySort {
+	bool operator()(const GDScriptSampler::FlatEntry &p_a, const GDScriptSampler::FlatEntry &p_b) const {
+		if (p_a.self_samples != p_b.self_samples) {
+			return p_a.self_samples > p_b.self_samples;
+		}
+		return p_a.total_samples > p_b.total_samples;
+	}
+};
+
+void GDScriptSampler::get_function_profile(Vector<FlatEntry> &r_entries) const {
+
+	MutexLock lock(drain_mutex);
+
+	r_entries.resize(frames.size());
+	for (int i = 0; i < frames.size(); i++) {
+		FlatEntry &entry = r_entries.write[i];
+		entry.name = frames[i].name;
+		entry.file = frames[i].file;
+		entry.line = frames[i].line;
+		entry.self_samples = frames[i].self_samples;
+		entry.total_samples = frames[i].total_samples;
+	}
+	r_entries.sort_custom<_FlatEntrySort>();
+}
+
+void GDScriptSampler::get_line_profile(Vector<FlatEntry> &r_entries) const {
+
+	MutexLock lock(drain_mutex);
+
+	r_entries.clear();
+	for (const Map<uint64_t, uint64_t>::Element *E = line_samples.front(); E; E = E->next()) {
+		const FrameInfo &info = frames[E->key() >> 32];
+		FlatEntry entry;
+		entry.name = info.name;
+		entry.file = info.file;
+		entry.line = (int)(uint32_t)E->key();
+		entry.self_samples = E->get();
+		entry.total_samples = E->get();
+		r_entries.push_back(entry);
+	}
+	r_entries.sort_custom<_FlatEntrySort>();
+}
+
+void GDScriptSampler::print_profile(int p_max_entries) const {
+
+	print_line(vformat("GDScript sampling profile: %d samples every %d usec, %d dropped.", sample_count, interval_usec, dropped_samples));
+	if (!sample_count) {
+		return;
+	}
+
+	Vector<FlatEntry> entries;
+	get_function_profile(entries);
+	print_line("   self%  total%  function");
+	for (int i = 0; i < MIN(entries.size(), p_max_entries); i++) {
+		const FlatEntry &entry = entries[i];
+		print_line(vformat("  %5.1f%%  %5.1f%%  %s (%s:%d)", entry.self_samples * 100.0 / sample_count, entry.total_samples * 100.0 / sample_count, entry.name, entry.file, entry.line));
+	}
+
+	get_line_profile(entries);
+	print_line("   self%  line");
+	for (int i = 0; i < MIN(entries.size(), p_max_entries); i++) {
+		const FlatEntry &entry = entries[i];
+		print_line(vformat("  %5.1f%%  %s:%d (%s)", entry.self_samples * 100.0 / sample_count, entry.file, entry.line, entry.name));
+	}
+}
+
+void GDScriptSampler::_get_node_stack(int p_node, Vector<int> &r_stack) const {
+
+	r_stack.clear();
+	for (int node = p_node; nodes[node].frame != -1; node = nodes[node].parent) {
+		r_stack.push_back(nodes[node].frame);
+	}
+	r_stack.invert();
+}
+
+Dictionary GDScriptSampler::get_speedscope_profile() const {
+
+	MutexLock lock(drain_mutex);
+
+	Array shared_frames;
+	for (int i = 0; i < frames.size(); i++) {
+		Dictionary frame;
+		frame["name"] = frames[i].name;
+		frame["file"] = frames[i].file;
+		frame["line"] = frames[i].line;
+		shared_frames.push_back(frame);
+	}
+
+	// Identical stacks are merged into a single weighted sample.
+	Array profiles;
+	Vector<int> stack;
+	for (int i = 0; i < thread_roots.size(); i++) {
+
+		int root = thread_roots[i];
+		if (root == -1) {
+			continue;
+		}
+
+		Array samples;
+		Array weights;
+		List<int> pending;
+		pending.push_back(root);
+		while (pending.size()) {
+			int node = pending.front()->get();
+			pending.pop_front();
+			for (const Map<int, int>::Element *E = nodes[node].children.front(); E; E = E->next()) {
+				pending.push_back(E->get());
+			}
+
+			if (node == root || !nodes[node].self_samples) {
+				continue;
+			}
+
+			_get_node_stack(node, stack);
+			Array sample;
+			for (int j = 0; j < stack.size(); j++) {
+				sample.push_back(stack[j]);
+			}
+			samples.push_back(sample);
+			weights.push_back(nodes[node].self_samples * interval_usec);
+		}
+
+		Dictionary profile;
+		profile["type"] = "sampled";
+		profile["name"] = main_thread[i] ? String("Main thread") : "Thread " + itos(i);
+		profile["unit"] = "microseconds";
+		profile["startValue"] = 0;
+		profile["endValue"] = nodes[root].total_samples * interval_usec;
+		profile["samples"] = samples;
+		profile["weights"] = weights;
+		profiles.push_back(profile);
+	}
+
+	Dictionary shared;
+	shared["frames"] = shared_frames;
+
+	Dictionary file;
+	file["$schema"] = "https://www.speedscope.app/file-format-schema.json";
+	file["shared"] = shared;
+	file["profiles"] = profiles;
+	file["name"] = "GDScript";
+	file["activeProfileIndex"] = 0;
+	file["exporter"] = "Godot Engine";
+	return file;
+}
+
+Error GDScriptSampler::save_speedscope_profile(const String &p_path) const {
+
+	Error err;
+	FileAccess *f = FileAccess::open(p_path, FileAccess::WRITE, &err);
+	ERR_FAIL_COND_V_MSG(!f, err, "Couldn't save the GDScript profile to '" + p_path + "'.");
+
+	f->store_string(JSON::print(get_speedscope_profile(), "", false));
+	f->close();
+	memdelete(f);
+	return OK;
+}
+
+GDScriptSampler::GDScriptSampler() {
+
+	ERR_FAIL_COND(singleton);
+	singleton = this;
+	// Stacks registered by a previous sampler are gone.
+	generation++;
+
+	thread_count = 0;
+	ring = NULL; // Allocated on start.
+	ring_read = 0;
+	ring_write = 0;
+	dropped_samples = 0;
+	thread = NULL;
+	exit_thread = false;
+	interval_usec = 1000;
+	sample_count = 0;
+}
+
+GDScriptSampler::~GDScriptSampler() {
+
+	stop();
+
+	for (uint32_t i = 0; i < thread_count; i++) {
+		memdelete(thread_stacks[i]);
+	}
+	if (ring) {
+		memdelete_arr(ring);
+	}
+	singleton = NULL;
+}
@@ -0,0 +1,183 @@
+/*************************************************************************/
+/*  gdscript_sampler.h                                                   */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2020 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2020 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+
+#ifndef GDSCRIPT_SAMPLER_H
+#define GDSCRIPT_SAMPLER_H
+
+#include "core/dictionary.h"
+#include "core/map.h"
+#include "core/os/mutex.h"
+#include "core/os/thread.h"
+#include "core/ustring.h"
+#include "core/vector.h"
+
+class GDScriptFunction;
+
+// Statistical profiler for GDScript. While it runs, every script call keeps a frame on a
+// shadow stack owned by the calling thread, and a timer thread copies all stacks into a
+// ring buffer at a fixed interval. Samples are aggregated into a call tree and per line
+// counts when drained, outside of the timer thread, so the running scripts only pay for
+// pushing and popping their frames.
+class GDScriptSampler {
+public:
+	enum {
+		MAX_THREADS = 64,
+		MAX_STACK_DEPTH = 256,
+		MAX_SAMPLE_DEPTH = 64, // Deeper stacks keep their innermost frames.
+		RING_SIZE = 512, // Power of two.
+	};
+
+	struct Frame {
+		const GDScriptFunction *function;
+		volatile int line;
+	};
+
+	struct FlatEntry {
+		String name;
+		String file;
+		int line;
+		uint64_t self_samples;
+		uint64_t total_samples;
+	};
+
+private:
+	struct ThreadStack {
+		Frame frames[MAX_STACK_DEPTH];
+		volatile uint32_t depth;
+	};
+
+	struct SampleFrame {
+		const GDScriptFunction *function;
+		int line;
+	};
+
+	struct Sample {
+		uint32_t thread;
+		uint32_t depth;
+		SampleFrame frames[MAX_SAMPLE_DEPTH]; // Outermost first.
+	};
+
+	struct FrameInfo {
+		String name;
+		String file;
+		int line;
+		uint64_t self_samples;
+		uint64_t total_samples;
+		uint64_t last_sample; // Counts recursive frames once per sample.
+	};
+
+	struct Node {
+		int frame; // -1 for the root of a thread.
+		int parent;
+		uint64_t self_samples;
+		uint64_t total_samples;
+		Map<int, int> children;
+	};
+
+	static GDScriptSampler *singleton;
+	static uint32_t generation;
+	static thread_local ThreadStack *thread_stack;
+	static thread_local uint32_t thread_stack_generation;
+
+	// Stacks are registered by threads the first time they call a script and stay valid
+	// until the sampler is destroyed, as threads don't report when they exit.
+	ThreadStack *thread_stacks[MAX_THREADS];
+	bool main_thread[MAX_THREADS];
+	volatile uint32_t thread_count;
+	Mutex register_mutex;
+
+	// Single producer (the timer thread) and single consumer (drain(), serialized by drain_mutex).
+	Sample *ring;
+	volatile uint32_t ring_read;
+	volatile uint32_t ring_write;
+	volatile uint32_t dropped_samples;
+
+	// Held while copying stacks, so functions can't be freed while the timer thread reads them.
+	Mutex capture_mutex;
+	Mutex drain_mutex;
+
+	Thread *thread;
+	volatile bool exit_thread;
+	uint32_t interval_usec;
+
+	Map<const GDScriptFunction *, int> function_frames;
+	Vector<FrameInfo> frames;
+	Vector<Node> nodes;
+	Vector<int> thread_roots;
+	Map<uint64_t, uint64_t> line_samples; // (frame << 32 | line) -> self samples.
+	uint64_t sample_count;
+
+	static void _thread_func(void *p_user);
+	static ThreadStack *_register_thread();
+
+	void _capture();
+	void _add_sample(const Sample &p_sample);
+	int _get_frame(const GDScriptFunction *p_function);
+	int _get_child(int p_node, int p_frame);
+	void _get_node_stack(int p_node, Vector<int> &r_stack) const;
+
+public:
+	static bool active; // Checked by the VM before touching the shadow stacks.
+
+	_FORCE_INLINE_ static GDScriptSampler *get_singleton() { return singleton; }
+
+	// Called by GDScriptFunction::call(). push_frame() returns NULL if the frame couldn't be
+	// recorded, in which case pop_frame() must not be called either.
+	static Frame *push_frame(const GDScriptFunction *p_function, int p_line);
+	static void pop_frame();
+
+	void function_freed(const GDScriptFunction *p_function);
+
+	Error start(uint32_t p_interval_usec);
+	void stop();
+	bool is_running() const { return thread != NULL; }
+	void clear();
+
+	// Moves the pending samples from the ring buffer into the profiles.
+	void drain();
+
+	uint64_t get_sample_count() const { return sample_count; }
+	uint32_t get_dropped_sample_count() const { return dropped_samples; }
+
+	// Functions and lines sorted by self samples, highest first.
+	void get_function_profile(Vector<FlatEntry> &r_entries) const;
+	void get_line_profile(Vector<FlatEntry> &r_entries) const;
+	void print_profile(int p_max_entries = 20) const;
+
+	// Call tree in the speedscope format (https://www.speedscope.app), one profile per thread.
+	Dictionary get_speedscope_profile() const;
+	Error save_speedscope_profile(const String &p_path) const;
+
+	GDScriptSampler();
+	~GDScriptSampler();
+};
+
+#endif // GDSCRIPT_SAMPLER_H
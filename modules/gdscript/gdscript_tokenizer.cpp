@@ -1192,6 +1192,180 @@ void GDScriptTokenizerText::advance(int p_amount) {
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void GDScriptTokenizerRecorded::set_code(const String &p_code) {
+
+	tokens.clear();
+	identifiers.clear();
+	constants.clear();
+	position = 0;
+#ifdef DEBUG_ENABLED
+	warning_skips.clear();
+	warning_states.resize(1);
+	warning_states.write[0].ignore = false;
+	warning_states.write[0].global_skips.clear();
+#endif // DEBUG_ENABLED
+
+	Map<StringName, int> identifier_map;
+
+	GDScriptTokenizerText tt;
+	tt.set_code(p_code);
+
+	while (true) {
+
+		TokenData td;
+		td.type = tt.get_token();
+		td.line = tt.get_token_line();
+		td.col = tt.get_token_column();
+
+		switch (td.type) {
+			case TK_IDENTIFIER: {
+				StringName identifier = tt.get_token_identifier();
+				Map<StringName, int>::Element *E = identifier_map.find(identifier);
+				if (!E) {
+					E = identifier_map.insert(identifier, identifiers.size());
+					identifiers.push_back(identifier);
+				}
+				td.value = E->get();
+			} break;
+			case TK_CONSTANT: {
+				td.value = constants.size();
+				constants.push_back(tt.get_token_constant());
+			} break;
+			case TK_BUILT_IN_TYPE: {
+				td.value = tt.get_token_type();
+			} break;
+			case TK_BUILT_IN_FUNC: {
+				td.value = tt.get_token_built_in_func();
+			} break;
+			case TK_NEWLINE: {
+				td.value = constants.size();
+				constants.push_back(Vector2(tt.get_token_line_indent(), tt.get_token_line_tab_indent()));
+			} break;
+			case TK_ERROR: {
+				td.value = constants.size();
+				constants.push_back(tt.get_token_error());
+			} break;
+			default: {
+			}
+		}
+
+#ifdef DEBUG_ENABLED
+		// Annotations are only known once the text tokenizer reads their comment, which can be after some of
+		// the parsing, so keep track of what it knew at each token.
+		const WarningState &last_state = warning_states[warning_states.size() - 1];
+		if (tt.is_ignoring_warnings() != last_state.ignore || tt.get_warning_global_skips().size() != last_state.global_skips.size()) {
+			WarningState state;
+			state.ignore = tt.is_ignoring_warnings();
+			state.global_skips = tt.get_warning_global_skips();
+			warning_states.push_back(state);
+		}
+		td.warning_state = warning_states.size() - 1;
+#endif // DEBUG_ENABLED
+
+		tokens.push_back(td);
+
+		// The text tokenizer repeats the last token from here on.
+		if (td.type == TK_EOF || td.type == TK_ERROR) {
+			break;
+		}
+		tt.advance();
+	}
+
+#ifdef DEBUG_ENABLED
+	warning_skips = tt.get_warning_skips();
+#endif // DEBUG_ENABLED
+}
+
+const GDScriptTokenizerRecorded::TokenData &GDScriptTokenizerRecorded::_get_token_data(int p_offset) const {
+
+	int index = position + p_offset;
+	if (index < 0 || tokens.empty()) {
+		return empty_token; // Before the first token.
+	}
+	return tokens[MIN(index, tokens.size() - 1)];
+}
+
+GDScriptTokenizerRecorded::Token GDScriptTokenizerRecorded::get_token(int p_offset) const {
+
+	return _get_token_data(p_offset).type;
+}
+
+int GDScriptTokenizerRecorded::get_token_line(int p_offset) const {
+
+	return _get_token_data(p_offset).line;
+}
+
+int GDScriptTokenizerRecorded::get_token_column(int p_offset) const {
+
+	return _get_token_data(p_offset).col;
+}
+
+const Variant &GDScriptTokenizerRecorded::get_token_constant(int p_offset) const {
+
+	const TokenData &td = _get_token_data(p_offset);
+	ERR_FAIL_COND_V(td.type != TK_CONSTANT, nil);
+	return constants[td.value];
+}
+
+StringName GDScriptTokenizerRecorded::get_token_identifier(int p_offset) const {
+
+	const TokenData &td = _get_token_data(p_offset);
+	ERR_FAIL_COND_V(td.type != TK_IDENTIFIER, StringName());
+	return identifiers[td.value];
+}
+
+GDScriptFunctions::Function GDScriptTokenizerRecorded::get_token_built_in_func(int p_offset) const {
+
+	const TokenData &td = _get_token_data(p_offset);
+	ERR_FAIL_COND_V(td.type != TK_BUILT_IN_FUNC, GDScriptFunctions::FUNC_MAX);
+	return GDScriptFunctions::Function(td.value);
+}
+
+Variant::Type GDScriptTokenizerRecorded::get_token_type(int p_offset) const {
+
+	const TokenData &td = _get_token_data(p_offset);
+	ERR_FAIL_COND_V(td.type != TK_BUILT_IN_TYPE, Variant::NIL);
+	return Variant::Type(td.value);
+}
+
+int GDScriptTokenizerRecorded::get_token_line_indent(int p_offset) const {
+
+	const TokenData &td = _get_token_data(p_offset);
+	ERR_FAIL_COND_V(td.type != TK_NEWLINE, 0);
+	return constants[td.value].operator Vector2().x;
+}
+
+int GDScriptTokenizerRecorded::get_token_line_tab_indent(int p_offset) const {
+
+	const TokenData &td = _get_token_data(p_offset);
+	ERR_FAIL_COND_V(td.type != TK_NEWLINE, 0);
+	return constants[td.value].operator Vector2().y;
+}
+
+String GDScriptTokenizerRecorded::get_token_error(int p_offset) const {
+
+	const TokenData &td = _get_token_data(p_offset);
+	ERR_FAIL_COND_V(td.type != TK_ERROR, String());
+	return constants[td.value];
+}
+
+void GDScriptTokenizerRecorded::advance(int p_amount) {
+
+	ERR_FAIL_COND(p_amount <= 0);
+	position += p_amount;
+}
+
+GDScriptTokenizerRecorded::GDScriptTokenizerRecorded() {
+
+	position = 0;
+#ifdef DEBUG_ENABLED
+	warning_states.resize(1);
+	warning_states.write[0].ignore = false;
+#endif // DEBUG_ENABLED
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+
 #define BYTECODE_VERSION 13
 
 Error GDScriptTokenizerBuffer::set_code_buffer(const Vector<uint8_t> &p_buffer) {
@@ -250,6 +250,71 @@ public:
 #endif // DEBUG_ENABLED
 };
 
+// Runs a GDScriptTokenizerText over a whole script up front and replays its tokens, so
+// scripts can be tokenized on other threads ahead of being parsed. The parser sees exactly
+// what the text tokenizer would have given it, warning annotations included.
+class GDScriptTokenizerRecorded : public GDScriptTokenizer {
+
+	struct TokenData {
+		Token type;
+		int line;
+		int col;
+		int value; // Identifier or constant index, or the built-in type or function.
+#ifdef DEBUG_ENABLED
+		int warning_state; // Index in warning_states.
+#endif // DEBUG_ENABLED
+		TokenData() {
+			type = TK_EMPTY;
+			line = col = value = 0;
+#ifdef DEBUG_ENABLED
+			warning_state = 0;
+#endif // DEBUG_ENABLED
+		}
+	};
+
+	Vector<TokenData> tokens;
+	TokenData empty_token;
+	Vector<StringName> identifiers;
+	Vector<Variant> constants; // Also holds newline indents and errors, like the text tokenizer.
+	int position;
+	Variant nil;
+
+#ifdef DEBUG_ENABLED
+	// Warning annotations known to the text tokenizer at each token.
+	struct WarningState {
+		bool ignore;
+		Set<String> global_skips;
+	};
+
+	Vector<Pair<int, String> > warning_skips;
+	Vector<WarningState> warning_states;
+#endif // DEBUG_ENABLED
+
+	const TokenData &_get_token_data(int p_offset) const;
+
+public:
+	void set_code(const String &p_code);
+	int get_token_count() const { return tokens.size(); }
+
+	virtual Token get_token(int p_offset = 0) const;
+	virtual StringName get_token_identifier(int p_offset = 0) const;
+	virtual GDScriptFunctions::Function get_token_built_in_func(int p_offset = 0) const;
+	virtual Variant::Type get_token_type(int p_offset = 0) const;
+	virtual int get_token_line(int p_offset = 0) const;
+	virtual int get_token_column(int p_offset = 0) const;
+	virtual int get_token_line_indent(int p_offset = 0) const;
+	virtual int get_token_line_tab_indent(int p_offset = 0) const;
+	virtual const Variant &get_token_constant(int p_offset = 0) const;
+	virtual String get_token_error(int p_offset = 0) const;
+	virtual void advance(int p_amount = 1);
+#ifdef DEBUG_ENABLED
+	virtual const Vector<Pair<int, String> > &get_warning_skips() const { return warning_skips; }
+	virtual const Set<String> &get_warning_global_skips() const { return warning_states[_get_token_data(0).warning_state].global_skips; }
+	virtual bool is_ignoring_warnings() const { return warning_states[_get_token_data(0).warning_state].ignore; }
+#endif // DEBUG_ENABLED
+	GDScriptTokenizerRecorded();
+};
+
 class GDScriptTokenizerBuffer : public GDScriptTokenizer {
 
 	enum {
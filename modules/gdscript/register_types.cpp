@@ -35,6 +35,7 @@
 #include "core/os/dir_access.h"
 #include "core/os/file_access.h"
 #include "gdscript.h"
+#include "gdscript_compiled_buffer.h"
 #include "gdscript_tokenizer.h"
 
 GDScriptLanguage *script_language_gd = NULL;
@@ -57,7 +58,14 @@ class EditorExportGDScript : public EditorExportPlugin {
 
 	GDCLASS(EditorExportGDScript, EditorExportPlugin);
 
+	bool debug; // Scripts are compiled for the templates the export uses.
+
 public:
+	virtual void _export_begin(const Set<String> &p_features, bool p_debug, const String &p_path, int p_flags) {
+
+		debug = p_debug;
+	}
+
 	virtual void _export_file(const String &p_path, const String &p_type, const Set<String> &p_features) {
 
 		int script_mode = EditorExportPreset::MODE_SCRIPT_COMPILED;
@@ -83,6 +91,21 @@ public:
 
 		if (!file.empty()) {
 
+			// Store the compiled code along the tokens, so loading it won't need to parse and compile.
+			Ref<GDScript> script;
+			script.instance();
+			script->set_script_path(p_path);
+			script->set_source_code(txt);
+			if (script->reload_for_export(debug) == OK && script->is_valid()) {
+				GDScriptCompiledBuffer compiled;
+				Vector<uint8_t> buffer = compiled.save(script, file);
+				if (!buffer.empty()) {
+					file = buffer;
+				} else {
+					WARN_PRINT("Script '" + p_path + "' will be compiled when loaded: " + compiled.get_error());
+				}
+			}
+
 			if (script_mode == EditorExportPreset::MODE_SCRIPT_ENCRYPTED) {
 
 				String tmp_path = EditorSettings::get_singleton()->get_cache_dir().plus_file("script.gde");
@@ -132,6 +155,11 @@ public:
 			}
 		}
 	}
+
+	EditorExportGDScript() {
+
+		debug = true;
+	}
 };
 
 static void _editor_init() {
@@ -2844,6 +2844,34 @@ void Animation::clear() {
 	emit_signal(SceneStringNames::get_singleton()->tracks_changed);
 }
 
+uint64_t Animation::get_memory_size_estimate() const {
+
+	uint64_t size = sizeof(Animation);
+	for (int i = 0; i < tracks.size(); i++) {
+		switch (tracks[i]->type) {
+			case TYPE_VALUE: {
+				size += sizeof(ValueTrack) + static_cast<const ValueTrack *>(tracks[i])->values.size() * sizeof(TKey<Variant>);
+			} break;
+			case TYPE_TRANSFORM: {
+				size += sizeof(TransformTrack) + static_cast<const TransformTrack *>(tracks[i])->transforms.size() * sizeof(TKey<TransformKey>);
+			} break;
+			case TYPE_METHOD: {
+				size += sizeof(MethodTrack) + static_cast<const MethodTrack *>(tracks[i])->methods.size() * sizeof(MethodKey);
+			} break;
+			case TYPE_BEZIER: {
+				size += sizeof(BezierTrack) + static_cast<const BezierTrack *>(tracks[i])->values.size() * sizeof(TKey<BezierKey>);
+			} break;
+			case TYPE_AUDIO: {
+				size += sizeof(AudioTrack) + static_cast<const AudioTrack *>(tracks[i])->values.size() * sizeof(TKey<AudioKey>);
+			} break;
+			case TYPE_ANIMATION: {
+				size += sizeof(AnimationTrack) + static_cast<const AnimationTrack *>(tracks[i])->values.size() * sizeof(TKey<StringName>);
+			} break;
+		}
+	}
+	return size;
+}
+
 bool Animation::_transform_track_optimize_key(const TKey<TransformKey> &t0, const TKey<TransformKey> &t1, const TKey<TransformKey> &t2, float p_alowed_linear_err, float p_alowed_angular_err, float p_max_optimizable_angle, const Vector3 &p_norm) {
 
 	real_t c = (t1.time - t0.time) / (t2.time - t0.time);
@@ -368,6 +368,8 @@ public:
 
 	void clear();
 
+	virtual uint64_t get_memory_size_estimate() const;
+
 	void optimize(float p_allowed_linear_err = 0.05, float p_allowed_angular_err = 0.01, float p_max_optimizable_angle = Math_PI * 0.125);
 
 	Animation();
@@ -517,6 +517,11 @@ Vector<uint8_t> AudioStreamSample::get_data() const {
 	return pv;
 }
 
+uint64_t AudioStreamSample::get_memory_size_estimate() const {
+
+	return sizeof(AudioStreamSample) + data_bytes;
+}
+
 Error AudioStreamSample::save_to_wav(const String &p_path) {
 	if (format == AudioStreamSample::FORMAT_IMA_ADPCM) {
 		WARN_PRINT("Saving IMA_ADPC samples are not supported yet");
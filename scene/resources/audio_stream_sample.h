@@ -140,6 +140,7 @@ public:
 
 	void set_data(const Vector<uint8_t> &p_data);
 	Vector<uint8_t> get_data() const;
+	virtual uint64_t get_memory_size_estimate() const;
 
 	Error save_to_wav(const String &p_path);
 
@@ -80,6 +80,11 @@ real_t HeightMapShape::get_enclosing_radius() const {
 	return Vector3(real_t(map_width), max_height - min_height, real_t(map_depth)).length();
 }
 
+uint64_t HeightMapShape::get_memory_size_estimate() const {
+	// The heights are copied to the physics server too.
+	return sizeof(HeightMapShape) + uint64_t(map_data.size()) * sizeof(float) * 2;
+}
+
 void HeightMapShape::_update_shape() {
 
 	Dictionary d;
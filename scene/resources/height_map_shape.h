@@ -57,6 +57,8 @@ public:
 	virtual Vector<Vector3> get_debug_mesh_lines();
 	virtual real_t get_enclosing_radius() const;
 
+	virtual uint64_t get_memory_size_estimate() const;
+
 	HeightMapShape();
 };
 
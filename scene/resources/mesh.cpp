@@ -1313,6 +1313,21 @@ RID ArrayMesh::get_rid() const {
 	_create_if_empty();
 	return mesh;
 }
+
+uint64_t ArrayMesh::get_memory_size_estimate() const {
+
+	uint64_t size = sizeof(ArrayMesh);
+	for (int i = 0; i < surfaces.size(); i++) {
+		const Surface &s = surfaces[i];
+		// Vertex arrays, plus one copy of them for each blend shape.
+		uint64_t vertex_size = uint64_t(VS::get_singleton()->mesh_surface_get_format_stride(s.format, s.array_length, s.index_array_length)) * s.array_length;
+		size += vertex_size * (1 + blend_shapes.size());
+		if (s.index_array_length > 0) {
+			size += uint64_t(s.index_array_length) * (s.array_length >= (1 << 16) ? 4 : 2);
+		}
+	}
+	return size;
+}
 AABB ArrayMesh::get_aabb() const {
 
 	return aabb;
@@ -1362,6 +1377,78 @@ void ArrayMesh::regen_normalmaps() {
 	}
 }
 
+void ArrayMesh::generate_lods() {
+
+	if (surfaces.size() == 0) {
+		return;
+	}
+
+	Vector<VS::SurfaceData> surface_data;
+
+	for (int i = 0; i < surfaces.size(); i++) {
+
+		VS::SurfaceData sd = VS::get_singleton()->mesh_get_surface(mesh, i);
+		sd.lods.clear();
+		if (surfaces[i].material.is_valid()) {
+			sd.material = surfaces[i].material->get_rid();
+		}
+
+		if (surfaces[i].primitive == PRIMITIVE_TRIANGLES && !surfaces[i].is_2d && sd.index_count > 0) {
+
+			Array arrays = surface_get_arrays(i);
+			Vector<Vector3> vertices = arrays[ARRAY_VERTEX];
+			Vector<int> indices = arrays[ARRAY_INDEX];
+			bool is_index_16 = sd.vertex_count <= 65536;
+
+			int target_index_count = indices.size();
+			int last_index_count = indices.size();
+			float last_error = 0;
+
+			for (int j = 0; j < 8; j++) {
+
+				//halve the triangle count on each level
+				target_index_count = (target_index_count / 6) * 3;
+				if (target_index_count < 36) {
+					break;
+				}
+
+				float error;
+				Vector<int> lod_indices = SurfaceTool::simplify_indices(vertices, indices, target_index_count, &error);
+				if (lod_indices.size() == 0 || lod_indices.size() > last_index_count * 3 / 4) {
+					break; //not worth it, seams and borders are probably keeping it from simplifying further
+				}
+
+				VS::SurfaceData::LOD lod;
+				//must be unique and increasing, even when simplification was lossless
+				lod.edge_length = MAX(error, last_error + CMP_EPSILON);
+				lod.index_data.resize(lod_indices.size() * (is_index_16 ? 2 : 4));
+				uint8_t *w = lod.index_data.ptrw();
+				for (int k = 0; k < lod_indices.size(); k++) {
+					if (is_index_16) {
+						((uint16_t *)w)[k] = lod_indices[k];
+					} else {
+						((uint32_t *)w)[k] = lod_indices[k];
+					}
+				}
+
+				sd.lods.push_back(lod);
+				last_error = lod.edge_length;
+				last_index_count = lod_indices.size();
+			}
+		}
+
+		surface_data.push_back(sd);
+	}
+
+	VS::get_singleton()->mesh_clear(mesh);
+	for (int i = 0; i < surface_data.size(); i++) {
+		VS::get_singleton()->mesh_add_surface(mesh, surface_data[i]);
+	}
+
+	clear_cache();
+	emit_changed();
+}
+
 //dirty hack
 bool (*array_mesh_lightmap_unwrap_callback)(float p_texel_size, const float *p_vertices, const float *p_normals, int p_vertex_count, const int *p_indices, const int *p_face_materials, int p_index_count, float **r_uv, int **r_vertex, int *r_vertex_count, int **r_index, int *r_index_count, int *r_size_hint_x, int *r_size_hint_y) = NULL;
 
@@ -1572,6 +1659,8 @@ void ArrayMesh::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("create_outline", "margin"), &ArrayMesh::create_outline);
 	ClassDB::bind_method(D_METHOD("regen_normalmaps"), &ArrayMesh::regen_normalmaps);
 	ClassDB::set_method_flags(get_class_static(), _scs_create("regen_normalmaps"), METHOD_FLAGS_DEFAULT | METHOD_FLAG_EDITOR);
+	ClassDB::bind_method(D_METHOD("generate_lods"), &ArrayMesh::generate_lods);
+	ClassDB::set_method_flags(get_class_static(), _scs_create("generate_lods"), METHOD_FLAGS_DEFAULT | METHOD_FLAG_EDITOR);
 	ClassDB::bind_method(D_METHOD("lightmap_unwrap", "transform", "texel_size"), &ArrayMesh::lightmap_unwrap);
 	ClassDB::set_method_flags(get_class_static(), _scs_create("lightmap_unwrap"), METHOD_FLAGS_DEFAULT | METHOD_FLAG_EDITOR);
 	ClassDB::bind_method(D_METHOD("get_faces"), &ArrayMesh::get_faces);
@@ -235,7 +235,10 @@ public:
 	AABB get_aabb() const;
 	virtual RID get_rid() const;
 
+	virtual uint64_t get_memory_size_estimate() const;
+
 	void regen_normalmaps();
+	void generate_lods();
 
 	Error lightmap_unwrap(const Transform &p_base_transform = Transform(), float p_texel_size = 0.05);
 
@@ -201,6 +201,10 @@ void MultiMesh::set_buffer(const Vector<float> &p_buffer) {
 	VS::get_singleton()->multimesh_set_buffer(multimesh, p_buffer);
 }
 
+void MultiMesh::set_buffer_range(int p_from_instance, const Vector<float> &p_buffer) {
+	VS::get_singleton()->multimesh_set_buffer_range(multimesh, p_from_instance, p_buffer);
+}
+
 Vector<float> MultiMesh::get_buffer() const {
 	return VS::get_singleton()->multimesh_get_buffer(multimesh);
 }
@@ -288,6 +292,19 @@ RID MultiMesh::get_rid() const {
 	return multimesh;
 }
 
+uint64_t MultiMesh::get_memory_size_estimate() const {
+
+	// Floats per instance in the buffer, see set_buffer().
+	int stride = transform_format == TRANSFORM_2D ? 8 : 12;
+	if (use_colors) {
+		stride += 4;
+	}
+	if (use_custom_data) {
+		stride += 4;
+	}
+	return sizeof(MultiMesh) + uint64_t(instance_count) * stride * sizeof(float);
+}
+
 void MultiMesh::set_use_colors(bool p_enable) {
 	ERR_FAIL_COND(instance_count > 0);
 	use_colors = p_enable;
@@ -339,6 +356,7 @@ void MultiMesh::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("get_instance_color", "instance"), &MultiMesh::get_instance_color);
 	ClassDB::bind_method(D_METHOD("set_instance_custom_data", "instance", "custom_data"), &MultiMesh::set_instance_custom_data);
 	ClassDB::bind_method(D_METHOD("get_instance_custom_data", "instance"), &MultiMesh::get_instance_custom_data);
+	ClassDB::bind_method(D_METHOD("set_buffer_range", "from_instance", "buffer"), &MultiMesh::set_buffer_range);
 	ClassDB::bind_method(D_METHOD("get_aabb"), &MultiMesh::get_aabb);
 
 	ClassDB::bind_method(D_METHOD("get_buffer"), &MultiMesh::get_buffer);
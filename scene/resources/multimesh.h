@@ -75,6 +75,8 @@ protected:
 	Vector<float> get_buffer() const;
 
 public:
+	void set_buffer_range(int p_from_instance, const Vector<float> &p_buffer);
+
 	void set_mesh(const Ref<Mesh> &p_mesh);
 	Ref<Mesh> get_mesh() const;
 
@@ -108,6 +110,8 @@ public:
 
 	virtual RID get_rid() const;
 
+	virtual uint64_t get_memory_size_estimate() const;
+
 	MultiMesh();
 	~MultiMesh();
 };
@@ -32,8 +32,10 @@
 
 #include "core/core_string_names.h"
 #include "core/engine.h"
+#include "core/hash_map.h"
 #include "core/io/resource_loader.h"
 #include "core/project_settings.h"
+#include "core/variant_internal.h"
 #include "scene/2d/node_2d.h"
 #include "scene/3d/spatial.h"
 #include "scene/gui/control.h"
@@ -41,6 +43,89 @@
 
 #define PACKED_SCENE_VERSION 2
 
+Vector<SceneState::PropertySetter> SceneState::_get_property_setters() const {
+
+	MutexLock lock(property_setters_mutex);
+
+	if (property_setters_valid) {
+		return property_setters;
+	}
+
+	property_setters.clear();
+
+	for (int i = 0; i < nodes.size(); i++) {
+
+		const NodeData &n = nodes[i];
+		// Only nodes created here from their own type have a known class, instanced
+		// and inherited ones are whatever their scene makes of them.
+		bool known_type = n.type != TYPE_INSTANCED && n.instance < 0 && !(i == 0 && base_scene_idx >= 0) && n.type >= 0 && n.type < names.size();
+
+		for (int j = 0; j < n.properties.size(); j++) {
+
+			PropertySetter setter;
+			setter.method = NULL;
+			setter.index = -1;
+			setter.ptrcall_type = Variant::VARIANT_MAX;
+
+			int name = n.properties[j].name;
+			if (known_type && name >= 0 && name < names.size() && names[name] != CoreStringNames::get_singleton()->_script) {
+
+				MethodBind *getter = NULL;
+				if (!ClassDB::get_property_binds(names[n.type], names[name], setter.method, getter, setter.index)) {
+					setter.method = NULL;
+				}
+			}
+
+#if defined(PTRCALL_ENABLED) && defined(DEBUG_METHODS_ENABLED)
+			if (setter.method && setter.index < 0 && !setter.method->is_vararg() && !setter.method->has_return() && setter.method->get_argument_count() == 1) {
+				Variant::Type type = setter.method->get_argument_type(0);
+				if (VariantInternal::is_ptrcall_type(type)) {
+					setter.ptrcall_type = type;
+				}
+			}
+#endif
+			property_setters.push_back(setter);
+		}
+	}
+
+	property_setters_valid = true;
+	return property_setters;
+}
+
+void SceneState::_invalidate_property_setters() {
+
+	MutexLock lock(property_setters_mutex);
+	property_setters_valid = false;
+	property_setters.clear();
+}
+
+void SceneState::_call_property_setter(Node *p_node, const PropertySetter &p_setter, Variant &p_value) {
+
+	p_node->_mark_edited(); // Like Object::set().
+
+#ifdef PTRCALL_ENABLED
+	if (p_setter.ptrcall_type == Variant::NIL) {
+		const void *arg = &p_value;
+		p_setter.method->ptrcall(p_node, &arg, NULL);
+		return;
+	} else if (p_setter.ptrcall_type == p_value.get_type()) {
+		const void *arg = VariantInternal::get_inline_pointer(&p_value);
+		p_setter.method->ptrcall(p_node, &arg, NULL);
+		return;
+	}
+#endif
+
+	Callable::CallError ce;
+	if (p_setter.index >= 0) {
+		Variant index = p_setter.index;
+		const Variant *args[2] = { &index, &p_value };
+		p_setter.method->call(p_node, args, 2, ce);
+	} else {
+		const Variant *args[1] = { &p_value };
+		p_setter.method->call(p_node, args, 1, ce);
+	}
+}
+
 bool SceneState::can_instance() const {
 
 	return nodes.size() > 0;
@@ -78,6 +163,9 @@ Node *SceneState::instance(GenEditState p_edit_state) const {
 
 	const NodeData *nd = &nodes[0];
 
+	Vector<PropertySetter> setters = _get_property_setters();
+	int setter_ofs = 0;
+
 	Node **ret_nodes = (Node **)alloca(sizeof(Node *) * nc);
 
 	bool gen_node_path_cache = p_edit_state != GEN_EDIT_STATE_DISABLED && node_path_cache.empty();
@@ -87,6 +175,8 @@ Node *SceneState::instance(GenEditState p_edit_state) const {
 	for (int i = 0; i < nc; i++) {
 
 		const NodeData &n = nd[i];
+		const PropertySetter *node_setters = setters.ptr() + setter_ofs;
+		setter_ofs += n.properties.size();
 
 		Node *parent = NULL;
 
@@ -189,6 +279,8 @@ Node *SceneState::instance(GenEditState p_edit_state) const {
 			if (nprop_count) {
 
 				const NodeData::Property *nprops = &n.properties[0];
+				// Setters resolved for the type only apply while the node is still that type.
+				bool direct_set = !disable_property_setters && n.type != TYPE_INSTANCED && n.type < sname_count && node->get_class_name() == snames[n.type];
 
 				for (int j = 0; j < nprop_count; j++) {
 
@@ -250,7 +342,11 @@ Node *SceneState::instance(GenEditState p_edit_state) const {
 						} else if (p_edit_state == GEN_EDIT_STATE_INSTANCE) {
 							value = value.duplicate(true); // Duplicate arrays and dictionaries for the editor
 						}
-						node->set(snames[nprops[j].name], value, &valid);
+						if (direct_set && node_setters[j].method && !node->get_script_instance()) {
+							_call_property_setter(node, node_setters[j], value);
+						} else {
+							node->set(snames[nprops[j].name], value, &valid);
+						}
 					}
 				}
 			}
@@ -932,6 +1028,7 @@ void SceneState::clear() {
 	node_paths.clear();
 	editable_instances.clear();
 	base_scene_idx = -1;
+	_invalidate_property_setters();
 }
 
 Ref<SceneState> SceneState::_get_base_scene_state() const {
@@ -1044,6 +1141,13 @@ void SceneState::set_disable_placeholders(bool p_disable) {
 	disable_placeholders = p_disable;
 }
 
+bool SceneState::disable_property_setters = false;
+
+void SceneState::set_disable_property_setters(bool p_disable) {
+
+	disable_property_setters = p_disable;
+}
+
 bool SceneState::is_connection(int p_node, const StringName &p_signal, int p_to_node, const StringName &p_to_method) const {
 
 	ERR_FAIL_COND_V(p_node < 0, false);
@@ -1200,6 +1304,8 @@ void SceneState::set_bundled_scene(const Dictionary &p_dictionary) {
 		editable_instances.write[i] = ei[i];
 	}
 
+	_invalidate_property_setters();
+
 	//path=p_dictionary["path"];
 }
 
@@ -1565,6 +1671,7 @@ int SceneState::add_node(int p_parent, int p_owner, int p_type, int p_name, int
 	nd.index = p_index;
 
 	nodes.push_back(nd);
+	_invalidate_property_setters();
 
 	return nodes.size() - 1;
 }
@@ -1578,6 +1685,7 @@ void SceneState::add_node_property(int p_node, int p_name, int p_value) {
 	prop.name = p_name;
 	prop.value = p_value;
 	nodes.write[p_node].properties.push_back(prop);
+	_invalidate_property_setters();
 }
 void SceneState::add_node_group(int p_node, int p_group) {
 
@@ -1589,6 +1697,7 @@ void SceneState::set_base_scene(int p_idx) {
 
 	ERR_FAIL_INDEX(p_idx, variants.size());
 	base_scene_idx = p_idx;
+	_invalidate_property_setters();
 }
 void SceneState::add_connection(int p_from, int p_to, int p_signal, int p_method, int p_flags, const Vector<int> &p_binds) {
 
@@ -1657,12 +1766,294 @@ SceneState::SceneState() {
 
 	base_scene_idx = -1;
 	last_modified_time = 0;
+	property_setters_valid = false;
 }
 
 ////////////////
 
+void PackedScene::_pool_get_nodes(Node *p_node, Vector<Node *> &r_nodes) {
+
+	r_nodes.push_back(p_node);
+	for (int i = 0; i < p_node->get_child_count(); i++) {
+		_pool_get_nodes(p_node->get_child(i), r_nodes);
+	}
+}
+
+void PackedScene::_pool_take_snapshot(Node *p_instance) {
+
+	Vector<Node *> nodes;
+	_pool_get_nodes(p_instance, nodes);
+
+	HashMap<ObjectID, int> indices;
+	for (int i = 0; i < nodes.size(); i++) {
+		indices[nodes[i]->get_instance_id()] = i;
+	}
+
+	pool_nodes.clear();
+	pool_properties.clear();
+	pool_connections.clear();
+
+	for (int i = 0; i < nodes.size(); i++) {
+
+		Node *node = nodes[i];
+
+		PoolNode pool_node;
+		pool_node.name = node->get_name();
+		pool_node.script = node->get_script();
+		node->get_groups(&pool_node.groups);
+
+		List<String> meta;
+		node->get_meta_list(&meta);
+		for (List<String>::Element *E = meta.front(); E; E = E->next()) {
+			pool_node.meta[E->get()] = node->get_meta(E->get()).duplicate(true);
+		}
+
+		pool_node.process = node->is_processing();
+		pool_node.physics_process = node->is_physics_processing();
+		pool_node.process_internal = node->is_processing_internal();
+		pool_node.physics_process_internal = node->is_physics_processing_internal();
+		pool_node.process_input = node->is_processing_input();
+		pool_node.process_unhandled_input = node->is_processing_unhandled_input();
+		pool_node.process_unhandled_key_input = node->is_processing_unhandled_key_input();
+		pool_nodes.push_back(pool_node);
+
+		List<PropertyInfo> plist;
+		node->get_property_list(&plist);
+
+		for (List<PropertyInfo>::Element *E = plist.front(); E; E = E->next()) {
+
+			if (!(E->get().usage & PROPERTY_USAGE_STORAGE) || E->get().name == "script") {
+				continue;
+			}
+
+			PoolProperty prop;
+			prop.node = i;
+			prop.name = E->get().name;
+			prop.value = node->get(prop.name);
+
+			MethodBind *setter = NULL;
+			if (!ClassDB::get_property_binds(node->get_class_name(), prop.name, setter, prop.getter, prop.index)) {
+				prop.getter = NULL;
+			}
+
+			if (prop.value.get_type() == Variant::OBJECT) {
+				// Each instance has its own copy of resources local to scene, leave them be.
+				Ref<Resource> res = prop.value;
+				if (res.is_valid() && res->is_local_to_scene()) {
+					continue;
+				}
+			} else if (prop.value.get_type() == Variant::ARRAY || prop.value.get_type() == Variant::DICTIONARY) {
+				prop.value = prop.value.duplicate(true); // Instances can change these in place.
+			}
+
+			pool_properties.push_back(prop);
+		}
+
+		List<Connection> connections;
+		node->get_all_signal_connections(&connections);
+
+		for (List<Connection>::Element *E = connections.front(); E; E = E->next()) {
+
+			const Connection &c = E->get();
+			const int *to = c.callable.is_custom() || !c.callable.get_object() ? NULL : indices.getptr(c.callable.get_object()->get_instance_id());
+			if (!to) {
+				continue;
+			}
+
+			PoolConnection conn;
+			conn.from = i;
+			conn.to = *to;
+			conn.signal = c.signal.get_name();
+			conn.method = c.callable.get_method();
+			conn.binds = c.binds;
+			conn.flags = c.flags;
+			pool_connections.push_back(conn);
+		}
+	}
+
+	pool_snapshot_valid = true;
+}
+
+bool PackedScene::_pool_reset(Node *p_instance) {
+
+	Vector<Node *> nodes;
+	_pool_get_nodes(p_instance, nodes);
+
+	// Nodes added, removed or moved since the instance was made can't be put back in place.
+	if (nodes.size() != pool_nodes.size()) {
+		return false;
+	}
+	for (int i = 0; i < nodes.size(); i++) {
+		if ((i > 0 && nodes[i]->get_name() != pool_nodes[i].name) || Ref<Script>(nodes[i]->get_script()) != pool_nodes[i].script) {
+			return false;
+		}
+	}
+
+	// Before the properties, like in a new instance the script is set up first and the stored values are set on it.
+	for (int i = 0; i < nodes.size(); i++) {
+		if (nodes[i]->get_script_instance() && !nodes[i]->get_script_instance()->reset_state()) {
+			return false;
+		}
+	}
+	Vector<Node *> nodes_after_scripts;
+	_pool_get_nodes(p_instance, nodes_after_scripts);
+	for (int i = 0; i < nodes.size(); i++) {
+		if (nodes_after_scripts.size() != nodes.size() || nodes_after_scripts[i] != nodes[i]) {
+			return false; // Changed its nodes while resetting.
+		}
+	}
+
+	HashMap<ObjectID, int> indices;
+	for (int i = 0; i < nodes.size(); i++) {
+		indices[nodes[i]->get_instance_id()] = i;
+	}
+
+	p_instance->set_name(pool_nodes[0].name);
+
+	// Only set what changed since the instance was made.
+	for (int i = 0; i < pool_properties.size(); i++) {
+
+		const PoolProperty &prop = pool_properties[i];
+		Node *node = nodes[prop.node];
+
+		Variant value;
+		if (prop.getter) {
+			Callable::CallError ce;
+			if (prop.index >= 0) {
+				Variant index = prop.index;
+				const Variant *args[1] = { &index };
+				value = prop.getter->call(node, args, 1, ce);
+			} else {
+				value = prop.getter->call(node, NULL, 0, ce);
+			}
+		} else {
+			value = node->get(prop.name);
+		}
+
+		if (value != prop.value) {
+			if (prop.value.get_type() == Variant::ARRAY || prop.value.get_type() == Variant::DICTIONARY) {
+				node->set(prop.name, prop.value.duplicate(true));
+			} else {
+				node->set(prop.name, prop.value);
+			}
+		}
+	}
+
+	Vector<bool> connected;
+	connected.resize(pool_connections.size());
+	for (int i = 0; i < connected.size(); i++) {
+		connected.write[i] = false;
+	}
+
+	for (int i = 0; i < nodes.size(); i++) {
+
+		Node *node = nodes[i];
+		const PoolNode &pool_node = pool_nodes[i];
+
+		// Keep the connections between nodes of the instance that it was made with, drop the ones made since.
+		// Connections with other objects than nodes, like resources, are made and cleared by the property setters.
+		List<Connection> connections;
+		node->get_all_signal_connections(&connections);
+
+		for (List<Connection>::Element *E = connections.front(); E; E = E->next()) {
+
+			const Connection &c = E->get();
+			if (c.callable.is_custom() || !Object::cast_to<Node>(c.callable.get_object())) {
+				continue;
+			}
+
+			const int *to = indices.getptr(c.callable.get_object()->get_instance_id());
+			int found = -1;
+			for (int j = 0; to && j < pool_connections.size(); j++) {
+				const PoolConnection &conn = pool_connections[j];
+				if (!connected[j] && conn.from == i && conn.to == *to && conn.signal == c.signal.get_name() && conn.method == c.callable.get_method()) {
+					found = j;
+					break;
+				}
+			}
+
+			if (found != -1) {
+				connected.write[found] = true;
+			} else {
+				node->disconnect(c.signal.get_name(), c.callable);
+			}
+		}
+
+		connections.clear();
+		node->get_signals_connected_to_this(&connections);
+
+		for (List<Connection>::Element *E = connections.front(); E; E = E->next()) {
+
+			const Connection &c = E->get();
+			Node *source = Object::cast_to<Node>(c.signal.get_object());
+			if (source && !indices.has(source->get_instance_id())) {
+				source->disconnect(c.signal.get_name(), c.callable);
+			}
+		}
+
+		// After the properties, whose setters can change these, and before the groups, which processing is kept in.
+		node->set_process(pool_node.process);
+		node->set_physics_process(pool_node.physics_process);
+		node->set_process_internal(pool_node.process_internal);
+		node->set_physics_process_internal(pool_node.physics_process_internal);
+		node->set_process_input(pool_node.process_input);
+		node->set_process_unhandled_input(pool_node.process_unhandled_input);
+		node->set_process_unhandled_key_input(pool_node.process_unhandled_key_input);
+
+		List<Node::GroupInfo> groups;
+		node->get_groups(&groups);
+
+		for (List<Node::GroupInfo>::Element *E = groups.front(); E; E = E->next()) {
+
+			bool keep = false;
+			for (const List<Node::GroupInfo>::Element *F = pool_node.groups.front(); F; F = F->next()) {
+				if (F->get().name == E->get().name && F->get().persistent == E->get().persistent) {
+					keep = true;
+					break;
+				}
+			}
+			if (!keep) {
+				node->remove_from_group(E->get().name);
+			}
+		}
+		for (const List<Node::GroupInfo>::Element *F = pool_node.groups.front(); F; F = F->next()) {
+			if (!node->is_in_group(F->get().name)) {
+				node->add_to_group(F->get().name, F->get().persistent);
+			}
+		}
+
+		List<String> meta;
+		node->get_meta_list(&meta);
+
+		for (List<String>::Element *E = meta.front(); E; E = E->next()) {
+			if (!pool_node.meta.has(E->get())) {
+				node->remove_meta(E->get());
+			}
+		}
+		for (const Variant *key = pool_node.meta.next(); key; key = pool_node.meta.next(key)) {
+			const Variant &value = pool_node.meta[*key];
+			if (!node->has_meta(*key) || node->get_meta(*key) != value) {
+				node->set_meta(*key, value.duplicate(true));
+			}
+		}
+
+		node->request_ready();
+	}
+
+	for (int i = 0; i < pool_connections.size(); i++) {
+
+		if (!connected[i]) {
+			const PoolConnection &conn = pool_connections[i];
+			nodes[conn.from]->connect(conn.signal, Callable(nodes[conn.to], conn.method), conn.binds, conn.flags);
+		}
+	}
+
+	return true;
+}
+
 void PackedScene::_set_bundled_scene(const Dictionary &p_scene) {
 
+	clear_pool();
 	state->set_bundled_scene(p_scene);
 }
 
@@ -1673,11 +2064,13 @@ Dictionary PackedScene::_get_bundled_scene() const {
 
 Error PackedScene::pack(Node *p_scene) {
 
+	clear_pool();
 	return state->pack(p_scene);
 }
 
 void PackedScene::clear() {
 
+	clear_pool();
 	state->clear();
 }
 
@@ -1708,8 +2101,111 @@ Node *PackedScene::instance(GenEditState p_edit_state) const {
 	return s;
 }
 
+Node *PackedScene::instance_pooled() {
+
+	{
+		MutexLock lock(pool_mutex);
+		while (pool.size()) {
+			Node *node = Object::cast_to<Node>(ObjectDB::get_instance(pool.front()->get()));
+			pool.pop_front();
+			if (node) {
+				return node;
+			}
+		}
+	}
+
+	Node *node = instance();
+	ERR_FAIL_COND_V(!node, NULL);
+
+	MutexLock lock(pool_mutex);
+	if (!pool_snapshot_valid) {
+		_pool_take_snapshot(node);
+	}
+
+	return node;
+}
+
+void PackedScene::recycle(Node *p_node) {
+
+	ERR_FAIL_NULL(p_node);
+	ERR_FAIL_COND_MSG(get_path() != "" && get_path().find("::") == -1 && p_node->get_filename() != get_path(), "Node is not an instance of this scene.");
+	ERR_FAIL_COND_MSG(p_node->is_queued_for_deletion(), "Node is queued for deletion.");
+
+	if (p_node->get_parent()) {
+		p_node->get_parent()->remove_child(p_node);
+	}
+
+	MutexLock lock(pool_mutex);
+
+	if (!pool_snapshot_valid) {
+		// The snapshot must come from an untouched instance, which can then join the pool.
+		Node *fresh = instance();
+		if (fresh) {
+			_pool_take_snapshot(fresh);
+			pool.push_back(fresh->get_instance_id());
+		}
+	}
+
+	if ((pool_max_size > 0 && pool.size() >= pool_max_size) || !pool_snapshot_valid || !_pool_reset(p_node)) {
+		memdelete(p_node);
+		return;
+	}
+
+	pool.push_back(p_node->get_instance_id());
+}
+
+void PackedScene::prewarm_pool(int p_count) {
+
+	MutexLock lock(pool_mutex);
+
+	while (pool.size() < p_count && (pool_max_size <= 0 || pool.size() < pool_max_size)) {
+
+		Node *node = instance();
+		ERR_FAIL_COND(!node);
+		if (!pool_snapshot_valid) {
+			_pool_take_snapshot(node);
+		}
+		pool.push_back(node->get_instance_id());
+	}
+}
+
+void PackedScene::clear_pool() {
+
+	MutexLock lock(pool_mutex);
+
+	while (pool.size()) {
+		Object *obj = ObjectDB::get_instance(pool.front()->get());
+		pool.pop_front();
+		if (obj) {
+			memdelete(obj);
+		}
+	}
+
+	pool_snapshot_valid = false;
+	pool_nodes.clear();
+	pool_properties.clear();
+	pool_connections.clear();
+}
+
+int PackedScene::get_pool_count() {
+
+	MutexLock lock(pool_mutex);
+	return pool.size();
+}
+
+void PackedScene::set_pool_max_size(int p_size) {
+
+	pool_max_size = p_size;
+}
+
+int PackedScene::get_pool_max_size() const {
+
+	return pool_max_size;
+}
+
 void PackedScene::replace_state(Ref<SceneState> p_by) {
 
+	clear_pool();
 	state = p_by;
 	state->set_path(get_path());
 #ifdef TOOLS_ENABLED
@@ -1719,6 +2215,7 @@ void PackedScene::replace_state(Ref<SceneState> p_by) {
 
 void PackedScene::recreate_state() {
 
+	clear_pool();
 	state = Ref<SceneState>(memnew(SceneState));
 	state->set_path(get_path());
 #ifdef TOOLS_ENABLED
@@ -1745,6 +2242,13 @@ void PackedScene::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("_set_bundled_scene"), &PackedScene::_set_bundled_scene);
 	ClassDB::bind_method(D_METHOD("_get_bundled_scene"), &PackedScene::_get_bundled_scene);
 	ClassDB::bind_method(D_METHOD("get_state"), &PackedScene::get_state);
+	ClassDB::bind_method(D_METHOD("instance_pooled"), &PackedScene::instance_pooled);
+	ClassDB::bind_method(D_METHOD("recycle", "node"), &PackedScene::recycle);
+	ClassDB::bind_method(D_METHOD("prewarm_pool", "count"), &PackedScene::prewarm_pool);
+	ClassDB::bind_method(D_METHOD("clear_pool"), &PackedScene::clear_pool);
+	ClassDB::bind_method(D_METHOD("get_pool_count"), &PackedScene::get_pool_count);
+	ClassDB::bind_method(D_METHOD("set_pool_max_size", "size"), &PackedScene::set_pool_max_size);
+	ClassDB::bind_method(D_METHOD("get_pool_max_size"), &PackedScene::get_pool_max_size);
 
 	ADD_PROPERTY(PropertyInfo(Variant::DICTIONARY, "_bundled"), "_set_bundled_scene", "_get_bundled_scene");
 
@@ -1756,4 +2260,11 @@ void PackedScene::_bind_methods() {
 PackedScene::PackedScene() {
 
 	state = Ref<SceneState>(memnew(SceneState));
+	pool_max_size = 0;
+	pool_snapshot_valid = false;
+}
+
+PackedScene::~PackedScene() {
+
+	clear_pool();
 }
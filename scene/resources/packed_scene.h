@@ -31,6 +31,7 @@
 #ifndef PACKED_SCENE_H
 #define PACKED_SCENE_H
 
+#include "core/os/mutex.h"
 #include "core/resource.h"
 #include "scene/main/node.h"
 
@@ -92,6 +93,23 @@ class SceneState : public Reference {
 
 	Vector<ConnectionData> connections;
 
+	// Setter of a stored property, resolved from the node type so instance() can call it
+	// directly instead of looking it up through Object::set() on every instance.
+	struct PropertySetter {
+
+		MethodBind *method; // NULL when the property must go through Object::set().
+		int index;
+		Variant::Type ptrcall_type; // Argument type when the setter can be ptrcalled, VARIANT_MAX otherwise.
+	};
+
+	mutable Mutex property_setters_mutex;
+	mutable Vector<PropertySetter> property_setters; // Properties of all nodes, in node order.
+	mutable bool property_setters_valid;
+
+	Vector<PropertySetter> _get_property_setters() const;
+	void _invalidate_property_setters();
+	static void _call_property_setter(Node *p_node, const PropertySetter &p_setter, Variant &p_value);
+
 	Error _parse_node(Node *p_owner, Node *p_node, int p_parent_idx, Map<StringName, int> &name_map, HashMap<Variant, int, VariantHasher, VariantComparator> &variant_map, Map<Node *, int> &node_map, Map<Node *, int> &nodepath_map);
 	Error _parse_connections(Node *p_owner, Node *p_node, Map<StringName, int> &name_map, HashMap<Variant, int, VariantHasher, VariantComparator> &variant_map, Map<Node *, int> &node_map, Map<Node *, int> &nodepath_map);
 
@@ -102,6 +120,7 @@ class SceneState : public Reference {
 	_FORCE_INLINE_ Ref<SceneState> _get_base_scene_state() const;
 
 	static bool disable_placeholders;
+	static bool disable_property_setters;
 
 	Vector<String> _get_node_groups(int p_idx) const;
 
@@ -125,6 +144,7 @@ public:
 	};
 
 	static void set_disable_placeholders(bool p_disable);
+	static void set_disable_property_setters(bool p_disable); // Set every property through Object::set(), to compare against.
 
 	int find_node_by_path(const NodePath &p_node) const;
 	Variant get_property_value(int p_node, const StringName &p_property, bool &found) const;
@@ -201,6 +221,56 @@ class PackedScene : public Resource {
 
 	Ref<SceneState> state;
 
+	// Instances kept aside by recycle() to be handed out again by instance_pooled(). They
+	// are reset to the values a fresh instance has, recorded once in the pool snapshot.
+	// Script instances reset themselves, see ScriptInstance::reset_state().
+	struct PoolProperty {
+
+		int node; // Index in the depth-first node order.
+		StringName name;
+		Variant value;
+		MethodBind *getter; // Resolved once so checking the value is a call, NULL when it goes through Object::get().
+		int index;
+	};
+
+	struct PoolNode {
+
+		StringName name;
+		Ref<Script> script;
+		List<Node::GroupInfo> groups;
+		Dictionary meta;
+		bool process;
+		bool physics_process;
+		bool process_internal;
+		bool physics_process_internal;
+		bool process_input;
+		bool process_unhandled_input;
+		bool process_unhandled_key_input;
+	};
+
+	// A connection between two nodes of the instance.
+	struct PoolConnection {
+
+		int from;
+		int to;
+		StringName signal;
+		StringName method;
+		Vector<Variant> binds;
+		uint32_t flags;
+	};
+
+	Mutex pool_mutex;
+	List<ObjectID> pool;
+	int pool_max_size;
+	bool pool_snapshot_valid;
+	Vector<PoolNode> pool_nodes; // Depth-first, the root first.
+	Vector<PoolProperty> pool_properties;
+	Vector<PoolConnection> pool_connections;
+
+	static void _pool_get_nodes(Node *p_node, Vector<Node *> &r_nodes);
+	void _pool_take_snapshot(Node *p_instance);
+	bool _pool_reset(Node *p_instance);
+
 	void _set_bundled_scene(const Dictionary &p_scene);
 	Dictionary _get_bundled_scene() const;
 
@@ -222,6 +292,15 @@ public:
 	bool can_instance() const;
 	Node *instance(GenEditState p_edit_state = GEN_EDIT_STATE_DISABLED) const;
 
+	Node *instance_pooled();
+	void recycle(Node *p_node);
+	void prewarm_pool(int p_count);
+	void clear_pool();
+	int get_pool_count();
+
+	void set_pool_max_size(int p_size);
+	int get_pool_max_size() const;
+
 	void recreate_state();
 	void replace_state(Ref<SceneState> p_by);
 
@@ -233,6 +312,7 @@ public:
 	Ref<SceneState> get_state();
 
 	PackedScene();
+	~PackedScene();
 };
 
 VARIANT_ENUM_CAST(PackedScene::GenEditState)
@@ -993,6 +993,358 @@ void SurfaceTool::generate_normals(bool p_flip) {
 	}
 }
 
+/* Mesh simplification, based on quadric error metrics (Garland & Heckbert) */
+
+struct SurfaceToolQuadric {
+
+	//symmetric 4x4 matrix, upper triangle only
+	double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+	double a11 = 0, a12 = 0, a13 = 0;
+	double a22 = 0, a23 = 0;
+	double a33 = 0;
+	double weight = 0;
+
+	void add_plane(const Vector3 &p_normal, double p_d, double p_weight) {
+
+		double a = p_normal.x;
+		double b = p_normal.y;
+		double c = p_normal.z;
+
+		a00 += a * a * p_weight;
+		a01 += a * b * p_weight;
+		a02 += a * c * p_weight;
+		a03 += a * p_d * p_weight;
+		a11 += b * b * p_weight;
+		a12 += b * c * p_weight;
+		a13 += b * p_d * p_weight;
+		a22 += c * c * p_weight;
+		a23 += c * p_d * p_weight;
+		a33 += p_d * p_d * p_weight;
+		weight += p_weight;
+	}
+
+	void operator+=(const SurfaceToolQuadric &p_q) {
+
+		a00 += p_q.a00;
+		a01 += p_q.a01;
+		a02 += p_q.a02;
+		a03 += p_q.a03;
+		a11 += p_q.a11;
+		a12 += p_q.a12;
+		a13 += p_q.a13;
+		a22 += p_q.a22;
+		a23 += p_q.a23;
+		a33 += p_q.a33;
+		weight += p_q.weight;
+	}
+
+	//returns the weighted average of the squared distances to all planes
+	double evaluate(const Vector3 &p_pos) const {
+
+		if (weight <= 0) {
+			return 0;
+		}
+
+		double x = p_pos.x;
+		double y = p_pos.y;
+		double z = p_pos.z;
+
+		double r = a00 * x * x + 2 * a01 * x * y + 2 * a02 * x * z + 2 * a03 * x;
+		r += a11 * y * y + 2 * a12 * y * z + 2 * a13 * y;
+		r += a22 * z * z + 2 * a23 * z + a33;
+
+		return MAX(r, 0.0) / weight;
+	}
+};
+
+struct SurfaceToolCollapse {
+
+	int from; //vertex being removed
+	int to; //vertex it collapses into (same UV chart as from)
+	double error;
+
+	bool operator<(const SurfaceToolCollapse &p_collapse) const {
+		return error < p_collapse.error;
+	}
+};
+
+Vector<int> SurfaceTool::simplify_indices(const Vector<Vector3> &p_vertices, const Vector<int> &p_indices, int p_target_index_count, float *r_error) {
+
+	ERR_FAIL_COND_V(p_indices.size() % 3 != 0, p_indices);
+
+	if (r_error) {
+		*r_error = 0;
+	}
+
+	int vertex_count = p_vertices.size();
+	const Vector3 *vertices = p_vertices.ptr();
+
+	//weld vertices that share a position, vertices split by other attributes (seams) are locked
+
+	Vector<int> position_remap;
+	position_remap.resize(vertex_count);
+	Vector<int> wedge_count;
+	wedge_count.resize(vertex_count);
+
+	{
+		HashMap<Vector3, int, PositionHasher> position_map;
+		int *remap = position_remap.ptrw();
+		int *wedges = wedge_count.ptrw();
+
+		for (int i = 0; i < vertex_count; i++) {
+
+			wedges[i] = 0;
+			int *existing = position_map.getptr(vertices[i]);
+			if (existing) {
+				remap[i] = *existing;
+				wedges[*existing]++;
+			} else {
+				position_map.set(vertices[i], i);
+				remap[i] = i;
+				wedges[i]++;
+			}
+		}
+	}
+
+	const int *remap = position_remap.ptr();
+
+	Vector<int> result = p_indices;
+	for (int i = 0; i < result.size(); i++) {
+		ERR_FAIL_INDEX_V(result[i], vertex_count, p_indices);
+	}
+
+	Vector<bool> locked;
+	locked.resize(vertex_count);
+	Vector<SurfaceToolQuadric> quadrics;
+	quadrics.resize(vertex_count);
+
+	{
+		bool *lock = locked.ptrw();
+		for (int i = 0; i < vertex_count; i++) {
+			lock[i] = wedge_count[i] > 1;
+		}
+
+		//open borders are locked too, so tiled meshes don't crack between LODs
+		HashMap<uint64_t, int> edge_use;
+		SurfaceToolQuadric *q = quadrics.ptrw();
+		const int *idx = result.ptr();
+
+		for (int i = 0; i < result.size(); i += 3) {
+
+			int v[3] = { remap[idx[i + 0]], remap[idx[i + 1]], remap[idx[i + 2]] };
+
+			Vector3 normal = (vertices[v[1]] - vertices[v[0]]).cross(vertices[v[2]] - vertices[v[0]]);
+			real_t area = normal.length();
+			if (area > CMP_EPSILON) {
+				normal /= area;
+				double d = -normal.dot(vertices[v[0]]);
+				for (int j = 0; j < 3; j++) {
+					q[v[j]].add_plane(normal, d, area);
+				}
+			}
+
+			for (int j = 0; j < 3; j++) {
+				int a = MIN(v[j], v[(j + 1) % 3]);
+				int b = MAX(v[j], v[(j + 1) % 3]);
+				uint64_t key = (uint64_t(a) << 32) | uint64_t(b);
+				int *count = edge_use.getptr(key);
+				if (count) {
+					(*count)++;
+				} else {
+					edge_use.set(key, 1);
+				}
+			}
+		}
+
+		const uint64_t *K = NULL;
+		while ((K = edge_use.next(K))) {
+			if (edge_use[*K] == 1) {
+				lock[*K >> 32] = true;
+				lock[*K & 0xFFFFFFFF] = true;
+			}
+		}
+	}
+
+	const bool *lock = locked.ptr();
+	SurfaceToolQuadric *q = quadrics.ptrw();
+
+	Vector<int> vertex_remap; //collapse target for each original vertex, per pass
+	vertex_remap.resize(vertex_count);
+	Vector<bool> touched;
+	touched.resize(vertex_count);
+	Vector<int> adjacency_offsets;
+	adjacency_offsets.resize(vertex_count + 1);
+	Vector<int> adjacency;
+
+	double max_error = 0;
+
+	while (result.size() > p_target_index_count) {
+
+		int triangle_count = result.size() / 3;
+		const int *idx = result.ptr();
+
+		//gather candidate collapses along every edge, both directions when possible
+
+		Vector<SurfaceToolCollapse> collapses;
+		for (int i = 0; i < result.size(); i += 3) {
+			for (int j = 0; j < 3; j++) {
+
+				int a = idx[i + j];
+				int b = idx[i + (j + 1) % 3];
+				int ra = remap[a];
+				int rb = remap[b];
+
+				SurfaceToolQuadric sum = q[ra];
+				sum += q[rb];
+
+				SurfaceToolCollapse c;
+				c.error = 1e100;
+				if (!lock[ra]) {
+					c.from = a;
+					c.to = b;
+					c.error = sum.evaluate(vertices[rb]);
+				}
+				if (!lock[rb]) {
+					double error = sum.evaluate(vertices[ra]);
+					if (error < c.error) {
+						c.from = b;
+						c.to = a;
+						c.error = error;
+					}
+				}
+
+				if (c.error < 1e100) {
+					collapses.push_back(c);
+				}
+			}
+		}
+
+		if (collapses.empty()) {
+			break;
+		}
+
+		collapses.sort();
+
+		//triangles around each welded vertex, needed to reject collapses that flip faces
+
+		{
+			int *offsets = adjacency_offsets.ptrw();
+			for (int i = 0; i <= vertex_count; i++) {
+				offsets[i] = 0;
+			}
+			for (int i = 0; i < result.size(); i++) {
+				offsets[remap[idx[i]] + 1]++;
+			}
+			for (int i = 0; i < vertex_count; i++) {
+				offsets[i + 1] += offsets[i];
+			}
+
+			adjacency.resize(result.size());
+			int *adj = adjacency.ptrw();
+			Vector<int> fill = adjacency_offsets;
+			int *f = fill.ptrw();
+			for (int i = 0; i < result.size(); i++) {
+				adj[f[remap[idx[i]]]++] = i / 3;
+			}
+		}
+
+		const int *offsets = adjacency_offsets.ptr();
+		const int *adj = adjacency.ptr();
+
+		int *vremap = vertex_remap.ptrw();
+		bool *touch = touched.ptrw();
+		for (int i = 0; i < vertex_count; i++) {
+			vremap[i] = i;
+			touch[i] = false;
+		}
+
+		//every collapse of an interior vertex removes two triangles
+		int collapse_budget = MAX(1, (triangle_count - p_target_index_count / 3) / 2);
+		int collapse_count = 0;
+
+		for (int i = 0; i < collapses.size() && collapse_count < collapse_budget; i++) {
+
+			const SurfaceToolCollapse &c = collapses[i];
+			int rfrom = remap[c.from];
+			int rto = remap[c.to];
+
+			if (touch[rfrom] || touch[rto]) {
+				continue;
+			}
+
+			bool flips = false;
+			for (int j = offsets[rfrom]; j < offsets[rfrom + 1] && !flips; j++) {
+
+				int t = adj[j] * 3;
+				int v[3] = { remap[idx[t + 0]], remap[idx[t + 1]], remap[idx[t + 2]] };
+				if (v[0] == rto || v[1] == rto || v[2] == rto) {
+					continue; //this one degenerates and goes away
+				}
+
+				Vector3 p[3] = { vertices[v[0]], vertices[v[1]], vertices[v[2]] };
+				Vector3 n_before = (p[1] - p[0]).cross(p[2] - p[0]);
+				for (int k = 0; k < 3; k++) {
+					if (v[k] == rfrom) {
+						p[k] = vertices[rto];
+					}
+				}
+				Vector3 n_after = (p[1] - p[0]).cross(p[2] - p[0]);
+				flips = n_before.dot(n_after) <= 0;
+			}
+
+			if (flips) {
+				continue;
+			}
+
+			vremap[c.from] = c.to;
+			q[rto] += q[rfrom];
+			max_error = MAX(max_error, c.error);
+			collapse_count++;
+
+			//neighbourhood geometry changed, defer further collapses around it to the next pass
+			for (int j = offsets[rfrom]; j < offsets[rfrom + 1]; j++) {
+				int t = adj[j] * 3;
+				for (int k = 0; k < 3; k++) {
+					touch[remap[idx[t + k]]] = true;
+				}
+			}
+		}
+
+		if (collapse_count == 0) {
+			break;
+		}
+
+		Vector<int> new_result;
+		new_result.resize(result.size());
+		int *w = new_result.ptrw();
+		int new_index_count = 0;
+
+		for (int i = 0; i < result.size(); i += 3) {
+
+			int a = vremap[idx[i + 0]];
+			int b = vremap[idx[i + 1]];
+			int c = vremap[idx[i + 2]];
+
+			if (remap[a] == remap[b] || remap[b] == remap[c] || remap[c] == remap[a]) {
+				continue;
+			}
+
+			w[new_index_count++] = a;
+			w[new_index_count++] = b;
+			w[new_index_count++] = c;
+		}
+
+		new_result.resize(new_index_count);
+		result = new_result;
+	}
+
+	if (r_error) {
+		*r_error = Math::sqrt(max_error);
+	}
+
+	return result;
+}
+
 void SurfaceTool::set_material(const Ref<Material> &p_material) {
 
 	material = p_material;
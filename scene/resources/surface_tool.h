@@ -62,6 +62,10 @@ private:
 		static _FORCE_INLINE_ uint32_t hash(const Vertex &p_vtx);
 	};
 
+	struct PositionHasher {
+		static _FORCE_INLINE_ uint32_t hash(const Vector3 &p_pos) { return hash_djb2_buffer((const uint8_t *)&p_pos, sizeof(real_t) * 3); }
+	};
+
 	struct WeightSort {
 		int index;
 		float weight;
@@ -140,6 +144,8 @@ public:
 	void append_from(const Ref<Mesh> &p_existing, int p_surface, const Transform &p_xform);
 	Ref<ArrayMesh> commit(const Ref<ArrayMesh> &p_existing = Ref<ArrayMesh>(), uint32_t p_flags = Mesh::ARRAY_COMPRESS_DEFAULT);
 
+	static Vector<int> simplify_indices(const Vector<Vector3> &p_vertices, const Vector<int> &p_indices, int p_target_index_count, float *r_error = nullptr);
+
 	SurfaceTool();
 };
 
@@ -244,6 +244,14 @@ RID ImageTexture::get_rid() const {
 	return texture;
 }
 
+uint64_t ImageTexture::get_memory_size_estimate() const {
+
+	if (w == 0 || h == 0) {
+		return Texture2D::get_memory_size_estimate();
+	}
+	return Image::get_image_data_size(w, h, format, mipmaps);
+}
+
 bool ImageTexture::has_alpha() const {
 
 	return (format == Image::FORMAT_LA8 || format == Image::FORMAT_RGBA8);
@@ -682,6 +690,15 @@ RID StreamTexture::get_rid() const {
 	return texture;
 }
 
+uint64_t StreamTexture::get_memory_size_estimate() const {
+
+	if (w == 0 || h == 0) {
+		return Texture2D::get_memory_size_estimate();
+	}
+	// Mipmaps are not known once loaded, assume they are there.
+	return Image::get_image_data_size(w, h, format, true);
+}
+
 void StreamTexture::draw(RID p_canvas_item, const Point2 &p_pos, const Color &p_modulate, bool p_transpose, const Ref<Texture2D> &p_normal_map, const Ref<Texture2D> &p_specular_map, const Color &p_specular_color_shininess, VS::CanvasItemTextureFilter p_texture_filter, VS::CanvasItemTextureRepeat p_texture_repeat) const {
 
 	if ((w | h) == 0)
@@ -1984,6 +2001,14 @@ RID TextureLayered::get_rid() const {
 	return texture;
 }
 
+uint64_t TextureLayered::get_memory_size_estimate() const {
+
+	if (width == 0 || height == 0) {
+		return Texture::get_memory_size_estimate();
+	}
+	return uint64_t(Image::get_image_data_size(width, height, format, mipmaps)) * layers;
+}
+
 void TextureLayered::set_path(const String &p_path, bool p_take_over) {
 	if (texture.is_valid()) {
 		VS::get_singleton()->texture_set_path(texture, p_path);
@@ -116,6 +116,7 @@ public:
 	int get_height() const;
 
 	virtual RID get_rid() const;
+	virtual uint64_t get_memory_size_estimate() const;
 
 	bool has_alpha() const;
 	virtual void draw(RID p_canvas_item, const Point2 &p_pos, const Color &p_modulate = Color(1, 1, 1), bool p_transpose = false, const Ref<Texture2D> &p_normal_map = Ref<Texture2D>(), const Ref<Texture2D> &p_specular_map = Ref<Texture2D>(), const Color &p_specular_color_shininess = Color(1, 1, 1, 1), VS::CanvasItemTextureFilter p_texture_filter = VS::CANVAS_ITEM_TEXTURE_FILTER_DEFAULT, VS::CanvasItemTextureRepeat p_texture_repeat = VS::CANVAS_ITEM_TEXTURE_REPEAT_DEFAULT) const;
@@ -195,6 +196,7 @@ public:
 	int get_width() const;
 	int get_height() const;
 	virtual RID get_rid() const;
+	virtual uint64_t get_memory_size_estimate() const;
 
 	virtual void set_path(const String &p_path, bool p_take_over);
 
@@ -383,6 +385,8 @@ public:
 	virtual RID get_rid() const;
 	virtual void set_path(const String &p_path, bool p_take_over = false);
 
+	virtual uint64_t get_memory_size_estimate() const;
+
 	TextureLayered(VS::TextureLayeredType p_layered_type);
 	~TextureLayered();
 };
@@ -34,6 +34,8 @@
 
 #include "navigation_server.h"
 
+#include "core/method_bind_ext.gen.inc"
+
 NavigationServer *NavigationServer::singleton = NULL;
 
 void NavigationServer::_bind_methods() {
@@ -52,6 +54,10 @@ void NavigationServer::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("map_get_closest_point", "map", "to_point"), &NavigationServer::map_get_closest_point);
 	ClassDB::bind_method(D_METHOD("map_get_closest_point_normal", "map", "to_point"), &NavigationServer::map_get_closest_point_normal);
 	ClassDB::bind_method(D_METHOD("map_get_closest_point_owner", "map", "to_point"), &NavigationServer::map_get_closest_point_owner);
+	ClassDB::bind_method(D_METHOD("map_request_paths", "map", "origins", "destinations", "optimize", "receiver", "method", "userdata"), &NavigationServer::map_request_paths, DEFVAL(Variant()), DEFVAL(StringName()), DEFVAL(Variant()));
+
+	ClassDB::bind_method(D_METHOD("path_query_is_done", "query"), &NavigationServer::path_query_is_done);
+	ClassDB::bind_method(D_METHOD("path_query_get_path", "query", "index"), &NavigationServer::path_query_get_path);
 
 	ClassDB::bind_method(D_METHOD("region_create"), &NavigationServer::region_create);
 	ClassDB::bind_method(D_METHOD("region_set_map", "region", "map"), &NavigationServer::region_set_map);
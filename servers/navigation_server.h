@@ -95,6 +95,19 @@ public:
 	virtual Vector3 map_get_closest_point_normal(RID p_map, const Vector3 &p_point) const = 0;
 	virtual RID map_get_closest_point_owner(RID p_map, const Vector3 &p_point) const = 0;
 
+	/// Queues the search of the paths from each origin to the destination at
+	/// the same index. The paths are searched on worker threads, and the
+	/// returned query is used to poll them; free it to cancel the search.
+	/// When all the paths are found, `p_method` is called on `p_receiver`
+	/// during `process` with the query and the `p_udata`.
+	virtual RID map_request_paths(RID p_map, const Vector<Vector3> &p_origins, const Vector<Vector3> &p_destinations, bool p_optimize, Object *p_receiver = NULL, StringName p_method = StringName(), Variant p_udata = Variant()) const = 0;
+
+	/// Returns true when all the paths of this query are found.
+	virtual bool path_query_is_done(RID p_query) const = 0;
+
+	/// Returns the path found at this index, empty while not found yet.
+	virtual Vector<Vector3> path_query_get_path(RID p_query, int p_index) const = 0;
+
 	/// Creates a new region.
 	virtual RID region_create() const = 0;
 
@@ -0,0 +1,217 @@
+/*************************************************************************/
+/*  canvas_cull_grid.cpp                                                 */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2020 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2020 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "canvas_cull_grid.h"
+
+#include "core/os/copymem.h"
+#include "core/sort_array.h"
+
+void CanvasCullGrid::begin() {
+
+	entries.resize(0);
+	loose_count = 0;
+	built_loose_count = 0;
+	count = 0;
+	width = 0;
+	height = 0;
+	bounds = Rect2();
+	cell_scale = Vector2();
+}
+
+void CanvasCullGrid::add(uint32_t p_index, const Rect2 &p_rect) {
+
+	Entry e;
+	e.index = p_index;
+	e.rect = p_rect;
+	entries.push_back(e);
+}
+
+void CanvasCullGrid::add_loose(uint32_t p_index) {
+
+	if (loose_count == (uint32_t)loose.size()) {
+		loose.resize(MAX(16, loose_count * 2));
+	}
+	loose.write[loose_count++] = p_index;
+}
+
+void CanvasCullGrid::end() {
+
+	int entry_count = entries.size();
+
+	if (entry_count == 0) {
+		cell_offsets.resize(0);
+		cell_indices.resize(0);
+		count = loose_count;
+		built_loose_count = loose_count;
+		return;
+	}
+
+	const Entry *e = entries.ptr();
+
+	bounds = e[0].rect;
+	for (int i = 1; i < entry_count; i++) {
+		bounds = bounds.merge(e[i].rect);
+	}
+
+	//aim for about one entry per cell, keeping cells roughly square
+	Vector2 size = bounds.size;
+	if (size.x > CMP_EPSILON && size.y > CMP_EPSILON) {
+		width = CLAMP(int(Math::ceil(Math::sqrt(entry_count * size.x / size.y))), 1, MAX_CELLS_PER_AXIS);
+		height = CLAMP(int(Math::ceil(real_t(entry_count) / width)), 1, MAX_CELLS_PER_AXIS);
+	} else if (size.x > CMP_EPSILON) {
+		width = MIN(entry_count, (int)MAX_CELLS_PER_AXIS);
+		height = 1;
+	} else if (size.y > CMP_EPSILON) {
+		width = 1;
+		height = MIN(entry_count, (int)MAX_CELLS_PER_AXIS);
+	} else {
+		width = 1;
+		height = 1;
+	}
+
+	cell_scale.x = size.x > CMP_EPSILON ? width / size.x : 0;
+	cell_scale.y = size.y > CMP_EPSILON ? height / size.y : 0;
+
+	int cell_count = width * height;
+	cell_offsets.resize(cell_count + 1);
+	uint32_t *offsets = cell_offsets.ptrw();
+	zeromem(offsets, sizeof(uint32_t) * (cell_count + 1));
+
+	//count entries per cell, entries covering too many cells become loose
+	for (int i = 0; i < entry_count; i++) {
+		int from_x, from_y, to_x, to_y;
+		_get_cell_range(e[i].rect, from_x, from_y, to_x, to_y);
+		if ((to_x - from_x + 1) * (to_y - from_y + 1) > MAX_CELLS_PER_ENTRY) {
+			add_loose(e[i].index);
+			continue;
+		}
+		for (int y = from_y; y <= to_y; y++) {
+			for (int x = from_x; x <= to_x; x++) {
+				offsets[y * width + x + 1]++;
+			}
+		}
+	}
+
+	for (int i = 0; i < cell_count; i++) {
+		offsets[i + 1] += offsets[i];
+	}
+
+	cell_indices.resize(offsets[cell_count]);
+	uint32_t *indices = cell_indices.ptrw();
+
+	Vector<uint32_t> cursor_vec;
+	cursor_vec.resize(cell_count);
+	uint32_t *cursor = cursor_vec.ptrw();
+	copymem(cursor, offsets, sizeof(uint32_t) * cell_count);
+
+	for (int i = 0; i < entry_count; i++) {
+		int from_x, from_y, to_x, to_y;
+		_get_cell_range(e[i].rect, from_x, from_y, to_x, to_y);
+		if ((to_x - from_x + 1) * (to_y - from_y + 1) > MAX_CELLS_PER_ENTRY) {
+			continue;
+		}
+		for (int y = from_y; y <= to_y; y++) {
+			for (int x = from_x; x <= to_x; x++) {
+				indices[cursor[y * width + x]++] = e[i].index;
+			}
+		}
+	}
+
+	count = entry_count + loose_count;
+	built_loose_count = loose_count;
+	entries.resize(0);
+}
+
+const uint32_t *CanvasCullGrid::query(const Rect2 &p_rect, uint32_t &r_count) {
+
+	bool use_cells = width > 0 && p_rect.intersects_touch(bounds);
+
+	int from_x = 0, from_y = 0, to_x = -1, to_y = -1;
+	uint32_t max_count = loose_count;
+
+	if (use_cells) {
+		_get_cell_range(p_rect, from_x, from_y, to_x, to_y);
+		const uint32_t *offsets = cell_offsets.ptr();
+		for (int y = from_y; y <= to_y; y++) {
+			max_count += offsets[y * width + to_x + 1] - offsets[y * width + from_x];
+		}
+	}
+
+	if ((uint32_t)result.size() < max_count) {
+		result.resize(max_count);
+	}
+
+	uint32_t *w = result.ptrw();
+	uint32_t n = 0;
+
+	const uint32_t *l = loose.ptr();
+	for (uint32_t i = 0; i < loose_count; i++) {
+		w[n++] = l[i];
+	}
+
+	if (use_cells) {
+		const uint32_t *offsets = cell_offsets.ptr();
+		const uint32_t *indices = cell_indices.ptr();
+		for (int y = from_y; y <= to_y; y++) {
+			//cells in a row are contiguous
+			uint32_t from = offsets[y * width + from_x];
+			uint32_t to = offsets[y * width + to_x + 1];
+			for (uint32_t i = from; i < to; i++) {
+				w[n++] = indices[i];
+			}
+		}
+	}
+
+	if (n > 1) {
+		//callers need draw order, and entries may be in several cells
+		SortArray<uint32_t> sorter;
+		sorter.sort(w, n);
+
+		uint32_t unique = 1;
+		for (uint32_t i = 1; i < n; i++) {
+			if (w[i] != w[unique - 1]) {
+				w[unique++] = w[i];
+			}
+		}
+		n = unique;
+	}
+
+	r_count = n;
+	return w;
+}
+
+CanvasCullGrid::CanvasCullGrid() {
+
+	width = 0;
+	height = 0;
+	count = 0;
+	loose_count = 0;
+	built_loose_count = 0;
+}
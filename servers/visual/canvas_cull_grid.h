@@ -0,0 +1,99 @@
+/*************************************************************************/
+/*  canvas_cull_grid.h                                                   */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2020 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2020 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef CANVAS_CULL_GRID_H
+#define CANVAS_CULL_GRID_H
+
+#include "core/math/rect2.h"
+#include "core/vector.h"
+
+// Uniform grid over the children of a canvas or canvas item, in the local
+// space of the parent. It is built once from the children bounds and then
+// queried every frame, so culling only touches the children near the view.
+// Children that move after the grid was built (or that can't be bounded)
+// are added as loose entries, which every query returns.
+
+class CanvasCullGrid {
+
+	enum {
+		MAX_CELLS_PER_AXIS = 256,
+		MAX_CELLS_PER_ENTRY = 16,
+	};
+
+	struct Entry {
+		uint32_t index;
+		Rect2 rect;
+	};
+
+	Vector<Entry> entries;
+	Vector<uint32_t> loose;
+	Vector<uint32_t> cell_offsets;
+	Vector<uint32_t> cell_indices;
+	Vector<uint32_t> result;
+
+	Rect2 bounds;
+	Vector2 cell_scale;
+	int width;
+	int height;
+	uint32_t count;
+	uint32_t loose_count;
+	uint32_t built_loose_count;
+
+	_FORCE_INLINE_ void _get_cell_range(const Rect2 &p_rect, int &r_from_x, int &r_from_y, int &r_to_x, int &r_to_y) const {
+		Vector2 from = (p_rect.position - bounds.position) * cell_scale;
+		Vector2 to = (p_rect.position + p_rect.size - bounds.position) * cell_scale;
+		r_from_x = CLAMP(int(Math::floor(from.x)), 0, width - 1);
+		r_from_y = CLAMP(int(Math::floor(from.y)), 0, height - 1);
+		r_to_x = CLAMP(int(Math::floor(to.x)), 0, width - 1);
+		r_to_y = CLAMP(int(Math::floor(to.y)), 0, height - 1);
+	}
+
+public:
+	void begin();
+	void add(uint32_t p_index, const Rect2 &p_rect);
+	void add_loose(uint32_t p_index);
+	void end();
+
+	// Returns the indices that may intersect p_rect, sorted and unique.
+	// The returned array is valid until the next query on this grid.
+	const uint32_t *query(const Rect2 &p_rect, uint32_t &r_count);
+
+	_FORCE_INLINE_ const Rect2 &get_bounds() const { return bounds; }
+	_FORCE_INLINE_ bool has_bounds() const { return width > 0; }
+	_FORCE_INLINE_ uint32_t get_count() const { return count; }
+	_FORCE_INLINE_ const uint32_t *get_loose() const { return loose.ptr(); }
+	_FORCE_INLINE_ uint32_t get_loose_count() const { return loose_count; }
+	// Loose entries added since the grid was built, used to decide when to rebuild.
+	_FORCE_INLINE_ uint32_t get_moved_count() const { return loose_count - built_loose_count; }
+
+	CanvasCullGrid();
+};
+
+#endif // CANVAS_CULL_GRID_H
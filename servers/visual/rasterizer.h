@@ -153,6 +153,7 @@ public:
 		bool redraw_if_visible : 4;
 
 		float depth; //used for sorting
+		float lod_edge_length; //mesh LODs with a smaller simplification error than this are not visible
 
 		SelfList<InstanceBase> dependency_item;
 
@@ -219,6 +220,7 @@ public:
 			dynamic_gi = false;
 			redraw_if_visible = false;
 			lightmap_capture = NULL;
+			lod_edge_length = 0;
 		}
 
 		virtual ~InstanceBase() {
@@ -394,6 +396,7 @@ public:
 	virtual Color multimesh_instance_get_custom_data(RID p_multimesh, int p_index) const = 0;
 
 	virtual void multimesh_set_buffer(RID p_multimesh, const Vector<float> &p_buffer) = 0;
+	virtual void multimesh_set_buffer_range(RID p_multimesh, int p_from_instance, const Vector<float> &p_buffer) = 0;
 	virtual Vector<float> multimesh_get_buffer(RID p_multimesh) const = 0;
 
 	virtual void multimesh_set_visible_instances(RID p_multimesh, int p_visible) = 0;
@@ -1230,6 +1233,8 @@ public:
 	virtual void canvas_render_items(RID p_to_render_target, Item *p_item_list, const Color &p_modulate, Light *p_light_list, const Transform2D &p_canvas_transform) = 0;
 	virtual void canvas_debug_viewport_shadows(Light *p_lights_with_shadow) = 0;
 
+	virtual int get_render_info(VS::RenderInfo p_info) = 0;
+
 	struct LightOccluderInstance {
 
 		bool enabled;
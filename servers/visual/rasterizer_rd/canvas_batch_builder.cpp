@@ -0,0 +1,90 @@
+/*************************************************************************/
+/*  canvas_batch_builder.cpp                                             */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2020 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2020 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "canvas_batch_builder.h"
+
+void CanvasBatchBuilder::begin(uint32_t p_instance_limit) {
+
+	instance_count = 0;
+	instance_limit = p_instance_limit;
+	batch_count = 0;
+}
+
+bool CanvasBatchBuilder::add_instance(const Key &p_key, const Instance &p_instance) {
+
+	if (instance_count == instance_limit) {
+		return false; //full, caller must flush
+	}
+
+	if (batch_count == 0 || batches[batch_count - 1].key != p_key) {
+
+		if (batch_count == batch_max) {
+			batch_max = batch_max ? batch_max * 2 : 64;
+			batches = (Batch *)memrealloc(batches, sizeof(Batch) * batch_max);
+		}
+
+		Batch &batch = batches[batch_count++];
+		batch.key = p_key;
+		batch.from = instance_count;
+		batch.count = 0;
+	}
+
+	if (instance_count == instance_max) {
+		instance_max = instance_max ? instance_max * 2 : 256;
+		instances = (Instance *)memrealloc(instances, sizeof(Instance) * instance_max);
+	}
+
+	instances[instance_count++] = p_instance;
+	batches[batch_count - 1].count++;
+
+	return true;
+}
+
+CanvasBatchBuilder::CanvasBatchBuilder() {
+
+	instances = NULL;
+	instance_count = 0;
+	instance_max = 0;
+	instance_limit = 0;
+
+	batches = NULL;
+	batch_count = 0;
+	batch_max = 0;
+}
+
+CanvasBatchBuilder::~CanvasBatchBuilder() {
+
+	if (instances) {
+		memfree(instances);
+	}
+	if (batches) {
+		memfree(batches);
+	}
+}
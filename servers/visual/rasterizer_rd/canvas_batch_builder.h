@@ -0,0 +1,97 @@
+/*************************************************************************/
+/*  canvas_batch_builder.h                                               */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2020 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2020 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef CANVAS_BATCH_BUILDER_H
+#define CANVAS_BATCH_BUILDER_H
+
+#include "core/os/memory.h"
+#include "core/typedefs.h"
+
+// Collects consecutive canvas rects that share the same render state into
+// batches, so each batch can be drawn with a single instanced draw call.
+// It knows nothing about the rendering device, so the generated batches
+// can be inspected directly.
+
+class CanvasBatchBuilder {
+public:
+	// Must match BatchInstance in canvas_uniforms_inc.glsl
+	struct Instance {
+		float world[6];
+		float pad[2];
+		float modulation[4];
+		float dst_rect[4];
+		float src_rect[4];
+	};
+
+	struct Key {
+		const void *pipeline_variants; //depends on the material
+		uint64_t texture_binding;
+		uint32_t flags;
+		uint32_t specular_shininess;
+		float color_texture_pixel_size[2];
+
+		_FORCE_INLINE_ bool operator==(const Key &p_key) const {
+			return pipeline_variants == p_key.pipeline_variants && texture_binding == p_key.texture_binding && flags == p_key.flags && specular_shininess == p_key.specular_shininess && color_texture_pixel_size[0] == p_key.color_texture_pixel_size[0] && color_texture_pixel_size[1] == p_key.color_texture_pixel_size[1];
+		}
+		_FORCE_INLINE_ bool operator!=(const Key &p_key) const {
+			return !(*this == p_key);
+		}
+	};
+
+	struct Batch {
+		Key key;
+		uint32_t from;
+		uint32_t count;
+	};
+
+private:
+	Instance *instances;
+	uint32_t instance_count;
+	uint32_t instance_max;
+	uint32_t instance_limit;
+
+	Batch *batches;
+	uint32_t batch_count;
+	uint32_t batch_max;
+
+public:
+	void begin(uint32_t p_instance_limit);
+	bool add_instance(const Key &p_key, const Instance &p_instance);
+
+	_FORCE_INLINE_ uint32_t get_instance_count() const { return instance_count; }
+	_FORCE_INLINE_ const Instance *get_instances() const { return instances; }
+	_FORCE_INLINE_ uint32_t get_batch_count() const { return batch_count; }
+	_FORCE_INLINE_ const Batch &get_batch(uint32_t p_index) const { return batches[p_index]; }
+
+	CanvasBatchBuilder();
+	~CanvasBatchBuilder();
+};
+
+#endif // CANVAS_BATCH_BUILDER_H
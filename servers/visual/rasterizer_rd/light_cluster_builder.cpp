@@ -30,9 +30,12 @@
 
 #include "light_cluster_builder.h"
 
+#include "servers/visual/rasterizer_rd/rasterizer_rd.h"
+
 void LightClusterBuilder::begin(const Transform &p_view_transform, const CameraMatrix &p_cam_projection) {
 	view_xform = p_view_transform;
 	projection = p_cam_projection;
+	projection_inverse = projection.inverse();
 	z_near = -projection.get_z_near();
 	z_far = -projection.get_z_far();
 
@@ -40,140 +43,321 @@ void LightClusterBuilder::begin(const Transform &p_view_transform, const CameraM
 	light_count = 0;
 	refprobe_count = 0;
 	item_count = 0;
-	sort_id_count = 0;
 }
 
-void LightClusterBuilder::bake_cluster() {
+bool LightClusterBuilder::_get_item_tile_rect(const Item &p_item, int p_slice, int &r_from_x, int &r_from_y, int &r_to_x, int &r_to_y) const {
 
-	float slice_depth = (z_near - z_far) / depth;
+	Vector3 min = p_item.aabb.position;
+	Vector3 max = p_item.aabb.position + p_item.aabb.size;
 
-	uint8_t *cluster_dataw = cluster_data.ptrw();
-	Cell *cluster_data_ptr = (Cell *)cluster_dataw;
-	//clear the cluster
-	zeromem(cluster_data_ptr, (width * height * depth * sizeof(Cell)));
+	float limit_near = MIN((z_near - slice_depth * p_slice), max.z);
+	float limit_far = MAX((z_near - slice_depth * (p_slice + 1)), min.z);
 
-	/* Step 1, create cell positions and count them */
+	max.z = limit_near;
+	min.z = limit_near;
 
-	for (uint32_t i = 0; i < item_count; i++) {
+	Vector3 proj_min = projection.xform(min);
+	Vector3 proj_max = projection.xform(max);
 
-		const Item &item = items[i];
+	int near_from_x = int(Math::floor((proj_min.x * 0.5 + 0.5) * width));
+	int near_from_y = int(Math::floor((-proj_max.y * 0.5 + 0.5) * height));
+	int near_to_x = int(Math::floor((proj_max.x * 0.5 + 0.5) * width));
+	int near_to_y = int(Math::floor((-proj_min.y * 0.5 + 0.5) * height));
 
-		int from_slice = Math::floor((z_near - (item.aabb.position.z + item.aabb.size.z)) / slice_depth);
-		int to_slice = Math::floor((z_near - item.aabb.position.z) / slice_depth);
+	max.z = limit_far;
+	min.z = limit_far;
 
-		if (from_slice >= (int)depth || to_slice < 0) {
-			continue; //sorry no go
-		}
+	proj_min = projection.xform(min);
+	proj_max = projection.xform(max);
 
-		from_slice = MAX(0, from_slice);
-		to_slice = MIN((int)depth - 1, to_slice);
+	int far_from_x = int(Math::floor((proj_min.x * 0.5 + 0.5) * width));
+	int far_from_y = int(Math::floor((-proj_max.y * 0.5 + 0.5) * height));
+	int far_to_x = int(Math::floor((proj_max.x * 0.5 + 0.5) * width));
+	int far_to_y = int(Math::floor((-proj_min.y * 0.5 + 0.5) * height));
 
-		for (int j = from_slice; j <= to_slice; j++) {
+	int from_x = MIN(near_from_x, far_from_x);
+	int from_y = MIN(near_from_y, far_from_y);
+	int to_x = MAX(near_to_x, far_to_x);
+	int to_y = MAX(near_to_y, far_to_y);
 
-			Vector3 min = item.aabb.position;
-			Vector3 max = item.aabb.position + item.aabb.size;
+	if (from_x >= (int)width || to_x < 0 || from_y >= (int)height || to_y < 0) {
+		return false;
+	}
 
-			float limit_near = MIN((z_near - slice_depth * j), max.z);
-			float limit_far = MAX((z_near - slice_depth * (j + 1)), min.z);
+	r_from_x = MAX(0, from_x);
+	r_from_y = MAX(0, from_y);
+	r_to_x = MIN((int)width - 1, to_x);
+	r_to_y = MIN((int)height - 1, to_y);
 
-			max.z = limit_near;
-			min.z = limit_near;
+	return true;
+}
 
-			Vector3 proj_min = projection.xform(min);
-			Vector3 proj_max = projection.xform(max);
+void LightClusterBuilder::_bake_slice_masks(uint32_t p_slice, void *p_userdata) {
 
-			int near_from_x = int(Math::floor((proj_min.x * 0.5 + 0.5) * width));
-			int near_from_y = int(Math::floor((-proj_max.y * 0.5 + 0.5) * height));
-			int near_to_x = int(Math::floor((proj_max.x * 0.5 + 0.5) * width));
-			int near_to_y = int(Math::floor((-proj_min.y * 0.5 + 0.5) * height));
+	uint32_t slice_cells = width * height;
+	uint32_t *masks = cell_masks + p_slice * slice_cells * cell_mask_words;
+	zeromem(masks, sizeof(uint32_t) * slice_cells * cell_mask_words);
 
-			max.z = limit_far;
-			min.z = limit_far;
+	float slice_near = z_near - slice_depth * p_slice;
+	float slice_far = z_near - slice_depth * (p_slice + 1);
+	float slice_center = (slice_near + slice_far) * 0.5;
 
-			proj_min = projection.xform(min);
-			proj_max = projection.xform(max);
+	// View space bounds of every tile column and row in this slice, kept as
+	// separate arrays so the inner loops below stay branchless and vectorizable.
 
-			int far_from_x = int(Math::floor((proj_min.x * 0.5 + 0.5) * width));
-			int far_from_y = int(Math::floor((-proj_max.y * 0.5 + 0.5) * height));
-			int far_to_x = int(Math::floor((proj_max.x * 0.5 + 0.5) * width));
-			int far_to_y = int(Math::floor((-proj_min.y * 0.5 + 0.5) * height));
+	Vector<float> bounds;
+	bounds.resize((width + height) * 2);
+	float *column_min = bounds.ptrw();
+	float *column_max = column_min + width;
+	float *row_min = column_max + width;
+	float *row_max = row_min + height;
 
-			//print_line(itos(j) + " near - " + Vector2i(near_from_x, near_from_y) + " -> " + Vector2i(near_to_x, near_to_y));
-			//print_line(itos(j) + " far - " + Vector2i(far_from_x, far_from_y) + " -> " + Vector2i(far_to_x, far_to_y));
+	{
+		float ndc_near = projection.xform(Vector3(0, 0, slice_near)).z;
+		float ndc_far = projection.xform(Vector3(0, 0, slice_far)).z;
+
+		for (uint32_t i = 0; i < width; i++) {
+			float ndc_from = float(i) / width * 2.0 - 1.0;
+			float ndc_to = float(i + 1) / width * 2.0 - 1.0;
+			float a = projection_inverse.xform(Vector3(ndc_from, 0, ndc_near)).x;
+			float b = projection_inverse.xform(Vector3(ndc_from, 0, ndc_far)).x;
+			float c = projection_inverse.xform(Vector3(ndc_to, 0, ndc_near)).x;
+			float d = projection_inverse.xform(Vector3(ndc_to, 0, ndc_far)).x;
+			column_min[i] = MIN(MIN(a, b), MIN(c, d));
+			column_max[i] = MAX(MAX(a, b), MAX(c, d));
+		}
+
+		for (uint32_t i = 0; i < height; i++) {
+			float ndc_from = 1.0 - float(i + 1) / height * 2.0;
+			float ndc_to = 1.0 - float(i) / height * 2.0;
+			float a = projection_inverse.xform(Vector3(0, ndc_from, ndc_near)).y;
+			float b = projection_inverse.xform(Vector3(0, ndc_from, ndc_far)).y;
+			float c = projection_inverse.xform(Vector3(0, ndc_to, ndc_near)).y;
+			float d = projection_inverse.xform(Vector3(0, ndc_to, ndc_far)).y;
+			row_min[i] = MIN(MIN(a, b), MIN(c, d));
+			row_max[i] = MAX(MAX(a, b), MAX(c, d));
+		}
+	}
 
-			int from_x = MIN(near_from_x, far_from_x);
-			int from_y = MIN(near_from_y, far_from_y);
-			int to_x = MAX(near_to_x, far_to_x);
-			int to_y = MAX(near_to_y, far_to_y);
+	for (uint32_t t = 0; t < ITEM_TYPE_MAX; t++) {
+		for (uint32_t b = 0; b < type_counts[t]; b++) {
 
-			if (from_x >= (int)width || to_x < 0 || from_y >= (int)height || to_y < 0) {
+			const Item &item = items[item_order[type_offsets[t] + b]];
+
+			if ((int)p_slice < item.from_slice || (int)p_slice > item.to_slice) {
 				continue;
 			}
 
-			int sx = MAX(0, from_x);
-			int sy = MAX(0, from_y);
-			int dx = MIN((int)width - 1, to_x);
-			int dy = MIN((int)height - 1, to_y);
+			int sx, sy, dx, dy;
+			if (!_get_item_tile_rect(item, p_slice, sx, sy, dx, dy)) {
+				continue;
+			}
 
-			//print_line(itos(j) + " - " + Vector2i(sx, sy) + " -> " + Vector2i(dx, dy));
+			uint32_t word = mask_offsets[t] + (b >> 5);
+			uint32_t bit = 1 << (b & 31);
 
-			for (int x = sx; x <= dx; x++) {
+			if (item.light_radius <= 0) {
+				//not a light, the projected AABB is all there is
 				for (int y = sy; y <= dy; y++) {
-					uint32_t offset = j * (width * height) + y * width + x;
+					for (int x = sx; x <= dx; x++) {
+						masks[(y * width + x) * cell_mask_words + word] |= bit;
+					}
+				}
+				continue;
+			}
+
+			//sphere vs froxel AABB, then cone vs froxel bounding sphere for spots
+
+			Vector3 pos = item.light_position;
+			float radius_squared = item.light_radius * item.light_radius;
+			float dist_z = MAX(0.0f, MAX(slice_far - pos.z, pos.z - slice_near));
+			float slice_half_depth = (slice_near - slice_far) * 0.5;
+			bool is_spot = t == ITEM_TYPE_SPOT_LIGHT;
+
+			for (int y = sy; y <= dy; y++) {
 
-					if (unlikely(sort_id_count == sort_id_max)) {
-						sort_id_max = nearest_power_of_2_templated(sort_id_max + 1);
-						sort_ids = (SortID *)memrealloc(sort_ids, sizeof(SortID) * sort_id_max);
-						if (ids.size()) {
+				float dist_y = MAX(0.0f, MAX(row_min[y] - pos.y, pos.y - row_max[y]));
+				float dist_yz = dist_y * dist_y + dist_z * dist_z;
+				if (dist_yz > radius_squared) {
+					continue;
+				}
+
+				uint32_t *row_masks = masks + y * width * cell_mask_words + word;
+
+				for (int x = sx; x <= dx; x++) {
+
+					float dist_x = MAX(0.0f, MAX(column_min[x] - pos.x, pos.x - column_max[x]));
+					bool inside = dist_x * dist_x + dist_yz <= radius_squared;
+
+					if (inside && is_spot) {
+						Vector3 half((column_max[x] - column_min[x]) * 0.5, (row_max[y] - row_min[y]) * 0.5, slice_half_depth);
+						Vector3 center(column_min[x] + half.x, row_min[y] + half.y, slice_center);
+						float bound_radius = half.length();
+
+						Vector3 v = center - pos;
+						float v_len_squared = v.length_squared();
+						float v1_len = v.dot(item.light_direction);
+						float closest = item.spot_cos * Math::sqrt(MAX(0.0f, v_len_squared - v1_len * v1_len)) - v1_len * item.spot_sin;
 
-							ids.resize(sort_id_max);
-							RD::get_singleton()->free(items_buffer);
-							items_buffer = RD::get_singleton()->storage_buffer_create(sizeof(uint32_t) * sort_id_max);
-						}
+						inside = closest <= bound_radius && v1_len >= -bound_radius;
 					}
 
-					sort_ids[sort_id_count].cell_index = offset;
-					sort_ids[sort_id_count].item_index = item.index;
-					sort_ids[sort_id_count].item_type = item.type;
+					row_masks[x * cell_mask_words] |= inside ? bit : 0;
+				}
+			}
+		}
+	}
+
+	//count, so index lists can be laid out before filling them
+
+	uint32_t total = 0;
+	for (uint32_t i = 0; i < slice_cells; i++) {
+		const uint32_t *cell_mask = masks + i * cell_mask_words;
+		for (uint32_t t = 0; t < ITEM_TYPE_MAX; t++) {
+			uint32_t count = 0;
+			for (uint32_t w = 0; w < mask_words[t]; w++) {
+				uint32_t m = cell_mask[mask_offsets[t] + w];
+				while (m) {
+					m &= m - 1;
+					count++;
+				}
+			}
+			total += MIN(count, (uint32_t)COUNTER_MASK);
+		}
+	}
+
+	slice_offsets[p_slice] = total;
+}
+
+void LightClusterBuilder::_bake_slice_ids(uint32_t p_slice, void *p_userdata) {
+
+	uint32_t slice_cells = width * height;
+	const uint32_t *masks = cell_masks + p_slice * slice_cells * cell_mask_words;
+	Cell *slice_cell_ptr = cells + p_slice * slice_cells;
+
+	uint32_t offset = slice_offsets[p_slice];
+
+	for (uint32_t i = 0; i < slice_cells; i++) {
 
-					sort_id_count++;
+		const uint32_t *cell_mask = masks + i * cell_mask_words;
 
-					//for now, only count
-					cluster_data_ptr[offset].item_pointers[item.type]++;
-					//print_line("at offset " + itos(offset) + " value: " + itos(cluster_data_ptr[offset].item_pointers[item.type]));
+		for (uint32_t t = 0; t < ITEM_TYPE_MAX; t++) {
+
+			uint32_t pointer = offset;
+			uint32_t count = 0;
+
+			for (uint32_t w = 0; w < mask_words[t] && count < COUNTER_MASK; w++) {
+				uint32_t m = cell_mask[mask_offsets[t] + w];
+				uint32_t b = w << 5;
+				while (m && count < COUNTER_MASK) {
+					if (m & 1) {
+						ids_ptr[offset++] = items[item_order[type_offsets[t] + b]].index;
+						count++;
+					}
+					m >>= 1;
+					b++;
 				}
 			}
+
+			slice_cell_ptr[i].item_pointers[t] = pointer | (count << COUNTER_SHIFT);
 		}
 	}
+}
 
-	/* Step 2, Assign pointers (and reset counters) */
+void LightClusterBuilder::bake_cluster() {
 
-	uint32_t offset = 0;
-	for (uint32_t i = 0; i < (width * height * depth); i++) {
-		for (int j = 0; j < ITEM_TYPE_MAX; j++) {
-			uint32_t count = cluster_data_ptr[i].item_pointers[j]; //save count
-			cluster_data_ptr[i].item_pointers[j] = offset; //replace count by pointer
-			offset += count; //increase offset by count;
+	slice_depth = (z_near - z_far) / depth;
+
+	/* Step 1, find the slice range of each item and group them by type */
+
+	for (uint32_t i = 0; i < ITEM_TYPE_MAX; i++) {
+		type_counts[i] = 0;
+	}
+
+	for (uint32_t i = 0; i < item_count; i++) {
+
+		Item &item = items[i];
+
+		item.from_slice = Math::floor((z_near - (item.aabb.position.z + item.aabb.size.z)) / slice_depth);
+		item.to_slice = Math::floor((z_near - item.aabb.position.z) / slice_depth);
+
+		if (item.from_slice >= (int)depth || item.to_slice < 0) {
+			item.from_slice = 0; //sorry no go
+			item.to_slice = -1;
+		} else {
+			item.from_slice = MAX(0, item.from_slice);
+			item.to_slice = MIN((int)depth - 1, item.to_slice);
 		}
+
+		type_counts[item.type]++;
 	}
 
-	//print_line("offset: " + itos(offset));
-	/* Step 3, Place item lists */
+	if (unlikely(item_order_max < item_count)) {
+		item_order_max = nearest_power_of_2_templated(item_count);
+		item_order = (uint32_t *)memrealloc(item_order, sizeof(uint32_t) * item_order_max);
+	}
 
-	uint32_t *ids_ptr = ids.ptrw();
+	cell_mask_words = 0;
+	uint32_t type_offset = 0;
+	for (uint32_t i = 0; i < ITEM_TYPE_MAX; i++) {
+		type_offsets[i] = type_offset;
+		type_offset += type_counts[i];
+		mask_offsets[i] = cell_mask_words;
+		mask_words[i] = (type_counts[i] + 31) >> 5;
+		cell_mask_words += mask_words[i];
+	}
 
-	for (uint32_t i = 0; i < sort_id_count; i++) {
-		const SortID &id = sort_ids[i];
-		Cell &cell = cluster_data_ptr[id.cell_index];
-		uint32_t pointer = cell.item_pointers[id.item_type] & POINTER_MASK;
-		uint32_t counter = cell.item_pointers[id.item_type] >> COUNTER_SHIFT;
-		ids_ptr[pointer + counter] = id.item_index;
+	{
+		uint32_t type_fill[ITEM_TYPE_MAX];
+		for (uint32_t i = 0; i < ITEM_TYPE_MAX; i++) {
+			type_fill[i] = type_offsets[i];
+		}
+		for (uint32_t i = 0; i < item_count; i++) {
+			item_order[type_fill[items[i].type]++] = i;
+		}
+	}
+
+	uint32_t cell_count = width * height * depth;
+	uint32_t mask_size = MAX(1u, cell_count * cell_mask_words);
+	if (unlikely(cell_mask_max < mask_size)) {
+		cell_mask_max = nearest_power_of_2_templated(mask_size);
+		cell_masks = (uint32_t *)memrealloc(cell_masks, sizeof(uint32_t) * cell_mask_max);
+	}
+
+	/* Step 2, fill the cell masks and count the items of each slice */
+
+	RasterizerRD::thread_work_pool.do_work(depth, this, &LightClusterBuilder::_bake_slice_masks, (void *)nullptr);
 
-		cell.item_pointers[id.item_type] = pointer | ((counter + 1) << COUNTER_SHIFT);
+	/* Step 3, turn counts into offsets, and make room for the index lists */
+
+	uint32_t offset = 0;
+	for (uint32_t i = 0; i < depth; i++) {
+		uint32_t count = slice_offsets[i];
+		slice_offsets[i] = offset;
+		offset += count;
+	}
+
+	if (unlikely((uint32_t)ids.size() < offset)) {
+		ids.resize(nearest_power_of_2_templated(offset));
+		RD::get_singleton()->free(items_buffer);
+		items_buffer = RD::get_singleton()->storage_buffer_create(sizeof(uint32_t) * ids.size());
 	}
 
+	/* Step 4, place item lists, writing every cell (no need to clear them first) */
+
+	cells = (Cell *)cluster_data.ptrw();
+	ids_ptr = ids.ptrw();
+
+	RasterizerRD::thread_work_pool.do_work(depth, this, &LightClusterBuilder::_bake_slice_ids, (void *)nullptr);
+
+	cells = nullptr;
+
 	RD::get_singleton()->texture_update(cluster_texture, 0, cluster_data, true);
-	RD::get_singleton()->buffer_update(items_buffer, 0, offset * sizeof(uint32_t), ids_ptr, true);
+	if (offset) {
+		RD::get_singleton()->buffer_update(items_buffer, 0, offset * sizeof(uint32_t), ids_ptr, true);
+	}
+
+	ids_ptr = nullptr;
 }
 
 void LightClusterBuilder::setup(uint32_t p_width, uint32_t p_height, uint32_t p_depth) {
@@ -190,6 +374,7 @@ void LightClusterBuilder::setup(uint32_t p_width, uint32_t p_height, uint32_t p_
 	depth = p_depth;
 
 	cluster_data.resize(width * height * depth * sizeof(Cell));
+	slice_offsets = (uint32_t *)memrealloc(slice_offsets, sizeof(uint32_t) * depth);
 
 	{
 		RD::TextureFormat tf;
@@ -225,10 +410,8 @@ LightClusterBuilder::LightClusterBuilder() {
 	items = (Item *)memalloc(sizeof(Item) * 1024);
 	item_max = 1024;
 
-	sort_ids = (SortID *)memalloc(sizeof(SortID) * 1024);
-	ids.resize(2014);
-	items_buffer = RD::get_singleton()->storage_buffer_create(sizeof(uint32_t) * 1024);
-	item_max = 1024;
+	ids.resize(1024);
+	items_buffer = RD::get_singleton()->storage_buffer_create(sizeof(uint32_t) * ids.size());
 }
 LightClusterBuilder::~LightClusterBuilder() {
 
@@ -248,8 +431,16 @@ LightClusterBuilder::~LightClusterBuilder() {
 	if (items) {
 		memfree(items);
 	}
-	if (sort_ids) {
-		memfree(sort_ids);
+	if (item_order) {
+		memfree(item_order);
+	}
+	if (cell_masks) {
+		memfree(cell_masks);
+	}
+	if (slice_offsets) {
+		memfree(slice_offsets);
+	}
+	if (items_buffer.is_valid()) {
 		RD::get_singleton()->free(items_buffer);
 	}
 }
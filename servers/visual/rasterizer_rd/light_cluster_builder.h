@@ -90,6 +90,14 @@ private:
 		AABB aabb;
 		ItemType type;
 		uint32_t index;
+		int from_slice;
+		int to_slice;
+		//view space light volume, for the finer per-froxel tests
+		Vector3 light_position;
+		float light_radius;
+		Vector3 light_direction;
+		float spot_cos;
+		float spot_sin;
 	};
 
 	Item *items = nullptr;
@@ -107,20 +115,32 @@ private:
 	Vector<uint8_t> cluster_data;
 	RID cluster_texture;
 
-	struct SortID {
-		uint32_t cell_index;
-		uint32_t item_index;
-		ItemType item_type;
-	};
-
-	SortID *sort_ids = nullptr;
 	Vector<uint32_t> ids;
-	uint32_t sort_id_count = 0;
-	uint32_t sort_id_max = 0;
 	RID items_buffer;
 
+	// Binning is done per depth slice, in parallel. Each cell keeps a bitmask
+	// per item type (bit N is the Nth item of that type), which is then
+	// expanded into the index lists.
+
+	uint32_t *item_order = nullptr; //items sorted by type
+	uint32_t item_order_max = 0;
+	uint32_t type_offsets[ITEM_TYPE_MAX];
+	uint32_t type_counts[ITEM_TYPE_MAX];
+	uint32_t mask_offsets[ITEM_TYPE_MAX];
+	uint32_t mask_words[ITEM_TYPE_MAX];
+	uint32_t cell_mask_words = 0;
+
+	uint32_t *cell_masks = nullptr;
+	uint32_t cell_mask_max = 0;
+	uint32_t *slice_offsets = nullptr; //per slice item counts, then offsets into ids
+
+	Cell *cells = nullptr; //valid while baking
+	uint32_t *ids_ptr = nullptr; //valid while baking
+	float slice_depth = 0;
+
 	Transform view_xform;
 	CameraMatrix projection;
+	CameraMatrix projection_inverse;
 	float z_far = 0;
 	float z_near = 0;
 
@@ -134,9 +154,14 @@ private:
 		item.aabb = p_aabb;
 		item.index = p_index;
 		item.type = p_type;
+		item.light_radius = 0;
 		item_count++;
 	}
 
+	bool _get_item_tile_rect(const Item &p_item, int p_slice, int &r_from_x, int &r_from_y, int &r_to_x, int &r_to_y) const;
+	void _bake_slice_masks(uint32_t p_slice, void *p_userdata);
+	void _bake_slice_ids(uint32_t p_slice, void *p_userdata);
+
 public:
 	void begin(const Transform &p_view_transform, const CameraMatrix &p_cam_projection);
 
@@ -168,6 +193,10 @@ public:
 				aabb.size *= 2.0;
 
 				_add_item(aabb, ITEM_TYPE_OMNI_LIGHT, light_count);
+
+				Item &item = items[item_count - 1];
+				item.light_position = xform.origin;
+				item.light_radius = ld.radius;
 			} break;
 			case LIGHT_TYPE_SPOT: {
 				Vector3 v(0, 0, -1);
@@ -182,6 +211,13 @@ public:
 				aabb.expand_to(xform.xform(Vector3(-v.x, -v.y, v.z)));
 				aabb.expand_to(xform.xform(Vector3(v.x, -v.y, v.z)));
 				_add_item(aabb, ITEM_TYPE_SPOT_LIGHT, light_count);
+
+				Item &item = items[item_count - 1];
+				item.light_position = xform.origin;
+				item.light_radius = ld.radius;
+				item.light_direction = -xform.basis.get_axis(2).normalized();
+				item.spot_cos = Math::cos(Math::deg2rad(ld.spot_aperture));
+				item.spot_sin = Math::sin(Math::deg2rad(ld.spot_aperture));
 			} break;
 		}
 
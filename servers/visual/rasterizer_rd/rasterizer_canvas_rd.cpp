@@ -469,10 +469,10 @@ void RasterizerCanvasRD::free_polygon(PolygonID p_polygon) {
 	polygon_buffers.polygons.erase(p_polygon);
 }
 
-Size2i RasterizerCanvasRD::_bind_texture_binding(TextureBindingID p_binding, RD::DrawListID p_draw_list, uint32_t &flags) {
+RasterizerCanvasRD::TextureBinding *RasterizerCanvasRD::_get_texture_binding(TextureBindingID p_binding, uint32_t &flags) {
 
 	TextureBinding **texture_binding_ptr = bindings.texture_bindings.getptr(p_binding);
-	ERR_FAIL_COND_V(!texture_binding_ptr, Size2i());
+	ERR_FAIL_COND_V(!texture_binding_ptr, NULL);
 	TextureBinding *texture_binding = *texture_binding_ptr;
 
 	if (texture_binding->key.normalmap.is_valid()) {
@@ -485,7 +485,17 @@ Size2i RasterizerCanvasRD::_bind_texture_binding(TextureBindingID p_binding, RD:
 	if (!RD::get_singleton()->uniform_set_is_valid(texture_binding->uniform_set)) {
 		//texture may have changed (erased or replaced, see if we can fix)
 		texture_binding->uniform_set = _create_texture_binding(texture_binding->key.texture, texture_binding->key.normalmap, texture_binding->key.specular, texture_binding->key.texture_filter, texture_binding->key.texture_repeat, texture_binding->key.multimesh);
-		ERR_FAIL_COND_V(!texture_binding->uniform_set.is_valid(), Size2i(1, 1));
+		ERR_FAIL_COND_V(!texture_binding->uniform_set.is_valid(), NULL);
+	}
+
+	return texture_binding;
+}
+
+Size2i RasterizerCanvasRD::_bind_texture_binding(TextureBindingID p_binding, RD::DrawListID p_draw_list, uint32_t &flags) {
+
+	TextureBinding *texture_binding = _get_texture_binding(p_binding, flags);
+	if (!texture_binding) {
+		return Size2i(1, 1);
 	}
 
 	RD::get_singleton()->draw_list_bind_uniform_set(p_draw_list, texture_binding->uniform_set, 0);
@@ -496,6 +506,88 @@ Size2i RasterizerCanvasRD::_bind_texture_binding(TextureBindingID p_binding, RD:
 	}
 }
 
+bool RasterizerCanvasRD::_batch_add_rect(RD::DrawListID p_draw_list, RD::FramebufferFormatID p_framebuffer_format, PipelineVariants *p_pipeline_variants, TextureBindingID p_binding, const PushConstant &p_push_constant) {
+
+	CanvasBatchBuilder::Key key;
+	key.pipeline_variants = p_pipeline_variants;
+	key.texture_binding = p_binding;
+	key.flags = p_push_constant.flags;
+	key.specular_shininess = p_push_constant.specular_shininess;
+	key.color_texture_pixel_size[0] = p_push_constant.color_texture_pixel_size[0];
+	key.color_texture_pixel_size[1] = p_push_constant.color_texture_pixel_size[1];
+
+	CanvasBatchBuilder::Instance instance;
+	for (int i = 0; i < 6; i++) {
+		instance.world[i] = p_push_constant.world[i];
+	}
+	instance.pad[0] = 0;
+	instance.pad[1] = 0;
+	for (int i = 0; i < 4; i++) {
+		instance.modulation[i] = p_push_constant.modulation[i];
+		instance.dst_rect[i] = p_push_constant.dst_rect[i];
+		instance.src_rect[i] = p_push_constant.src_rect[i];
+	}
+
+	if (batching.builder.add_instance(key, instance)) {
+		return true;
+	}
+
+	//out of room, draw what is pending and retry with what is left of this frame's region
+	_batch_flush(p_draw_list, p_framebuffer_format);
+	return batching.builder.add_instance(key, instance);
+}
+
+void RasterizerCanvasRD::_batch_flush(RD::DrawListID p_draw_list, RD::FramebufferFormatID p_framebuffer_format) {
+
+	uint32_t instance_count = batching.builder.get_instance_count();
+	if (instance_count == 0) {
+		return;
+	}
+
+	uint32_t base = batching.region_index * batching.region_size + batching.region_used;
+	RD::get_singleton()->buffer_update(batching.instance_buffer, base * sizeof(CanvasBatchBuilder::Instance), instance_count * sizeof(CanvasBatchBuilder::Instance), batching.builder.get_instances(), false);
+
+	PushConstant push_constant;
+	//world transform comes from the instances, keep an identity here so the fragment stage never sees a degenerate one
+	_update_transform_2d_to_mat2x3(Transform2D(), push_constant.world);
+	for (int i = 0; i < 4; i++) {
+		push_constant.modulation[i] = 0;
+		push_constant.ninepatch_margins[i] = 0;
+		push_constant.src_rect[i] = 0;
+		push_constant.dst_rect[i] = 0;
+		push_constant.lights[i] = 0;
+	}
+	push_constant.pad = 0;
+
+	for (uint32_t i = 0; i < batching.builder.get_batch_count(); i++) {
+
+		const CanvasBatchBuilder::Batch &batch = batching.builder.get_batch(i);
+
+		PipelineVariants *pipeline_variants = (PipelineVariants *)batch.key.pipeline_variants;
+		RID pipeline = pipeline_variants->variants[PIPELINE_LIGHT_MODE_DISABLED][PIPELINE_VARIANT_QUAD].get_render_pipeline(RD::INVALID_ID, p_framebuffer_format);
+		RD::get_singleton()->draw_list_bind_render_pipeline(p_draw_list, pipeline);
+
+		uint32_t flags = 0;
+		_bind_texture_binding(batch.key.texture_binding, p_draw_list, flags);
+
+		push_constant.flags = batch.key.flags | FLAGS_USING_BATCH;
+		push_constant.specular_shininess = batch.key.specular_shininess;
+		push_constant.color_texture_pixel_size[0] = batch.key.color_texture_pixel_size[0];
+		push_constant.color_texture_pixel_size[1] = batch.key.color_texture_pixel_size[1];
+		push_constant.batch_offset = base + batch.from;
+
+		RD::get_singleton()->draw_list_set_push_constant(p_draw_list, &push_constant, sizeof(PushConstant));
+		RD::get_singleton()->draw_list_bind_index_array(p_draw_list, shader.quad_index_array);
+		RD::get_singleton()->draw_list_draw(p_draw_list, true, batch.count);
+
+		render_info.current.draw_calls++;
+		render_info.current.batches++;
+	}
+
+	batching.region_used += instance_count;
+	batching.builder.begin(batching.region_size - batching.region_used);
+}
+
 ////////////////////
 void RasterizerCanvasRD::_render_item(RD::DrawListID p_draw_list, const Item *p_item, RD::FramebufferFormatID p_framebuffer_format, const Transform2D &p_canvas_transform_inverse, Item *&current_clip, Light *p_lights, PipelineVariants *p_pipeline_variants) {
 
@@ -517,8 +609,8 @@ void RasterizerCanvasRD::_render_item(RD::DrawListID p_draw_list, const Item *p_
 	push_constant.color_texture_pixel_size[0] = 0;
 	push_constant.color_texture_pixel_size[1] = 0;
 
-	push_constant.pad[0] = 0;
-	push_constant.pad[1] = 0;
+	push_constant.batch_offset = 0;
+	push_constant.pad = 0;
 
 	push_constant.lights[0] = 0;
 	push_constant.lights[1] = 0;
@@ -618,6 +710,14 @@ void RasterizerCanvasRD::_render_item(RD::DrawListID p_draw_list, const Item *p_
 				}
 			}
 
+			{
+				RD::Uniform u;
+				u.type = RD::UNIFORM_TYPE_STORAGE_BUFFER;
+				u.binding = 7;
+				u.ids.push_back(batching.instance_buffer);
+				uniforms.push_back(u);
+			}
+
 			//validate and update lighs if they are being used
 
 			if (light_count > 0) {
@@ -687,11 +787,18 @@ void RasterizerCanvasRD::_render_item(RD::DrawListID p_draw_list, const Item *p_
 			}
 		}
 
+		if (light_count > 0) {
+			//pending batches are drawn without lights, so they must go before this state is bound
+			_batch_flush(p_draw_list, p_framebuffer_format);
+		}
+
 		RD::get_singleton()->draw_list_bind_uniform_set(p_draw_list, canvas_item_state, 2);
 	}
 
 	light_mode = light_count > 0 ? PIPELINE_LIGHT_MODE_ENABLED : PIPELINE_LIGHT_MODE_DISABLED;
 
+	bool can_batch = batching.enabled && light_count == 0;
+
 	PipelineVariants *pipeline_variants = p_pipeline_variants;
 
 	bool reclip = false;
@@ -706,21 +813,37 @@ void RasterizerCanvasRD::_render_item(RD::DrawListID p_draw_list, const Item *p_
 
 				const Item::CommandRect *rect = static_cast<const Item::CommandRect *>(c);
 
-				//bind pipeline
-				{
-					RID pipeline = pipeline_variants->variants[light_mode][PIPELINE_VARIANT_QUAD].get_render_pipeline(RD::INVALID_ID, p_framebuffer_format);
-					RD::get_singleton()->draw_list_bind_render_pipeline(p_draw_list, pipeline);
-				}
+				render_info.current.commands++;
 
-				//bind textures
+				//clipped UVs need the source rect in the fragment stage, so those are not batched
+				bool batch_rect = can_batch && !(rect->flags & CANVAS_RECT_CLIP_UV);
 
 				Size2 texpixel_size;
-				{
+
+				if (batch_rect) {
+					//state is bound when the batch is drawn
+					TextureBinding *texture_binding = _get_texture_binding(rect->texture_binding.binding_id, push_constant.flags);
+					if (texture_binding && texture_binding->key.texture.is_valid()) {
+						texpixel_size = storage->texture_2d_get_size(texture_binding->key.texture);
+					} else {
+						texpixel_size = Size2(1, 1);
+					}
+				} else {
+					_batch_flush(p_draw_list, p_framebuffer_format);
+
+					//bind pipeline
+					{
+						RID pipeline = pipeline_variants->variants[light_mode][PIPELINE_VARIANT_QUAD].get_render_pipeline(RD::INVALID_ID, p_framebuffer_format);
+						RD::get_singleton()->draw_list_bind_render_pipeline(p_draw_list, pipeline);
+					}
+
+					//bind textures
 					texpixel_size = _bind_texture_binding(rect->texture_binding.binding_id, p_draw_list, push_constant.flags);
-					texpixel_size.x = 1.0 / texpixel_size.x;
-					texpixel_size.y = 1.0 / texpixel_size.y;
 				}
 
+				texpixel_size.x = 1.0 / texpixel_size.x;
+				texpixel_size.y = 1.0 / texpixel_size.y;
+
 				if (rect->specular_shininess.a < 0.999) {
 					push_constant.flags |= FLAGS_DEFAULT_SPECULAR_MAP_USED;
 				}
@@ -796,9 +919,22 @@ void RasterizerCanvasRD::_render_item(RD::DrawListID p_draw_list, const Item *p_
 				push_constant.color_texture_pixel_size[0] = texpixel_size.x;
 				push_constant.color_texture_pixel_size[1] = texpixel_size.y;
 
+				if (batch_rect) {
+					if (_batch_add_rect(p_draw_list, p_framebuffer_format, pipeline_variants, rect->texture_binding.binding_id, push_constant)) {
+						break;
+					}
+
+					//this frame ran out of batch space, draw it on its own
+					RID pipeline = pipeline_variants->variants[light_mode][PIPELINE_VARIANT_QUAD].get_render_pipeline(RD::INVALID_ID, p_framebuffer_format);
+					RD::get_singleton()->draw_list_bind_render_pipeline(p_draw_list, pipeline);
+					uint32_t flags = 0;
+					_bind_texture_binding(rect->texture_binding.binding_id, p_draw_list, flags);
+				}
+
 				RD::get_singleton()->draw_list_set_push_constant(p_draw_list, &push_constant, sizeof(PushConstant));
 				RD::get_singleton()->draw_list_bind_index_array(p_draw_list, shader.quad_index_array);
 				RD::get_singleton()->draw_list_draw(p_draw_list, true);
+				render_info.current.draw_calls++;
 
 			} break;
 
@@ -806,6 +942,9 @@ void RasterizerCanvasRD::_render_item(RD::DrawListID p_draw_list, const Item *p_
 
 				const Item::CommandNinePatch *np = static_cast<const Item::CommandNinePatch *>(c);
 
+				render_info.current.commands++;
+				_batch_flush(p_draw_list, p_framebuffer_format);
+
 				//bind pipeline
 				{
 					RID pipeline = pipeline_variants->variants[light_mode][PIPELINE_VARIANT_NINEPATCH].get_render_pipeline(RD::INVALID_ID, p_framebuffer_format);
@@ -878,6 +1017,7 @@ void RasterizerCanvasRD::_render_item(RD::DrawListID p_draw_list, const Item *p_
 				RD::get_singleton()->draw_list_set_push_constant(p_draw_list, &push_constant, sizeof(PushConstant));
 				RD::get_singleton()->draw_list_bind_index_array(p_draw_list, shader.quad_index_array);
 				RD::get_singleton()->draw_list_draw(p_draw_list, true);
+				render_info.current.draw_calls++;
 
 			} break;
 			case Item::Command::TYPE_POLYGON: {
@@ -886,6 +1026,9 @@ void RasterizerCanvasRD::_render_item(RD::DrawListID p_draw_list, const Item *p_
 
 				PolygonBuffers *pb = polygon_buffers.polygons.getptr(polygon->polygon.polygon_id);
 				ERR_CONTINUE(!pb);
+
+				render_info.current.commands++;
+				_batch_flush(p_draw_list, p_framebuffer_format);
 				//bind pipeline
 				{
 					static const PipelineVariant variant[VS::PRIMITIVE_MAX] = { PIPELINE_VARIANT_ATTRIBUTE_POINTS, PIPELINE_VARIANT_ATTRIBUTE_LINES, PIPELINE_VARIANT_ATTRIBUTE_LINES_STRIP, PIPELINE_VARIANT_ATTRIBUTE_TRIANGLES, PIPELINE_VARIANT_ATTRIBUTE_TRIANGLE_STRIP };
@@ -934,12 +1077,16 @@ void RasterizerCanvasRD::_render_item(RD::DrawListID p_draw_list, const Item *p_
 					RD::get_singleton()->draw_list_bind_index_array(p_draw_list, pb->indices);
 				}
 				RD::get_singleton()->draw_list_draw(p_draw_list, pb->indices.is_valid());
+				render_info.current.draw_calls++;
 
 			} break;
 			case Item::Command::TYPE_PRIMITIVE: {
 
 				const Item::CommandPrimitive *primitive = static_cast<const Item::CommandPrimitive *>(c);
 
+				render_info.current.commands++;
+				_batch_flush(p_draw_list, p_framebuffer_format);
+
 				//bind pipeline
 				{
 					static const PipelineVariant variant[4] = { PIPELINE_VARIANT_PRIMITIVE_POINTS, PIPELINE_VARIANT_PRIMITIVE_LINES, PIPELINE_VARIANT_PRIMITIVE_TRIANGLES, PIPELINE_VARIANT_PRIMITIVE_TRIANGLES };
@@ -973,6 +1120,7 @@ void RasterizerCanvasRD::_render_item(RD::DrawListID p_draw_list, const Item *p_
 				}
 				RD::get_singleton()->draw_list_set_push_constant(p_draw_list, &push_constant, sizeof(PushConstant));
 				RD::get_singleton()->draw_list_draw(p_draw_list, true);
+				render_info.current.draw_calls++;
 
 				if (primitive->point_count == 4) {
 					for (uint32_t j = 1; j < 3; j++) {
@@ -988,6 +1136,7 @@ void RasterizerCanvasRD::_render_item(RD::DrawListID p_draw_list, const Item *p_
 
 					RD::get_singleton()->draw_list_set_push_constant(p_draw_list, &push_constant, sizeof(PushConstant));
 					RD::get_singleton()->draw_list_draw(p_draw_list, true);
+					render_info.current.draw_calls++;
 				}
 
 			} break;
@@ -1295,6 +1444,8 @@ void RasterizerCanvasRD::_render_item(RD::DrawListID p_draw_list, const Item *p_
 
 					if (ci->ignore != reclip) {
 
+						_batch_flush(p_draw_list, p_framebuffer_format);
+
 						if (ci->ignore) {
 							RD::get_singleton()->draw_list_disable_scissor(p_draw_list);
 							reclip = true;
@@ -1348,12 +1499,16 @@ void RasterizerCanvasRD::_render_items(RID p_to_render_target, int p_item_count,
 
 	PipelineVariants *pipeline_variants = &shader.pipeline_variants;
 
+	batching.builder.begin(batching.region_size - batching.region_used);
+
 	for (int i = 0; i < p_item_count; i++) {
 
 		Item *ci = items[i];
 
 		if (current_clip != ci->final_clip_owner) {
 
+			_batch_flush(draw_list, fb_format);
+
 			current_clip = ci->final_clip_owner;
 
 			//setup clip
@@ -1369,6 +1524,8 @@ void RasterizerCanvasRD::_render_items(RID p_to_render_target, int p_item_count,
 
 		if (ci->material != prev_material) {
 
+			_batch_flush(draw_list, fb_format);
+
 			MaterialData *material_data = NULL;
 			if (ci->material.is_valid()) {
 				material_data = (MaterialData *)storage->material_get_data(ci->material, RasterizerStorageRD::SHADER_TYPE_2D);
@@ -1394,6 +1551,8 @@ void RasterizerCanvasRD::_render_items(RID p_to_render_target, int p_item_count,
 		prev_material = ci->material;
 	}
 
+	_batch_flush(draw_list, fb_format);
+
 	RD::get_singleton()->draw_list_end();
 }
 
@@ -2197,6 +2356,34 @@ void RasterizerCanvasRD::set_time(double p_time) {
 
 void RasterizerCanvasRD::update() {
 	_dispose_bindings();
+
+	//frame is done, move on to the next batch region and keep the stats around
+	batching.region_index = (batching.region_index + 1) % batching.region_count;
+	batching.region_used = 0;
+
+	render_info.last = render_info.current;
+	render_info.current.commands = 0;
+	render_info.current.draw_calls = 0;
+	render_info.current.batches = 0;
+}
+
+int RasterizerCanvasRD::get_render_info(VS::RenderInfo p_info) {
+
+	switch (p_info) {
+		case VS::INFO_2D_COMMANDS_IN_FRAME: {
+			return render_info.last.commands;
+		} break;
+		case VS::INFO_2D_DRAW_CALLS_IN_FRAME: {
+			return render_info.last.draw_calls;
+		} break;
+		case VS::INFO_2D_BATCHES_IN_FRAME: {
+			return render_info.last.batches;
+		} break;
+		default: {
+		}
+	}
+
+	return 0;
 }
 
 RasterizerCanvasRD::RasterizerCanvasRD(RasterizerStorageRD *p_storage) {
@@ -2438,6 +2625,22 @@ RasterizerCanvasRD::RasterizerCanvasRD(RasterizerStorageRD *p_storage) {
 		polygon_buffers.last_id = 1;
 	}
 
+	{ //batching
+
+		batching.enabled = GLOBAL_GET("rendering/quality/2d/use_batching");
+		batching.region_size = DEFAULT_MAX_BATCH_INSTANCES_PER_FRAME;
+		batching.region_count = RD::get_singleton()->get_frame_delay() + 1;
+		batching.region_index = 0;
+		batching.region_used = 0;
+		//always created, as the canvas item state references it even when batching is disabled
+		batching.instance_buffer = RD::get_singleton()->storage_buffer_create(batching.region_size * batching.region_count * sizeof(CanvasBatchBuilder::Instance));
+
+		render_info.current.commands = 0;
+		render_info.current.draw_calls = 0;
+		render_info.current.batches = 0;
+		render_info.last = render_info.current;
+	}
+
 	{ // default index buffer
 
 		Vector<uint8_t> pv;
@@ -2513,6 +2716,7 @@ RasterizerCanvasRD::~RasterizerCanvasRD() {
 		RD::get_singleton()->free(state.lights_uniform_buffer);
 		RD::get_singleton()->free(shader.default_skeleton_uniform_buffer);
 		RD::get_singleton()->free(shader.default_skeleton_texture_buffer);
+		RD::get_singleton()->free(batching.instance_buffer);
 	}
 
 	//shadow rendering
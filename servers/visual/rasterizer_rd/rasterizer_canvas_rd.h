@@ -32,6 +32,7 @@
 #define RASTERIZER_CANVAS_RD_H
 
 #include "servers/visual/rasterizer.h"
+#include "servers/visual/rasterizer_rd/canvas_batch_builder.h"
 #include "servers/visual/rasterizer_rd/rasterizer_storage_rd.h"
 #include "servers/visual/rasterizer_rd/render_pipeline_vertex_format_cache_rd.h"
 #include "servers/visual/rasterizer_rd/shader_compiler_rd.h"
@@ -80,6 +81,8 @@ class RasterizerCanvasRD : public RasterizerCanvas {
 		FLAGS_NINEPATCH_V_MODE_SHIFT = 18,
 		FLAGS_LIGHT_COUNT_SHIFT = 20,
 
+		FLAGS_USING_BATCH = (1 << 24),
+
 		FLAGS_DEFAULT_NORMAL_MAP_USED = (1 << 26),
 		FLAGS_DEFAULT_SPECULAR_MAP_USED = (1 << 27)
 
@@ -102,7 +105,8 @@ class RasterizerCanvasRD : public RasterizerCanvas {
 		MAX_RENDER_ITEMS = 256 * 1024,
 		MAX_LIGHT_TEXTURES = 1024,
 		DEFAULT_MAX_LIGHTS_PER_ITEM = 16,
-		DEFAULT_MAX_LIGHTS_PER_RENDER = 256
+		DEFAULT_MAX_LIGHTS_PER_RENDER = 256,
+		DEFAULT_MAX_BATCH_INSTANCES_PER_FRAME = 16384
 	};
 
 	/****************/
@@ -437,7 +441,8 @@ class RasterizerCanvasRD : public RasterizerCanvas {
 				float ninepatch_margins[4];
 				float dst_rect[4];
 				float src_rect[4];
-				float pad[2];
+				uint32_t batch_offset;
+				uint32_t pad;
 			};
 			//primitive
 			struct {
@@ -450,6 +455,36 @@ class RasterizerCanvasRD : public RasterizerCanvas {
 		uint32_t lights[4];
 	};
 
+	/******************/
+	/**** BATCHING ****/
+	/******************/
+
+	// Rects that share material, texture binding and flags are merged into
+	// a single instanced draw. Instance data goes to a storage buffer split
+	// in one region per frame in flight, so it is never overwritten while
+	// the GPU may still be reading it.
+
+	struct {
+		bool enabled;
+		CanvasBatchBuilder builder;
+		RID instance_buffer;
+		uint32_t region_size;
+		uint32_t region_count;
+		uint32_t region_index;
+		uint32_t region_used;
+	} batching;
+
+	struct InfoCounters {
+		uint32_t commands;
+		uint32_t draw_calls;
+		uint32_t batches;
+	};
+
+	struct {
+		InfoCounters current;
+		InfoCounters last;
+	} render_info;
+
 	struct SkeletonUniform {
 		float skeleton_transform[16];
 		float skeleton_inverse[16];
@@ -457,7 +492,10 @@ class RasterizerCanvasRD : public RasterizerCanvas {
 
 	Item *items[MAX_RENDER_ITEMS];
 
+	TextureBinding *_get_texture_binding(TextureBindingID p_binding, uint32_t &flags);
 	Size2i _bind_texture_binding(TextureBindingID p_binding, RenderingDevice::DrawListID p_draw_list, uint32_t &flags);
+	bool _batch_add_rect(RenderingDevice::DrawListID p_draw_list, RenderingDevice::FramebufferFormatID p_framebuffer_format, PipelineVariants *p_pipeline_variants, TextureBindingID p_binding, const PushConstant &p_push_constant);
+	void _batch_flush(RenderingDevice::DrawListID p_draw_list, RenderingDevice::FramebufferFormatID p_framebuffer_format);
 	void _render_item(RenderingDevice::DrawListID p_draw_list, const Item *p_item, RenderingDevice::FramebufferFormatID p_framebuffer_format, const Transform2D &p_canvas_transform_inverse, Item *&current_clip, Light *p_lights, PipelineVariants *p_pipeline_variants);
 	void _render_items(RID p_to_render_target, int p_item_count, const Transform2D &p_canvas_transform_inverse, Light *p_lights, RID p_screen_uniform_set);
 
@@ -489,6 +527,8 @@ public:
 
 	void canvas_debug_viewport_shadows(Light *p_lights_with_shadow){};
 
+	int get_render_info(VS::RenderInfo p_info);
+
 	void draw_window_margins(int *p_margins, RID *p_margin_textures) {}
 
 	void set_time(double p_time);
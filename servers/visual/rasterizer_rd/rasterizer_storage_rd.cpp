@@ -1898,6 +1898,13 @@ void RasterizerStorageRD::mesh_add_surface(RID p_mesh, const VS::SurfaceData &p_
 				s->lods[i].index_array = RD::get_singleton()->index_array_create(s->lods[i].index_buffer, 0, indices);
 				s->lods[i].edge_length = p_surface.lods[i].edge_length;
 			}
+
+			//keep them sorted by edge length, so selection at render time can stop early
+			for (uint32_t i = 1; i < s->lod_count; i++) {
+				for (uint32_t j = i; j > 0 && s->lods[j - 1].edge_length > s->lods[j].edge_length; j--) {
+					SWAP(s->lods[j - 1], s->lods[j]);
+				}
+			}
 		}
 	}
 
@@ -2508,6 +2515,36 @@ void RasterizerStorageRD::_multimesh_mark_all_dirty(MultiMesh *multimesh, bool p
 	}
 }
 
+void RasterizerStorageRD::_multimesh_mark_dirty_range(MultiMesh *multimesh, int p_from, int p_count, bool p_aabb) {
+
+	if (p_count <= 0) {
+		return;
+	}
+
+	uint32_t from_region = p_from / MULTIMESH_DIRTY_REGION_SIZE;
+	uint32_t to_region = (p_from + p_count - 1) / MULTIMESH_DIRTY_REGION_SIZE;
+#ifdef DEBUG_ENABLED
+	uint32_t data_cache_dirty_region_count = (multimesh->instances - 1) / MULTIMESH_DIRTY_REGION_SIZE + 1;
+	ERR_FAIL_UNSIGNED_INDEX(to_region, data_cache_dirty_region_count); //bug
+#endif
+	for (uint32_t i = from_region; i <= to_region; i++) {
+		if (!multimesh->data_cache_dirty_regions[i]) {
+			multimesh->data_cache_dirty_regions[i] = true;
+			multimesh->data_cache_used_dirty_regions++;
+		}
+	}
+
+	if (p_aabb) {
+		multimesh->aabb_dirty = true;
+	}
+
+	if (!multimesh->dirty) {
+		multimesh->dirty_list = multimesh_dirty_list;
+		multimesh_dirty_list = multimesh;
+		multimesh->dirty = true;
+	}
+}
+
 void RasterizerStorageRD::_multimesh_re_create_aabb(MultiMesh *multimesh, const float *p_data, int p_instances) {
 
 	ERR_FAIL_COND(multimesh->mesh.is_null());
@@ -2798,6 +2835,39 @@ void RasterizerStorageRD::multimesh_set_buffer(RID p_multimesh, const Vector<flo
 	}
 }
 
+void RasterizerStorageRD::multimesh_set_buffer_range(RID p_multimesh, int p_from_instance, const Vector<float> &p_buffer) {
+	MultiMesh *multimesh = multimesh_owner.getornull(p_multimesh);
+	ERR_FAIL_COND(!multimesh);
+	ERR_FAIL_COND(multimesh->instances == 0);
+	ERR_FAIL_COND((p_buffer.size() % multimesh->stride_cache) != 0);
+
+	int count = p_buffer.size() / multimesh->stride_cache;
+	ERR_FAIL_COND(p_from_instance < 0 || p_from_instance + count > multimesh->instances);
+
+	if (count == 0) {
+		return;
+	}
+
+	if (multimesh->data_cache.size() == 0 && multimesh->mesh.is_null()) {
+		//nothing to keep track of on CPU, so upload the range right away
+		const float *r = p_buffer.ptr();
+		uint64_t offset = uint64_t(p_from_instance) * multimesh->stride_cache * sizeof(float);
+		RD::get_singleton()->buffer_update(multimesh->buffer, offset, p_buffer.size() * sizeof(float), r, false);
+		multimesh->buffer_set = true;
+		return;
+	}
+
+	//the AABB needs the whole buffer, so keep it local and let the range be uploaded with the other dirty regions
+	_multimesh_make_local(multimesh);
+
+	{
+		float *w = multimesh->data_cache.ptrw();
+		copymem(w + p_from_instance * multimesh->stride_cache, p_buffer.ptr(), p_buffer.size() * sizeof(float));
+	}
+
+	_multimesh_mark_dirty_range(multimesh, p_from_instance, count, true);
+}
+
 Vector<float> RasterizerStorageRD::multimesh_get_buffer(RID p_multimesh) const {
 	MultiMesh *multimesh = multimesh_owner.getornull(p_multimesh);
 	ERR_FAIL_COND_V(!multimesh, Vector<float>());
@@ -2810,9 +2880,9 @@ Vector<float> RasterizerStorageRD::multimesh_get_buffer(RID p_multimesh) const {
 
 		Vector<uint8_t> buffer = RD::get_singleton()->buffer_get_data(multimesh->buffer);
 		Vector<float> ret;
-		ret.resize(multimesh->instances);
+		ret.resize(multimesh->instances * multimesh->stride_cache);
 		{
-			float *w = multimesh->data_cache.ptrw();
+			float *w = ret.ptrw();
 			const uint8_t *r = buffer.ptr();
 			copymem(w, r, buffer.size());
 		}
@@ -2865,30 +2935,45 @@ void RasterizerStorageRD::_update_dirty_multimeshes() {
 
 			if (multimesh->data_cache_used_dirty_regions) {
 
-				uint32_t data_cache_dirty_region_count = (multimesh->instances - 1) / MULTIMESH_DIRTY_REGION_SIZE + 1;
-				uint32_t visible_region_count = (visible_instances - 1) / MULTIMESH_DIRTY_REGION_SIZE + 1;
+				uint32_t visible_region_count = visible_instances ? (visible_instances - 1) / MULTIMESH_DIRTY_REGION_SIZE + 1 : 0;
 
-				uint32_t region_size = multimesh->stride_cache * MULTIMESH_DIRTY_REGION_SIZE * sizeof(float);
+				uint32_t region_size = multimesh->stride_cache * MULTIMESH_DIRTY_REGION_SIZE;
+				uint32_t total_size = multimesh->stride_cache * multimesh->instances;
+
+				if (visible_region_count && multimesh->data_cache_used_dirty_regions > visible_region_count / 2) {
+					//if dirty regions represent the majority of regions, just copy all, else transfer cost piles up too much
+					RD::get_singleton()->buffer_update(multimesh->buffer, 0, MIN(visible_region_count * region_size, total_size) * sizeof(float), data, false);
 
-				if (multimesh->data_cache_used_dirty_regions > 32 || multimesh->data_cache_used_dirty_regions > visible_region_count / 2) {
-					//if there too many dirty regions, or represent the majority of regions, just copy all, else transfer cost piles up too much
-					RD::get_singleton()->buffer_update(multimesh->buffer, 0, MIN(visible_region_count * region_size, multimesh->instances * multimesh->stride_cache * sizeof(float)), data, false);
-				} else {
-					//not that many regions? update them all
 					for (uint32_t i = 0; i < visible_region_count; i++) {
 						if (multimesh->data_cache_dirty_regions[i]) {
-							uint64_t offset = i * region_size;
-							uint64_t size = multimesh->stride_cache * multimesh->instances * sizeof(float);
-							RD::get_singleton()->buffer_update(multimesh->buffer, offset, MIN(region_size, size - offset), &data[i * region_size], false);
+							multimesh->data_cache_dirty_regions[i] = false;
+							multimesh->data_cache_used_dirty_regions--;
 						}
 					}
-				}
+				} else {
+					//upload runs of contiguous dirty regions with a single transfer each
+					uint32_t i = 0;
+					while (i < visible_region_count) {
+						if (!multimesh->data_cache_dirty_regions[i]) {
+							i++;
+							continue;
+						}
 
-				for (uint32_t i = 0; i < data_cache_dirty_region_count; i++) {
-					multimesh->data_cache_dirty_regions[i] = false;
+						uint32_t from = i;
+						while (i < visible_region_count && multimesh->data_cache_dirty_regions[i]) {
+							multimesh->data_cache_dirty_regions[i] = false;
+							multimesh->data_cache_used_dirty_regions--;
+							i++;
+						}
+
+						uint32_t offset = from * region_size;
+						uint32_t size = MIN((i - from) * region_size, total_size - offset);
+						RD::get_singleton()->buffer_update(multimesh->buffer, offset * sizeof(float), size * sizeof(float), &data[offset], false);
+					}
 				}
 
-				multimesh->data_cache_used_dirty_regions = 0;
+				//regions past the visible instances stay dirty, they are uploaded once they become visible
+				multimesh->buffer_set = true;
 			}
 
 			if (multimesh->aabb_dirty) {
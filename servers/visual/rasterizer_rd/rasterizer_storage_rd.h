@@ -326,6 +326,7 @@ private:
 	_FORCE_INLINE_ void _multimesh_make_local(MultiMesh *multimesh) const;
 	_FORCE_INLINE_ void _multimesh_mark_dirty(MultiMesh *multimesh, int p_index, bool p_aabb);
 	_FORCE_INLINE_ void _multimesh_mark_all_dirty(MultiMesh *multimesh, bool p_data, bool p_aabb);
+	_FORCE_INLINE_ void _multimesh_mark_dirty_range(MultiMesh *multimesh, int p_from, int p_count, bool p_aabb);
 	_FORCE_INLINE_ void _multimesh_re_create_aabb(MultiMesh *multimesh, const float *p_data, int p_instances);
 	void _update_dirty_multimeshes();
 
@@ -662,7 +663,7 @@ public:
 		return mesh->surfaces[p_surface_index]->primitive;
 	}
 
-	_FORCE_INLINE_ void mesh_surface_get_arrays_and_format(RID p_mesh, uint32_t p_surface_index, uint32_t p_input_mask, RID &r_vertex_array_rd, RID &r_index_array_rd, RD::VertexFormatID &r_vertex_format) {
+	_FORCE_INLINE_ void mesh_surface_get_arrays_and_format(RID p_mesh, uint32_t p_surface_index, uint32_t p_input_mask, float p_lod_edge_length, RID &r_vertex_array_rd, RID &r_index_array_rd, RD::VertexFormatID &r_vertex_format) {
 		Mesh *mesh = mesh_owner.getornull(p_mesh);
 		ERR_FAIL_COND(!mesh);
 		ERR_FAIL_UNSIGNED_INDEX(p_surface_index, mesh->surface_count);
@@ -671,6 +672,14 @@ public:
 
 		r_index_array_rd = s->index_array;
 
+		//lods are sorted by edge length, use the coarsest one whose error is still not visible
+		for (uint32_t i = 0; i < s->lod_count; i++) {
+			if (s->lods[i].edge_length > p_lod_edge_length) {
+				break;
+			}
+			r_index_array_rd = s->lods[i].index_array;
+		}
+
 		s->version_lock.lock();
 
 		//there will never be more than, at much, 3 or 4 versions, so iterating is the fastest way
@@ -748,6 +757,7 @@ public:
 	Color multimesh_instance_get_custom_data(RID p_multimesh, int p_index) const;
 
 	void multimesh_set_buffer(RID p_multimesh, const Vector<float> &p_buffer);
+	void multimesh_set_buffer_range(RID p_multimesh, int p_from_instance, const Vector<float> &p_buffer);
 	Vector<float> multimesh_get_buffer(RID p_multimesh) const;
 
 	void multimesh_set_visible_instances(RID p_multimesh, int p_visible);
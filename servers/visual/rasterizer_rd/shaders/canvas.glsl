@@ -42,6 +42,9 @@ VERTEX_SHADER_GLOBALS
 void main() {
 
 	vec4 instance_custom = vec4(0.0);
+	vec2 world_x = draw_data.world_x;
+	vec2 world_y = draw_data.world_y;
+	vec2 world_ofs = draw_data.world_ofs;
 #ifdef USE_PRIMITIVE
 
 	//weird bug,
@@ -77,14 +80,30 @@ void main() {
 	vec2 vertex_base_arr[4] = vec2[](vec2(0.0, 0.0), vec2(0.0, 1.0), vec2(1.0, 1.0), vec2(1.0, 0.0));
 	vec2 vertex_base = vertex_base_arr[gl_VertexIndex];
 
-	vec2 uv = draw_data.src_rect.xy + abs(draw_data.src_rect.zw) * ((draw_data.flags & FLAGS_TRANSPOSE_RECT) != 0 ? vertex_base.yx : vertex_base.xy);
+	vec4 src_rect = draw_data.src_rect;
+	vec4 dst_rect = draw_data.dst_rect;
 	vec4 color = draw_data.modulation;
-	vec2 vertex = draw_data.dst_rect.xy + abs(draw_data.dst_rect.zw) * mix(vertex_base, vec2(1.0, 1.0) - vertex_base, lessThan(draw_data.src_rect.zw, vec2(0.0, 0.0)));
+
+#ifndef USE_NINEPATCH
+	if (bool(draw_data.flags & FLAGS_USING_BATCH)) {
+		//rects merged by the batcher, one instance per rect
+		BatchInstance instance = batch_instances.data[draw_data.batch_offset + gl_InstanceIndex];
+		world_x = instance.world_x;
+		world_y = instance.world_y;
+		world_ofs = instance.world_ofs;
+		src_rect = instance.src_rect;
+		dst_rect = instance.dst_rect;
+		color = instance.modulation;
+	}
+#endif
+
+	vec2 uv = src_rect.xy + abs(src_rect.zw) * ((draw_data.flags & FLAGS_TRANSPOSE_RECT) != 0 ? vertex_base.yx : vertex_base.xy);
+	vec2 vertex = dst_rect.xy + abs(dst_rect.zw) * mix(vertex_base, vec2(1.0, 1.0) - vertex_base, lessThan(src_rect.zw, vec2(0.0, 0.0)));
 	uvec4 bones = uvec4(0, 0, 0, 0);
 
 #endif
 
-	mat4 world_matrix = mat4(vec4(draw_data.world_x, 0.0, 0.0), vec4(draw_data.world_y, 0.0, 0.0), vec4(0.0, 0.0, 1.0, 0.0), vec4(draw_data.world_ofs, 0.0, 1.0));
+	mat4 world_matrix = mat4(vec4(world_x, 0.0, 0.0), vec4(world_y, 0.0, 0.0), vec4(0.0, 0.0, 1.0, 0.0), vec4(world_ofs, 0.0, 1.0));
 
 #if 0
 	if (draw_data.flags & FLAGS_INSTANCING_ENABLED) {
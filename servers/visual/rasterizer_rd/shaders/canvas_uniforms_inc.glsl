@@ -19,6 +19,8 @@
 
 #define FLAGS_LIGHT_COUNT_SHIFT 20
 
+#define FLAGS_USING_BATCH (1 << 24)
+
 #define FLAGS_DEFAULT_NORMAL_MAP_USED (1 << 26)
 #define FLAGS_DEFAULT_SPECULAR_MAP_USED (1 << 27)
 
@@ -45,7 +47,8 @@ layout(push_constant, binding = 0, std430) uniform DrawData {
 	vec4 ninepatch_margins;
 	vec4 dst_rect; //for built-in rect and UV
 	vec4 src_rect;
-	vec2 pad;
+	uint batch_offset;
+	uint pad;
 
 #endif
 	vec2 color_texture_pixel_size;
@@ -92,6 +95,21 @@ layout(set = 2, binding = 2, std140) uniform SkeletonData {
 }
 skeleton_data;
 
+struct BatchInstance {
+	vec2 world_x;
+	vec2 world_y;
+	vec2 world_ofs;
+	vec2 pad;
+	vec4 modulation;
+	vec4 dst_rect;
+	vec4 src_rect;
+};
+
+layout(set = 2, binding = 7, std430) restrict readonly buffer BatchInstances {
+	BatchInstance data[];
+}
+batch_instances;
+
 #ifdef USE_LIGHTING
 
 #define LIGHT_FLAGS_BLEND_MASK (3 << 16)
@@ -35,17 +35,197 @@
 
 static const int z_range = VS::CANVAS_ITEM_Z_MAX - VS::CANVAS_ITEM_Z_MIN + 1;
 
-void VisualServerCanvas::_render_canvas_item_tree(RID p_to_render_target, Canvas::ChildItem *p_child_items, int p_child_item_count, Item *p_canvas_item, const Transform2D &p_transform, const Rect2 &p_clip_rect, const Color &p_modulate, RasterizerCanvas::Light *p_lights) {
+static _FORCE_INLINE_ VisualServerCanvas::Item *_get_child_item(VisualServerCanvas::Item *p_child) {
+	return p_child;
+}
+
+static _FORCE_INLINE_ VisualServerCanvas::Item *_get_child_item(const VisualServerCanvas::Canvas::ChildItem &p_child) {
+	return p_child.item;
+}
+
+static _FORCE_INLINE_ void _update_child_order(VisualServerCanvas::Item *p_canvas_item) {
+
+	if (p_canvas_item->children_order_dirty) {
+
+		p_canvas_item->child_items.sort_custom<VisualServerCanvas::ItemIndexSort>();
+		p_canvas_item->children_order_dirty = false;
+		p_canvas_item->cull_grid_dirty = true;
+	}
+}
+
+template <class T>
+void VisualServerCanvas::_update_cull_grid(CanvasCullGrid &r_grid, bool &r_grid_dirty, T *p_children, int p_child_count) {
+
+	if (!r_grid_dirty && r_grid.get_moved_count() <= CULL_GRID_MAX_MOVED + r_grid.get_count() / 4) {
+		return;
+	}
+
+	r_grid.begin();
+
+	for (int i = 0; i < p_child_count; i++) {
+
+		Item *child = _get_child_item(p_children[i]);
+		child->cull_index = i;
+		child->cull_loose = false;
+
+		if (!child->visible) {
+			continue; //becomes loose when made visible
+		}
+
+		_update_subtree_rect(child);
+
+		if (child->subtree_unbounded) {
+			child->cull_loose = true;
+			r_grid.add_loose(i);
+		} else if (child->subtree_has_rect) {
+			r_grid.add(i, child->subtree_rect);
+		}
+	}
+
+	r_grid.end();
+	r_grid_dirty = false;
+}
+
+template <class T>
+const uint32_t *VisualServerCanvas::_cull_children(CanvasCullGrid &r_grid, bool &r_grid_dirty, T *p_children, int p_child_count, const Transform2D &p_xform, const Rect2 &p_cull_rect, uint32_t &r_count) {
+
+	if (p_child_count < CULL_GRID_MIN_CHILDREN || Math::is_zero_approx(p_xform.basis_determinant())) {
+		return NULL; //test every child
+	}
+
+	_update_cull_grid(r_grid, r_grid_dirty, p_children, p_child_count);
+
+	return r_grid.query(p_xform.affine_inverse().xform(p_cull_rect), r_count);
+}
+
+void VisualServerCanvas::_update_subtree_rect(Item *p_item) {
+
+	Item *ci = p_item;
+
+	if (!ci->subtree_dirty) {
+		return;
+	}
+
+	bool unbounded = ci->update_when_visible || ci->copy_back_buffer || ci->vp_render || ci->dynamic_rect;
+	bool has_rect = false;
+	Rect2 rect;
+
+	if (ci->commands) {
+		rect = ci->xform.xform(ci->get_rect());
+		has_rect = true;
+	}
+
+	_update_child_order(ci);
+
+	int child_item_count = ci->child_items.size();
+	Item **child_items = ci->child_items.ptrw();
+
+	const uint32_t *indices = NULL;
+	int count = child_item_count;
+
+	if (child_item_count >= CULL_GRID_MIN_CHILDREN) {
+		//grid bounds only grow until it is rebuilt, so only the children that changed since need visiting
+		_update_cull_grid(ci->cull_grid, ci->cull_grid_dirty, child_items, child_item_count);
+
+		if (ci->cull_grid.has_bounds()) {
+			rect = has_rect ? rect.merge(ci->xform.xform(ci->cull_grid.get_bounds())) : ci->xform.xform(ci->cull_grid.get_bounds());
+			has_rect = true;
+		}
+
+		indices = ci->cull_grid.get_loose();
+		count = ci->cull_grid.get_loose_count();
+	}
+
+	for (int i = 0; i < count; i++) {
+
+		Item *child = child_items[indices ? indices[i] : i];
+		if (!child->visible) {
+			continue;
+		}
+
+		_update_subtree_rect(child);
+
+		if (child->subtree_unbounded) {
+			unbounded = true;
+		} else if (child->subtree_has_rect) {
+			Rect2 child_rect = ci->xform.xform(child->subtree_rect);
+			rect = has_rect ? rect.merge(child_rect) : child_rect;
+			has_rect = true;
+		}
+	}
+
+	ci->subtree_rect = rect;
+	ci->subtree_has_rect = has_rect;
+	ci->subtree_unbounded = unbounded;
+	ci->subtree_dirty = false;
+}
+
+void VisualServerCanvas::_mark_subtree_dirty(Item *p_item) {
+
+	//always notify the parent of the first item, it may be dirty but hidden from a clean parent
+	Item *ci = p_item;
+	ci->subtree_dirty = true;
+
+	while (true) {
+
+		Item *parent = canvas_item_owner.getornull(ci->parent);
+		if (parent) {
+
+			if (!parent->cull_grid_dirty && !ci->cull_loose && ci->cull_index >= 0) {
+				ci->cull_loose = true;
+				parent->cull_grid.add_loose(ci->cull_index);
+			}
+
+			if (parent->subtree_dirty) {
+				return; //already propagated from here
+			}
+
+			parent->subtree_dirty = true;
+			ci = parent;
+			continue;
+		}
+
+		Canvas *canvas = canvas_owner.getornull(ci->parent);
+		if (canvas && !canvas->cull_grid_dirty && !ci->cull_loose && ci->cull_index >= 0) {
+			ci->cull_loose = true;
+			canvas->cull_grid.add_loose(ci->cull_index);
+		}
+
+		return;
+	}
+}
+
+void VisualServerCanvas::_render_canvas_item_tree(RID p_to_render_target, Canvas *p_canvas, Item *p_canvas_item, const Transform2D &p_transform, const Rect2 &p_clip_rect, const Color &p_modulate, RasterizerCanvas::Light *p_lights) {
 
 	RENDER_TIMESTAMP("Cull CanvasItem Tree");
 
 	memset(z_list, 0, z_range * sizeof(RasterizerCanvas::Item *));
 	memset(z_last_list, 0, z_range * sizeof(RasterizerCanvas::Item *));
 
-	for (int i = 0; i < p_child_item_count; i++) {
-		_cull_canvas_item(p_child_items[i].item, p_transform, p_clip_rect, Color(1, 1, 1, 1), 0, z_list, z_last_list, NULL, NULL);
+	//items are culled against the clip rect moved to the origin, see _cull_canvas_item
+	Rect2 cull_rect(Point2(), p_clip_rect.size);
+
+	if (p_canvas) {
+
+		int child_item_count = p_canvas->child_items.size();
+		Canvas::ChildItem *child_items = p_canvas->child_items.ptrw();
+
+		uint32_t visible_count = 0;
+		const uint32_t *visible = _cull_children(p_canvas->cull_grid, p_canvas->cull_grid_dirty, child_items, child_item_count, p_transform, cull_rect, visible_count);
+		if (visible) {
+			child_item_count = visible_count;
+		}
+
+		for (int i = 0; i < child_item_count; i++) {
+
+			Item *child = child_items[visible ? visible[i] : i].item;
+			if (_is_subtree_culled(child, p_transform, cull_rect)) {
+				continue;
+			}
+			_cull_canvas_item(child, p_transform, p_clip_rect, Color(1, 1, 1, 1), 0, z_list, z_last_list, NULL, NULL);
+		}
 	}
-	if (p_canvas_item) {
+	if (p_canvas_item && !_is_subtree_culled(p_canvas_item, p_transform, cull_rect)) {
 		_cull_canvas_item(p_canvas_item, p_transform, p_clip_rect, Color(1, 1, 1, 1), 0, z_list, z_last_list, NULL, NULL);
 	}
 
@@ -78,7 +258,7 @@ void _collect_ysort_children(VisualServerCanvas::Item *p_canvas_item, Transform2
 				r_items[r_index] = child_items[i];
 				child_items[i]->ysort_xform = p_transform;
 				child_items[i]->ysort_pos = p_transform.xform(child_items[i]->xform.elements[2]);
-				child_items[i]->material_owner = child_items[i]->use_parent_material ? p_material_owner : NULL;
+				child_items[i]->ysort_material_owner = child_items[i]->use_parent_material ? p_material_owner : NULL;
 			}
 
 			r_index++;
@@ -103,11 +283,7 @@ void VisualServerCanvas::_cull_canvas_item(Item *p_canvas_item, const Transform2
 	if (!ci->visible)
 		return;
 
-	if (ci->children_order_dirty) {
-
-		ci->child_items.sort_custom<ItemIndexSort>();
-		ci->children_order_dirty = false;
-	}
+	_update_child_order(ci);
 
 	Rect2 rect = ci->get_rect();
 	Transform2D xform = p_transform * ci->xform;
@@ -128,6 +304,8 @@ void VisualServerCanvas::_cull_canvas_item(Item *p_canvas_item, const Transform2
 
 	int child_item_count = ci->child_items.size();
 	Item **child_items = ci->child_items.ptrw();
+	const uint32_t *visible_children = NULL;
+	Rect2 cull_rect(Point2(), p_clip_rect.size);
 
 	if (ci->clip) {
 		if (p_canvas_clip != NULL) {
@@ -143,19 +321,29 @@ void VisualServerCanvas::_cull_canvas_item(Item *p_canvas_item, const Transform2
 
 	if (ci->sort_y) {
 
+		//only collected and sorted again when something below changed
 		if (ci->ysort_children_count == -1) {
 			ci->ysort_children_count = 0;
-			_collect_ysort_children(ci, Transform2D(), p_material_owner, NULL, ci->ysort_children_count);
+			_collect_ysort_children(ci, Transform2D(), ci, NULL, ci->ysort_children_count);
+
+			ci->ysort_children.resize(ci->ysort_children_count);
+
+			int i = 0;
+			_collect_ysort_children(ci, Transform2D(), ci, ci->ysort_children.ptrw(), i);
+
+			SortArray<Item *, ItemPtrSort> sorter;
+			sorter.sort(ci->ysort_children.ptrw(), ci->ysort_children_count);
 		}
 
 		child_item_count = ci->ysort_children_count;
-		child_items = (Item **)alloca(child_item_count * sizeof(Item *));
-
-		int i = 0;
-		_collect_ysort_children(ci, Transform2D(), p_material_owner, child_items, i);
+		child_items = ci->ysort_children.ptrw();
+	} else {
 
-		SortArray<Item *, ItemPtrSort> sorter;
-		sorter.sort(child_items, child_item_count);
+		uint32_t visible_count = 0;
+		visible_children = _cull_children(ci->cull_grid, ci->cull_grid_dirty, child_items, child_item_count, xform, cull_rect, visible_count);
+		if (visible_children) {
+			child_item_count = visible_count;
+		}
 	}
 
 	if (ci->z_relative)
@@ -165,12 +353,20 @@ void VisualServerCanvas::_cull_canvas_item(Item *p_canvas_item, const Transform2
 
 	for (int i = 0; i < child_item_count; i++) {
 
-		if (!child_items[i]->behind || (ci->sort_y && child_items[i]->sort_y))
+		Item *child = child_items[visible_children ? visible_children[i] : i];
+		if (!child->behind || (ci->sort_y && child->sort_y))
 			continue;
 		if (ci->sort_y) {
-			_cull_canvas_item(child_items[i], xform * child_items[i]->ysort_xform, p_clip_rect, modulate, p_z, z_list, z_last_list, (Item *)ci->final_clip_owner, (Item *)child_items[i]->material_owner);
+			Transform2D child_xform = xform * child->ysort_xform;
+			if (_is_subtree_culled(child, child_xform, cull_rect))
+				continue;
+			//the collected owner stands in for p_material_owner, which is only known now
+			Item *material_owner = child->ysort_material_owner == ci ? p_material_owner : child->ysort_material_owner;
+			_cull_canvas_item(child, child_xform, p_clip_rect, modulate, p_z, z_list, z_last_list, (Item *)ci->final_clip_owner, material_owner);
 		} else {
-			_cull_canvas_item(child_items[i], xform, p_clip_rect, modulate, p_z, z_list, z_last_list, (Item *)ci->final_clip_owner, p_material_owner);
+			if (_is_subtree_culled(child, xform, cull_rect))
+				continue;
+			_cull_canvas_item(child, xform, p_clip_rect, modulate, p_z, z_list, z_last_list, (Item *)ci->final_clip_owner, p_material_owner);
 		}
 	}
 
@@ -209,12 +405,19 @@ void VisualServerCanvas::_cull_canvas_item(Item *p_canvas_item, const Transform2
 
 	for (int i = 0; i < child_item_count; i++) {
 
-		if (child_items[i]->behind || (ci->sort_y && child_items[i]->sort_y))
+		Item *child = child_items[visible_children ? visible_children[i] : i];
+		if (child->behind || (ci->sort_y && child->sort_y))
 			continue;
 		if (ci->sort_y) {
-			_cull_canvas_item(child_items[i], xform * child_items[i]->ysort_xform, p_clip_rect, modulate, p_z, z_list, z_last_list, (Item *)ci->final_clip_owner, (Item *)child_items[i]->material_owner);
+			Transform2D child_xform = xform * child->ysort_xform;
+			if (_is_subtree_culled(child, child_xform, cull_rect))
+				continue;
+			Item *material_owner = child->ysort_material_owner == ci ? p_material_owner : child->ysort_material_owner;
+			_cull_canvas_item(child, child_xform, p_clip_rect, modulate, p_z, z_list, z_last_list, (Item *)ci->final_clip_owner, material_owner);
 		} else {
-			_cull_canvas_item(child_items[i], xform, p_clip_rect, modulate, p_z, z_list, z_last_list, (Item *)ci->final_clip_owner, p_material_owner);
+			if (_is_subtree_culled(child, xform, cull_rect))
+				continue;
+			_cull_canvas_item(child, xform, p_clip_rect, modulate, p_z, z_list, z_last_list, (Item *)ci->final_clip_owner, p_material_owner);
 		}
 	}
 }
@@ -250,6 +453,7 @@ void VisualServerCanvas::render_canvas(RID p_render_target, Canvas *p_canvas, co
 
 		p_canvas->child_items.sort();
 		p_canvas->children_order_dirty = false;
+		p_canvas->cull_grid_dirty = true;
 	}
 
 	int l = p_canvas->child_items.size();
@@ -265,30 +469,30 @@ void VisualServerCanvas::render_canvas(RID p_render_target, Canvas *p_canvas, co
 
 	if (!has_mirror) {
 
-		_render_canvas_item_tree(p_render_target, ci, l, NULL, p_transform, p_clip_rect, p_canvas->modulate, p_lights);
+		_render_canvas_item_tree(p_render_target, p_canvas, NULL, p_transform, p_clip_rect, p_canvas->modulate, p_lights);
 
 	} else {
 		//used for parallaxlayer mirroring
 		for (int i = 0; i < l; i++) {
 
 			const Canvas::ChildItem &ci2 = p_canvas->child_items[i];
-			_render_canvas_item_tree(p_render_target, NULL, 0, ci2.item, p_transform, p_clip_rect, p_canvas->modulate, p_lights);
+			_render_canvas_item_tree(p_render_target, NULL, ci2.item, p_transform, p_clip_rect, p_canvas->modulate, p_lights);
 
 			//mirroring (useful for scrolling backgrounds)
 			if (ci2.mirror.x != 0) {
 
 				Transform2D xform2 = p_transform * Transform2D(0, Vector2(ci2.mirror.x, 0));
-				_render_canvas_item_tree(p_render_target, NULL, 0, ci2.item, xform2, p_clip_rect, p_canvas->modulate, p_lights);
+				_render_canvas_item_tree(p_render_target, NULL, ci2.item, xform2, p_clip_rect, p_canvas->modulate, p_lights);
 			}
 			if (ci2.mirror.y != 0) {
 
 				Transform2D xform2 = p_transform * Transform2D(0, Vector2(0, ci2.mirror.y));
-				_render_canvas_item_tree(p_render_target, NULL, 0, ci2.item, xform2, p_clip_rect, p_canvas->modulate, p_lights);
+				_render_canvas_item_tree(p_render_target, NULL, ci2.item, xform2, p_clip_rect, p_canvas->modulate, p_lights);
 			}
 			if (ci2.mirror.y != 0 && ci2.mirror.x != 0) {
 
 				Transform2D xform2 = p_transform * Transform2D(0, ci2.mirror);
-				_render_canvas_item_tree(p_render_target, NULL, 0, ci2.item, xform2, p_clip_rect, p_canvas->modulate, p_lights);
+				_render_canvas_item_tree(p_render_target, NULL, ci2.item, xform2, p_clip_rect, p_canvas->modulate, p_lights);
 			}
 		}
 	}
@@ -359,6 +563,8 @@ void VisualServerCanvas::canvas_item_set_parent(RID p_item, RID p_parent) {
 
 			Item *item_owner = canvas_item_owner.getornull(canvas_item->parent);
 			item_owner->child_items.erase(canvas_item);
+			item_owner->cull_grid_dirty = true;
+			_mark_subtree_dirty(item_owner);
 
 			if (item_owner->sort_y) {
 				_mark_ysort_dirty(item_owner, canvas_item_owner);
@@ -366,6 +572,9 @@ void VisualServerCanvas::canvas_item_set_parent(RID p_item, RID p_parent) {
 		}
 
 		canvas_item->parent = RID();
+		canvas_item->cull_index = -1;
+		canvas_item->cull_loose = false;
+		canvas_item->ysort_children_count = -1;
 	}
 
 	if (p_parent.is_valid()) {
@@ -376,11 +585,14 @@ void VisualServerCanvas::canvas_item_set_parent(RID p_item, RID p_parent) {
 			ci.item = canvas_item;
 			canvas->child_items.push_back(ci);
 			canvas->children_order_dirty = true;
+			canvas->cull_grid_dirty = true;
 		} else if (canvas_item_owner.owns(p_parent)) {
 
 			Item *item_owner = canvas_item_owner.getornull(p_parent);
 			item_owner->child_items.push_back(canvas_item);
 			item_owner->children_order_dirty = true;
+			item_owner->cull_grid_dirty = true;
+			_mark_subtree_dirty(item_owner);
 
 			if (item_owner->sort_y) {
 				_mark_ysort_dirty(item_owner, canvas_item_owner);
@@ -401,6 +613,7 @@ void VisualServerCanvas::canvas_item_set_visible(RID p_item, bool p_visible) {
 
 	canvas_item->visible = p_visible;
 
+	_mark_subtree_dirty(canvas_item);
 	_mark_ysort_dirty(canvas_item, canvas_item_owner);
 }
 void VisualServerCanvas::canvas_item_set_light_mask(RID p_item, int p_mask) {
@@ -417,6 +630,13 @@ void VisualServerCanvas::canvas_item_set_transform(RID p_item, const Transform2D
 	ERR_FAIL_COND(!canvas_item);
 
 	canvas_item->xform = p_transform;
+
+	_mark_subtree_dirty(canvas_item);
+
+	Item *parent = canvas_item_owner.getornull(canvas_item->parent);
+	if (parent && parent->sort_y) {
+		_mark_ysort_dirty(parent, canvas_item_owner);
+	}
 }
 void VisualServerCanvas::canvas_item_set_clip(RID p_item, bool p_clip) {
 
@@ -439,6 +659,9 @@ void VisualServerCanvas::canvas_item_set_custom_rect(RID p_item, bool p_custom_r
 
 	canvas_item->custom_rect = p_custom_rect;
 	canvas_item->rect = p_rect;
+	canvas_item->rect_dirty = true;
+
+	_mark_subtree_dirty(canvas_item);
 }
 void VisualServerCanvas::canvas_item_set_modulate(RID p_item, const Color &p_color) {
 
@@ -469,6 +692,8 @@ void VisualServerCanvas::canvas_item_set_update_when_visible(RID p_item, bool p_
 	ERR_FAIL_COND(!canvas_item);
 
 	canvas_item->update_when_visible = p_update;
+
+	_mark_subtree_dirty(canvas_item);
 }
 
 void VisualServerCanvas::canvas_item_set_default_texture_filter(RID p_item, VS::CanvasItemTextureFilter p_filter) {
@@ -490,6 +715,8 @@ void VisualServerCanvas::canvas_item_add_line(RID p_item, const Point2 &p_from,
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
 
+	_mark_subtree_dirty(canvas_item);
+
 	Item::CommandPrimitive *line = canvas_item->alloc_command<Item::CommandPrimitive>();
 	ERR_FAIL_COND(!line);
 	if (p_width > 1.001) {
@@ -517,6 +744,8 @@ void VisualServerCanvas::canvas_item_add_polyline(RID p_item, const Vector<Point
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
 
+	_mark_subtree_dirty(canvas_item);
+
 	Item::CommandPolygon *pline = canvas_item->alloc_command<Item::CommandPolygon>();
 	ERR_FAIL_COND(!pline);
 
@@ -609,6 +838,8 @@ void VisualServerCanvas::canvas_item_add_multiline(RID p_item, const Vector<Poin
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
 
+	_mark_subtree_dirty(canvas_item);
+
 	Item::CommandPolygon *pline = canvas_item->alloc_command<Item::CommandPolygon>();
 	ERR_FAIL_COND(!pline);
 
@@ -629,6 +860,8 @@ void VisualServerCanvas::canvas_item_add_rect(RID p_item, const Rect2 &p_rect, c
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
 
+	_mark_subtree_dirty(canvas_item);
+
 	Item::CommandRect *rect = canvas_item->alloc_command<Item::CommandRect>();
 	ERR_FAIL_COND(!rect);
 	rect->modulate = p_color;
@@ -640,6 +873,8 @@ void VisualServerCanvas::canvas_item_add_circle(RID p_item, const Point2 &p_pos,
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
 
+	_mark_subtree_dirty(canvas_item);
+
 	Item::CommandPolygon *circle = canvas_item->alloc_command<Item::CommandPolygon>();
 	ERR_FAIL_COND(!circle);
 
@@ -678,6 +913,8 @@ void VisualServerCanvas::canvas_item_add_texture_rect(RID p_item, const Rect2 &p
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
 
+	_mark_subtree_dirty(canvas_item);
+
 	Item::CommandRect *rect = canvas_item->alloc_command<Item::CommandRect>();
 	ERR_FAIL_COND(!rect);
 	rect->modulate = p_modulate;
@@ -712,6 +949,8 @@ void VisualServerCanvas::canvas_item_add_texture_rect_region(RID p_item, const R
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
 
+	_mark_subtree_dirty(canvas_item);
+
 	Item::CommandRect *rect = canvas_item->alloc_command<Item::CommandRect>();
 	ERR_FAIL_COND(!rect);
 	rect->modulate = p_modulate;
@@ -757,6 +996,8 @@ void VisualServerCanvas::canvas_item_add_nine_patch(RID p_item, const Rect2 &p_r
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
 
+	_mark_subtree_dirty(canvas_item);
+
 	Item::CommandNinePatch *style = canvas_item->alloc_command<Item::CommandNinePatch>();
 	ERR_FAIL_COND(!style);
 	style->texture_binding.create(canvas_item->texture_filter, canvas_item->texture_repeat, p_texture, p_normal_map, p_specular_map, p_filter, p_repeat, RID());
@@ -780,6 +1021,8 @@ void VisualServerCanvas::canvas_item_add_primitive(RID p_item, const Vector<Poin
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
 
+	_mark_subtree_dirty(canvas_item);
+
 	Item::CommandPrimitive *prim = canvas_item->alloc_command<Item::CommandPrimitive>();
 	ERR_FAIL_COND(!prim);
 
@@ -807,6 +1050,8 @@ void VisualServerCanvas::canvas_item_add_polygon(RID p_item, const Vector<Point2
 
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
+
+	_mark_subtree_dirty(canvas_item);
 #ifdef DEBUG_ENABLED
 	int pointcount = p_points.size();
 	ERR_FAIL_COND(pointcount < 3);
@@ -831,6 +1076,8 @@ void VisualServerCanvas::canvas_item_add_triangle_array(RID p_item, const Vector
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
 
+	_mark_subtree_dirty(canvas_item);
+
 	int vertex_count = p_points.size();
 	ERR_FAIL_COND(vertex_count == 0);
 	ERR_FAIL_COND(!p_colors.empty() && p_colors.size() != vertex_count && p_colors.size() != 1);
@@ -854,6 +1101,8 @@ void VisualServerCanvas::canvas_item_add_set_transform(RID p_item, const Transfo
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
 
+	_mark_subtree_dirty(canvas_item);
+
 	Item::CommandTransform *tr = canvas_item->alloc_command<Item::CommandTransform>();
 	ERR_FAIL_COND(!tr);
 	tr->xform = p_transform;
@@ -864,6 +1113,9 @@ void VisualServerCanvas::canvas_item_add_mesh(RID p_item, const RID &p_mesh, con
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
 
+	canvas_item->dynamic_rect = true;
+	_mark_subtree_dirty(canvas_item);
+
 	Item::CommandMesh *m = canvas_item->alloc_command<Item::CommandMesh>();
 	ERR_FAIL_COND(!m);
 	m->mesh = p_mesh;
@@ -877,6 +1129,9 @@ void VisualServerCanvas::canvas_item_add_particles(RID p_item, RID p_particles,
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
 
+	canvas_item->dynamic_rect = true;
+	_mark_subtree_dirty(canvas_item);
+
 	Item::CommandParticles *part = canvas_item->alloc_command<Item::CommandParticles>();
 	ERR_FAIL_COND(!part);
 	part->particles = p_particles;
@@ -892,6 +1147,9 @@ void VisualServerCanvas::canvas_item_add_multimesh(RID p_item, RID p_mesh, RID p
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
 
+	canvas_item->dynamic_rect = true;
+	_mark_subtree_dirty(canvas_item);
+
 	Item::CommandMultiMesh *mm = canvas_item->alloc_command<Item::CommandMultiMesh>();
 	ERR_FAIL_COND(!mm);
 	mm->multimesh = p_mesh;
@@ -904,6 +1162,8 @@ void VisualServerCanvas::canvas_item_add_clip_ignore(RID p_item, bool p_ignore)
 	Item *canvas_item = canvas_item_owner.getornull(p_item);
 	ERR_FAIL_COND(!canvas_item);
 
+	_mark_subtree_dirty(canvas_item);
+
 	Item::CommandClipIgnore *ci = canvas_item->alloc_command<Item::CommandClipIgnore>();
 	ERR_FAIL_COND(!ci);
 	ci->ignore = p_ignore;
@@ -916,6 +1176,11 @@ void VisualServerCanvas::canvas_item_set_sort_children_by_y(RID p_item, bool p_e
 	canvas_item->sort_y = p_enable;
 
 	_mark_ysort_dirty(canvas_item, canvas_item_owner);
+
+	//children that sort their own children may have been collected from here, and their cached lists are stale now
+	for (int i = 0; i < canvas_item->child_items.size(); i++) {
+		canvas_item->child_items[i]->ysort_children_count = -1;
+	}
 }
 void VisualServerCanvas::canvas_item_set_z_index(RID p_item, int p_z) {
 
@@ -959,6 +1224,8 @@ void VisualServerCanvas::canvas_item_set_copy_to_backbuffer(RID p_item, bool p_e
 		canvas_item->copy_back_buffer->rect = p_rect;
 		canvas_item->copy_back_buffer->full = p_rect == Rect2();
 	}
+
+	_mark_subtree_dirty(canvas_item);
 }
 
 void VisualServerCanvas::canvas_item_clear(RID p_item) {
@@ -967,6 +1234,9 @@ void VisualServerCanvas::canvas_item_clear(RID p_item) {
 	ERR_FAIL_COND(!canvas_item);
 
 	canvas_item->clear();
+	canvas_item->dynamic_rect = false;
+
+	_mark_subtree_dirty(canvas_item);
 }
 void VisualServerCanvas::canvas_item_set_draw_index(RID p_item, int p_index) {
 
@@ -1002,6 +1272,11 @@ void VisualServerCanvas::canvas_item_set_use_parent_material(RID p_item, bool p_
 	ERR_FAIL_COND(!canvas_item);
 
 	canvas_item->use_parent_material = p_enable;
+
+	Item *parent = canvas_item_owner.getornull(canvas_item->parent);
+	if (parent && parent->sort_y) {
+		_mark_ysort_dirty(parent, canvas_item_owner);
+	}
 }
 
 RID VisualServerCanvas::canvas_light_create() {
@@ -1352,6 +1627,8 @@ bool VisualServerCanvas::free(RID p_rid) {
 		for (int i = 0; i < canvas->child_items.size(); i++) {
 
 			canvas->child_items[i].item->parent = RID();
+			canvas->child_items[i].item->cull_index = -1;
+			canvas->child_items[i].item->cull_loose = false;
 		}
 
 		for (Set<RasterizerCanvas::Light *>::Element *E = canvas->lights.front(); E; E = E->next()) {
@@ -1383,6 +1660,8 @@ bool VisualServerCanvas::free(RID p_rid) {
 
 				Item *item_owner = canvas_item_owner.getornull(canvas_item->parent);
 				item_owner->child_items.erase(canvas_item);
+				item_owner->cull_grid_dirty = true;
+				_mark_subtree_dirty(item_owner);
 
 				if (item_owner->sort_y) {
 					_mark_ysort_dirty(item_owner, canvas_item_owner);
@@ -1393,6 +1672,8 @@ bool VisualServerCanvas::free(RID p_rid) {
 		for (int i = 0; i < canvas_item->child_items.size(); i++) {
 
 			canvas_item->child_items[i]->parent = RID();
+			canvas_item->child_items[i]->cull_index = -1;
+			canvas_item->child_items[i]->cull_loose = false;
 		}
 
 		/*
@@ -31,6 +31,7 @@
 #ifndef VISUALSERVERCANVAS_H
 #define VISUALSERVERCANVAS_H
 
+#include "canvas_cull_grid.h"
 #include "rasterizer.h"
 #include "visual_server_viewport.h"
 
@@ -52,11 +53,27 @@ public:
 		Color ysort_modulate;
 		Transform2D ysort_xform;
 		Vector2 ysort_pos;
+		Item *ysort_material_owner;
+		Vector<Item *> ysort_children; //flattened and sorted, rebuilt when ysort_children_count is -1
 		VS::CanvasItemTextureFilter texture_filter;
 		VS::CanvasItemTextureRepeat texture_repeat;
 
 		Vector<Item *> child_items;
 
+		//bounds of this item and its visible children in the parent space, used to skip whole subtrees when culling
+		Rect2 subtree_rect;
+		bool subtree_dirty;
+		bool subtree_has_rect;
+		bool subtree_unbounded; //must always be visited (backbuffer copies, update when visible, storage driven rects)
+		bool dynamic_rect; //has meshes, multimeshes or particles, whose rect can change without the item changing
+
+		//place in the parent cull grid
+		int cull_index;
+		bool cull_loose;
+
+		CanvasCullGrid cull_grid;
+		bool cull_grid_dirty;
+
 		Item() {
 			children_order_dirty = true;
 			E = NULL;
@@ -70,6 +87,14 @@ public:
 			ysort_children_count = -1;
 			ysort_xform = Transform2D();
 			ysort_pos = Vector2();
+			ysort_material_owner = NULL;
+			subtree_dirty = true;
+			subtree_has_rect = false;
+			subtree_unbounded = false;
+			dynamic_rect = false;
+			cull_index = -1;
+			cull_loose = false;
+			cull_grid_dirty = true;
 			texture_filter = VS::CANVAS_ITEM_TEXTURE_FILTER_DEFAULT;
 			texture_repeat = VS::CANVAS_ITEM_TEXTURE_REPEAT_DEFAULT;
 		}
@@ -130,6 +155,8 @@ public:
 
 		bool children_order_dirty;
 		Vector<ChildItem> child_items;
+		CanvasCullGrid cull_grid;
+		bool cull_grid_dirty;
 		Color modulate;
 		RID parent;
 		float parent_scale;
@@ -143,13 +170,16 @@ public:
 		}
 		void erase_item(Item *p_item) {
 			int idx = find_item(p_item);
-			if (idx >= 0)
+			if (idx >= 0) {
 				child_items.remove(idx);
+				cull_grid_dirty = true;
+			}
 		}
 
 		Canvas() {
 			modulate = Color(1, 1, 1, 1);
 			children_order_dirty = true;
+			cull_grid_dirty = true;
 			parent_scale = 1.0;
 		}
 	};
@@ -161,7 +191,29 @@ public:
 	bool disable_scale;
 
 private:
-	void _render_canvas_item_tree(RID p_to_render_target, Canvas::ChildItem *p_child_items, int p_child_item_count, Item *p_canvas_item, const Transform2D &p_transform, const Rect2 &p_clip_rect, const Color &p_modulate, RasterizerCanvas::Light *p_lights);
+	enum {
+		CULL_GRID_MIN_CHILDREN = 64, //below this, children are tested one by one
+		CULL_GRID_MAX_MOVED = 32, //plus a quarter of the children, rebuild the grid once this many moved
+	};
+
+	template <class T>
+	void _update_cull_grid(CanvasCullGrid &r_grid, bool &r_grid_dirty, T *p_children, int p_child_count);
+	template <class T>
+	const uint32_t *_cull_children(CanvasCullGrid &r_grid, bool &r_grid_dirty, T *p_children, int p_child_count, const Transform2D &p_xform, const Rect2 &p_cull_rect, uint32_t &r_count);
+	void _update_subtree_rect(Item *p_item);
+	_FORCE_INLINE_ bool _is_subtree_culled(Item *p_item, const Transform2D &p_parent_xform, const Rect2 &p_cull_rect) {
+		if (!p_item->visible) {
+			return true;
+		}
+		_update_subtree_rect(p_item);
+		if (p_item->subtree_unbounded) {
+			return false;
+		}
+		return !p_item->subtree_has_rect || !p_cull_rect.intersects_touch(p_parent_xform.xform(p_item->subtree_rect));
+	}
+	void _mark_subtree_dirty(Item *p_item);
+
+	void _render_canvas_item_tree(RID p_to_render_target, Canvas *p_canvas, Item *p_canvas_item, const Transform2D &p_transform, const Rect2 &p_clip_rect, const Color &p_modulate, RasterizerCanvas::Light *p_lights);
 	void _cull_canvas_item(Item *p_canvas_item, const Transform2D &p_transform, const Rect2 &p_clip_rect, const Color &p_modulate, int p_z, RasterizerCanvas::Item **z_list, RasterizerCanvas::Item **z_last_list, Item *p_canvas_clip, Item *p_material_owner);
 	void _light_mask_canvas_items(int p_z, RasterizerCanvas::Item *p_canvas_item, RasterizerCanvas::Light *p_masked_lights);
 
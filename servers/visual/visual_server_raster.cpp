@@ -175,7 +175,16 @@ void VisualServerRaster::finish() {
 
 int VisualServerRaster::get_render_info(RenderInfo p_info) {
 
-	return VSG::storage->get_render_info(p_info);
+	switch (p_info) {
+		case INFO_2D_COMMANDS_IN_FRAME:
+		case INFO_2D_DRAW_CALLS_IN_FRAME:
+		case INFO_2D_BATCHES_IN_FRAME: {
+			return VSG::canvas_render->get_render_info(p_info);
+		}
+		default: {
+			return VSG::storage->get_render_info(p_info);
+		}
+	}
 }
 
 String VisualServerRaster::get_video_adapter_name() const {
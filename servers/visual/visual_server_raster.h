@@ -269,6 +269,7 @@ public:
 	BIND2RC(Color, multimesh_instance_get_custom_data, RID, int)
 
 	BIND2(multimesh_set_buffer, RID, const Vector<float> &)
+	BIND3(multimesh_set_buffer_range, RID, int, const Vector<float> &)
 	BIND1RC(Vector<float>, multimesh_get_buffer, RID)
 
 	BIND2(multimesh_set_visible_instances, RID, int)
@@ -31,6 +31,7 @@
 #include "visual_server_scene.h"
 
 #include "core/os/os.h"
+#include "core/project_settings.h"
 #include "visual_server_globals.h"
 #include "visual_server_raster.h"
 
@@ -41,6 +42,13 @@
 RID VisualServerScene::camera_create() {
 
 	Camera *camera = memnew(Camera);
+	for (int i = 0; i < 64; i++) {
+		if (!(lod_views_used & (uint64_t(1) << i))) {
+			lod_views_used |= uint64_t(1) << i;
+			camera->lod_view = i;
+			break;
+		}
+	}
 	return camera_owner.make_rid(camera);
 }
 
@@ -919,6 +927,15 @@ void VisualServerScene::instance_geometry_set_material_override(RID p_instance,
 }
 
 void VisualServerScene::instance_geometry_set_draw_range(RID p_instance, float p_min, float p_max, float p_min_margin, float p_max_margin) {
+
+	Instance *instance = instance_owner.getornull(p_instance);
+	ERR_FAIL_COND(!instance);
+
+	instance->lod_begin = p_min;
+	instance->lod_end = p_max;
+	instance->lod_begin_hysteresis = p_min_margin;
+	instance->lod_end_hysteresis = p_max_margin;
+	instance->lod_in_range_views = UINT64_MAX;
 }
 void VisualServerScene::instance_geometry_set_as_instance_lod(RID p_instance, RID p_as_lod_of_instance) {
 }
@@ -1793,7 +1810,9 @@ void VisualServerScene::render_camera(RID p_render_buffers, RID p_camera, RID p_
 		} break;
 	}
 
-	_prepare_scene(camera->transform, camera_matrix, ortho, camera->env, camera->effects, camera->visible_layers, p_scenario, p_shadow_atlas, RID());
+	float screen_lod_threshold = _get_screen_lod_threshold(camera_matrix, ortho, p_viewport_size.height);
+
+	_prepare_scene(camera->transform, camera_matrix, ortho, camera->env, camera->effects, camera->visible_layers, p_scenario, p_shadow_atlas, RID(), true, screen_lod_threshold, camera->lod_view);
 	_render_scene(p_render_buffers, camera->transform, camera_matrix, ortho, camera->env, camera->effects, p_scenario, p_shadow_atlas, RID(), -1);
 #endif
 }
@@ -1807,6 +1826,7 @@ void VisualServerScene::render_camera(RID p_render_buffers, Ref<ARVRInterface> &
 	/* SETUP CAMERA, we are ignoring type and FOV here */
 	float aspect = p_viewport_size.width / (float)p_viewport_size.height;
 	CameraMatrix camera_matrix = p_interface->get_projection_for_eye(p_eye, aspect, camera->znear, camera->zfar);
+	float screen_lod_threshold = _get_screen_lod_threshold(camera_matrix, false, p_viewport_size.height);
 
 	// We also ignore our camera position, it will have been positioned with a slightly old tracking position.
 	// Instead we take our origin point and have our ar/vr interface add fresh tracking data! Whoohoo!
@@ -1872,17 +1892,61 @@ void VisualServerScene::render_camera(RID p_render_buffers, Ref<ARVRInterface> &
 		mono_transform *= apply_z_shift;
 
 		// now prepare our scene with our adjusted transform projection matrix
-		_prepare_scene(mono_transform, combined_matrix, false, camera->env, camera->effects, camera->visible_layers, p_scenario, p_shadow_atlas, RID());
+		_prepare_scene(mono_transform, combined_matrix, false, camera->env, camera->effects, camera->visible_layers, p_scenario, p_shadow_atlas, RID(), true, screen_lod_threshold, camera->lod_view);
 	} else if (p_eye == ARVRInterface::EYE_MONO) {
 		// For mono render, prepare as per usual
-		_prepare_scene(cam_transform, camera_matrix, false, camera->env, camera->effects, camera->visible_layers, p_scenario, p_shadow_atlas, RID());
+		_prepare_scene(cam_transform, camera_matrix, false, camera->env, camera->effects, camera->visible_layers, p_scenario, p_shadow_atlas, RID(), true, screen_lod_threshold, camera->lod_view);
 	}
 
 	// And render our scene...
 	_render_scene(p_render_buffers, cam_transform, camera_matrix, false, camera->env, camera->effects, p_scenario, p_shadow_atlas, RID(), -1);
 };
 
-void VisualServerScene::_prepare_scene(const Transform p_cam_transform, const CameraMatrix &p_cam_projection, bool p_cam_orthogonal, RID p_force_environment, RID p_force_camera_effects, uint32_t p_visible_layers, RID p_scenario, RID p_shadow_atlas, RID p_reflection_probe, bool p_using_shadows) {
+bool VisualServerScene::_instance_update_draw_range(Instance *p_instance, const Vector3 &p_cam_pos, int p_lod_view) {
+
+	if (p_instance->lod_begin <= 0 && p_instance->lod_end <= 0) {
+		return true;
+	}
+
+	float distance = p_cam_pos.distance_to(p_instance->transformed_aabb.position + p_instance->transformed_aabb.size * 0.5);
+
+	//margins widen the range once inside it, so instances don't flicker around the boundaries,
+	//the state is kept per camera since each one sees the instance at another distance
+	//(views without a camera bit, like reflection probes, don't use margins)
+	float begin = p_instance->lod_begin;
+	float end = p_instance->lod_end;
+	uint64_t view_bit = p_lod_view >= 0 ? uint64_t(1) << p_lod_view : 0;
+	if (p_instance->lod_in_range_views & view_bit) {
+		begin -= p_instance->lod_begin_hysteresis;
+		end += p_instance->lod_end_hysteresis;
+	}
+
+	bool in_range = distance >= begin && (p_instance->lod_end <= 0 || distance < end);
+	if (in_range) {
+		p_instance->lod_in_range_views |= view_bit;
+	} else {
+		p_instance->lod_in_range_views &= ~view_bit;
+	}
+
+	return in_range;
+}
+
+float VisualServerScene::_get_screen_lod_threshold(const CameraMatrix &p_cam_projection, bool p_cam_orthogonal, float p_viewport_height) const {
+
+	if (mesh_lod_threshold <= 0 || p_viewport_height <= 0) {
+		return 0; //always use full detail
+	}
+
+	//size of a pixel at unit distance (or at any distance, when orthogonal)
+	float pixel_size = p_cam_projection.get_viewport_half_extents().y * 2.0 / p_viewport_height;
+	if (!p_cam_orthogonal) {
+		pixel_size /= p_cam_projection.get_z_near();
+	}
+
+	return pixel_size * mesh_lod_threshold;
+}
+
+void VisualServerScene::_prepare_scene(const Transform p_cam_transform, const CameraMatrix &p_cam_projection, bool p_cam_orthogonal, RID p_force_environment, RID p_force_camera_effects, uint32_t p_visible_layers, RID p_scenario, RID p_shadow_atlas, RID p_reflection_probe, bool p_using_shadows, float p_screen_lod_threshold, int p_lod_view) {
 	// Note, in stereo rendering:
 	// - p_cam_transform will be a transform in the middle of our two eyes
 	// - p_cam_projection is a wider frustrum that encompasses both eyes
@@ -1990,10 +2054,27 @@ void VisualServerScene::_prepare_scene(const Transform p_cam_transform, const Ca
 				gi_probe_cull_count++;
 			}
 
+		} else if (((1 << ins->base_type) & VS::INSTANCE_GEOMETRY_MASK) && !_instance_update_draw_range(ins, p_cam_transform.origin, p_lod_view)) {
+			//outside its draw range, another instance (HLOD) takes over here
 		} else if (((1 << ins->base_type) & VS::INSTANCE_GEOMETRY_MASK) && ins->visible && ins->cast_shadows != VS::SHADOW_CASTING_SETTING_SHADOWS_ONLY) {
 
 			keep = true;
 
+			if (p_screen_lod_threshold > 0) {
+				//object space error that stays under the pixel threshold at this distance
+				float distance = 1.0;
+				if (!p_cam_orthogonal) {
+					Vector3 center = ins->transformed_aabb.position + ins->transformed_aabb.size * 0.5;
+					distance = p_cam_transform.origin.distance_to(center) - ins->transformed_aabb.size.length() * 0.5;
+					distance = MAX(distance, p_cam_projection.get_z_near());
+				}
+				Vector3 scale = ins->transform.basis.get_scale_abs();
+				float max_scale = MAX(scale.x, MAX(scale.y, scale.z));
+				ins->lod_edge_length = max_scale > CMP_EPSILON ? distance * p_screen_lod_threshold / max_scale : 0;
+			} else {
+				ins->lod_edge_length = 0;
+			}
+
 			InstanceGeometryData *geom = static_cast<InstanceGeometryData *>(ins->base_data);
 
 			if (ins->redraw_if_visible) {
@@ -2787,6 +2868,9 @@ bool VisualServerScene::free(RID p_rid) {
 	if (camera_owner.owns(p_rid)) {
 
 		Camera *camera = camera_owner.getornull(p_rid);
+		if (camera->lod_view != -1) {
+			lod_views_used &= ~(uint64_t(1) << camera->lod_view);
+		}
 
 		camera_owner.free(p_rid);
 		memdelete(camera);
@@ -2832,6 +2916,8 @@ VisualServerScene *VisualServerScene::singleton = NULL;
 VisualServerScene::VisualServerScene() {
 
 	render_pass = 1;
+	lod_views_used = 0;
+	mesh_lod_threshold = GLOBAL_GET("rendering/quality/lod/threshold_pixels");
 	singleton = this;
 }
 
@@ -54,6 +54,7 @@ public:
 	};
 
 	uint64_t render_pass;
+	float mesh_lod_threshold;
 
 	static VisualServerScene *singleton;
 
@@ -75,6 +76,7 @@ public:
 		bool vaspect;
 		RID env;
 		RID effects;
+		int lod_view; //bit of this camera in Instance::lod_in_range_views, -1 if none is free
 
 		Transform transform;
 
@@ -88,10 +90,12 @@ public:
 			size = 1.0;
 			offset = Vector2();
 			vaspect = false;
+			lod_view = -1;
 		}
 	};
 
 	mutable RID_PtrOwner<Camera> camera_owner;
+	uint64_t lod_views_used;
 
 	virtual RID camera_create();
 	virtual void camera_set_perspective(RID p_camera, float p_fovy_degrees, float p_z_near, float p_z_far);
@@ -168,6 +172,7 @@ public:
 		float lod_end;
 		float lod_begin_hysteresis;
 		float lod_end_hysteresis;
+		uint64_t lod_in_range_views; //draw range hysteresis state, one bit per camera
 		RID lod_instance;
 
 		uint64_t last_render_pass;
@@ -209,6 +214,7 @@ public:
 			lod_end = 0;
 			lod_begin_hysteresis = 0;
 			lod_end_hysteresis = 0;
+			lod_in_range_views = UINT64_MAX;
 
 			last_render_pass = 0;
 			last_frame_pass = 0;
@@ -420,8 +426,11 @@ public:
 
 	_FORCE_INLINE_ bool _light_instance_update_shadow(Instance *p_instance, const Transform p_cam_transform, const CameraMatrix &p_cam_projection, bool p_cam_orthogonal, RID p_shadow_atlas, Scenario *p_scenario);
 
+	_FORCE_INLINE_ bool _instance_update_draw_range(Instance *p_instance, const Vector3 &p_cam_pos, int p_lod_view);
+	float _get_screen_lod_threshold(const CameraMatrix &p_cam_projection, bool p_cam_orthogonal, float p_viewport_height) const;
+
 	bool _render_reflection_probe_step(Instance *p_instance, int p_step);
-	void _prepare_scene(const Transform p_cam_transform, const CameraMatrix &p_cam_projection, bool p_cam_orthogonal, RID p_force_environment, RID p_force_camera_effects, uint32_t p_visible_layers, RID p_scenario, RID p_shadow_atlas, RID p_reflection_probe, bool p_using_shadows = true);
+	void _prepare_scene(const Transform p_cam_transform, const CameraMatrix &p_cam_projection, bool p_cam_orthogonal, RID p_force_environment, RID p_force_camera_effects, uint32_t p_visible_layers, RID p_scenario, RID p_shadow_atlas, RID p_reflection_probe, bool p_using_shadows = true, float p_screen_lod_threshold = 0.0, int p_lod_view = -1);
 	void _render_scene(RID p_render_buffers, const Transform p_cam_transform, const CameraMatrix &p_cam_projection, bool p_cam_orthogonal, RID p_force_environment, RID p_force_camera_effects, RID p_scenario, RID p_shadow_atlas, RID p_reflection_probe, int p_reflection_probe_pass);
 	void render_empty_scene(RID p_render_buffers, RID p_scenario, RID p_shadow_atlas);
 